@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// === Actuator descriptor table ===
+// One line per AUTO/MANUAL actuator (RTDB /commands/<id>/<name>/{isAuto,value}).
+// Commands members, ActuatorState flags, RelayId values, relayStates bits,
+// stream path dispatch, mode handling and relay sync are all generated from
+// this list. The row order is the bit index in every packed mask.
+//
+//   X(name, relayId, relayField, label)
+//     name        Commands member, ActuatorState flag prefix and RTDB key
+//     relayId     RelayId enumerator for the relay
+//     relayField  RealTimeData::relayStates member
+//     label       log label
+#define ACTUATOR_TABLE(X) \
+    X(fan,    RELAY_FAN,    fan,       "🌀 Fan")          \
+    X(light,  RELAY_LIGHT,  light,     "💡 Light")        \
+    X(pump,   RELAY_PUMP,   waterPump, "💧 Pump")         \
+    X(valve,  RELAY_VALVE,  valve,     "🚰 Valve")        \
+    X(cooler, RELAY_COOLER, cooler,    "💨 Water Cooler") \
+    X(heater, RELAY_HEATER, heater,    "🔥 Water Heater")
+
+// --- Generators ---
+#define ACTUATOR_INDEX(name, relayId, relayField, label)        ACTUATOR_##name,
+#define ACTUATOR_RELAY_ID(name, relayId, relayField, label)     relayId,
+#define ACTUATOR_COMMAND(name, relayId, relayField, label)      CommandState name;
+#define ACTUATOR_STATE_FLAG(name, relayId, relayField, label)   bool name : 1;
+#define ACTUATOR_AUTO_FLAG(name, relayId, relayField, label)    bool name##Auto : 1;
+#define ACTUATOR_MANUAL_FLAG(name, relayId, relayField, label)  bool name##Manual : 1;
+#define ACTUATOR_MANUAL_VALUE_FLAG(name, relayId, relayField, label) bool name##ManualValue : 1;
+#define ACTUATOR_JUST_ENABLED_FLAG(name, relayId, relayField, label) bool name##AutoJustEnabled : 1;
+#define ACTUATOR_RELAY_FIELD(name, relayId, relayField, label)  bool relayField : 1;
+
+enum ActuatorIndex : uint8_t {
+    ACTUATOR_TABLE(ACTUATOR_INDEX)
+    ACTUATOR_COUNT
+};
+
+// Bits 0..ACTUATOR_COUNT-1 of every packed actuator mask
+#define ACTUATOR_MASK ((uint16_t)((1u << ACTUATOR_COUNT) - 1))
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include "actuator_table.h"
+
+// Command structure for RTDB (/commands/<device id>)
+struct CommandState {
+    bool isAuto;
+    bool value;
+};
+
+struct PhDosingCommandState {
+    bool phDosingEnabled;
+    bool value;
+};
+
+struct WaterChangeCommands {
+    bool manualChangeRequest;
+    bool manualChangeCancel;
+    bool inProgress = false;
+};
+
+struct SumpCleaningCommands {
+    bool manualCleanRequest;
+    bool manualCleanCancel;
+    bool inProgress = false;
+};
+struct Commands {
+    ACTUATOR_TABLE(ACTUATOR_COMMAND)
+    PhDosingCommandState phDosing;
+    WaterChangeCommands waterChange;
+    SumpCleaningCommands sumpCleaning;
+};
+
+// Per-actuator runtime descriptor, indexed by ActuatorIndex
+struct ActuatorDescriptor {
+    const char *name;                    // RTDB key
+    const char *label;
+    CommandState Commands::*command;
+};
+
+#define ACTUATOR_DESCRIPTOR(name, relayId, relayField, label) { #name, label, &Commands::name },
+inline constexpr ActuatorDescriptor ACTUATORS[ACTUATOR_COUNT] = {
+    ACTUATOR_TABLE(ACTUATOR_DESCRIPTOR)
+};
+
+// Bit i set when actuator i is in AUTO
+inline uint16_t commands_auto_mask(const Commands &commands) {
+    uint16_t mask = 0;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if ((commands.*ACTUATORS[i].command).isAuto) mask |= 1u << i;
+    }
+    return mask;
+}
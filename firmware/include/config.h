@@ -11,6 +11,8 @@
 
 // DS18B20 (Water Temp)
 #define ONEWIRE_BUS           25
+#define TEMP_MAX_PROBES       4
+#define TEMP_RESOLUTION_BITS  12    // 750 ms conversion, runs asynchronously
 
 // Turbidity Sensor
 #define TURBIDITY_PIN         35
@@ -38,11 +40,68 @@
 #define DO_CAL_VOLTAGE        453.14
 #define DO_SENSOR_SAMPLES     32
 
+// ADC DMA Acquisition (pH, DO, turbidity sampled in the background)
+#define ADC_DMA_ENABLED           true
+#define ADC_DMA_SAMPLE_FREQ_HZ    20000     // total conversions/s across the 3 channels
+#define ADC_DMA_FRAME_SAMPLES     256       // samples per channel averaged into one frame
+#define ADC_DMA_BUFFER_BYTES      4096      // driver ring buffer: ~100 ms of conversions, 2 sensor task periods
+#define ADC_DMA_TRIM_PCT          10        // top/bottom share of each frame dropped before averaging
+#define ADC_DMA_STALE_MS          2000      // no frame for this long: frame is stale, controller restarted
+
 // Float Switch (Water Level)
 #define FLOAT_SWITCH_PIN          32
 #define FLOAT_LOW_DEBOUNCE_MS     3000UL // Time the float must remain low to confirm "low" state
 #define FLOAT_HIGH_DEBOUNCE_MS    3000UL // Time the float must remain high to confirm "normal" state
 
+// Sensor Acquisition Task (sensor I/O off the control loop)
+#define SENSOR_TASK_ENABLED       true
+#define SENSOR_TASK_CORE          0         // loop() runs on core 1
+#define SENSOR_TASK_PRIORITY      1
+#define SENSOR_TASK_STACK         4096
+#define SENSOR_TASK_PERIOD_MS     50
+#define SENSOR_RING_SIZE          8         // power of two
+
+// LCD (20x4 HD44780 behind a PCF8574 I2C backpack)
+#define LCD_ADDR                  0x27
+#define LCD_COLS                  20
+#define LCD_ROWS                  4
+#define LCD_I2C_HZ                100000    // PCF8574 is specified for 100 kHz; most backpacks also run at 400000
+#define LCD_TASK_ENABLED          true      // I2C refresh on a background task; false: inline in lcd_display()
+#define LCD_TASK_CORE             0
+#define LCD_TASK_PRIORITY         1
+#define LCD_TASK_STACK            2048
+
+// Scheduler (timer wheel driving periodic loop jobs)
+#define SCHED_MAX_JOBS            16
+#define SCHED_TICK_MS             10        // wheel resolution
+#define SCHED_WHEEL_SLOTS         64        // power of two; one revolution = 640 ms
+#define LOOP_IDLE_MAX_MS          5         // max sleep when no job is due (stream/MQTT still polled)
+#define RULES_TICK_MS             1000UL    // rule evaluation cadence, independent of sensor updates
+
+// Loop Profiler (per-phase latency histograms; PROF_SCOPE compiles out when false)
+#define LOOP_PROF_ENABLED         false
+#define LOOP_PROF_STALL_US        200000UL  // single call longer than this is logged as a stall
+#define LOOP_PROF_UPLOAD_MS       (15UL * 60UL * 1000UL)  // histograms → /diagnostics/<device>/loop
+
+// Control State Persistence (commands → NVS, rule timers → RTC memory)
+#define CTRL_CHECKPOINT_MS        1000UL    // NVS is only written when a command changed
+
+// Boot Profiler
+#define BOOT_MAX_STAGES           16
+#define BOOT_REPORT_DELAY_MS      60000UL   // timeline logged + uploaded to /diagnostics/<device>/boot
+#define BOOT_SENSOR_PRIME_MS      15000UL   // failed first reads are retried every pass until then
+
+// Logging (lib/logger; levels: 0 off, 1 error, 2 warn, 3 info, 4 debug)
+#define LOG_MAX_LEVEL             3         // compile-time ceiling; calls above a module's ceiling are removed
+#define LOG_BOOT_LEVEL            3         // runtime level of every module at boot (log_set_level)
+#define LOG_TASK_ENABLED          true      // false: print from the caller, blocking on the UART
+#define LOG_TASK_CORE             0
+#define LOG_TASK_PRIORITY         0         // idle priority: drains only when nothing else is runnable
+#define LOG_TASK_STACK            3072
+#define LOG_DRAIN_MS              20
+#define LOG_RING_SIZE             32        // queued messages, power of two
+#define LOG_LINE_MAX              128       // longer messages are truncated
+
 // Unified Sensor Read Interval
 #define UNIFIED_SENSOR_INTERVAL   10000UL
 
@@ -62,6 +121,14 @@
 
 #define RELAY_SYNC_COOLDOWN       2000UL // Minimum time between relay state changes
 
+// Relay minimum on/off times (0 = no limit), enforced by the relay driver
+#define COOLER_MIN_ON_MS          60000UL   // compressor: let it run at least 1 min
+#define COOLER_MIN_OFF_MS         180000UL  // compressor: 3 min for pressures to equalize
+#define HEATER_MIN_ON_MS          0UL
+#define HEATER_MIN_OFF_MS         0UL
+#define PUMP_MIN_ON_MS            0UL
+#define PUMP_MIN_OFF_MS           0UL
+
 // Environmental Thresholds
 #define TEMP_ON_THRESHOLD         29.1f // Temperature to turn ON fan
 #define TEMP_OFF_THRESHOLD        26.9f // Temperature to turn OFF fan
@@ -110,6 +177,63 @@
 // Sump Pump Control
 #define TURBIDITY_CLEAN_THRESHOLD   400.0f   // NTU level that triggers sump cleaning
 #define SUMP_CLEAN_DURATION_MS      30000UL // drain duration
+#define SUMP_HIGH_DWELL_MS          60000UL // NTU must stay high this long before an auto clean
+
+// HTTPS Connection Pool (keep-alive REST calls)
+#define HTTP_POOL_SIZE            3         // RTDB, Firestore, securetoken; sign-in (identitytoolkit) evicts the LRU one
+#define HTTP_POOL_TIMEOUT_MS      10000UL
+#define HTTP_POOL_IDLE_MS         60000UL   // close sockets idle this long to free TLS heap
+
+// Outbound Write Queue
+#define OUTBOUND_QUEUE_SIZE       8
+#define OUTBOUND_BACKOFF_BASE_MS  2000UL
+#define OUTBOUND_BACKOFF_MAX_MS   60000UL
+#define OUTBOUND_COMMAND_TTL_MS   (2UL * 60UL * 1000UL)   // relay / command state
+#define OUTBOUND_LIVE_TTL_MS      (60UL * 1000UL)         // live sensor data
+#define OUTBOUND_LOG_TTL_MS       (30UL * 60UL * 1000UL)  // Firestore batch logs
+
+// Command Latency Tracing (ack written to /diagnostics/<device>/commandAck)
+#define CMD_TRACE_SLOTS           4         // commands followed concurrently
+#define CMD_TRACE_TIMEOUT_MS      60000UL   // give up waiting for commit/sync ack
+
+// Telemetry Log (append-only flash ring on LittleFS, backfilled to Firestore)
+#define TLOG_SEGMENT_RECORDS      256       // 32-byte records per segment file (8 KB)
+#define TLOG_MAX_SEGMENTS         48        // ~384 KB cap; oldest segment dropped when full
+#define TLOG_BATCH_RECORDS        60        // samples averaged into one Firestore entry
+#define TLOG_BATCH_WINDOW_S       600       // max time span of one entry (10 min)
+#define TLOG_BACKFILL_PER_MIN     6         // token-bucket refill rate for uploads
+#define TLOG_BACKFILL_BURST       2
+#define TLOG_BACKFILL_MAX_QUEUE   2         // only upload while the outbound queue is this shallow
+
+// Control Trace Recorder (binary flash ring for host replay, see sim/replay)
+#define TRACE_ENABLED             false
+#define TRACE_SEGMENT_BYTES       16384     // segment file size; each segment opens with a state snapshot
+#define TRACE_MAX_SEGMENTS        24        // ~384 KB cap; oldest segment dropped when full
+#define TRACE_BUFFER_BYTES        1024      // RAM staging buffer between flash writes
+#define TRACE_FLUSH_MS            5000UL    // max age of buffered records (lost on power cut)
+#define TRACE_DUMP_KEY            'T'       // send over Serial to dump the ring as "#TRACE" hex lines
+
+// MQTT Transport (optional; persistent connection to a local broker)
+#define MQTT_ENABLED              false
+#define MQTT_BROKER_HOST          "192.168.1.10"
+#define MQTT_BROKER_PORT          1883
+#define MQTT_CLIENT_ID            "aquabell_esp32"
+#define MQTT_TOPIC_PREFIX         "aquabell/aquabell_esp32"   // <prefix>/live, /relays, /status, /commands
+#define MQTT_KEEPALIVE_S          30
+#define MQTT_BUFFER_SIZE          1024
+#define MQTT_RECONNECT_MS         5000UL    // first retry after a failed connect
+#define MQTT_RECONNECT_MAX_MS     300000UL  // retry interval doubles per failure up to this
+#define MQTT_CONNECT_TIMEOUT_MS   1000      // TCP connect to the broker (runs inside loop())
+#define MQTT_TELEMETRY_ONLY       false     // true: skip RTDB live pushes while the broker is connected
+
+// Time Sync (ESP-IDF SNTP, background polling)
+#define TIME_SYNC_INTERVAL_MS     (24UL * 60UL * 60UL * 1000UL)
+
+// WiFi Management (event-driven, non-blocking reconnects)
+#define WIFI_CONNECT_TIMEOUT_MS   10000UL   // one association attempt
+#define WIFI_RETRY_MIN_MS         500UL     // backoff after a failed attempt, doubling...
+#define WIFI_RETRY_MAX_MS         30000UL   // ...up to this
+#define WIFI_MAX_LISTENERS        4
 
 // WiFi Credentials
 #define WIFI_SSID                 "meow"
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free multi-producer / single-consumer ring buffer (bounded, Vyukov style).
+// push() may be called from any task, pop() only from one consumer task.
+// Each slot carries a sequence number: producers claim a slot with one CAS on
+// head_ and publish it by bumping the sequence, so a full ring never blocks a
+// producer. A producer preempted between claim and publish only delays the
+// consumer at that slot. N must be a power of two.
+template <typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRing size must be a power of two");
+
+public:
+    MpscRing() {
+        for (size_t i = 0; i < N; i++) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Producer side: returns false (item not stored) when the ring is full
+    bool push(const T &item) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & (N - 1)];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                // Slot free for this lap; on success we own it
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.seq.store(pos + 1, std::memory_order_release); // publish after the copy
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // consumer has not freed this slot yet
+            } else {
+                pos = head_.load(std::memory_order_relaxed);   // another producer took it
+            }
+        }
+    }
+
+    // Consumer side: returns false when the ring is empty (or the next slot is not yet published)
+    bool pop(T &out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[tail & (N - 1)];
+        if (cell.seq.load(std::memory_order_acquire) != tail + 1) return false;
+
+        out = cell.item;
+        cell.seq.store(tail + N, std::memory_order_release); // free for the next lap
+        tail_.store(tail + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Claimed slots, published or not (approximate while producers run)
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return head - tail;
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T item;
+    };
+
+    Cell cells_[N];
+    std::atomic<size_t> head_{0};   // next position to claim (producers)
+    std::atomic<size_t> tail_{0};   // next position to read (consumer)
+};
@@ -2,78 +2,93 @@
 #include <Arduino.h>
 #include <math.h>
 #include <stdint.h>
+#include "actuator_table.h"
 
 // Centralized actuator state management
-
+// Flags are bit-packed per category; the *Bits member of each category
+// reads/writes the whole group at once (compare, XOR-diff, reset).
+// Only the loop task writes this struct: bitfields in one word are not atomic.
 struct ActuatorState {
-    // Current physical states
-    bool fan = false;
-    bool light = false;
-    bool pump = false;
-    bool valve = false;
-    bool cooler = false;
-    bool heater = false;
-    bool phLowering = false;
-    bool phRaising = false;
-    bool phDosingEnabled = true;
-    bool waterChange = false;
-    bool sumpCleaning = false;
-    bool sumpWaterValve = false;
-    bool sumpDrainValve = false;
+    // Current states (bits 0-10 follow RelayId order; table actuators first)
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_STATE_FLAG)
+            bool phLowering : 1;
+            bool phRaising : 1;
+            bool waterChange : 1;
+            bool sumpWaterValve : 1;
+            bool sumpDrainValve : 1;
+            bool phDosingEnabled : 1;
+            bool sumpCleaning : 1;
+        };
+        uint16_t stateBits;
+    };
 
     // Control modes
-    bool fanAuto = true;
-    bool lightAuto = true;
-    bool pumpAuto = true;
-    bool valveAuto = true;
-    bool coolerAuto = true;
-    bool heaterAuto = true;
-    bool phLoweringAuto = true;
-    bool phRaisingAuto = true;
-    bool waterChangeAuto = true;
-    bool sumpCleaningAuto = true;
-    bool sumpWaterValveAuto = true;
-    bool sumpDrainValveAuto = true;
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_AUTO_FLAG)
+            bool phLoweringAuto : 1;
+            bool phRaisingAuto : 1;
+            bool waterChangeAuto : 1;
+            bool sumpWaterValveAuto : 1;
+            bool sumpDrainValveAuto : 1;
+            bool sumpCleaningAuto : 1;
+        };
+        uint16_t autoBits;
+    };
 
     // Emergency overrides
-    bool emergencyMode = false;
-    bool lowWaterEmergency = false;
-    
+    union {
+        struct {
+            bool emergencyMode : 1;
+            bool lowWaterEmergency : 1;
+        };
+        uint8_t emergencyBits;
+    };
+
     // Manual overrides
-    bool fanManual = false;
-    bool lightManual = false;
-    bool pumpManual = false;
-    bool valveManual = false;
-    bool coolerManual = false;
-    bool heaterManual = false;
-    bool waterChangeManual = false;
-    bool sumpCleaningManual = false;
-    bool sumpWaterValveManual = false;
-    bool sumpDrainValveManual = false;
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_MANUAL_FLAG)
+            bool waterChangeManual : 1;
+            bool sumpCleaningManual : 1;
+            bool sumpWaterValveManual : 1;
+            bool sumpDrainValveManual : 1;
+        };
+        uint16_t manualBits;
+    };
 
     // Manual values (when manual mode is active)
-    bool fanManualValue = false;
-    bool lightManualValue = false;
-    bool pumpManualValue = false;
-    bool valveManualValue = false;
-    bool coolerManualValue = false;
-    bool heaterManualValue = false;
-    bool waterChangeManualValue = false;
-    bool sumpCleaningManualValue = false;
-    bool sumpWaterValveManualValue = false;
-    bool sumpDrainValveManualValue = false;
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_MANUAL_VALUE_FLAG)
+            bool waterChangeManualValue : 1;
+            bool sumpCleaningManualValue : 1;
+            bool sumpWaterValveManualValue : 1;
+            bool sumpDrainValveManualValue : 1;
+        };
+        uint16_t manualValueBits;
+    };
+
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_JUST_ENABLED_FLAG)
+            bool phDosingJustEnabled : 1;
+            bool waterChangeAutoJustEnabled : 1;
+            bool sumpCleaningAutoJustEnabled : 1;
+            bool sumpWaterValveAutoJustEnabled : 1;
+            bool sumpDrainValveAutoJustEnabled : 1;
+        };
+        uint16_t justEnabledBits;
+    };
 
-    bool fanAutoJustEnabled = false;
-    bool lightAutoJustEnabled = false;
-    bool pumpAutoJustEnabled = false;
-    bool valveAutoJustEnabled = false;
-    bool coolerAutoJustEnabled = false;
-    bool heaterAutoJustEnabled = false;
-    bool phDosingJustEnabled = false;
-    bool waterChangeAutoJustEnabled = false;
-    bool sumpCleaningAutoJustEnabled = false;
-    bool sumpWaterValveAutoJustEnabled = false;
-    bool sumpDrainValveAutoJustEnabled = false;
+    // Everything off, every actuator in AUTO, pH dosing enabled
+    ActuatorState()
+        : stateBits(0), autoBits(0x0FFF), emergencyBits(0),
+          manualBits(0), manualValueBits(0), justEnabledBits(0) {
+        phDosingEnabled = true;
+    }
 };
 
 struct RealTimeData {
@@ -85,19 +100,28 @@ struct RealTimeData {
     float airHumidity = NAN;
     bool floatTriggered = 0; // 0 = false, 1 = true
 
-    struct {
-        bool fan;
-        bool light;
-        bool waterPump;
-        bool valve;
-        bool cooler;
-        bool heater;
-        bool phLowering;
-        bool phRaising;
-        bool waterChange;
-        bool sumpCleaning;
-        bool sumpWaterValve;
-        bool sumpDrainValve;
+    union {
+        struct {
+            ACTUATOR_TABLE(ACTUATOR_RELAY_FIELD)
+            bool phLowering : 1;
+            bool phRaising : 1;
+            bool waterChange : 1;
+            bool sumpCleaning : 1;
+            bool sumpWaterValve : 1;
+            bool sumpDrainValve : 1;
+        };
+        uint16_t bits;
+    } relayStates = {};
+};
+
+// Copy the table actuators' states into relayStates (same bit order in both)
+inline void reflect_actuator_relays(RealTimeData &data, const ActuatorState &actuators) {
+    data.relayStates.bits = (data.relayStates.bits & ~ACTUATOR_MASK) | (actuators.stateBits & ACTUATOR_MASK);
+}
 
-    } relayStates;
+// Timestamped sensor sample published by the acquisition task
+struct SensorSample {
+    uint32_t timestamp = 0;   // millis() when the sample was taken
+    RealTimeData data;
+    bool updated[5] = {false, false, false, false, false}; // waterTemp, pH, DO, turbidity, air
 };
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// push() may only be called from one task and pop() from one other task.
+// One slot stays empty to tell "full" from "empty"; N must be a power of two.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    // Producer side: returns false (item not stored) when the ring is full
+    bool push(const T &item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (N - 1);
+        if (next == tail_.load(std::memory_order_acquire)) return false;
+
+        buf_[head] = item;
+        head_.store(next, std::memory_order_release); // publish after the copy
+        return true;
+    }
+
+    // Consumer side: returns false when the ring is empty
+    bool pop(T &out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+
+        out = buf_[tail];
+        tail_.store((tail + 1) & (N - 1), std::memory_order_release); // free slot after the copy
+        return true;
+    }
+
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return (head - tail) & (N - 1);
+    }
+
+    static constexpr size_t capacity() { return N - 1; }
+
+private:
+    T buf_[N];
+    std::atomic<size_t> head_{0};   // next slot to write (producer)
+    std::atomic<size_t> tail_{0};   // next slot to read (consumer)
+};
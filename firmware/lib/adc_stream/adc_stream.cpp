@@ -0,0 +1,188 @@
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <algorithm>
+#include "config.h"
+#include "adc_stream.h"
+
+// ADC1 channels behind the sensor pins
+#define ADC_CH_PH         ADC1_CHANNEL_3   // GPIO39
+#define ADC_CH_DO         ADC1_CHANNEL_6   // GPIO34
+#define ADC_CH_TURBIDITY  ADC1_CHANNEL_7   // GPIO35
+
+#define ADC_DMA_READ_LEN  256              // bytes drained per read call
+#define ADC_RESULT_BYTES  SOC_ADC_DIGI_RESULT_BYTES
+
+// The sensor task drains every SENSOR_TASK_PERIOD_MS; the driver ring must
+// hold at least two periods of conversions or it overflows between polls
+static_assert(ADC_DMA_BUFFER_BYTES >=
+              2UL * ADC_DMA_SAMPLE_FREQ_HZ * ADC_RESULT_BYTES * SENSOR_TASK_PERIOD_MS / 1000,
+              "ADC_DMA_BUFFER_BYTES too small for the sensor task period");
+
+static bool streamActive = false;
+
+// Samples of the frame being built, per channel
+struct ChannelSamples {
+    uint16_t raw[ADC_DMA_FRAME_SAMPLES];
+    uint16_t count;
+};
+static ChannelSamples phSamples, doSamples, turbSamples;
+
+static AdcFrame latestFrame;
+static bool frameAvailable = false;
+static unsigned long lastFrameMs = 0;
+static AdcStreamStats stats;
+
+static inline float rawToMv(float raw) {
+    return raw * ADC_VOLTAGE_MV / ADC_MAX;
+}
+
+static inline void addSample(ChannelSamples &c, uint16_t raw) {
+    if (c.count < ADC_DMA_FRAME_SAMPLES) c.raw[c.count++] = raw;
+}
+
+static void resetFrame() {
+    phSamples.count = doSamples.count = turbSamples.count = 0;
+}
+
+// Drop the top/bottom ADC_DMA_TRIM_PCT % and average the rest (as read_ph_voltage_avg())
+static float trimmedMean(ChannelSamples &c) {
+    std::sort(c.raw, c.raw + c.count);
+    uint16_t trim = c.count * ADC_DMA_TRIM_PCT / 100;
+    uint32_t sum = 0;
+    for (uint16_t i = trim; i < c.count - trim; i++) sum += c.raw[i];
+    return sum / float(c.count - 2 * trim);
+}
+
+static void publishFrame() {
+    latestFrame.phMv = rawToMv(trimmedMean(phSamples));
+    latestFrame.doMv = rawToMv(trimmedMean(doSamples));
+    latestFrame.turbidityMv = rawToMv(trimmedMean(turbSamples));
+    latestFrame.timestamp = millis();
+    lastFrameMs = latestFrame.timestamp;
+    frameAvailable = true;
+    stats.frames++;
+    resetFrame();
+}
+
+// No frame for ADC_DMA_STALE_MS: restart the controller, which also clears
+// the driver's sticky overflow state
+static void restartStream(unsigned long now) {
+    adc_digi_stop();
+    adc_digi_start();
+    resetFrame();
+    lastFrameMs = now;
+    stats.restarts++;
+    Serial.printf("[ADC] ⚠️ No DMA frame for %lu ms — controller restarted\n", (unsigned long)ADC_DMA_STALE_MS);
+}
+
+bool adc_stream_init() {
+    if (streamActive) return true;
+
+    adc_digi_init_config_t initCfg = {};
+    initCfg.max_store_buf_size = ADC_DMA_BUFFER_BYTES;
+    initCfg.conv_num_each_intr = ADC_DMA_READ_LEN;
+    initCfg.adc1_chan_mask = BIT(ADC_CH_PH) | BIT(ADC_CH_DO) | BIT(ADC_CH_TURBIDITY);
+    initCfg.adc2_chan_mask = 0;
+
+    if (adc_digi_initialize(&initCfg) != ESP_OK) {
+        Serial.println("[ADC] ❌ DMA init failed — using analogRead()");
+        return false;
+    }
+
+    static adc_digi_pattern_config_t pattern[3] = {};
+    const adc_channel_t channels[3] = {
+        (adc_channel_t)ADC_CH_PH, (adc_channel_t)ADC_CH_DO, (adc_channel_t)ADC_CH_TURBIDITY
+    };
+    for (int i = 0; i < 3; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channels[i] & 0x7;
+        pattern[i].unit = 0; // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_configuration_t digCfg = {};
+    digCfg.conv_limit_en = 1;              // required on the ESP32
+    digCfg.conv_limit_num = 250;
+    digCfg.pattern_num = 3;
+    digCfg.adc_pattern = pattern;
+    digCfg.sample_freq_hz = ADC_DMA_SAMPLE_FREQ_HZ;
+    digCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+    if (adc_digi_controller_configure(&digCfg) != ESP_OK || adc_digi_start() != ESP_OK) {
+        Serial.println("[ADC] ❌ DMA configure/start failed — using analogRead()");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    streamActive = true;
+    resetFrame();
+    lastFrameMs = millis();
+    Serial.println("✅ ADC DMA acquisition started (pH, DO, turbidity).");
+    return true;
+}
+
+bool adc_stream_active() {
+    return streamActive;
+}
+
+bool adc_stream_poll() {
+    if (!streamActive) return false;
+
+    static uint8_t buf[ADC_DMA_READ_LEN];
+    bool completed = false;
+    uint32_t start = micros();
+
+    // Drain everything currently buffered; timeout 0 = never wait
+    while (true) {
+        uint32_t len = 0;
+        esp_err_t err = adc_digi_read_bytes(buf, sizeof(buf), &len, 0);
+        // INVALID_STATE = the driver ring overflowed and conversions were lost;
+        // the `len` bytes returned are still valid samples
+        if (err == ESP_ERR_INVALID_STATE) stats.overflows++;
+        else if (err != ESP_OK) break;
+        if (len == 0) break;
+        stats.bytes += len;
+
+        for (uint32_t i = 0; i + ADC_RESULT_BYTES <= len; i += ADC_RESULT_BYTES) {
+            const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[i];
+            switch (p->type1.channel) {
+                case ADC_CH_PH:        addSample(phSamples, p->type1.data);   break;
+                case ADC_CH_DO:        addSample(doSamples, p->type1.data);   break;
+                case ADC_CH_TURBIDITY: addSample(turbSamples, p->type1.data); break;
+                default: continue;
+            }
+
+            // Publish a frame as soon as every channel has enough samples
+            if (phSamples.count == ADC_DMA_FRAME_SAMPLES && doSamples.count == ADC_DMA_FRAME_SAMPLES &&
+                turbSamples.count == ADC_DMA_FRAME_SAMPLES) {
+                publishFrame();
+                completed = true;
+            }
+        }
+    }
+
+    unsigned long now = millis();
+    if (!completed && now - lastFrameMs >= ADC_DMA_STALE_MS) restartStream(now);
+
+    uint32_t us = micros() - start;
+    stats.lastPollUs = us;
+    if (us > stats.maxPollUs) stats.maxPollUs = us;
+    return completed;
+}
+
+bool adc_stream_latest(AdcFrame &out) {
+    if (!frameAvailable || millis() - latestFrame.timestamp >= ADC_DMA_STALE_MS) return false;
+    out = latestFrame;
+    return true;
+}
+
+const AdcStreamStats &adc_stream_stats() {
+    return stats;
+}
+
+void adc_stream_log_stats() {
+    Serial.printf("[ADC] frames=%lu bytes=%lu overflows=%lu restarts=%lu | poll last %lu us, max %lu us\n",
+                  (unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long)stats.overflows,
+                  (unsigned long)stats.restarts, (unsigned long)stats.lastPollUs, (unsigned long)stats.maxPollUs);
+}
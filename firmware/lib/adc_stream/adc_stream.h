@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+
+// === Continuous ADC1 acquisition (DMA) ===
+// Samples the pH, DO and turbidity pins in the background and hands out
+// frames of trimmed-mean voltages, so sensor reads no longer busy-wait on
+// analogRead().
+
+struct AdcFrame {
+    float phMv = 0.0f;          // PH_SENSOR_PIN (GPIO39, ADC1_CH3)
+    float doMv = 0.0f;          // DO_SENSOR_PIN (GPIO34, ADC1_CH6)
+    float turbidityMv = 0.0f;   // TURBIDITY_PIN (GPIO35, ADC1_CH7)
+    uint32_t timestamp = 0;     // millis() when the frame completed
+};
+
+struct AdcStreamStats {
+    uint32_t frames = 0;
+    uint32_t bytes = 0;         // conversion bytes drained
+    uint32_t overflows = 0;     // reads reporting conversions lost to a full driver ring
+    uint32_t restarts = 0;      // controller restarts after ADC_DMA_STALE_MS without a frame
+    uint32_t lastPollUs = 0;    // time spent in adc_stream_poll()
+    uint32_t maxPollUs = 0;
+};
+
+// Start the DMA driver; returns false if it could not be started
+// (callers then fall back to analogRead()).
+bool adc_stream_init();
+
+// True once the DMA driver is running
+bool adc_stream_active();
+
+// Drain whatever the DMA has produced so far (never blocks).
+// Call often; returns true when a new averaged frame completed.
+bool adc_stream_poll();
+
+// Copy the latest completed frame; returns false if none is available yet
+// or the newest one is ADC_DMA_STALE_MS old
+bool adc_stream_latest(AdcFrame &out);
+
+const AdcStreamStats &adc_stream_stats();
+void adc_stream_log_stats();
@@ -0,0 +1,71 @@
+#include <Arduino.h>
+#include "esp_system.h"
+#include "config.h"
+#include "boot_profiler.h"
+
+struct StageRecord {
+    const char *name;
+    uint32_t startUs;
+    uint32_t endUs;
+    uint8_t core;
+};
+
+static const char *const MILESTONE_NAMES[BOOT_MILESTONE_COUNT] = {
+    "firstSensorReading", "firstControlDecision", "wifiUp",
+};
+
+static StageRecord stages[BOOT_MAX_STAGES];
+static uint8_t stageCount = 0;
+static uint32_t milestoneUs[BOOT_MILESTONE_COUNT];   // 0 = not reached
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+
+void boot_stage_record(const char *name, int64_t startUs, int64_t endUs) {
+    portENTER_CRITICAL(&bootMux);
+    if (stageCount < BOOT_MAX_STAGES) {
+        stages[stageCount++] = { name, (uint32_t)startUs, (uint32_t)endUs, (uint8_t)xPortGetCoreID() };
+    }
+    portEXIT_CRITICAL(&bootMux);
+}
+
+void boot_milestone(BootMilestone milestone) {
+    if (milestoneUs[milestone]) return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&bootMux);
+    if (!milestoneUs[milestone]) milestoneUs[milestone] = now ? now : 1;
+    portEXIT_CRITICAL(&bootMux);
+
+    Serial.printf("[BOOT] ⏱️ %s at %lu ms\n", MILESTONE_NAMES[milestone], (unsigned long)(now / 1000));
+}
+
+void boot_log_report() {
+    Serial.println("[BOOT] stage          core   start     end  (ms)");
+    for (uint8_t i = 0; i < stageCount; i++) {
+        const StageRecord &s = stages[i];
+        Serial.printf("[BOOT] %-14s %4u %7.1f %7.1f  (%.1f)\n", s.name, s.core,
+                      s.startUs / 1000.0f, s.endUs / 1000.0f, (s.endUs - s.startUs) / 1000.0f);
+    }
+    for (uint8_t m = 0; m < BOOT_MILESTONE_COUNT; m++) {
+        if (milestoneUs[m]) Serial.printf("[BOOT] %-22s %7.1f ms\n", MILESTONE_NAMES[m], milestoneUs[m] / 1000.0f);
+        else Serial.printf("[BOOT] %-22s not reached\n", MILESTONE_NAMES[m]);
+    }
+}
+
+void boot_to_json(JsonDocument &doc) {
+    doc["timestamp"] = time(nullptr);
+    doc["resetReason"] = (int)esp_reset_reason();
+
+    JsonObject milestones = doc["milestonesMs"].to<JsonObject>();
+    for (uint8_t m = 0; m < BOOT_MILESTONE_COUNT; m++) {
+        if (milestoneUs[m]) milestones[MILESTONE_NAMES[m]] = milestoneUs[m] / 1000.0f;
+    }
+
+    JsonArray list = doc["stages"].to<JsonArray>();
+    for (uint8_t i = 0; i < stageCount; i++) {
+        JsonObject o = list.add<JsonObject>();
+        o["name"] = stages[i].name;
+        o["core"] = stages[i].core;
+        o["startMs"] = stages[i].startUs / 1000.0f;
+        o["endMs"] = stages[i].endUs / 1000.0f;
+    }
+}
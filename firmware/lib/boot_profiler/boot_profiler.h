@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "esp_timer.h"
+
+// === Boot timeline profiler ===
+// Records when each init stage ran (start/end, core) and when the first
+// occurrence of each boot milestone happened, relative to app start
+// (esp_timer). Stages may run concurrently on both cores.
+
+enum BootMilestone : uint8_t {
+    BOOT_FIRST_SENSOR_READING = 0,   // first sample seen by the control loop
+    BOOT_FIRST_CONTROL_DECISION,     // first rule engine pass that drove the relays
+    BOOT_WIFI_UP,                    // got IP
+    BOOT_MILESTONE_COUNT
+};
+
+void boot_stage_record(const char *name, int64_t startUs, int64_t endUs);
+
+// First call per milestone wins; later calls are ignored
+void boot_milestone(BootMilestone milestone);
+
+void boot_log_report();
+void boot_to_json(JsonDocument &doc);
+
+// Times the enclosing scope as one named stage
+struct BootStage {
+    const char *name;
+    int64_t start;
+    explicit BootStage(const char *n) : name(n), start(esp_timer_get_time()) {}
+    ~BootStage() { boot_stage_record(name, start, esp_timer_get_time()); }
+};
+
+#define BOOT_CONCAT_(a, b) a##b
+#define BOOT_CONCAT(a, b)  BOOT_CONCAT_(a, b)
+#define BOOT_STAGE(name)   BootStage BOOT_CONCAT(_bootStage, __LINE__)(name)
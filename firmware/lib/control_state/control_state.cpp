@@ -0,0 +1,105 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include "esp_attr.h"
+#include "config.h"
+#include "control_state.h"
+
+#define CTRL_NVS_NAMESPACE   "ctrl"
+#define CTRL_LAYOUT_VERSION  1
+#define RTC_CHECKPOINT_MAGIC 0x52554C45u   // "RULE"
+
+// Only the user-set part of Commands; one-shot requests and device-owned
+// inProgress flags are never persisted
+struct __attribute__((packed)) SavedCommands {
+    CommandState actuators[ACTUATOR_COUNT];
+    PhDosingCommandState phDosing;
+};
+
+struct RtcCheckpoint {
+    uint32_t magic;
+    RuleCheckpoint rules;
+    uint32_t check;
+};
+
+RTC_NOINIT_ATTR static RtcCheckpoint rtcCheckpoint;
+
+static SavedCommands lastSaved;
+static bool lastSavedValid = false;
+
+static uint32_t checksum(const void *data, size_t len) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static SavedCommands savedFrom(const Commands &commands) {
+    SavedCommands saved;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) saved.actuators[i] = commands.*ACTUATORS[i].command;
+    saved.phDosing = commands.phDosing;
+    return saved;
+}
+
+// ===== Commands (NVS) =====
+bool control_state_load_commands(Commands &out) {
+    Preferences prefs;
+    if (!prefs.begin(CTRL_NVS_NAMESPACE, true)) return false;
+
+    SavedCommands saved;
+    bool ok = prefs.getUChar("ver", 0) == CTRL_LAYOUT_VERSION &&
+              prefs.getBytes("cmds", &saved, sizeof(saved)) == sizeof(saved);
+    prefs.end();
+    if (!ok) {
+        Serial.println("[State] No saved commands — waiting for Firebase");
+        return false;
+    }
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) out.*ACTUATORS[i].command = saved.actuators[i];
+    out.phDosing = saved.phDosing;
+    lastSaved = saved;
+    lastSavedValid = true;
+
+    Serial.print("[State] ↩️ Commands restored from NVS -");
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const CommandState &cmd = saved.actuators[i];
+        Serial.printf(" %s:%s", ACTUATORS[i].name, cmd.isAuto ? "AUTO" : cmd.value ? "ON" : "OFF");
+    }
+    Serial.println();
+    return true;
+}
+
+void control_state_save_commands(const Commands &commands) {
+    SavedCommands saved = savedFrom(commands);
+    if (lastSavedValid && memcmp(&saved, &lastSaved, sizeof(saved)) == 0) return;
+
+    Preferences prefs;
+    if (!prefs.begin(CTRL_NVS_NAMESPACE, false)) return;
+    prefs.putUChar("ver", CTRL_LAYOUT_VERSION);
+    bool ok = prefs.putBytes("cmds", &saved, sizeof(saved)) == sizeof(saved);
+    prefs.end();
+
+    if (ok) {
+        lastSaved = saved;
+        lastSavedValid = true;
+        Serial.println("[State] Commands saved to NVS");
+    }
+}
+
+// ===== Rule timers (RTC slow memory) =====
+void control_state_checkpoint(const RuleCheckpoint &checkpoint) {
+    rtcCheckpoint.magic = RTC_CHECKPOINT_MAGIC;
+    rtcCheckpoint.rules = checkpoint;
+    rtcCheckpoint.check = checksum(&rtcCheckpoint.rules, sizeof(rtcCheckpoint.rules));
+}
+
+bool control_state_restore(RuleCheckpoint &out) {
+    // Power-on leaves RTC memory random: magic + checksum reject it
+    if (rtcCheckpoint.magic != RTC_CHECKPOINT_MAGIC ||
+        rtcCheckpoint.check != checksum(&rtcCheckpoint.rules, sizeof(rtcCheckpoint.rules))) {
+        return false;
+    }
+    out = rtcCheckpoint.rules;
+    rtcCheckpoint.magic = 0;   // consume once
+    Serial.println("[State] ↩️ Rule timers restored from RTC memory");
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+#include "commands.h"
+#include "rule_engine.h"
+
+// === Control state persistence ===
+// The last /commands snapshot lives in NVS (survives power loss) so control
+// resumes at boot without waiting for Firebase; the rule timer checkpoint
+// lives in RTC slow memory (survives resets, watchdog and panics, not power loss).
+
+// Load the saved commands; false on first boot or after a layout change
+bool control_state_load_commands(Commands &out);
+
+// Save when the user-set fields (isAuto/value, pH dosing) changed since the last write
+void control_state_save_commands(const Commands &commands);
+
+void control_state_checkpoint(const RuleCheckpoint &checkpoint);
+bool control_state_restore(RuleCheckpoint &out);
@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <time.h>
+#include "config.h"
+#include "commands.h"
+#include "firebase.h"
+#include "command_trace.h"
+#include "logger.h"
+
+enum TraceStage : uint8_t {
+    TRACE_FREE = 0,
+    TRACE_WAIT_COMMIT,     // relays not settled yet
+    TRACE_WAIT_SYNC,       // committed, waiting for a relay sync to be queued
+    TRACE_WAIT_ACK,        // committed and sync queued, waiting for delivery
+};
+
+struct CommandTrace {
+    TraceStage stage = TRACE_FREE;
+    uint16_t mask = 0;
+    uint16_t syncMask = 0;          // AUTO actuators: acked by the relay sync
+    uint16_t unacked = 0;           // syncMask bits not yet in a delivered sync
+    bool syncQueued = false;        // a sync carrying unacked keys is in the queue
+    uint32_t seq = 0;
+    const char *source = "";
+    time_t receivedAt = 0;          // wall clock, for matching against the UI write
+    unsigned long startMillis = 0;  // timeout reference
+    uint32_t receivedUs = 0;
+    uint32_t committedUs = 0;
+    uint32_t submittedUs = 0;
+};
+
+static CommandTrace traces[CMD_TRACE_SLOTS];
+static CommandTraceStats stats;
+static uint32_t nextSeq = 1;
+
+static void writeAck(const CommandTrace &t, uint32_t ackedUs, bool timedOut) {
+    JsonDocument doc;
+    doc["seq"] = t.seq;
+    doc["source"] = t.source;
+    doc["receivedAt"] = (long long)t.receivedAt;
+
+    JsonArray actuators = doc["actuators"].to<JsonArray>();
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (t.mask & (1u << i)) actuators.add(ACTUATORS[i].name);
+    }
+
+    if (t.stage >= TRACE_WAIT_SYNC) doc["commitMs"] = (t.committedUs - t.receivedUs) / 1000.0f;
+    // Queued before the commit (the command handler's own push): no queue wait
+    if (t.stage == TRACE_WAIT_ACK) doc["queueMs"] = (int32_t)(t.submittedUs - t.committedUs) > 0
+                                                    ? (t.submittedUs - t.committedUs) / 1000.0f : 0.0f;
+    if (!timedOut) {
+        if (t.syncMask) doc["ackMs"] = (ackedUs - t.submittedUs) / 1000.0f;
+        doc["totalMs"] = (ackedUs - t.receivedUs) / 1000.0f;
+    }
+    doc["synced"] = t.syncMask != 0;
+    doc["timedOut"] = timedOut;
+
+    appendDiagnostics("commandAck", doc);
+}
+
+static void finish(CommandTrace &t, uint32_t ackedUs, bool timedOut) {
+    if (timedOut) {
+        stats.timedOut++;
+        LOGW(CMD_TRACE, "⚠️ Command #%lu (%s) timed out at stage %u",
+             (unsigned long)t.seq, t.source, t.stage);
+    } else {
+        uint32_t commitUs = t.committedUs - t.receivedUs;
+        uint32_t totalUs = ackedUs - t.receivedUs;
+        stats.completed++;
+        stats.sumCommitUs += commitUs;
+        stats.sumTotalUs += totalUs;
+        if (commitUs > stats.maxCommitUs) stats.maxCommitUs = commitUs;
+        if (totalUs > stats.maxTotalUs) stats.maxTotalUs = totalUs;
+        if (t.syncMask) {
+            LOGI(CMD_TRACE, "Command #%lu (%s): relay %.1f ms, synced %.1f ms",
+                 (unsigned long)t.seq, t.source, commitUs / 1000.0f, totalUs / 1000.0f);
+        } else {
+            LOGI(CMD_TRACE, "Command #%lu (%s, manual): relay %.1f ms",
+                 (unsigned long)t.seq, t.source, commitUs / 1000.0f);
+        }
+    }
+
+    writeAck(t, ackedUs, timedOut);
+    t.stage = TRACE_FREE;
+}
+
+void cmd_trace_received(uint16_t actuatorMask, uint16_t autoMask, uint32_t receivedUs, const char *source) {
+    actuatorMask &= ACTUATOR_MASK;
+    if (!actuatorMask) return;
+
+    for (auto &t : traces) {
+        if (t.stage != TRACE_FREE) continue;
+
+        t.stage = TRACE_WAIT_COMMIT;
+        t.mask = actuatorMask;
+        t.syncMask = actuatorMask & autoMask;
+        t.unacked = t.syncMask;
+        t.syncQueued = false;
+        t.seq = nextSeq++;
+        t.source = source;
+        t.receivedAt = time(nullptr);
+        t.startMillis = millis();
+        t.receivedUs = receivedUs;
+        stats.traced++;
+        return;
+    }
+    stats.dropped++;
+}
+
+void cmd_trace_poll(uint16_t pendingMask, unsigned long nowMillis) {
+    uint32_t nowUs = micros();
+    for (auto &t : traces) {
+        if (t.stage == TRACE_FREE) continue;
+
+        if (t.stage == TRACE_WAIT_COMMIT && !(pendingMask & t.mask)) {
+            t.committedUs = nowUs;
+            t.stage = TRACE_WAIT_SYNC;
+            // MANUAL only: the relays now match the user's write, nothing to sync.
+            // Otherwise the sync may already be delivered or queued.
+            if (!t.unacked) {
+                finish(t, nowUs, false);
+                continue;
+            }
+            if (t.syncQueued) t.stage = TRACE_WAIT_ACK;
+        }
+        if (nowMillis - t.startMillis >= CMD_TRACE_TIMEOUT_MS) finish(t, nowUs, true);
+    }
+}
+
+void cmd_trace_sync_submitted(uint16_t keysMask) {
+    uint32_t nowUs = micros();
+    for (auto &t : traces) {
+        // A sync queued while the commit is pending carries the value the rules
+        // just requested (AUTO re-enable pushes from the command handler)
+        if (t.stage != TRACE_WAIT_COMMIT && t.stage != TRACE_WAIT_SYNC) continue;
+        if (!(t.unacked & keysMask)) continue;
+        t.submittedUs = nowUs;
+        t.syncQueued = true;
+        if (t.stage == TRACE_WAIT_SYNC) t.stage = TRACE_WAIT_ACK;
+    }
+}
+
+void cmd_trace_sync_done(bool ok, uint16_t keysMask) {
+    uint32_t nowUs = micros();
+    for (auto &t : traces) {
+        if (!t.syncQueued || !(t.unacked & keysMask)) continue;
+        if (!ok) {
+            t.syncQueued = false;           // retried with the next (full) sync
+            if (t.stage == TRACE_WAIT_ACK) t.stage = TRACE_WAIT_SYNC;
+            continue;
+        }
+        t.unacked &= ~keysMask;
+        if (t.unacked) continue;
+        t.syncQueued = false;
+        if (t.stage == TRACE_WAIT_ACK) finish(t, nowUs, false);   // else at the commit
+    }
+}
+
+const CommandTraceStats &cmd_trace_stats() {
+    return stats;
+}
+
+void cmd_trace_log_stats() {
+    uint32_t n = stats.completed;
+    Serial.printf("[Trace] commands=%lu completed=%lu timedOut=%lu dropped=%lu | relay avg=%.1f max=%.1f ms | synced avg=%.1f max=%.1f ms\n",
+                  (unsigned long)stats.traced, (unsigned long)n,
+                  (unsigned long)stats.timedOut, (unsigned long)stats.dropped,
+                  n ? stats.sumCommitUs / 1000.0f / n : 0.0f, stats.maxCommitUs / 1000.0f,
+                  n ? stats.sumTotalUs / 1000.0f / n : 0.0f, stats.maxTotalUs / 1000.0f);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+
+// === Command latency tracing ===
+// Follows each actuator command from the moment its event is received to
+// the relay commit and to the acknowledged relay-sync PATCH, then writes an
+// ack with a sequence number and the stage latencies as a new child of
+// /diagnostics/<device>/commandAck, so the acks form a history to take
+// percentiles over instead of overwriting each other.
+//
+//   received  → stream/MQTT callback entry
+//   committed → first relay_commit() after which none of the command's relays
+//               are still pending (includes min on/off holds)
+//   acked     → outbound queue reports a relay sync delivered whose body
+//               carries the command's AUTO actuators (includes the stream
+//               debounce and sync cooldown). A sync queued before the commit
+//               counts too: handing an actuator back to AUTO pushes the rules'
+//               new value from the command handler itself. The trace completes
+//               at whichever of commit and ack comes last.
+//
+// A MANUAL actuator's value is the user's own write and never appears in a
+// relay sync, so a command with only MANUAL actuators is complete at commit.
+
+struct CommandTraceStats {
+    uint32_t traced = 0;
+    uint32_t completed = 0;
+    uint32_t timedOut = 0;
+    uint32_t dropped = 0;           // no free slot when the command arrived
+    uint32_t maxCommitUs = 0;       // received → committed
+    uint32_t maxTotalUs = 0;        // received → acked (→ committed when nothing is synced)
+    uint64_t sumCommitUs = 0;
+    uint64_t sumTotalUs = 0;
+};
+
+// Start a trace for the actuators in `actuatorMask` (ActuatorIndex bits);
+// `autoMask` is commands_auto_mask() after the command was applied
+void cmd_trace_received(uint16_t actuatorMask, uint16_t autoMask, uint32_t receivedUs, const char *source);
+
+// After relay_commit(): settles traces whose relays are no longer pending,
+// expires stale ones. `pendingMask` is relay_pending_mask().
+void cmd_trace_poll(uint16_t pendingMask, unsigned long nowMillis);
+
+// Relay sync lifecycle (called by the firebase sync paths). `keysMask` holds
+// the actuators whose value key is in the body (the merged body when done).
+void cmd_trace_sync_submitted(uint16_t keysMask);
+void cmd_trace_sync_done(bool ok, uint16_t keysMask);
+
+const CommandTraceStats &cmd_trace_stats();
+void cmd_trace_log_stats();
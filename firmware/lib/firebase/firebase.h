@@ -1,63 +1,41 @@
 #pragma once
 #include "sensor_data.h"
+#include "commands.h"
+#include "rtdb_command_parser.h"
+#include "outbound_queue.h"
 #include <Arduino.h>
 #include <time.h>
 #include <FirebaseClient.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h> 
 
-// Command structure for RTDB
-struct CommandState {
-    bool isAuto;
-    bool value;
-};
-
-struct PhDosingCommandState {
-    bool phDosingEnabled;
-    bool value;
-};
-
-struct WaterChangeCommands {
-    bool manualChangeRequest;
-    bool manualChangeCancel;
-    bool inProgress = false;
-};
-
-struct SumpCleaningCommands {
-    bool manualCleanRequest;
-    bool manualCleanCancel;
-    bool inProgress = false;
-};
-struct Commands {
-    CommandState fan;
-    CommandState light;
-    CommandState pump;
-    CommandState valve;
-    CommandState cooler;
-    CommandState heater;
-    PhDosingCommandState phDosing;
-    WaterChangeCommands waterChange;
-    SumpCleaningCommands sumpCleaning;
-};
+#define DEVICE_ID "aquabell_esp32"
+#define RTDB_URL "https://aquabell-cap2025-default-rtdb.asia-southeast1.firebasedatabase.app"
 
 void pushToRTDBLive(const RealTimeData &data, const bool updatedSensors[6]);
-bool pushBatchLogToFirestore(RealTimeData *buffer, int size, time_t timestamp);
+// Averages the samples into one Firestore entry and queues it; onDone overrides the default log callback
+bool pushBatchLogToFirestore(RealTimeData *buffer, int size, time_t timestamp, OutboundDoneFn onDone = nullptr);
+// Overwrites /diagnostics/<device>/<node> with `doc` (low priority)
+bool pushDiagnostics(const char *node, const JsonDocument &doc);
+// Adds `doc` as a new child of /diagnostics/<device>/<node> (POST, low priority)
+bool appendDiagnostics(const char *node, const JsonDocument &doc);
 bool firebaseSignIn();
 bool fetchControlCommands();
-void syncRelayState(const RealTimeData &data, const Commands& commands);
+// Live data + relay state in one multi-location PATCH
+void pushLiveAndRelayState(const RealTimeData &data, const Commands& commands, const bool updatedSensors[6]);
 bool refreshIdToken();
 void safeTokenRefresh();
 // New FirebaseClient stream-based functions
 void startFirebaseStream();
 void handleFirebaseStream();
 void onRTDBStream(AsyncResult &result);
+// Manual overrides, AUTO re-enable and forced sync after a command update (stream or MQTT)
+void handleCommandPatch(const CommandPatchResult &patch, const char *source);
+// WiFi link listener: signs in / restarts the stream on up, drops sockets and resyncs on down
+void firebase_on_wifi(bool up);
 bool isStreamConnected();
 bool isFirebaseReady();
 bool isInitialCommandsSynced();
 
-// Helper function for processing patch events
-void processPatchEvent(const String& dataPath, JsonDocument& patchData, Commands& currentCommands, bool& hasChanges);
-
-// Non-blocking retry management
-bool processRetry();
-bool isRetryInProgress();
+// Prioritized outbound write queue (sends at most one request per call)
+bool processOutboundQueue();
@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include "config.h"
+#include "http_pool.h"
+
+struct PoolSlot {
+    String host;
+    WiFiClientSecure client;
+    HTTPClient http;
+    unsigned long lastUsed = 0;
+};
+
+static PoolSlot slots[HTTP_POOL_SIZE];
+static HttpPoolStats stats;
+
+// "https://host/path?query" → "host"
+static String hostOf(const String &url) {
+    int start = url.indexOf("://");
+    start = (start < 0) ? 0 : start + 3;
+    int end = url.indexOf('/', start);
+    return url.substring(start, end < 0 ? url.length() : end);
+}
+
+static void closeSlot(PoolSlot &slot) {
+    slot.http.end();
+    slot.client.stop();
+    slot.host = "";
+}
+
+// Find the slot already bound to `host`, else a free one, else evict the LRU slot
+static PoolSlot &slotFor(const String &host) {
+    PoolSlot *freeSlot = nullptr;
+    PoolSlot *lru = &slots[0];
+
+    for (auto &slot : slots) {
+        if (slot.host == host) return slot;
+        if (!freeSlot && slot.host.isEmpty()) freeSlot = &slot;
+        if (slot.lastUsed < lru->lastUsed) lru = &slot;
+    }
+
+    PoolSlot &slot = freeSlot ? *freeSlot : *lru;
+    if (!slot.host.isEmpty()) closeSlot(slot);
+
+    slot.host = host;
+    slot.client.setInsecure();
+    slot.client.setTimeout(HTTP_POOL_TIMEOUT_MS / 1000);
+    slot.http.setReuse(true);
+    slot.http.setTimeout(HTTP_POOL_TIMEOUT_MS);
+    return slot;
+}
+
+static int sendOnce(PoolSlot &slot, const char *method, const String &url, const String &payload,
+                    const char *contentType, const String &bearerToken, String *responseBody) {
+    if (slot.client.connected()) stats.handshakesAvoided++;
+    else stats.handshakes++;
+
+    if (!slot.http.begin(slot.client, url)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    if (contentType) slot.http.addHeader("Content-Type", contentType);
+    if (bearerToken.length() > 0) slot.http.addHeader("Authorization", "Bearer " + bearerToken);
+
+    int code = slot.http.sendRequest(method, payload);
+    if (responseBody) *responseBody = (code > 0) ? slot.http.getString() : String();
+
+    // end() drains any unread body and keeps the socket open when reusable
+    slot.http.end();
+    return code;
+}
+
+int http_pool_request(const char *method, const String &url, const String &payload,
+                      const char *contentType, const String &bearerToken, String *responseBody) {
+    unsigned long start = millis();
+    PoolSlot &slot = slotFor(hostOf(url));
+    bool wasConnected = slot.client.connected();
+
+    int code = sendOnce(slot, method, url, payload, contentType, bearerToken, responseBody);
+
+    // The server may have closed an idle keep-alive socket: retry once on a fresh one
+    if (code < 0 && wasConnected) {
+        slot.client.stop();
+        code = sendOnce(slot, method, url, payload, contentType, bearerToken, responseBody);
+    }
+
+    if (code < 0) {
+        stats.failures++;
+        slot.client.stop();
+    }
+
+    slot.lastUsed = millis();
+    uint32_t latency = slot.lastUsed - start;
+    stats.requests++;
+    stats.lastLatencyMs = latency;
+    stats.totalLatencyMs += latency;
+    if (latency > stats.maxLatencyMs) stats.maxLatencyMs = latency;
+
+    return code;
+}
+
+void http_pool_close_idle(unsigned long nowMillis) {
+    for (auto &slot : slots) {
+        if (!slot.host.isEmpty() && nowMillis - slot.lastUsed >= HTTP_POOL_IDLE_MS) {
+            closeSlot(slot);
+        }
+    }
+}
+
+void http_pool_close_all() {
+    for (auto &slot : slots) {
+        if (!slot.host.isEmpty()) closeSlot(slot);
+    }
+}
+
+const HttpPoolStats &http_pool_stats() {
+    return stats;
+}
+
+void http_pool_log_stats() {
+    uint32_t avg = stats.requests ? (uint32_t)(stats.totalLatencyMs / stats.requests) : 0;
+    Serial.printf("[HTTP] requests=%lu handshakes=%lu avoided=%lu failures=%lu latency last/avg/max=%lu/%lu/%lu ms\n",
+                  (unsigned long)stats.requests, (unsigned long)stats.handshakes,
+                  (unsigned long)stats.handshakesAvoided, (unsigned long)stats.failures,
+                  (unsigned long)stats.lastLatencyMs, (unsigned long)avg, (unsigned long)stats.maxLatencyMs);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+
+// === Keep-alive HTTPS connection pool ===
+// One persistent TLS socket per host (RTDB, Firestore, securetoken, ...)
+// reused across requests with HTTP keep-alive instead of a fresh
+// WiFiClientSecure + handshake for every call.
+
+struct HttpPoolStats {
+    uint32_t requests = 0;            // requests sent
+    uint32_t failures = 0;            // transport errors (negative HTTPClient codes)
+    uint32_t handshakes = 0;          // new TLS connections opened
+    uint32_t handshakesAvoided = 0;   // requests served on an already-open socket
+    uint32_t lastLatencyMs = 0;
+    uint32_t maxLatencyMs = 0;
+    uint64_t totalLatencyMs = 0;
+};
+
+// Send a request on the pooled connection for the URL's host.
+// Returns the HTTP status or a negative HTTPClient error code.
+// If responseBody is given it receives the body; otherwise the body is discarded.
+int http_pool_request(const char *method, const String &url, const String &payload,
+                      const char *contentType, const String &bearerToken = "",
+                      String *responseBody = nullptr);
+
+// Close sockets that have been idle longer than HTTP_POOL_IDLE_MS (frees TLS heap)
+void http_pool_close_idle(unsigned long nowMillis);
+
+// Drop every pooled socket (e.g. after WiFi loss)
+void http_pool_close_all();
+
+const HttpPoolStats &http_pool_stats();
+void http_pool_log_stats();
+
+// 2xx (incl. 204 No Content from print=silent) counts as success
+inline bool http_ok(int code) { return code >= 200 && code < 300; }
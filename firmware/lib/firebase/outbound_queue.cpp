@@ -0,0 +1,219 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "http_pool.h"
+#include "outbound_queue.h"
+#include "logger.h"
+
+#define OUTBOUND_DONE_MAX  4
+
+struct OutboundItem {
+    bool used = false;
+    OutboundPriority prio = OUT_PRIO_LOG;
+    OutboundAuth auth = OUT_AUTH_QUERY;
+    const char *method = "PATCH";
+    String url;
+    String payload;
+    OutboundDoneFn onDone[OUTBOUND_DONE_MAX] = {};   // distinct callbacks of the writes merged here
+    unsigned long createdAt = 0;
+    unsigned long deadline = 0;
+    unsigned long nextAttempt = 0;
+    uint8_t attempts = 0;
+};
+
+static OutboundItem queue[OUTBOUND_QUEUE_SIZE];
+static OutboundMetrics metrics;
+
+static void finish(OutboundItem &item, OutboundResult result) {
+    OutboundDoneFn callbacks[OUTBOUND_DONE_MAX];
+    memcpy(callbacks, item.onDone, sizeof(callbacks));
+    String payload = item.payload;
+    item.used = false;
+    item.url = "";
+    item.payload = "";
+    memset(item.onDone, 0, sizeof(item.onDone));
+    for (OutboundDoneFn cb : callbacks) {
+        if (cb) cb(result, payload);
+    }
+}
+
+// A write coalesced into `item` keeps its callback (once per distinct function)
+static void addDone(OutboundItem &item, OutboundDoneFn onDone) {
+    if (!onDone) return;
+    for (auto &cb : item.onDone) {
+        if (cb == onDone) return;
+        if (!cb) {
+            cb = onDone;
+            return;
+        }
+    }
+    LOGW(OUTBOUND, "⚠️ More than %d callbacks on one write — one dropped", OUTBOUND_DONE_MAX);
+}
+
+// Merge PATCH body `newer` into `older` (top-level keys; newer wins). Falls back to `newer`.
+static String mergePayloads(const String &older, const String &newer) {
+    JsonDocument base, patch;
+    if (deserializeJson(base, older) || deserializeJson(patch, newer) ||
+        !base.is<JsonObject>() || !patch.is<JsonObject>()) {
+        return newer;
+    }
+    for (JsonPair kv : patch.as<JsonObject>()) {
+        base[kv.key()] = kv.value();
+    }
+    String merged;
+    serializeJson(base, merged);
+    return merged;
+}
+
+static unsigned long backoffDelay(uint8_t attempts) {
+    unsigned long delayMs = OUTBOUND_BACKOFF_BASE_MS << min<uint8_t>(attempts - 1, 8);
+    if (delayMs > OUTBOUND_BACKOFF_MAX_MS) delayMs = OUTBOUND_BACKOFF_MAX_MS;
+    return delayMs + random(0, delayMs / 2 + 1); // jitter: +0..50%
+}
+
+bool outbound_submit(OutboundPriority prio, const char *method, const String &url,
+                     const String &payload, OutboundAuth auth, unsigned long ttlMs,
+                     OutboundDoneFn onDone) {
+    unsigned long now = millis();
+    metrics.submitted++;
+
+    // Coalesce with a pending write to the same target. A PATCH only touches
+    // its own keys, so bodies merge; a PUT replaces the node, so the newer body
+    // wins whole; every POST creates a node of its own and is never coalesced.
+    // The pending item keeps its backoff and deadline: a steady stream of
+    // updates to a failing URL must not retry faster or live forever.
+    bool isPatch = strcmp(method, "PATCH") == 0;
+    bool isPut = strcmp(method, "PUT") == 0;
+    for (auto &item : queue) {
+        if ((isPatch || isPut) && item.used && item.prio == prio && item.url == url &&
+            strcmp(item.method, method) == 0) {
+            item.payload = isPatch ? mergePayloads(item.payload, payload) : payload;
+            addDone(item, onDone);
+            metrics.coalesced++;
+            return true;
+        }
+    }
+
+    // Free slot, else evict the lowest-priority (then newest) item if it ranks below us
+    OutboundItem *slot = nullptr;
+    OutboundItem *victim = nullptr;
+    for (auto &item : queue) {
+        if (!item.used) { slot = &item; break; }
+        if (!victim || item.prio > victim->prio ||
+            (item.prio == victim->prio && item.createdAt > victim->createdAt)) {
+            victim = &item;
+        }
+    }
+
+    if (!slot) {
+        if (!victim || victim->prio <= prio) {
+            metrics.dropped++;
+            LOGW(OUTBOUND, "⚠️ Queue full — dropping new priority-%u write", prio);
+            if (onDone) onDone(OUT_FAILED, payload);
+            return false;
+        }
+        metrics.dropped++;
+        LOGW(OUTBOUND, "⚠️ Queue full — evicting priority-%u write", victim->prio);
+        finish(*victim, OUT_FAILED);
+        slot = victim;
+    }
+
+    slot->used = true;
+    slot->prio = prio;
+    slot->auth = auth;
+    slot->method = method;
+    slot->url = url;
+    slot->payload = payload;
+    addDone(*slot, onDone);
+    slot->createdAt = now;
+    slot->deadline = now + ttlMs;
+    slot->nextAttempt = now;
+    slot->attempts = 0;
+    return true;
+}
+
+bool outbound_process(unsigned long nowMillis, const String &token) {
+    OutboundItem *next = nullptr;
+
+    for (auto &item : queue) {
+        if (!item.used) continue;
+
+        if ((long)(nowMillis - item.deadline) >= 0) {
+            metrics.expired++;
+            LOGW(OUTBOUND, "Write expired after %u attempt(s)", item.attempts);
+            finish(item, OUT_FAILED);
+            continue;
+        }
+
+        if ((long)(nowMillis - item.nextAttempt) < 0) continue;
+        if (!next || item.prio < next->prio ||
+            (item.prio == next->prio && item.createdAt < next->createdAt)) {
+            next = &item;
+        }
+    }
+
+    if (next) {
+        String url = next->url;
+        if (next->auth == OUT_AUTH_QUERY) {
+            url += (url.indexOf('?') < 0 ? "?auth=" : "&auth=") + token;
+        }
+
+        String response;
+        int code = http_pool_request(next->method, url, next->payload, "application/json",
+                                     next->auth == OUT_AUTH_BEARER ? token : String(""), &response);
+        next->attempts++;
+
+        if (http_ok(code)) {
+            uint32_t age = millis() - next->createdAt;
+            if (age > metrics.maxAgeMs) metrics.maxAgeMs = age;
+            metrics.sent++;
+            finish(*next, OUT_SENT);
+        } else if (code >= 400 && code < 500 && code != 401 && code != 408 && code != 429) {
+            // Request itself is bad; retrying will not help
+            metrics.dropped++;
+            LOGE(OUTBOUND, "❌ Rejected (%d): %s", code, response.c_str());
+            finish(*next, OUT_REJECTED);
+        } else {
+            unsigned long wait = backoffDelay(next->attempts);
+            next->nextAttempt = millis() + wait;
+            LOGW(OUTBOUND, "Attempt %u failed (%d) — retry in %lu ms",
+                 next->attempts, code, wait);
+        }
+    }
+
+    return outbound_depth() > 0;
+}
+
+void outbound_clear() {
+    for (auto &item : queue) {
+        if (item.used) finish(item, OUT_FAILED);
+    }
+}
+
+uint8_t outbound_depth() {
+    uint8_t depth = 0;
+    for (auto &item : queue) {
+        if (item.used) depth++;
+    }
+    return depth;
+}
+
+uint32_t outbound_oldest_age(unsigned long nowMillis) {
+    uint32_t oldest = 0;
+    for (auto &item : queue) {
+        if (item.used && nowMillis - item.createdAt > oldest) oldest = nowMillis - item.createdAt;
+    }
+    return oldest;
+}
+
+const OutboundMetrics &outbound_metrics() {
+    return metrics;
+}
+
+void outbound_log_metrics() {
+    Serial.printf("[Outbound] depth=%u oldest=%lu ms submitted=%lu sent=%lu coalesced=%lu dropped=%lu expired=%lu maxAge=%lu ms\n",
+                  outbound_depth(), (unsigned long)outbound_oldest_age(millis()),
+                  (unsigned long)metrics.submitted, (unsigned long)metrics.sent,
+                  (unsigned long)metrics.coalesced, (unsigned long)metrics.dropped,
+                  (unsigned long)metrics.expired, (unsigned long)metrics.maxAgeMs);
+}
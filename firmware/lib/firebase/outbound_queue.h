@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+
+// === Prioritized outbound request queue ===
+// Bounded queue of pending REST writes. The loop submits and moves on;
+// outbound_process() sends at most one due item per call, retrying failures
+// with exponential backoff + jitter until the item's deadline passes.
+
+// Lower value = sent first
+enum OutboundPriority : uint8_t {
+    OUT_PRIO_COMMAND = 0,   // relay / command state
+    OUT_PRIO_LIVE    = 1,   // live sensor data
+    OUT_PRIO_LOG     = 2,   // Firestore logs
+};
+
+// How the ID token is attached when the item is sent
+enum OutboundAuth : uint8_t {
+    OUT_AUTH_QUERY  = 0,    // RTDB: "&auth=<token>" appended to the URL
+    OUT_AUTH_BEARER = 1,    // Firestore: "Authorization: Bearer <token>"
+};
+
+// How a write ended
+enum OutboundResult : uint8_t {
+    OUT_SENT     = 0,       // delivered with a 2xx
+    OUT_FAILED   = 1,       // dropped or expired locally; the same write may succeed later
+    OUT_REJECTED = 2,       // 4xx from the server; re-sending the same body will not help
+};
+
+// Called once when the write finishes. `payload` is the (possibly coalesced)
+// body that was sent. When writes are coalesced, each distinct callback among
+// them is called once with the outcome of the merged write.
+typedef void (*OutboundDoneFn)(OutboundResult result, const String &payload);
+
+struct OutboundMetrics {
+    uint32_t submitted = 0;
+    uint32_t sent = 0;           // delivered with a 2xx
+    uint32_t coalesced = 0;      // merged into / replaced a pending write to the same URL
+    uint32_t dropped = 0;        // rejected/evicted because the queue was full, or rejected by the server
+    uint32_t expired = 0;        // deadline passed before delivery
+    uint32_t maxAgeMs = 0;       // oldest age seen at delivery
+};
+
+// Queue a JSON PATCH/PUT/POST. A PATCH to the same URL and priority as a
+// pending one is merged into it (newer keys overwrite older ones), a PUT
+// replaces the pending body; POSTs are never coalesced. A coalesced write
+// keeps the pending item's backoff and deadline. Returns false if the item
+// was dropped.
+bool outbound_submit(OutboundPriority prio, const char *method, const String &url,
+                     const String &payload, OutboundAuth auth, unsigned long ttlMs,
+                     OutboundDoneFn onDone = nullptr);
+
+// Send the highest-priority due item (if any) using `token`.
+// Returns true while items remain queued.
+bool outbound_process(unsigned long nowMillis, const String &token);
+
+// Drop everything (callbacks receive OUT_FAILED)
+void outbound_clear();
+
+uint8_t outbound_depth();
+uint32_t outbound_oldest_age(unsigned long nowMillis);
+const OutboundMetrics &outbound_metrics();
+void outbound_log_metrics();
@@ -0,0 +1,257 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <math.h>
+#include <time.h>
+#include "config.h"
+#include "command_trace.h"
+#include "firebase.h"
+#include "logger.h"
+#include "outbound_queue.h"
+#include "relay_control.h"
+#include "relay_sync.h"
+#include "rule_engine.h"
+#include "trace_recorder.h"
+#include "wifi_manager.h"
+
+// ===== Live data =====
+static void onLiveDataDone(OutboundResult result, const String &) {
+    if (result == OUT_SENT) LOGD(RTDB, "Live data updated successfully");
+    else LOGE(RTDB, "❌ Live data update dropped");
+}
+
+// Live sensor fields, keys relative to `prefix` ("" or "live_data/<id>/")
+static void appendLiveFields(JsonDocument &doc, const String &prefix,
+                             const RealTimeData &data, const bool updatedSensors[6]) {
+    if (updatedSensors[0] && !isnan(data.waterTemp)) doc[prefix + "waterTemp"] = data.waterTemp;
+    if (updatedSensors[1] && !isnan(data.pH)) doc[prefix + "pH"] = data.pH;
+    if (updatedSensors[2] && !isnan(data.dissolvedOxygen)) doc[prefix + "dissolvedOxygen"] = data.dissolvedOxygen;
+    if (updatedSensors[3] && !isnan(data.turbidityNTU)) doc[prefix + "turbidityNTU"] = data.turbidityNTU;
+    if (updatedSensors[4]) {
+        if (!isnan(data.airTemp)) doc[prefix + "airTemp"] = data.airTemp;
+        if (!isnan(data.airHumidity)) doc[prefix + "airHumidity"] = data.airHumidity;
+    }
+    if (updatedSensors[5]) doc[prefix + "floatTriggered"] = data.floatTriggered;
+
+    // Always update timestamp
+    doc[prefix + "timestamp"] = time(nullptr);
+}
+
+void pushToRTDBLive(const RealTimeData &data, const bool updatedSensors[6]) {
+    if (!wifi_is_up()) return;
+
+    JsonDocument doc;
+    appendLiveFields(doc, "", data, updatedSensors);
+
+    String payload;
+    serializeJson(doc, payload);
+
+    outbound_submit(OUT_PRIO_LIVE, "PATCH", RTDB_URL "/live_data/" DEVICE_ID ".json?print=silent",
+                    payload, OUT_AUTH_QUERY, OUTBOUND_LIVE_TTL_MS, onLiveDataDone);
+}
+
+// ===== Relay sync snapshot =====
+// Bits 0-5: table actuator values, 6: pH pump active, 7/8: waterChange/sumpCleaning inProgress
+struct RelaySyncSnapshot {
+    uint16_t values = 0;
+    uint8_t autoMask = 0;     // which table actuators were in AUTO (and therefore synced)
+    bool valid = false;
+};
+
+static RelaySyncSnapshot lastSyncedRelays;
+
+#define RELAY_SYNC_KEY(name, relayId, relayField, label) #name "/value",
+static const char *const RELAY_SYNC_KEYS[ACTUATOR_COUNT] = {
+    ACTUATOR_TABLE(RELAY_SYNC_KEY)
+};
+
+#define SYNC_BIT_PH_ACTIVE          (1u << ACTUATOR_COUNT)
+#define SYNC_BIT_WATER_CHANGE       (1u << (ACTUATOR_COUNT + 1))
+#define SYNC_BIT_SUMP_CLEANING      (1u << (ACTUATOR_COUNT + 2))
+#define SYNC_MASK_ALL               ((1u << (ACTUATOR_COUNT + 3)) - 1)
+
+static RelaySyncSnapshot relaySnapshotOf(const RealTimeData &data, const Commands &commands) {
+    RelaySyncSnapshot snap;
+    snap.values = data.relayStates.bits & ACTUATOR_MASK;
+    if (data.relayStates.phRaising || data.relayStates.phLowering) snap.values |= SYNC_BIT_PH_ACTIVE;
+    if (commands.waterChange.inProgress) snap.values |= SYNC_BIT_WATER_CHANGE;
+    if (commands.sumpCleaning.inProgress) snap.values |= SYNC_BIT_SUMP_CLEANING;
+
+    snap.autoMask = commands_auto_mask(commands);
+    snap.valid = true;
+    return snap;
+}
+
+void invalidateRelaySync() {
+    lastSyncedRelays.valid = false;
+}
+
+// Relay/command fields that differ from the last synced snapshot, keys
+// relative to `prefix` ("" or "commands/<id>/"). `snap` receives the state
+// to record once the write has been queued.
+static void appendRelayFields(JsonDocument &doc, const String &prefix,
+                              const RealTimeData &data, const Commands &commands,
+                              RelaySyncSnapshot &snap) {
+    snap = relaySnapshotOf(data, commands);
+
+    uint16_t changed = lastSyncedRelays.valid ? (snap.values ^ lastSyncedRelays.values) : SYNC_MASK_ALL;
+    // An actuator that just returned to AUTO is re-synced even if its value is unchanged
+    changed |= snap.autoMask & ~lastSyncedRelays.autoMask;
+
+    // Only sync actuators in AUTO mode
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        uint16_t bit = 1u << i;
+        if ((snap.autoMask & bit) && (changed & bit)) doc[prefix + RELAY_SYNC_KEYS[i]] = (bool)(snap.values & bit);
+    }
+
+    bool phActive = snap.values & SYNC_BIT_PH_ACTIVE;
+    if (commands.phDosing.value != phActive) doc[prefix + "phDosing/value"] = phActive;
+
+    // Sync inProgress for waterChange and sumpCleaning
+    if (changed & SYNC_BIT_WATER_CHANGE) doc[prefix + "waterChange/inProgress"] = commands.waterChange.inProgress;
+    if (changed & SYNC_BIT_SUMP_CLEANING) doc[prefix + "sumpCleaning/inProgress"] = commands.sumpCleaning.inProgress;
+
+    // Clear manual request/cancel flags after handling
+    if (commands.waterChange.manualChangeRequest || commands.waterChange.manualChangeCancel) {
+        doc[prefix + "waterChange/manualChangeRequest"] = false;
+        doc[prefix + "waterChange/manualChangeCancel"] = false;
+    }
+    if (commands.sumpCleaning.manualCleanRequest || commands.sumpCleaning.manualCleanCancel) {
+        doc[prefix + "sumpCleaning/manualCleanRequest"] = false;
+        doc[prefix + "sumpCleaning/manualCleanCancel"] = false;
+    }
+}
+
+// Actuators whose value key is in a relay sync body (keys relative to `prefix`)
+static uint16_t syncedActuatorMask(const JsonDocument &doc, const String &prefix) {
+    uint16_t mask = 0;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (doc[prefix + RELAY_SYNC_KEYS[i]].is<bool>()) mask |= 1u << i;
+    }
+    return mask;
+}
+
+// Apply the local side effects of an acknowledged relay sync
+static void applyRelaySyncAck(const JsonDocument &doc, const String &prefix) {
+    LOGD(RTDB, "Relay sync ✅");
+
+    extern Commands currentCommands;
+    JsonVariant phValue = doc[prefix + "phDosing/value"];
+    if (!phValue.isNull()) {
+        currentCommands.phDosing.value = phValue.as<bool>();
+    }
+    // Clear only the manual flags this write reset remotely; the others were
+    // not part of it and may still be waiting to be handled
+    if (doc[prefix + "waterChange/manualChangeRequest"].is<bool>()) currentCommands.waterChange.manualChangeRequest = false;
+    if (doc[prefix + "waterChange/manualChangeCancel"].is<bool>()) currentCommands.waterChange.manualChangeCancel = false;
+    if (doc[prefix + "sumpCleaning/manualCleanRequest"].is<bool>()) currentCommands.sumpCleaning.manualCleanRequest = false;
+    if (doc[prefix + "sumpCleaning/manualCleanCancel"].is<bool>()) currentCommands.sumpCleaning.manualCleanCancel = false;
+}
+
+// Settle the command traces the delivered (possibly coalesced) body covered,
+// then apply its local side effects
+static void onRelaySyncResult(OutboundResult result, const String &payload, const String &prefix) {
+    JsonDocument doc;
+    bool parsed = !deserializeJson(doc, payload);
+    bool ok = result == OUT_SENT;
+    cmd_trace_sync_done(ok, parsed ? syncedActuatorMask(doc, prefix) : 0);
+    if (!ok) {
+        invalidateRelaySync();
+        return;
+    }
+    if (parsed) applyRelaySyncAck(doc, prefix);
+}
+
+static void onLiveAndRelayDone(OutboundResult result, const String &payload) {
+    if (result != OUT_SENT) LOGE(RTDB, "❌ Live + relay update dropped");
+    else LOGD(RTDB, "Live data updated successfully");
+    onRelaySyncResult(result, payload, "commands/" DEVICE_ID "/");
+}
+
+// One multi-location PATCH at the database root: live_data/<id>/... and
+// commands/<id>/... are written atomically in a single request.
+void pushLiveAndRelayState(const RealTimeData &data, const Commands &commands, const bool updatedSensors[6]) {
+    if (!wifi_is_up()) return;
+    if (!isInitialCommandsSynced()) {
+        LOGI(RTDB, "Relay state not synced yet — pushing live data only");
+        pushToRTDBLive(data, updatedSensors);
+        return;
+    }
+
+    JsonDocument doc;
+    RelaySyncSnapshot snap;
+    appendLiveFields(doc, "live_data/" DEVICE_ID "/", data, updatedSensors);
+    appendRelayFields(doc, "commands/" DEVICE_ID "/", data, commands, snap);
+
+    String payload;
+    serializeJson(doc, payload);
+
+    if (outbound_submit(OUT_PRIO_COMMAND, "PATCH", RTDB_URL "/.json?print=silent",
+                        payload, OUT_AUTH_QUERY, OUTBOUND_COMMAND_TTL_MS, onLiveAndRelayDone)) {
+        lastSyncedRelays = snap;
+        cmd_trace_sync_submitted(syncedActuatorMask(doc, "commands/" DEVICE_ID "/"));
+    }
+}
+
+// ===== Command updates =====
+// Apply the side effects of a command update, whichever transport delivered it
+void handleCommandPatch(const CommandPatchResult &patch, const char *source) {
+    extern Commands currentCommands;
+
+    // The initial snapshot is not a user command
+    bool commandsSynced = isInitialCommandsSynced();
+    if (commandsSynced) {
+        cmd_trace_received(patch.actuatorMask, commands_auto_mask(currentCommands), patch.receivedUs, source);
+    }
+
+    bool hasChanges = patch.changed;
+    bool autoTriggered = patch.autoTriggered; // <—— track if AUTO got re-enabled
+
+    auto applyManualIfNeeded = [&]() {
+        for (int i = 0; i < ACTUATOR_COUNT; i++) {
+            const CommandState &cmd = currentCommands.*ACTUATORS[i].command;
+            if (cmd.isAuto) continue;
+            relay_set((RelayId)i, cmd.value);
+            LOGD(STREAM, "Manual %s applied: %s", ACTUATORS[i].label, cmd.value ? "ON" : "OFF");
+        }
+
+        // === MANUAL WATER CHANGE ===
+        if (currentCommands.waterChange.manualChangeRequest) {
+            LOGI(STREAM, "Manual water change REQUEST detected");
+        }
+        if (currentCommands.waterChange.manualChangeCancel) {
+            LOGI(STREAM, "Manual water change CANCEL detected");
+        }
+
+        // === MANUAL SUMP CLEANING ===
+        if (currentCommands.sumpCleaning.manualCleanRequest) {
+            LOGI(STREAM, "Manual sump cleaning REQUEST detected");
+        }
+        if (currentCommands.sumpCleaning.manualCleanCancel) {
+            LOGI(STREAM, "Manual sump cleaning CANCEL detected");
+        }
+    };
+
+    applyManualIfNeeded();
+
+    if (hasChanges) {
+        LOGD(STREAM, "Commands updated successfully");
+        // Remote /commands moved under the last synced snapshot: re-sync every
+        // AUTO value, or a write that flipped one would stay in the database
+        invalidateRelaySync();
+        extern volatile bool commandsChangedViaStream;
+        commandsChangedViaStream = true;
+
+        extern unsigned long lastStreamUpdate;
+        lastStreamUpdate = millis();
+    }
+
+    // Back to AUTO: run the rules now. evaluateRules(true) reflects the new
+    // relays and queues them with the live timestamp as one multi-location
+    // PATCH; nothing else is sent for this event.
+    if (autoTriggered && commandsSynced) {
+        LOGI(STREAM, "AUTO mode re-enabled — evaluating rule engine now...");
+        unsigned long evalMillis = millis();
+        evaluateRules(true, evalMillis);
+        if (TRACE_ENABLED) trace_rec_eval(evalMillis);
+    }
+}
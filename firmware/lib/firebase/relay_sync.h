@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+// === Live data and relay state sync ===
+// pushToRTDBLive(), pushLiveAndRelayState() and handleCommandPatch() (declared
+// in firebase.h) live in relay_sync.cpp, apart from the FirebaseClient
+// plumbing, so the host checks can run them against an RTDB stand-in.
+// Relay fields are synced as the difference from the last queued snapshot.
+
+// Remote /commands may have moved (stream update, reconnect): next sync sends everything
+void invalidateRelaySync();
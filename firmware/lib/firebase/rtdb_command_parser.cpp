@@ -0,0 +1,215 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <string.h>
+#include "rtdb_command_parser.h"
+#include "logger.h"
+
+// === Compile-time path table ===
+static constexpr uint32_t fnv1a(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+    return h;
+}
+
+static constexpr size_t cstrlen(const char *s) {
+    size_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+struct CommandField {
+    const char *path;       // leaf path relative to /commands/<id>
+    uint32_t hash;          // fnv1a(path), computed at compile time
+    int16_t offset;         // byte offset of the bool in Commands, -1 = device-owned (ignored)
+    bool triggersEval;      // false → true re-enables automation
+    int8_t actuator;        // ActuatorIndex for table actuators, -1 otherwise
+    const char *label;
+};
+
+#define CMD_FIELD_(path, member, trig, actuator, label) \
+    { path, fnv1a(path, cstrlen(path)), (int16_t)offsetof(Commands, member), trig, actuator, label }
+#define CMD_FIELD(path, member, trig, label) CMD_FIELD_(path, member, trig, -1, label)
+#define CMD_DEVICE_OWNED(path) \
+    { path, fnv1a(path, cstrlen(path)), -1, false, -1, nullptr }
+
+#define CMD_ACTUATOR_FIELDS(name, relayId, relayField, label) \
+    CMD_FIELD_("/" #name "/isAuto", name.isAuto, true,  ACTUATOR_##name, label " isAuto"), \
+    CMD_FIELD_("/" #name "/value",  name.value,  false, ACTUATOR_##name, label " value"),
+
+static constexpr CommandField FIELDS[] = {
+    ACTUATOR_TABLE(CMD_ACTUATOR_FIELDS)
+    CMD_FIELD("/phDosing/phDosingEnabled", phDosing.phDosingEnabled, true, "pH dosing enabled"),
+    CMD_FIELD("/phDosing/value",           phDosing.value,           false, "pH dosing value"),
+    CMD_FIELD("/waterChange/manualChangeRequest", waterChange.manualChangeRequest, false, "Water Change request"),
+    CMD_FIELD("/waterChange/manualChangeCancel",  waterChange.manualChangeCancel,  false, "Water Change cancel"),
+    CMD_FIELD("/sumpCleaning/manualCleanRequest", sumpCleaning.manualCleanRequest, false, "Sump Cleaning request"),
+    CMD_FIELD("/sumpCleaning/manualCleanCancel",  sumpCleaning.manualCleanCancel,  false, "Sump Cleaning cancel"),
+    // Written back by the device itself; echoes are ignored
+    CMD_DEVICE_OWNED("/waterChange/inProgress"),
+    CMD_DEVICE_OWNED("/sumpCleaning/inProgress"),
+};
+
+static constexpr size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+static constexpr bool hashesUnique() {
+    for (size_t i = 0; i < FIELD_COUNT; i++)
+        for (size_t j = i + 1; j < FIELD_COUNT; j++)
+            if (FIELDS[i].hash == FIELDS[j].hash) return false;
+    return true;
+}
+static_assert(hashesUnique(), "RTDB command path hash collision — adjust the table");
+
+#define MAX_PATH_LEN 64
+
+static const CommandField *findField(const char *path, size_t len) {
+    uint32_t h = fnv1a(path, len);
+    for (const auto &f : FIELDS) {
+        if (f.hash == h && strncmp(f.path, path, len) == 0 && f.path[len] == '\0') return &f;
+    }
+    return nullptr;
+}
+
+// === ArduinoJson filters (built once from the table) ===
+// Only known fields are copied into the document, whatever the event shape.
+enum FilterKind { FILTER_PATH, FILTER_SNAPSHOT, FILTER_ROOT, FILTER_GROUP, FILTER_LEAF };
+
+static const JsonDocument &filterFor(FilterKind kind) {
+    static JsonDocument filters[5];
+    static bool built = false;
+
+    if (!built) {
+        filters[FILTER_PATH]["path"] = true;
+        filters[FILTER_LEAF]["path"] = true;
+        filters[FILTER_LEAF]["data"] = true;
+        filters[FILTER_ROOT]["path"] = true;
+        filters[FILTER_GROUP]["path"] = true;
+
+        for (const auto &f : FIELDS) {
+            if (f.offset < 0) continue;
+            // "/group/leaf" → group, leaf
+            const char *slash = strchr(f.path + 1, '/');
+            String group(f.path + 1);
+            group.remove(slash - f.path - 1);
+            const char *leaf = slash + 1;
+
+            filters[FILTER_SNAPSHOT][group][leaf] = true;
+            filters[FILTER_ROOT]["data"][group][leaf] = true;
+            filters[FILTER_GROUP]["data"][leaf] = true;
+        }
+        built = true;
+    }
+    return filters[kind];
+}
+
+// === Tree walk ===
+static void applyLeaf(const char *path, size_t len, JsonVariantConst value,
+                      Commands &commands, CommandPatchResult &result) {
+    const CommandField *f = findField(path, len);
+    if (!f) {
+        LOGW(STREAM, "Unknown path: %.*s", (int)len, path);
+        return;
+    }
+    if (f->offset < 0 || value.isNull()) return;
+
+    bool &target = *reinterpret_cast<bool *>(reinterpret_cast<uint8_t *>(&commands) + f->offset);
+    bool newValue = value.as<bool>();
+    result.fieldsApplied++;
+
+    if (target == newValue) return;
+    if (f->triggersEval && !target && newValue) result.autoTriggered = true;
+
+    target = newValue;
+    result.changed = true;
+    if (f->actuator >= 0) result.actuatorMask |= 1u << f->actuator;
+    LOGD(STREAM, "%s: %s", f->label, newValue ? "true" : "false");
+}
+
+static void applyNode(char *path, size_t len, JsonVariantConst node,
+                      Commands &commands, CommandPatchResult &result) {
+    if (!node.is<JsonObjectConst>()) {
+        applyLeaf(path, len, node, commands, result);
+        return;
+    }
+
+    for (JsonPairConst kv : node.as<JsonObjectConst>()) {
+        const char *key = kv.key().c_str();
+        size_t keyLen = strlen(key);
+        size_t base = (len == 1 && path[0] == '/') ? 0 : len; // root "/" has no trailing segment
+        if (base + 1 + keyLen >= MAX_PATH_LEN) continue;
+
+        path[base] = '/';
+        memcpy(path + base + 1, key, keyLen + 1);
+        applyNode(path, base + 1 + keyLen, kv.value(), commands, result);
+        path[len] = '\0';
+    }
+}
+
+// === Public API ===
+bool sse_find_json(const char *payload, size_t len, const char *&json, size_t &jsonLen) {
+    if (!payload) return false;
+
+    const char *begin = payload;
+    const char *end = payload + len;
+    while (begin < end && isspace((unsigned char)*begin)) begin++;
+    while (end > begin && isspace((unsigned char)end[-1])) end--;
+    if (begin == end) return false;
+
+    if (*begin != '{' && *begin != '[') {
+        // Last "data:" line holds the JSON
+        const char *data = nullptr;
+        for (const char *p = begin; p + 5 <= end; p++) {
+            if (memcmp(p, "data:", 5) == 0) data = p + 5;
+        }
+        if (!data) return false;
+        while (data < end && *data == ' ') data++;
+        begin = data;
+    }
+
+    json = begin;
+    jsonLen = end - begin;
+    return jsonLen > 0;
+}
+
+bool rtdb_apply_command_event(const char *json, size_t len, Commands &commands,
+                              CommandPatchResult &result) {
+    // Pass 1: just the path (data is skipped, not copied)
+    JsonDocument head;
+    DeserializationError err = deserializeJson(head, json, len,
+                                               DeserializationOption::Filter(filterFor(FILTER_PATH)));
+    if (err) {
+        LOGE(STREAM, "JSON parse error: %s", err.c_str());
+        return false;
+    }
+
+    char path[MAX_PATH_LEN] = "/";
+    size_t pathLen = 1;
+    FilterKind kind = FILTER_SNAPSHOT;
+
+    const char *eventPath = head["path"];
+    if (eventPath) {
+        pathLen = strlen(eventPath);
+        if (pathLen == 0 || pathLen >= MAX_PATH_LEN) return true;
+        memcpy(path, eventPath, pathLen + 1);
+
+        int depth = 0;
+        for (size_t i = 0; i < pathLen; i++) {
+            if (path[i] == '/' && i + 1 < pathLen) depth++;
+        }
+        kind = depth == 0 ? FILTER_ROOT : depth == 1 ? FILTER_GROUP : FILTER_LEAF;
+    }
+
+    // Pass 2: only the fields that can matter for this path depth
+    JsonDocument doc;
+    err = deserializeJson(doc, json, len, DeserializationOption::Filter(filterFor(kind)));
+    if (err) {
+        LOGE(STREAM, "JSON parse error: %s", err.c_str());
+        return false;
+    }
+
+    JsonVariantConst node = eventPath ? doc["data"] : doc.as<JsonVariantConst>();
+    if (node.isNull()) return true;
+
+    applyNode(path, pathLen, node, commands, result);
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stddef.h>
+#include "commands.h"
+
+// === RTDB command stream parser ===
+// Parses straight from the SSE receive buffer (no String copy of the payload)
+// and maps RTDB paths onto Commands fields through a compile-time generated
+// table. The buffer is read-only, so this is not zero-copy: it is parsed
+// twice (the event path, then only the fields that can match at that path
+// depth) and ArduinoJson copies each key and string it keeps into the
+// document.
+
+struct CommandPatchResult {
+    bool changed = false;         // any Commands field changed
+    bool autoTriggered = false;   // an actuator went back to AUTO / pH dosing re-enabled
+    uint8_t fieldsApplied = 0;    // leaves that matched a known field
+    uint16_t actuatorMask = 0;    // ActuatorIndex bits whose isAuto/value changed
+    uint32_t receivedUs = 0;      // micros() at event arrival, stamped by the transport
+};
+
+// Locate the JSON body of an SSE payload ("event: put\ndata: {...}" or bare JSON).
+// On success `json`/`jsonLen` point into `payload`; nothing is copied.
+bool sse_find_json(const char *payload, size_t len, const char *&json, size_t &jsonLen);
+
+// Apply one stream event ({"path": "...", "data": ...} or a bare snapshot
+// object) to `commands`. Returns false if the JSON could not be parsed.
+bool rtdb_apply_command_event(const char *json, size_t len, Commands &commands,
+                              CommandPatchResult &result);
@@ -2,67 +2,141 @@
 #include <LiquidCrystal_I2C.h>
 #include "config.h"
 #include "sensor_data.h"
+#include "lcd_frame.h"
+#include "lcd_display.h"
 
-// 20x4 I2C LCD
-#define LCD_ADDR 0x27
-#define LCD_COLS 20
-#define LCD_ROWS 4
+// PCF8574 backpack wiring (as in LiquidCrystal_I2C): P0 RS, P1 RW, P2 EN, P3 backlight, P4-P7 D4-D7
+#define PCF_RS              0x01
+#define PCF_EN              0x04
+#define PCF_BACKLIGHT       0x08
+#define PCF_BYTES_PER_LCD   5       // bus bytes per HD44780 byte, see lcdByte()
+#define I2C_TX_MAX          120     // payload per transaction (Wire buffer is 128)
+#define HD44780_SET_DDRAM   0x80
 
+static const uint8_t ROW_OFFSETS[4] = {0x00, 0x40, 0x14, 0x54};   // 20x4 DDRAM layout
+
+// Library driver for the power-up init sequence only; refreshes write the expander directly
 LiquidCrystal_I2C lcd(LCD_ADDR, LCD_COLS, LCD_ROWS);
 
-// update interval (ms)
-const unsigned long UPDATE_INTERVAL = 1000;
-unsigned long lastUpdateMs = 0;
+static LcdFrame shown;      // what the display holds (I2C side only)
+static LcdFrame pending;    // latest render for the refresh task
+static portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t lcdTaskHandle = nullptr;
+static LcdStats stats;
+
+// ===== I2C transport =====
+static uint8_t txLen = 0;
+static uint32_t txBytes = 0;
 
-// Helper: pad or truncate a String to exactly width chars (right-padded with spaces)
-String fixedWidth(const String &s, uint8_t width) {
-    if ((int)s.length() > width) return s.substring(0, width);
-    String out = s;
-    while ((int)out.length() < width) out += ' ';
-    return out;
+static void txBegin() {
+    Wire.beginTransmission(LCD_ADDR);
+    txLen = 0;
 }
 
+static void txEnd() {
+    Wire.endTransmission();
+    txBytes += txLen + 1;   // + address byte
+}
+
+// One HD44780 byte in 4-bit mode, one EN pulse per nibble. RS settles with EN
+// low first; the two bytes before the next rising edge (45 us at 400 kHz)
+// cover the 37 us execution time, so no delays are needed.
+static void lcdByte(uint8_t value, uint8_t rs) {
+    if (txLen + PCF_BYTES_PER_LCD > I2C_TX_MAX) {
+        txEnd();
+        txBegin();
+    }
+    uint8_t hi = PCF_BACKLIGHT | rs | (value & 0xF0);
+    uint8_t lo = PCF_BACKLIGHT | rs | (uint8_t)(value << 4);
+    Wire.write(hi);
+    Wire.write(hi | PCF_EN);
+    Wire.write(hi);
+    Wire.write(lo | PCF_EN);
+    Wire.write(lo);
+    txLen += PCF_BYTES_PER_LCD;
+}
+
+// Send the cells of `next` that differ from the display
+static void commit(const LcdFrame &next) {
+    LcdRun runs[LCD_MAX_RUNS];
+    uint8_t n = lcd_frame_diff(shown, next, runs);
+    if (n == 0) {
+        stats.unchanged++;
+        return;
+    }
+
+    uint32_t start = micros();
+    txBytes = 0;
+    txBegin();
+    for (uint8_t i = 0; i < n; i++) {
+        const LcdRun &r = runs[i];
+        lcdByte(HD44780_SET_DDRAM | (ROW_OFFSETS[r.row] + r.col), 0);
+        for (uint8_t c = 0; c < r.len; c++) lcdByte((uint8_t)next.cells[r.row][r.col + c], PCF_RS);
+        stats.cells += r.len;
+    }
+    txEnd();
+    shown = next;
+
+    uint32_t us = micros() - start;
+    stats.refreshes++;
+    stats.i2cBytes += txBytes;
+    stats.lastBytes = txBytes;
+    stats.lastUs = us;
+    if (us > stats.maxUs) stats.maxUs = us;
+}
+
+static void lcdTask(void *) {
+    LcdFrame next;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        portENTER_CRITICAL(&frameMux);
+        next = pending;
+        portEXIT_CRITICAL(&frameMux);
+        commit(next);
+    }
+}
+
+// ===== API =====
 void lcd_init() {
-    lcd.init();
+    lcd.init();   // Wire.begin(), 4-bit init, clear
     lcd.backlight();
-    // print static labels once
-    lcd.setCursor(0, 0);
-    lcd.print(fixedWidth("Air: ", 5) + fixedWidth("Hum:", 8));
-    lcd.setCursor(0, 1);
-    lcd.print(fixedWidth("Water: ", 8) + fixedWidth("pH:", 6));
-    lcd.setCursor(0, 2);
-    lcd.print(fixedWidth("DO:", 8));
-    lcd.setCursor(0, 3);
-    lcd.print(fixedWidth("Turb:", 8));
+    Wire.setClock(LCD_I2C_HZ);
+
+    // Static labels; the first reading then only fills in the values
+    lcd_frame_fill(shown, ' ');
+    lcd_frame_render_labels(pending);
+    commit(pending);
+
+    if (!LCD_TASK_ENABLED) return;
+    BaseType_t ok = xTaskCreatePinnedToCore(lcdTask, "lcd", LCD_TASK_STACK, nullptr,
+                                            LCD_TASK_PRIORITY, &lcdTaskHandle, LCD_TASK_CORE);
+    if (ok != pdPASS) {
+        lcdTaskHandle = nullptr;
+        Serial.println("[LCD] ❌ Refresh task creation failed — refreshing inline");
+    }
 }
 
-// Write the dynamic values in-place (no lcd.clear())
 void lcd_display(const RealTimeData& data) {
+    LcdFrame next;
+    lcd_frame_render(next, data);
+
+    if (!lcdTaskHandle) {
+        commit(next);
+        return;
+    }
+    portENTER_CRITICAL(&frameMux);
+    pending = next;
+    portEXIT_CRITICAL(&frameMux);
+    xTaskNotifyGive(lcdTaskHandle);
+}
 
-    // --- AIR ---
-    String airVal = "Air:" + String(data.airTemp, 1) + "C";   // 1 decimal
-    String humVal = "Hum:" + String(data.airHumidity, 0) + "%"; // whole number
-    lcd.setCursor(0, 0);
-    lcd.print(fixedWidth(airVal, 10));
-    lcd.setCursor(10, 0);
-    lcd.print(fixedWidth(humVal, 10));
-
-    // --- WATER + pH ---
-    String waterVal = "Water: " + String(data.waterTemp, 1) + "C"; // 1 decimal
-    String pHVal    = "pH: "    + String(data.pH, 1);              // 1 decimal
-    lcd.setCursor(0, 1);
-    lcd.print(fixedWidth(waterVal, 12));
-    lcd.setCursor(12, 1);
-    lcd.print(fixedWidth(pHVal, 8));
-
-    // --- DO ---
-    String doVal = "DO: " + String(data.dissolvedOxygen, 1) + "mg/L"; // 1 decimal
-    lcd.setCursor(0, 2);
-    lcd.print(fixedWidth(doVal, 20));
-
-    // --- TURBIDITY ---
-    String turbVal = "Turb: " + String(data.turbidityNTU) + "NTU";
-    lcd.setCursor(0, 3);
-    lcd.print(fixedWidth(turbVal, 20));
+const LcdStats &lcd_stats() {
+    return stats;
 }
 
+void lcd_log_stats() {
+    Serial.printf("[LCD] refreshes=%lu unchanged=%lu cells=%lu i2c=%lu B | last %lu B in %lu us, max %lu us\n",
+                  (unsigned long)stats.refreshes, (unsigned long)stats.unchanged, (unsigned long)stats.cells,
+                  (unsigned long)stats.i2cBytes, (unsigned long)stats.lastBytes,
+                  (unsigned long)stats.lastUs, (unsigned long)stats.maxUs);
+}
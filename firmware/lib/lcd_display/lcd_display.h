@@ -1,7 +1,26 @@
 #pragma once
 #include <Arduino.h>
 #include <sensor_data.h>
-#include <LiquidCrystal_I2C.h>
+
+// === 20x4 I2C LCD ===
+// lcd_display() renders into a framebuffer (lcd_frame.h) and only the cells
+// that differ from what the display shows go out over I2C, several HD44780
+// bytes per transaction. With LCD_TASK_ENABLED the I2C side runs on its own
+// task and lcd_display() returns after the render; frames rendered while the
+// task is busy collapse into the latest one.
+
+struct LcdStats {
+    uint32_t refreshes = 0;    // frames that changed at least one cell
+    uint32_t unchanged = 0;    // frames identical to the display
+    uint32_t cells = 0;        // characters sent
+    uint32_t i2cBytes = 0;     // bus bytes including address bytes
+    uint32_t lastBytes = 0;
+    uint32_t lastUs = 0;       // I2C time of the last refresh
+    uint32_t maxUs = 0;
+};
 
 void lcd_init();
-void lcd_display(const RealTimeData& sensorData);
\ No newline at end of file
+void lcd_display(const RealTimeData& sensorData);
+
+const LcdStats &lcd_stats();
+void lcd_log_stats();
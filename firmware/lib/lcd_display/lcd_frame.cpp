@@ -0,0 +1,133 @@
+#include <math.h>
+#include <string.h>
+#include "lcd_frame.h"
+
+// ===== Field writer =====
+// A fixed-width slice of one row; text past the end is clipped, the rest is blank-padded
+struct Field {
+    char *p;
+    char *end;
+};
+
+static Field field(LcdFrame &frame, uint8_t row, uint8_t col, uint8_t width) {
+    char *start = &frame.cells[row][col];
+    return {start, start + width};
+}
+
+static inline void putChar(Field &f, char c) {
+    if (f.p < f.end) *f.p++ = c;
+}
+
+static void putStr(Field &f, const char *s) {
+    while (*s) putChar(f, *s++);
+}
+
+// Same text as Arduino's String(float, decimals): rounded fixed point, "nan", "inf", "ovf"
+static void putFloat(Field &f, float v, uint8_t decimals) {
+    static const uint32_t POW10[] = {1, 10, 100, 1000};
+    if (isnan(v)) return putStr(f, "nan");
+    if (isinf(v)) return putStr(f, v < 0 ? "-inf" : "inf");
+    if (decimals > 3) decimals = 3;
+
+    double scaled = fabs((double)v) * POW10[decimals] + 0.5;   // double, like dtostrf(); float drops the last digit of larger values
+    if (scaled >= 4294967040.0) return putStr(f, "ovf");
+    uint32_t n = (uint32_t)scaled;
+    if (v < 0) putChar(f, '-');
+
+    char digits[10];
+    int len = 0;
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n || len <= decimals);   // at least one digit before the point
+    while (len) {
+        putChar(f, digits[--len]);
+        if (len == decimals && decimals) putChar(f, '.');
+    }
+}
+
+static void pad(Field &f) {
+    while (f.p < f.end) *f.p++ = ' ';
+}
+
+// ===== Layout =====
+void lcd_frame_fill(LcdFrame &frame, char c) {
+    memset(frame.cells, c, sizeof(frame.cells));
+}
+
+void lcd_frame_render_labels(LcdFrame &frame) {
+    lcd_frame_fill(frame, ' ');
+    Field f = field(frame, 0, 0, 10);
+    putStr(f, "Air:");
+    f = field(frame, 0, 10, 10);
+    putStr(f, "Hum:");
+    f = field(frame, 1, 0, 12);
+    putStr(f, "Water:");
+    f = field(frame, 1, 12, 8);
+    putStr(f, "pH:");
+    f = field(frame, 2, 0, 20);
+    putStr(f, "DO:");
+    f = field(frame, 3, 0, 20);
+    putStr(f, "Turb:");
+}
+
+void lcd_frame_render(LcdFrame &frame, const RealTimeData &data) {
+    // --- AIR ---
+    Field f = field(frame, 0, 0, 10);
+    putStr(f, "Air:");
+    putFloat(f, data.airTemp, 1);
+    putChar(f, 'C');
+    pad(f);
+    f = field(frame, 0, 10, 10);
+    putStr(f, "Hum:");
+    putFloat(f, data.airHumidity, 0);
+    putChar(f, '%');
+    pad(f);
+
+    // --- WATER + pH ---
+    f = field(frame, 1, 0, 12);
+    putStr(f, "Water: ");
+    putFloat(f, data.waterTemp, 1);
+    putChar(f, 'C');
+    pad(f);
+    f = field(frame, 1, 12, 8);
+    putStr(f, "pH: ");
+    putFloat(f, data.pH, 1);
+    pad(f);
+
+    // --- DO ---
+    f = field(frame, 2, 0, 20);
+    putStr(f, "DO: ");
+    putFloat(f, data.dissolvedOxygen, 1);
+    putStr(f, "mg/L");
+    pad(f);
+
+    // --- TURBIDITY ---
+    f = field(frame, 3, 0, 20);
+    putStr(f, "Turb: ");
+    putFloat(f, data.turbidityNTU, 2);
+    putStr(f, "NTU");
+    pad(f);
+}
+
+// ===== Diff =====
+uint8_t lcd_frame_diff(const LcdFrame &shown, const LcdFrame &next, LcdRun runs[LCD_MAX_RUNS]) {
+    uint8_t count = 0;
+    for (uint8_t row = 0; row < LCD_ROWS; row++) {
+        const char *a = shown.cells[row];
+        const char *b = next.cells[row];
+        int open = -1;        // index of the run being extended on this row
+        uint8_t lastDiff = 0;
+        for (uint8_t col = 0; col < LCD_COLS; col++) {
+            if (a[col] == b[col]) continue;
+            if (open >= 0 && col - lastDiff - 1 <= LCD_RUN_MERGE_GAP) {
+                runs[open].len = col - runs[open].col + 1;
+            } else {
+                open = count;
+                runs[count++] = {row, col, 1};
+            }
+            lastDiff = col;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+#include "sensor_data.h"
+
+// === LCD framebuffer ===
+// The display content as 80 chars (LCD_ROWS x LCD_COLS), rendered without
+// heap Strings or printf, and the diff between two frames as runs of cells.
+// No I/O here, so it also builds on the host.
+
+struct LcdFrame {
+    char cells[LCD_ROWS][LCD_COLS];
+};
+
+// A run of changed cells on one row
+struct LcdRun {
+    uint8_t row;
+    uint8_t col;
+    uint8_t len;
+};
+
+// Unchanged cells between two changes are resent when that is cheaper than a
+// cursor move (one command byte)
+#define LCD_RUN_MERGE_GAP  1
+#define LCD_MAX_RUNS       (LCD_ROWS * (LCD_COLS + 1) / 2)
+
+void lcd_frame_fill(LcdFrame &frame, char c);
+
+// Static labels only (shown until the first reading arrives)
+void lcd_frame_render_labels(LcdFrame &frame);
+void lcd_frame_render(LcdFrame &frame, const RealTimeData &data);
+
+// Runs where `next` differs from `shown`, in display order; returns the count
+uint8_t lcd_frame_diff(const LcdFrame &shown, const LcdFrame &next, LcdRun runs[LCD_MAX_RUNS]);
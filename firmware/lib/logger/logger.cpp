@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include "config.h"
+#include "mpsc_ring.h"
+#include "logger.h"
+
+struct LogEntry {
+    uint8_t module;
+    uint8_t level;
+    uint16_t len;
+    char text[LOG_LINE_MAX];
+};
+
+#define LOG_MODULE_TAG(id, tag, ceiling) tag,
+static const char *const TAGS[LOG_MOD_COUNT] = { LOG_MODULES(LOG_MODULE_TAG) };
+#undef LOG_MODULE_TAG
+
+#define LOG_MODULE_BOOT_LEVEL(id, tag, ceiling) LOG_BOOT_LEVEL,
+uint8_t log_levels[LOG_MOD_COUNT] = { LOG_MODULES(LOG_MODULE_BOOT_LEVEL) };
+#undef LOG_MODULE_BOOT_LEVEL
+
+static MpscRing<LogEntry, LOG_RING_SIZE> ring;
+static TaskHandle_t drainTaskHandle = nullptr;
+
+// Producers run on both cores
+static std::atomic<uint32_t> queued{0};
+static std::atomic<uint32_t> written{0};
+static std::atomic<uint32_t> dropped{0};
+static std::atomic<uint32_t> truncated{0};
+static uint32_t maxDepth = 0;   // drain task only
+
+// ===== Drain task =====
+static void drainTask(void *) {
+    uint32_t reportedDrops = 0;
+    for (;;) {
+        uint32_t depth = ring.size();
+        if (depth > maxDepth) maxDepth = depth;
+
+        LogEntry e;
+        while (ring.pop(e)) {
+            Serial.printf("[%s] %.*s\n", TAGS[e.module], (int)e.len, e.text);
+            written.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t drops = dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            Serial.printf("[LOG] ⚠️ %lu message(s) dropped (ring full)\n", (unsigned long)(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+    }
+}
+
+void log_init() {
+    if (drainTaskHandle || !LOG_TASK_ENABLED) return;
+
+    BaseType_t ok = xTaskCreatePinnedToCore(drainTask, "log", LOG_TASK_STACK, nullptr,
+                                            LOG_TASK_PRIORITY, &drainTaskHandle, LOG_TASK_CORE);
+    if (ok != pdPASS) {
+        drainTaskHandle = nullptr;
+        Serial.println("[LOG] ❌ Drain task creation failed — logging inline");
+    }
+}
+
+// ===== Producers =====
+void log_write(LogModule module, LogLevel level, const char *fmt, ...) {
+    LogEntry e;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(e.text, sizeof(e.text), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if (n >= (int)sizeof(e.text)) {
+        n = sizeof(e.text) - 1;
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!drainTaskHandle) {
+        Serial.printf("[%s] %s\n", TAGS[module], e.text);
+        written.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    e.module = module;
+    e.level = level;
+    e.len = (uint16_t)n;
+    if (ring.push(e)) queued.fetch_add(1, std::memory_order_relaxed);
+    else dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ===== Runtime levels =====
+void log_set_level(LogModule module, LogLevel level) {
+    if (module < LOG_MOD_COUNT) log_levels[module] = level;
+}
+
+void log_set_level_all(LogLevel level) {
+    for (auto &l : log_levels) l = level;
+}
+
+LogLevel log_get_level(LogModule module) {
+    return module < LOG_MOD_COUNT ? (LogLevel)log_levels[module] : LOG_LEVEL_NONE;
+}
+
+// ===== Stats =====
+LogStats log_stats() {
+    LogStats s;
+    s.queued = queued.load(std::memory_order_relaxed);
+    s.written = written.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.truncated = truncated.load(std::memory_order_relaxed);
+    s.maxDepth = maxDepth;
+    return s;
+}
+
+void log_log_stats() {
+    LogStats s = log_stats();
+    Serial.printf("[LOG] %s | queued=%lu written=%lu dropped=%lu truncated=%lu maxDepth=%lu/%u\n",
+                  drainTaskHandle ? "async" : "inline",
+                  (unsigned long)s.queued, (unsigned long)s.written, (unsigned long)s.dropped,
+                  (unsigned long)s.truncated, (unsigned long)s.maxDepth, (unsigned)LOG_RING_SIZE);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// === Leveled asynchronous logger ===
+// LOGE/LOGW/LOGI/LOGD(MODULE, fmt, ...) print "[TAG] message". A call above
+// its module's compile-time ceiling is removed entirely (format string and
+// arguments included); one above the module's runtime level costs a compare.
+// Otherwise the message is formatted in the caller into a fixed-size entry
+// and queued on a lock-free ring; a low-priority task writes it to Serial, so
+// the caller never waits on the UART. A full ring drops the message and
+// counts it. Safe from any task, not from an ISR.
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+};
+
+// X(id, tag, compile-time ceiling); raise a ceiling here to build one module's debug lines in
+#define LOG_MODULES(X) \
+    X(MAIN,      "MAIN",         LOG_MAX_LEVEL) \
+    X(SENSOR,    "SENSOR",       LOG_MAX_LEVEL) \
+    X(EVAL,      "EVAL",         LOG_MAX_LEVEL) \
+    X(RULES,     "RULE_ENGINE",  LOG_MAX_LEVEL) \
+    X(AUTO_PH,   "AUTO PH",      LOG_MAX_LEVEL) \
+    X(MANUAL,    "MANUAL",       LOG_MAX_LEVEL) \
+    X(SUMP,      "SUMP",         LOG_MAX_LEVEL) \
+    X(AUTH,      "Auth",         LOG_MAX_LEVEL) \
+    X(RTDB,      "RTDB",         LOG_MAX_LEVEL) \
+    X(STREAM,    "RTDB Stream",  LOG_MAX_LEVEL) \
+    X(CONTROL,   "Control",      LOG_MAX_LEVEL) \
+    X(FIRESTORE, "Firestore",    LOG_MAX_LEVEL) \
+    X(OUTBOUND,  "Outbound",     LOG_MAX_LEVEL) \
+    X(CMD_TRACE, "Trace",        LOG_MAX_LEVEL) \
+    X(MQTT,      "MQTT",         LOG_MAX_LEVEL)
+
+#define LOG_MODULE_ID(id, tag, ceiling) LOG_MOD_##id,
+enum LogModule : uint8_t { LOG_MODULES(LOG_MODULE_ID) LOG_MOD_COUNT };
+#undef LOG_MODULE_ID
+
+#define LOG_MODULE_CEILING(id, tag, ceiling) static constexpr uint8_t LOG_CEILING_##id = (ceiling);
+LOG_MODULES(LOG_MODULE_CEILING)
+#undef LOG_MODULE_CEILING
+
+// Runtime levels, indexed by LogModule (read inline by the macros)
+extern uint8_t log_levels[LOG_MOD_COUNT];
+
+// True when a message of `level` from MODULE would be printed; use it to skip
+// building a message that takes more than one format call
+#define LOG_ENABLED(mod, level) \
+    ((level) <= LOG_CEILING_##mod && (level) <= log_levels[LOG_MOD_##mod])
+
+#define LOG_AT(mod, level, fmt, ...) \
+    do { \
+        if (LOG_ENABLED(mod, level)) log_write(LOG_MOD_##mod, (level), fmt, ##__VA_ARGS__); \
+    } while (0)
+
+#define LOGE(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOGW(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOGI(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOGD(mod, fmt, ...) LOG_AT(mod, LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+struct LogStats {
+    uint32_t queued = 0;       // handed to the drain task
+    uint32_t written = 0;      // printed (by the task or inline)
+    uint32_t dropped = 0;      // ring full
+    uint32_t truncated = 0;    // longer than LOG_LINE_MAX - 1
+    uint32_t maxDepth = 0;     // deepest ring seen by the drain task
+};
+
+// Start the drain task. Until it runs (or with LOG_TASK_ENABLED false, or if
+// task creation fails) messages are printed inline by the caller.
+void log_init();
+
+// Not normally called directly; the LOG* macros check the levels first
+void log_write(LogModule module, LogLevel level, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+void log_set_level(LogModule module, LogLevel level);
+void log_set_level_all(LogLevel level);
+LogLevel log_get_level(LogModule module);
+
+LogStats log_stats();
+void log_log_stats();
@@ -0,0 +1,98 @@
+#include <Arduino.h>
+#include "config.h"
+#include "loop_profiler.h"
+
+#if LOOP_PROF_ENABLED
+
+struct PhaseHist {
+    uint32_t buckets[PROF_BUCKETS] = {};
+    uint32_t count = 0;
+    uint32_t stalls = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+};
+
+static const char *const PHASE_NAMES[PROF_PHASE_COUNT] = {
+    "loop", "sched", "stream", "mqtt", "sensorRead", "sensorDrain",
+    "ph", "rules", "push", "network", "lcd", "tlog",
+};
+
+// Each phase is recorded from a single task, so no locking; readers may see
+// a slightly torn snapshot, which is fine for diagnostics.
+static PhaseHist hist[PROF_PHASE_COUNT];
+
+static inline uint8_t bucketOf(uint32_t us) {
+    uint8_t b = us ? 31 - __builtin_clz(us) : 0;
+    return b < PROF_BUCKETS ? b : PROF_BUCKETS - 1;
+}
+
+void loop_prof_record(ProfPhase phase, uint64_t elapsedUs) {
+    uint32_t us = elapsedUs > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsedUs;
+    PhaseHist &h = hist[phase];
+    h.buckets[bucketOf(us)]++;
+    h.count++;
+    h.totalUs += us;
+    if (us > h.maxUs) h.maxUs = us;
+
+    if (phase != PROF_LOOP && us >= LOOP_PROF_STALL_US) {
+        h.stalls++;
+        Serial.printf("[PROF] ⚠️ Stall in %s: %lu us (core %d)\n",
+                      PHASE_NAMES[phase], (unsigned long)us, xPortGetCoreID());
+    }
+}
+
+// Upper bound of the bucket holding the q-th fraction of samples
+static uint32_t percentileUs(const PhaseHist &h, float q) {
+    uint32_t target = (uint32_t)(h.count * q);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < PROF_BUCKETS; b++) {
+        seen += h.buckets[b];
+        if (seen > target) return b == PROF_BUCKETS - 1 ? h.maxUs : (2u << b);
+    }
+    return h.maxUs;
+}
+
+void loop_prof_log() {
+    Serial.println("[PROF] phase         count      avg      p50      p99      max   stalls (us)");
+    for (uint8_t p = 0; p < PROF_PHASE_COUNT; p++) {
+        const PhaseHist &h = hist[p];
+        if (!h.count) continue;
+        Serial.printf("[PROF] %-12s %6lu %8lu %8lu %8lu %8lu %8lu\n",
+                      PHASE_NAMES[p], (unsigned long)h.count,
+                      (unsigned long)(h.totalUs / h.count),
+                      (unsigned long)percentileUs(h, 0.50f),
+                      (unsigned long)percentileUs(h, 0.99f),
+                      (unsigned long)h.maxUs, (unsigned long)h.stalls);
+    }
+}
+
+bool loop_prof_to_json(JsonDocument &doc) {
+    doc["uptimeS"] = millis() / 1000;
+    doc["timestamp"] = time(nullptr);
+    JsonObject phases = doc["phases"].to<JsonObject>();
+
+    for (uint8_t p = 0; p < PROF_PHASE_COUNT; p++) {
+        const PhaseHist &h = hist[p];
+        if (!h.count) continue;
+        JsonObject o = phases[PHASE_NAMES[p]].to<JsonObject>();
+        o["count"] = h.count;
+        o["avgUs"] = (uint32_t)(h.totalUs / h.count);
+        o["maxUs"] = h.maxUs;
+        o["stalls"] = h.stalls;
+
+        // Trailing empty buckets are left out
+        uint8_t last = PROF_BUCKETS;
+        while (last > 0 && !h.buckets[last - 1]) last--;
+        JsonArray buckets = o["hist"].to<JsonArray>();
+        for (uint8_t b = 0; b < last; b++) buckets.add(h.buckets[b]);
+    }
+    return true;
+}
+
+#else
+
+void loop_prof_record(ProfPhase, uint64_t) {}
+void loop_prof_log() {}
+bool loop_prof_to_json(JsonDocument &) { return false; }
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "esp_timer.h"
+#include "config.h"
+
+// === Loop profiler ===
+// Per-phase latency histograms (log2 microsecond buckets, measured with the
+// 64-bit esp_timer clock) plus a stall detector that logs the phase and its
+// duration whenever one call exceeds LOOP_PROF_STALL_US.
+// With LOOP_PROF_ENABLED false, PROF_SCOPE() expands to nothing and the
+// functions below are empty stubs.
+
+enum ProfPhase : uint8_t {
+    PROF_LOOP = 0,          // whole loop() iteration
+    PROF_SCHED,             // scheduled jobs (token, NTP, backfill...)
+    PROF_STREAM,            // RTDB stream handling
+    PROF_MQTT,
+    PROF_SENSOR_READ,       // sensor driver reads (sensor task)
+    PROF_SENSOR_DRAIN,      // merging queued samples in loop()
+    PROF_PH,                // pH dosing logic
+    PROF_RULES,             // rule engine + relay reflect
+    PROF_PUSH,              // live push / relay sync submission
+    PROF_NETWORK,           // outbound queue (blocking HTTPS request)
+    PROF_LCD,
+    PROF_TLOG,              // telemetry log append (flash write)
+    PROF_PHASE_COUNT
+};
+
+#define PROF_BUCKETS 20     // bucket i: [2^i, 2^(i+1)) us; last bucket is open-ended
+
+void loop_prof_record(ProfPhase phase, uint64_t elapsedUs);
+
+// Serial dump: count, avg, p50/p99 (bucket upper bound), max per phase
+void loop_prof_log();
+
+// Fills `doc` with the histograms for the diagnostics node; false when disabled
+bool loop_prof_to_json(JsonDocument &doc);
+
+#if LOOP_PROF_ENABLED
+// Records the enclosing scope's duration. esp_timer does not wrap, so the
+// multi-second stalls (an HTTPS request plus its retry) are measured in full.
+struct LoopProfScope {
+    ProfPhase phase;
+    int64_t start;
+    explicit LoopProfScope(ProfPhase p) : phase(p), start(esp_timer_get_time()) {}
+    ~LoopProfScope() { loop_prof_record(phase, esp_timer_get_time() - start); }
+};
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b)  PROF_CONCAT_(a, b)
+#define PROF_SCOPE(phase)  LoopProfScope PROF_CONCAT(_profScope, __LINE__)(phase)
+#else
+#define PROF_SCOPE(phase)  ((void)0)
+#endif
@@ -0,0 +1,226 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "commands.h"
+#include "rtdb_command_parser.h"
+#include "firebase.h"
+#include "mqtt_transport.h"
+#include "wifi_manager.h"
+#include "trace_recorder.h"
+#include "logger.h"
+
+#define TOPIC_LIVE      MQTT_TOPIC_PREFIX "/live"
+#define TOPIC_RELAYS    MQTT_TOPIC_PREFIX "/relays"
+#define TOPIC_STATUS    MQTT_TOPIC_PREFIX "/status"
+#define TOPIC_COMMANDS  MQTT_TOPIC_PREFIX "/commands"
+
+static WiFiClient netClient;
+static PubSubClient mqtt(netClient);
+static MqttStats stats;
+static unsigned long lastConnectAttempt = 0;
+static unsigned long reconnectDelay = 0;      // 0 until the first attempt
+
+// Last values that went out, for delta publishing
+static RealTimeData lastLive;
+static RealTimeData lastRelays;
+static bool relaysPublished = false;
+static bool floatPublished = false;
+
+// ===== Commands =====
+static void onMessage(char *topic, byte *payload, unsigned int length) {
+    uint32_t startUs = micros();
+    const size_t prefixLen = sizeof(TOPIC_COMMANDS) - 1;
+    if (strncmp(topic, TOPIC_COMMANDS, prefixLen) != 0) return;
+
+    const char *subPath = topic + prefixLen;   // "" or "/fan/isAuto"
+    extern Commands currentCommands;
+    CommandPatchResult patch;
+    patch.receivedUs = startUs;
+    bool parsed;
+
+    if (*subPath == '\0') {
+        // Whole object (or an RTDB-style {"path","data"} event)
+        if (TRACE_ENABLED) trace_rec_command((const char *)payload, length, TRACE_SRC_MQTT);
+        parsed = rtdb_apply_command_event((const char *)payload, length, currentCommands, patch);
+    } else {
+        // Single field: wrap as a stream event so it goes through the same path table
+        char event[128];
+        int n = snprintf(event, sizeof(event), "{\"path\":\"%s\",\"data\":%.*s}",
+                         subPath, (int)length, (const char *)payload);
+        if (n <= 0 || n >= (int)sizeof(event)) {
+            LOGW(MQTT, "Command too long on %s", topic);
+            return;
+        }
+        if (TRACE_ENABLED) trace_rec_command(event, n, TRACE_SRC_MQTT);
+        parsed = rtdb_apply_command_event(event, n, currentCommands, patch);
+    }
+
+    if (!parsed) return;
+
+    stats.commandsReceived++;
+    handleCommandPatch(patch, "mqtt");
+
+    stats.lastCommandUs = micros() - startUs;
+    if (stats.lastCommandUs > stats.maxCommandUs) stats.maxCommandUs = stats.lastCommandUs;
+    LOGD(MQTT, "Command on %s applied in %lu us", topic, (unsigned long)stats.lastCommandUs);
+}
+
+// ===== Connection =====
+static bool publish(const char *topic, const JsonDocument &doc, bool retained) {
+    char buf[MQTT_BUFFER_SIZE];
+    size_t len = serializeJson(doc, buf, sizeof(buf));
+    if (len == 0 || len >= sizeof(buf)) {
+        stats.publishFailures++;
+        return false;
+    }
+
+    if (!mqtt.publish(topic, (const uint8_t *)buf, len, retained)) {
+        stats.publishFailures++;
+        return false;
+    }
+    stats.published++;
+    stats.bytesPublished += len;
+    return true;
+}
+
+static bool connectBroker() {
+    LOGI(MQTT, "Connecting to %s:%d...", MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+
+    // TCP first with a bounded wait; PubSubClient's own connect() would block
+    // for the full lwIP timeout on an unreachable broker. It reuses the open socket.
+    if (!netClient.connect(MQTT_BROKER_HOST, MQTT_BROKER_PORT, MQTT_CONNECT_TIMEOUT_MS)) {
+        LOGE(MQTT, "❌ Broker unreachable within %d ms", MQTT_CONNECT_TIMEOUT_MS);
+        return false;
+    }
+    if (!mqtt.connect(MQTT_CLIENT_ID, TOPIC_STATUS, 1, true, "offline")) {
+        LOGE(MQTT, "❌ Connect failed, state=%d", mqtt.state());
+        netClient.stop();
+        return false;
+    }
+
+    stats.connects++;
+    mqtt.publish(TOPIC_STATUS, "online", true);
+    mqtt.subscribe(TOPIC_COMMANDS, 1);
+    mqtt.subscribe(TOPIC_COMMANDS "/#", 1);
+
+    // Fresh session: next publishes carry the full state
+    relaysPublished = false;
+    floatPublished = false;
+    lastLive = RealTimeData();
+
+    LOGI(MQTT, "✅ Connected");
+    return true;
+}
+
+void mqtt_transport_init() {
+    mqtt.setServer(MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+    mqtt.setCallback(onMessage);
+    mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+    mqtt.setSocketTimeout(2);
+    mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+    LOGI(MQTT, "Transport initialized");
+}
+
+void mqtt_transport_loop(unsigned long nowMillis) {
+    if (!wifi_is_up()) return;
+
+    if (!mqtt.connected()) {
+        if (reconnectDelay && nowMillis - lastConnectAttempt < reconnectDelay) return;
+        lastConnectAttempt = nowMillis;
+        if (!connectBroker()) {
+            stats.connectFailures++;
+            reconnectDelay = reconnectDelay ? min(reconnectDelay * 2, MQTT_RECONNECT_MAX_MS) : MQTT_RECONNECT_MS;
+            LOGW(MQTT, "Next connect attempt in %lu s", reconnectDelay / 1000);
+            return;
+        }
+        reconnectDelay = MQTT_RECONNECT_MS;
+    }
+
+    mqtt.loop();
+}
+
+bool mqtt_transport_connected() {
+    return mqtt.connected();
+}
+
+// ===== Telemetry =====
+static bool changed(float last, float now) {
+    if (isnan(now)) return false;
+    return isnan(last) || fabsf(now - last) > 0.001f;
+}
+
+bool mqtt_publish_live(const RealTimeData &data, const bool updatedSensors[5]) {
+    if (!mqtt.connected()) return false;
+
+    JsonDocument doc;
+    if (updatedSensors[0] && changed(lastLive.waterTemp, data.waterTemp)) doc["waterTemp"] = data.waterTemp;
+    if (updatedSensors[1] && changed(lastLive.pH, data.pH)) doc["pH"] = data.pH;
+    if (updatedSensors[2] && changed(lastLive.dissolvedOxygen, data.dissolvedOxygen)) doc["dissolvedOxygen"] = data.dissolvedOxygen;
+    if (updatedSensors[3] && changed(lastLive.turbidityNTU, data.turbidityNTU)) doc["turbidityNTU"] = data.turbidityNTU;
+    if (updatedSensors[4]) {
+        if (changed(lastLive.airTemp, data.airTemp)) doc["airTemp"] = data.airTemp;
+        if (changed(lastLive.airHumidity, data.airHumidity)) doc["airHumidity"] = data.airHumidity;
+    }
+    if (!floatPublished || lastLive.floatTriggered != data.floatTriggered) doc["floatTriggered"] = data.floatTriggered;
+
+    if (doc.size() == 0) return false;
+    doc["timestamp"] = time(nullptr);
+
+    if (!publish(TOPIC_LIVE, doc, false)) return false;
+
+    // Remember only what was actually sent
+    if (!doc["waterTemp"].isNull()) lastLive.waterTemp = data.waterTemp;
+    if (!doc["pH"].isNull()) lastLive.pH = data.pH;
+    if (!doc["dissolvedOxygen"].isNull()) lastLive.dissolvedOxygen = data.dissolvedOxygen;
+    if (!doc["turbidityNTU"].isNull()) lastLive.turbidityNTU = data.turbidityNTU;
+    if (!doc["airTemp"].isNull()) lastLive.airTemp = data.airTemp;
+    if (!doc["airHumidity"].isNull()) lastLive.airHumidity = data.airHumidity;
+    lastLive.floatTriggered = data.floatTriggered;
+    floatPublished = true;
+    return true;
+}
+
+bool mqtt_publish_relays(const RealTimeData &data) {
+    if (!mqtt.connected()) return false;
+
+    const auto &now = data.relayStates;
+    const auto &last = lastRelays.relayStates;
+    bool full = !relaysPublished;
+    uint16_t changed = full ? ACTUATOR_MASK : (now.bits ^ last.bits);
+
+    JsonDocument doc;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (changed & (1u << i)) doc[ACTUATORS[i].name] = (bool)(now.bits & (1u << i));
+    }
+    if (full || now.phLowering != last.phLowering)   doc["phLowering"] = now.phLowering;
+    if (full || now.phRaising != last.phRaising)     doc["phRaising"] = now.phRaising;
+    if (full || now.waterChange != last.waterChange) doc["waterChange"] = now.waterChange;
+    if (full || now.sumpCleaning != last.sumpCleaning) doc["sumpCleaning"] = now.sumpCleaning;
+
+    if (doc.size() == 0) return false;
+
+    if (!publish(TOPIC_RELAYS, doc, true)) return false;
+    lastRelays = data;
+    relaysPublished = true;
+    return true;
+}
+
+// ===== Stats =====
+const MqttStats &mqtt_stats() {
+    return stats;
+}
+
+void mqtt_log_stats() {
+    Serial.printf("[MQTT] %s | connects=%lu (%lu failed) published=%lu (%lu B) failed=%lu commands=%lu last=%lu us max=%lu us\n",
+                  mqtt.connected() ? "connected" : "disconnected",
+                  (unsigned long)stats.connects,
+                  (unsigned long)stats.connectFailures,
+                  (unsigned long)stats.published,
+                  (unsigned long)stats.bytesPublished,
+                  (unsigned long)stats.publishFailures,
+                  (unsigned long)stats.commandsReceived,
+                  (unsigned long)stats.lastCommandUs,
+                  (unsigned long)stats.maxCommandUs);
+}
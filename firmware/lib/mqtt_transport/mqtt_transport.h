@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include "sensor_data.h"
+
+// === MQTT telemetry & command transport ===
+// One persistent PubSubClient connection to MQTT_BROKER_HOST.
+//   <prefix>/live       sensor deltas (JSON, only fields that changed)
+//   <prefix>/relays     relay state deltas (JSON, retained)
+//   <prefix>/status     "online" / "offline" (retained, last will)
+//   <prefix>/commands   full or partial Commands object, same shape as RTDB /commands/<id>
+//   <prefix>/commands/<group>/<field>   single field, payload true/false
+
+struct MqttStats {
+    uint32_t connects = 0;
+    uint32_t connectFailures = 0;
+    uint32_t published = 0;
+    uint32_t publishFailures = 0;
+    uint32_t bytesPublished = 0;
+    uint32_t commandsReceived = 0;
+    uint32_t lastCommandUs = 0;      // receive → Commands updated + side effects applied
+    uint32_t maxCommandUs = 0;
+};
+
+void mqtt_transport_init();
+// Keep the connection alive and dispatch incoming commands; call every loop().
+// A connect attempt blocks for at most MQTT_CONNECT_TIMEOUT_MS (TCP) plus the
+// CONNACK wait; failed attempts back off from MQTT_RECONNECT_MS, doubling up
+// to MQTT_RECONNECT_MAX_MS.
+void mqtt_transport_loop(unsigned long nowMillis);
+bool mqtt_transport_connected();
+
+// Publish sensors flagged in updatedSensors (waterTemp, pH, DO, turbidity, air)
+// that differ from the last published value. Returns false if nothing went out.
+bool mqtt_publish_live(const RealTimeData &data, const bool updatedSensors[5]);
+// Publish relay states that changed since the last publish
+bool mqtt_publish_relays(const RealTimeData &data);
+
+const MqttStats &mqtt_stats();
+void mqtt_log_stats();
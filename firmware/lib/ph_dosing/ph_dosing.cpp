@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "ph_dosing.h"
+#include "relay_control.h"
+
+// === Pulse sequencer ===
+void ph_dose_begin(PhDoseState &s, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    s.up = up;
+    s.pumpOn = false;
+    s.pulsesLeft = pulses;
+    s.pulseUs = pulseMs * 1000UL;
+    s.gapUs = gapMs * 1000UL;
+}
+
+uint32_t ph_dose_step(PhDoseState &s) {
+    if (s.pumpOn) {
+        // End of pulse → OFF, then gap (no trailing gap after the last pulse)
+        s.pumpOn = false;
+        if (s.pulsesLeft > 0) s.pulsesLeft--;
+        return s.pulsesLeft > 0 ? s.gapUs : 0;
+    }
+
+    if (s.pulsesLeft == 0) return 0;
+
+    // Start of pulse → ON for pulseUs
+    s.pumpOn = true;
+    return s.pulseUs;
+}
+
+// === esp_timer driver ===
+static esp_timer_handle_t doseTimer = nullptr;
+static portMUX_TYPE doseMux = portMUX_INITIALIZER_UNLOCKED;
+static PhDoseState dose;
+static volatile bool doseActive = false;
+static volatile bool doseCompleted = false;
+static uint32_t outputSeq = 0;      // bumped under doseMux whenever the pump outputs change
+
+// Drive the pumps to what the sequence says now. relay_set()/relay_commit()
+// take relayMux, so this runs outside doseMux (spinlocks must not nest). If
+// the other task changed the outputs in between, its state is written again
+// afterwards, so the last change always wins.
+static void applyPumpOutputs() {
+    for (;;) {
+        portENTER_CRITICAL(&doseMux);
+        bool up = dose.pumpOn && dose.up;
+        bool down = dose.pumpOn && !dose.up;
+        uint32_t seq = outputSeq;
+        portEXIT_CRITICAL(&doseMux);
+
+        control_ph_pump(up, down);
+        relay_commit(millis(), RELAY_MASK_PH);   // pulse edges can't wait for the loop commit
+
+        portENTER_CRITICAL(&doseMux);
+        bool current = seq == outputSeq;
+        portEXIT_CRITICAL(&doseMux);
+        if (current) return;
+    }
+}
+
+// Stop the sequence with both pumps OFF (the next edge could not be armed)
+static void abortDose() {
+    portENTER_CRITICAL(&doseMux);
+    doseActive = false;
+    doseCompleted = false;
+    dose.pumpOn = false;
+    dose.pulsesLeft = 0;
+    outputSeq++;
+    portEXIT_CRITICAL(&doseMux);
+    applyPumpOutputs();
+}
+
+// Runs in the esp_timer task: flip the pump and arm the next edge
+static void onDoseTimer(void *) {
+    uint32_t nextUs;
+
+    portENTER_CRITICAL(&doseMux);
+    if (!doseActive) {
+        portEXIT_CRITICAL(&doseMux);
+        return;
+    }
+    nextUs = ph_dose_step(dose);
+    outputSeq++;
+    if (nextUs == 0) {
+        doseActive = false;
+        doseCompleted = true;
+    }
+    portEXIT_CRITICAL(&doseMux);
+    applyPumpOutputs();
+
+    if (nextUs > 0 && esp_timer_start_once(doseTimer, nextUs) != ESP_OK) {
+        abortDose();
+        Serial.println("[AUTO PH] ❌ Failed to arm next dose edge — dose aborted, pumps OFF");
+    }
+}
+
+void ph_dosing_init() {
+    if (doseTimer) return;
+
+    esp_timer_create_args_t args = {};
+    args.callback = &onDoseTimer;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "ph_dose";
+
+    if (esp_timer_create(&args, &doseTimer) != ESP_OK) {
+        doseTimer = nullptr;
+        Serial.println("[AUTO PH] ❌ Failed to create dosing timer");
+        return;
+    }
+    Serial.println("✅ pH dosing engine initialized.");
+}
+
+bool ph_dosing_start(bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    if (!doseTimer || pulses == 0) return false;
+
+    portENTER_CRITICAL(&doseMux);
+    if (doseActive) {
+        portEXIT_CRITICAL(&doseMux);
+        return false;
+    }
+    ph_dose_begin(dose, up, pulses, pulseMs, gapMs);
+    doseActive = true;
+    doseCompleted = false;
+    portEXIT_CRITICAL(&doseMux);
+
+    // First edge (pump ON) fires from the timer task right away
+    if (esp_timer_start_once(doseTimer, 1) != ESP_OK) {
+        portENTER_CRITICAL(&doseMux);
+        doseActive = false;
+        portEXIT_CRITICAL(&doseMux);
+        Serial.println("[AUTO PH] ❌ Failed to start dosing timer");
+        return false;
+    }
+    return true;
+}
+
+void ph_dosing_cancel() {
+    if (doseTimer) esp_timer_stop(doseTimer);
+    abortDose();
+}
+
+bool ph_dosing_busy() {
+    return doseActive;
+}
+
+bool ph_dosing_take_completed() {
+    portENTER_CRITICAL(&doseMux);
+    bool completed = doseCompleted;
+    doseCompleted = false;
+    portEXIT_CRITICAL(&doseMux);
+    return completed;
+}
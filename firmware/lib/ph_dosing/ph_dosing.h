@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+// === Non-blocking pH dosing engine ===
+// Dose pulses are driven by an esp_timer one-shot instead of delay(),
+// so loop() keeps running (stream, float switch, other rules) while dosing.
+
+// Pulse sequencer state (pure, no hardware access)
+struct PhDoseState {
+    bool up = false;          // true = pH UP pump, false = pH DOWN pump
+    bool pumpOn = false;      // current pump output
+    uint8_t pulsesLeft = 0;   // pulses still to be completed
+    uint32_t pulseUs = 0;     // pump ON width per pulse
+    uint32_t gapUs = 0;       // pump OFF gap between pulses
+};
+
+// Prepare a dose sequence (pump stays OFF until the first step)
+void ph_dose_begin(PhDoseState &s, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs);
+
+// Advance the sequence by one edge.
+// Returns the delay in µs until the next edge, or 0 once the dose is finished.
+uint32_t ph_dose_step(PhDoseState &s);
+
+// === Timer-driven engine ===
+void ph_dosing_init();
+
+// Start a dose; returns false if one is already running or the timer can't be armed
+bool ph_dosing_start(bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs);
+
+// Abort any running dose and force both chemical pumps OFF
+void ph_dosing_cancel();
+
+// True while a dose sequence is running
+bool ph_dosing_busy();
+
+// Returns true exactly once after a dose sequence finished on its own
+bool ph_dosing_take_completed();
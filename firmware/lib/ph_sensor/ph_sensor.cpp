@@ -48,8 +48,7 @@ float read_ph_voltage_avg() {
 }
 
 // --- Convert voltage to pH ---
-float read_ph(float waterTempC = NAN) {
-    float voltage_mV = read_ph_voltage_avg();
+float ph_from_voltage(float voltage_mV, float waterTempC) {
     float ph = ph_slope * voltage_mV + ph_intercept;
 
     // If water temperature is available, apply Nernst-based compensation
@@ -69,3 +68,7 @@ float read_ph(float waterTempC = NAN) {
     return ph;
 }
 
+// --- Read the pin and convert to pH ---
+float read_ph(float waterTempC) {
+    return ph_from_voltage(read_ph_voltage_avg(), waterTempC);
+}
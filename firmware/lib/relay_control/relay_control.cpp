@@ -1,72 +1,151 @@
 #include <Arduino.h>
+#include "soc/gpio_struct.h"
 #include "config.h"
-#include "sensor_data.h"
+#include "relay_control.h"
 
-extern ActuatorState actuators;
-
-// Struct to map relay → actuator boolean
+// Relay pin + protection times
 struct RelayMap {
     int pin;
-    bool* statePtr;
+    unsigned long minOnMs;
+    unsigned long minOffMs;
 };
 
-// === Relay mapping table ===
-RelayMap RELAY_TABLE[] = {
-    { FAN_RELAY_PIN,              &actuators.fan },
-    { LIGHT_RELAY_PIN,            &actuators.light },
-    { PUMP_RELAY_PIN,             &actuators.pump },
-    { VALVE_RELAY_PIN,            &actuators.valve },
-    { WATER_COOLER_RELAY_PIN,     &actuators.cooler },
-    { WATER_HEATER_RELAY_PIN,     &actuators.heater },
-    { PH_LOWERING_RELAY_PIN,      &actuators.phLowering },
-    { PH_RAISING_RELAY_PIN,       &actuators.phRaising },
-    { DRAIN_PUMP_RELAY_PIN,       &actuators.waterChange },
-    { FLUSH_VALVE_RELAY_PIN,      &actuators.sumpWaterValve },
-    { DRAIN_VALVE_RELAY_PIN,      &actuators.sumpDrainValve },
+// === Relay mapping table (indexed by RelayId) ===
+static RelayMap RELAY_TABLE[RELAY_COUNT] = {
+    { FAN_RELAY_PIN,              0, 0 },
+    { LIGHT_RELAY_PIN,            0, 0 },
+    { PUMP_RELAY_PIN,             PUMP_MIN_ON_MS, PUMP_MIN_OFF_MS },
+    { VALVE_RELAY_PIN,            0, 0 },
+    { WATER_COOLER_RELAY_PIN,     COOLER_MIN_ON_MS, COOLER_MIN_OFF_MS },
+    { WATER_HEATER_RELAY_PIN,     HEATER_MIN_ON_MS, HEATER_MIN_OFF_MS },
+    { PH_LOWERING_RELAY_PIN,      0, 0 },
+    { PH_RAISING_RELAY_PIN,       0, 0 },
+    { DRAIN_PUMP_RELAY_PIN,       0, 0 },
+    { FLUSH_VALVE_RELAY_PIN,      0, 0 },
+    { DRAIN_VALVE_RELAY_PIN,      0, 0 },
 };
 
-const int RELAY_COUNT = sizeof(RELAY_TABLE) / sizeof(RELAY_TABLE[0]);
+// All relay pins live in the low GPIO bank (out_w1ts/out_w1tc)
+static_assert(FAN_RELAY_PIN < 32 && LIGHT_RELAY_PIN < 32 && PUMP_RELAY_PIN < 32 &&
+              VALVE_RELAY_PIN < 32 && WATER_COOLER_RELAY_PIN < 32 && WATER_HEATER_RELAY_PIN < 32 &&
+              PH_LOWERING_RELAY_PIN < 32 && PH_RAISING_RELAY_PIN < 32 && DRAIN_PUMP_RELAY_PIN < 32 &&
+              FLUSH_VALVE_RELAY_PIN < 32 && DRAIN_VALVE_RELAY_PIN < 32,
+              "relay pins must be GPIO0-31");
+
+// === Relay bank ===
+void relay_bank_set(RelayBank &bank, RelayId id, bool on) {
+    if (on) bank.requested |= RELAY_BIT(id);
+    else bank.requested &= ~RELAY_BIT(id);
+}
+
+uint16_t relay_bank_commit(RelayBank &bank, unsigned long nowMillis, uint16_t mask) {
+    uint16_t written = 0;
+    uint16_t diff = (bank.requested ^ bank.committed) & mask;
+    for (int i = 0; diff && i < RELAY_COUNT; i++) {
+        uint16_t bit = RELAY_BIT(i);
+        if (!(diff & bit)) continue;
+        diff &= ~bit;
+
+        const RelayMap &relay = RELAY_TABLE[i];
+        bool turningOn = bank.requested & bit;
+        unsigned long minHold = turningOn ? relay.minOffMs : relay.minOnMs;
+        if (minHold && nowMillis - bank.lastChange[i] < minHold) {
+            bank.heldChanges++;
+            continue;
+        }
+
+        bank.lastChange[i] = nowMillis;
+        bank.transitions[i]++;
+        written |= bit;
+    }
+
+    if (written) {
+        bank.committed ^= written;
+        bank.commits++;
+    }
+    return written;
+}
+
+// === Device bank ===
+static portMUX_TYPE relayMux = portMUX_INITIALIZER_UNLOCKED;
+static RelayBank device;
 
 // === Init all relays ===
 void relay_control_init() {
+    uint32_t allPins = 0;
     for (int i = 0; i < RELAY_COUNT; i++) {
+        digitalWrite(RELAY_TABLE[i].pin, HIGH);  // ACTIVE LOW: HIGH = OFF (latched before enabling the output)
         pinMode(RELAY_TABLE[i].pin, OUTPUT);
-        digitalWrite(RELAY_TABLE[i].pin, HIGH);  // ACTIVE LOW: HIGH = OFF
-        *(RELAY_TABLE[i].statePtr) = false;
+        allPins |= 1u << RELAY_TABLE[i].pin;
     }
+    GPIO.out_w1ts = allPins;
 
+    device.requested = 0;
+    device.committed = 0;
     Serial.println("✅ Relay control initialized. All relays OFF.");
 }
 
-// === Unified relay control ===
-void setRelay(int relayPin, bool state) {
-    digitalWrite(relayPin, state ? LOW : HIGH);
+// === Shadow register ===
+void relay_set(RelayId id, bool on) {
+    portENTER_CRITICAL(&relayMux);
+    relay_bank_set(device, id, on);
+    portEXIT_CRITICAL(&relayMux);
+}
 
-    for (int i = 0; i < RELAY_COUNT; i++) {
-        if (RELAY_TABLE[i].pin == relayPin) {
-            *(RELAY_TABLE[i].statePtr) = state;
-            break;
-        }
+uint16_t relay_commit(unsigned long nowMillis, uint16_t mask) {
+    portENTER_CRITICAL(&relayMux);
+    uint16_t written = relay_bank_commit(device, nowMillis, mask);
+
+    // ACTIVE LOW: clear the pin to switch the relay ON
+    uint32_t pinsOn = 0, pinsOff = 0;
+    for (int i = 0; written >> i; i++) {
+        if (!(written & RELAY_BIT(i))) continue;
+        if (device.committed & RELAY_BIT(i)) pinsOn |= 1u << RELAY_TABLE[i].pin;
+        else pinsOff |= 1u << RELAY_TABLE[i].pin;
     }
+    if (pinsOff) GPIO.out_w1ts = pinsOff;
+    if (pinsOn) GPIO.out_w1tc = pinsOn;
+    portEXIT_CRITICAL(&relayMux);
+
+    return written;
+}
+
+bool relay_is_on(RelayId id) {
+    return device.committed & RELAY_BIT(id);
+}
+
+uint16_t relay_pending_mask() {
+    return device.requested ^ device.committed;
+}
+
+uint32_t relay_transitions(RelayId id) {
+    return device.transitions[id];
+}
+
+void relay_log_stats() {
+    Serial.printf("[RELAY] commits=%lu held=%lu pending=0x%03x transitions:",
+                  (unsigned long)device.commits, (unsigned long)device.heldChanges, relay_pending_mask());
+    for (int i = 0; i < RELAY_COUNT; i++) Serial.printf(" %lu", (unsigned long)device.transitions[i]);
+    Serial.println();
 }
 
 // === Component wrappers ===
-void control_fan(bool s)               { setRelay(FAN_RELAY_PIN, s); }
-void control_light(bool s)             { setRelay(LIGHT_RELAY_PIN, s); }
-void control_pump(bool s)              { setRelay(PUMP_RELAY_PIN, s); }
-void control_valve(bool s)             { setRelay(VALVE_RELAY_PIN, s); }
-void control_cooler(bool s)            { setRelay(WATER_COOLER_RELAY_PIN, s); }
-void control_heater(bool s)            { setRelay(WATER_HEATER_RELAY_PIN, s); }
+void control_fan(bool s)               { relay_set(RELAY_FAN, s); }
+void control_light(bool s)             { relay_set(RELAY_LIGHT, s); }
+void control_pump(bool s)              { relay_set(RELAY_PUMP, s); }
+void control_valve(bool s)             { relay_set(RELAY_VALVE, s); }
+void control_cooler(bool s)            { relay_set(RELAY_COOLER, s); }
+void control_heater(bool s)            { relay_set(RELAY_HEATER, s); }
 
 void control_ph_pump(bool up, bool down) {
-    setRelay(PH_LOWERING_RELAY_PIN, down);
-    setRelay(PH_RAISING_RELAY_PIN, up);
+    relay_set(RELAY_PH_LOWERING, down);
+    relay_set(RELAY_PH_RAISING, up);
 }
 
-void control_drain(bool s)             { setRelay(DRAIN_PUMP_RELAY_PIN, s); }
+void control_drain(bool s)             { relay_set(RELAY_DRAIN_PUMP, s); }
 
 
 void control_sump_cleaning(bool waterValve, bool drainValve) {
-    setRelay(FLUSH_VALVE_RELAY_PIN, waterValve);
-    setRelay(DRAIN_VALVE_RELAY_PIN, drainValve);
+    relay_set(RELAY_FLUSH_VALVE, waterValve);
+    relay_set(RELAY_DRAIN_VALVE, drainValve);
 }
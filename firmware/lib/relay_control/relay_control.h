@@ -1,7 +1,60 @@
 #pragma once
 #include <Arduino.h>
+#include "actuator_table.h"
+
+// === Shadow-register relay driver ===
+// control_*() only update a shadow bitmask of requested states. relay_commit()
+// writes every changed relay in one GPIO.out_w1ts / out_w1tc pair, holding back
+// changes that would violate a relay's minimum on/off time.
+// The driver never writes ActuatorState; read physical states via relay_is_on().
+//
+// The shadow state and hold rules live in a RelayBank, so several banks can
+// run side by side (host tuner); relay_*() drive the device bank and its pins.
+
+// Table actuators come first so RelayId == ActuatorIndex for them
+enum RelayId : uint8_t {
+    ACTUATOR_TABLE(ACTUATOR_RELAY_ID)
+    RELAY_PH_LOWERING,
+    RELAY_PH_RAISING,
+    RELAY_DRAIN_PUMP,
+    RELAY_FLUSH_VALVE,
+    RELAY_DRAIN_VALVE,
+    RELAY_COUNT
+};
+
+#define RELAY_BIT(id)       ((uint16_t)(1u << (id)))
+#define RELAY_MASK_ALL      ((uint16_t)((1u << RELAY_COUNT) - 1))
+#define RELAY_MASK_PH       (RELAY_BIT(RELAY_PH_LOWERING) | RELAY_BIT(RELAY_PH_RAISING))
+
+// Requested/committed bits, hold timers and counters of one set of relays
+struct RelayBank {
+    uint16_t requested = 0;                       // bit set = relay ON requested
+    uint16_t committed = 0;                       // bit set = relay ON at the pin
+    unsigned long lastChange[RELAY_COUNT] = {0};  // 0 at boot: min-off also covers power-up
+    uint32_t transitions[RELAY_COUNT] = {0};
+    uint32_t commits = 0;
+    uint32_t heldChanges = 0;
+};
+
+void relay_bank_set(RelayBank &bank, RelayId id, bool on);
+// Commit the pending changes within `mask` their min on/off time allows.
+// Returns the bits that changed; no pins are touched.
+uint16_t relay_bank_commit(RelayBank &bank, unsigned long nowMillis, uint16_t mask = RELAY_MASK_ALL);
 
 void relay_control_init();
+
+// Request a state; takes effect on the next relay_commit()
+void relay_set(RelayId id, bool on);
+
+// Write pending changes within `mask` to the pins. Returns the bits written.
+uint16_t relay_commit(unsigned long nowMillis, uint16_t mask = RELAY_MASK_ALL);
+
+bool relay_is_on(RelayId id);          // physical (committed) state
+uint16_t relay_pending_mask();         // requested but not yet written (e.g. held by min on/off)
+uint32_t relay_transitions(RelayId id);
+void relay_log_stats();
+
+// === Component wrappers ===
 void control_fan(bool state);
 void control_light(bool state);
 void control_pump(bool state);
@@ -3,10 +3,13 @@
 #include "rule_engine.h"
 #include "sensor_data.h"
 #include "relay_control.h"
+#include "ph_dosing.h"
 #include "float_switch.h"
 #include "firebase.h"
+#include "wifi_manager.h"
 #include <time.h>
 #include "time_utils.h"
+#include "logger.h"
 
 // === External globals ===
 extern RealTimeData current;
@@ -15,227 +18,192 @@ extern Commands currentCommands;
 extern unsigned long lastStreamUpdate;
 extern unsigned long lastRelaySync;
 
-// === RULE EVALUATION ENTRY ===
-void evaluateRules(bool forceImmediate) {
-    unsigned long nowMillis = millis();
+// === Device bindings ===
+static void deviceSetRelay(void *, RelayId id, bool on) {
+    relay_set(id, on);
+}
+
+static bool deviceDoseStart(void *, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    return ph_dosing_start(up, pulses, pulseMs, gapMs);
+}
+
+static void deviceDoseCancel(void *) { ph_dosing_cancel(); }
+static bool deviceDoseBusy(void *) { return ph_dosing_busy(); }
+static bool deviceDoseTakeCompleted(void *) { return ph_dosing_take_completed(); }
+
+static bool deviceLocalTime(void *, struct tm &out) {
+    return isTimeAvailable() && getLocalTm(out);
+}
+
+static RuleIo deviceIo() {
+    RuleIo io;
+    io.setRelay = deviceSetRelay;
+    io.doseStart = deviceDoseStart;
+    io.doseCancel = deviceDoseCancel;
+    io.doseBusy = deviceDoseBusy;
+    io.doseTakeCompleted = deviceDoseTakeCompleted;
+    io.localTime = deviceLocalTime;
+    return io;
+}
+
+RuleEngine deviceRules(deviceIo());
+
+// === Output helpers ===
+static inline void setRelay(RuleEngine &re, RelayId id, bool on) {
+    re.io.setRelay(re.io.ctx, id, on);
+}
 
+static inline void setSumpValves(RuleEngine &re, bool waterValve, bool drainValve) {
+    setRelay(re, RELAY_FLUSH_VALVE, waterValve);
+    setRelay(re, RELAY_DRAIN_VALVE, drainValve);
+}
+
+static inline void doseCancel(RuleEngine &re) {
+    re.io.doseCancel(re.io.ctx);
+}
+
+// === RULE EVALUATION ENTRY ===
+void evaluateRules(bool forceImmediate, unsigned long nowMillis) {
     // Note: pH pump logic runs independently in main loop - no Firebase dependency
     // It's called every loop iteration for proper non-blocking timing control
     
-    bool wifiUp = (WiFi.status() == WL_CONNECTED);
+    bool wifiUp = wifi_is_up();
     bool fbReady = isFirebaseReady();
     bool cmdsSynced = isInitialCommandsSynced();
 
     // Allow local automation even if Firebase is not ready
     if (!wifiUp || !fbReady || !cmdsSynced) {
-        Serial.println("[EVAL] Firebase/WiFi not ready — running LOCAL automation only");
-        applyRulesWithModeControl(current, actuators, currentCommands, nowMillis);
+        LOGD(EVAL, "Firebase/WiFi not ready — running LOCAL automation only");
+        applyRulesWithModeControl(deviceRules, current, actuators, currentCommands, nowMillis);
         return;
     }
 
     // Apply rules — rule function handles auto flags internally
-    applyRulesWithModeControl(current, actuators, currentCommands, nowMillis);
+    applyRulesWithModeControl(deviceRules, current, actuators, currentCommands, nowMillis);
 
     // Sync and reflect states
     if (wifiUp && fbReady && cmdsSynced) {
         bool debounceOk = (millis() - lastStreamUpdate > 5000) &&
                           (millis() - lastRelaySync > RELAY_SYNC_COOLDOWN);
         if (forceImmediate || debounceOk) {
-            syncRelayState(current, currentCommands);
-            // Use empty array if no sensors updated (for relay state sync only)
+            // Relay state + live timestamp in one request
             bool emptySensors[6] = {false, false, false, false, false, false};
-            pushToRTDBLive(current, emptySensors);
+            pushLiveAndRelayState(current, currentCommands, emptySensors);
             lastRelaySync = millis();
         } else {
-            Serial.println("[EVAL] Skipping sync — debounce/cooldown active");
+            LOGD(EVAL, "Skipping sync — debounce/cooldown active");
         }
     }
 }
 
 
 // --- MAIN ENTRY ---
-void applyRulesWithModeControl(RealTimeData& data,
+void applyRulesWithModeControl(RuleEngine &re,
+    RealTimeData& data,
     ActuatorState& actuators,
     Commands& commands,
     unsigned long nowMillis) {
-    Serial.println("[RULE_ENGINE] Applying mode-aware rules");
+    LOGD(RULES, "Applying mode-aware rules");
 
     if (actuators.emergencyMode) {
-        Serial.println("[RULE_ENGINE] 🔒 Emergency active — skipping AUTO/MANUAL logic");
+        LOGD(RULES, "🔒 Emergency active — skipping AUTO/MANUAL logic");
         return;
     }
 
     // ===== 2. AUTO/MANUAL MODE PROCESSING =====
-    static bool prevFanAuto   = true;
-    static bool prevLightAuto = true;
-    static bool prevPumpAuto  = true;
-    static bool prevValveAuto = true;
-    static bool prevCoolerAuto = true;
-    static bool prevHeaterAuto = true;
-    static bool prevPhDosingEnabled = true;
-
-    bool fanAutoTransition   = commands.fan.isAuto   && !prevFanAuto;
-    bool lightAutoTransition = commands.light.isAuto && !prevLightAuto;
-    bool pumpAutoTransition  = commands.pump.isAuto  && !prevPumpAuto;
-    bool valveAutoTransition = commands.valve.isAuto && !prevValveAuto;
-    bool coolerAutoTransition = commands.cooler.isAuto && !prevCoolerAuto;
-    bool heaterAutoTransition = commands.heater.isAuto && !prevHeaterAuto;
-    bool phDosingTransition = commands.phDosing.phDosingEnabled && !prevPhDosingEnabled;
-
-    // --- FAN ---
-    if (!commands.fan.isAuto) {
-        actuators.fanAuto = false;
-        actuators.fan = commands.fan.value;
-        Serial.printf("[RULE_ENGINE] 🌀 Fan MANUAL from RTDB: %s\n", actuators.fan ? "ON" : "OFF");
-    } else {
-        actuators.fanAuto = true;
-        if (fanAutoTransition) {
-            actuators.fanAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 🌀 Fan AUTO re-enabled — evaluating now");
-        }
-    }
-
-    // --- LIGHT ---
-    if (!commands.light.isAuto) {
-        actuators.lightAuto = false;
-        actuators.light = commands.light.value;
-        Serial.printf("[RULE_ENGINE] 💡 Light MANUAL from RTDB: %s\n", actuators.light ? "ON" : "OFF");
-    } else {
-        actuators.lightAuto = true;
-        if (lightAutoTransition) {
-            actuators.lightAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 💡 Light AUTO re-enabled — evaluating now");
-        }
-    }
-
-    // --- PUMP ---
-    if (!commands.pump.isAuto) {
-        actuators.pumpAuto = false;
-        actuators.pump = commands.pump.value;
-        Serial.printf("[RULE_ENGINE] 💧 Pump MANUAL from RTDB: %s\n", actuators.pump ? "ON" : "OFF");
-    } else {
-        actuators.pumpAuto = true;
-        if (pumpAutoTransition) {
-            actuators.pumpAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 💧 Pump AUTO re-enabled — evaluating now");
-        }
-    }
-
-    // --- VALVE ---
-    if (!commands.valve.isAuto) {
-        actuators.valveAuto = false;
-        actuators.valve = commands.valve.value;
-        Serial.printf("[RULE_ENGINE] 🚰 Valve MANUAL from RTDB: %s\n", actuators.valve ? "ON" : "OFF");
-    } else {
-        actuators.valveAuto = true;
-        if (valveAutoTransition) {
-            actuators.valveAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 🚰 Valve AUTO re-enabled — evaluating now");
-        }
-    }
+    uint16_t &prevAutoMask = re.state.prevAutoMask;
+    bool &prevPhDosingEnabled = re.state.prevPhDosingEnabled;
 
-    // --- COOLER ---
-    if (!commands.cooler.isAuto) {
-        actuators.coolerAuto = false;
-        actuators.cooler = commands.cooler.value;
-        Serial.printf("[RULE_ENGINE] 💨 Water Cooler MANUAL from RTDB: %s\n", actuators.cooler ? "ON" : "OFF");
-    } else {
-        actuators.coolerAuto = true;
-        if (coolerAutoTransition) {
-            actuators.coolerAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 💨 Water Cooler AUTO re-enabled — evaluating now");
-        }
-    }
+    uint16_t autoMask = commands_auto_mask(commands);
+    uint16_t autoTransitions = autoMask & ~prevAutoMask;
+    bool phDosingTransition = commands.phDosing.phDosingEnabled && !prevPhDosingEnabled;
 
-    // --- HEATER ---
-    if (!commands.heater.isAuto) {
-        actuators.heaterAuto = false;
-        actuators.heater = commands.heater.value;
-        Serial.printf("[RULE_ENGINE] 🔥 Water Heater MANUAL from RTDB: %s\n", actuators.heater ? "ON" : "OFF");
-    } else {
-        actuators.heaterAuto = true;
-        if (heaterAutoTransition) {
-            actuators.heaterAutoJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 🔥 Water Heater AUTO re-enabled — evaluating now");
+    // --- Table actuators (fan, light, pump, valve, cooler, heater) ---
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const ActuatorDescriptor &act = ACTUATORS[i];
+        const CommandState &cmd = commands.*act.command;
+        uint16_t bit = 1u << i;
+
+        if (!cmd.isAuto) {
+            actuators.autoBits &= ~bit;
+            if (cmd.value) actuators.stateBits |= bit;
+            else actuators.stateBits &= ~bit;
+            LOGD(RULES, "%s MANUAL from RTDB: %s", act.label, cmd.value ? "ON" : "OFF");
+        } else {
+            actuators.autoBits |= bit;
+            if (autoTransitions & bit) {
+                actuators.justEnabledBits |= bit;
+                LOGI(RULES, "%s AUTO re-enabled — evaluating now", act.label);
+            }
         }
     }
 
     // --- PH DOSING ---
     if (!commands.phDosing.phDosingEnabled) {
         if (actuators.phDosingEnabled) {
-            Serial.println("[RULE_ENGINE] 🧪 pH dosing DISABLED via RTDB — halting automation");
+            LOGI(RULES, "🧪 pH dosing DISABLED via RTDB — halting automation");
         }
         actuators.phDosingEnabled = false;
         actuators.phDosingJustEnabled = false;
-        if (actuators.phRaising || actuators.phLowering) {
-            control_ph_pump(false, false);
+        if (actuators.phRaising || actuators.phLowering || re.io.doseBusy(re.io.ctx)) {
+            doseCancel(re);
             actuators.phRaising = false;
             actuators.phLowering = false;
-            Serial.println("[RULE_ENGINE] 🧪 Chemical pumps OFF (manual disable)");
+            LOGI(RULES, "🧪 Chemical pumps OFF (manual disable)");
         }
     } else {
         if (!actuators.phDosingEnabled) {
-            Serial.println("[RULE_ENGINE] 🧪 pH dosing AUTO re-enabled — monitoring pH");
+            LOGI(RULES, "🧪 pH dosing AUTO re-enabled — monitoring pH");
         }
         actuators.phDosingEnabled = true;
         if (phDosingTransition) {
             actuators.phDosingJustEnabled = true;
-            Serial.println("[RULE_ENGINE] 🧪 pH dosing toggle detected — resetting algorithm timers");
+            LOGI(RULES, "🧪 pH dosing toggle detected — resetting algorithm timers");
         }
     }
 
     // ===== 3. AUTO CONTROL RULES =====
-    if (actuators.fanAuto)   checkFanAndGrowLightLogic(actuators, data.airTemp, data.airHumidity, nowMillis);
-    if (actuators.lightAuto) checkLightLogic(actuators, nowMillis);
-    if (actuators.pumpAuto)  checkPumpLogic(actuators, nowMillis);
-    if (actuators.valveAuto) checkValveLogic(actuators, data.floatTriggered, nowMillis);
-    if (actuators.coolerAuto) checkCoolerLogic(actuators, data.waterTemp, nowMillis);
-    if (actuators.heaterAuto) checkHeaterLogic(actuators, data.waterTemp, nowMillis);
+    if (actuators.fanAuto)   checkFanAndGrowLightLogic(re, actuators, data.airTemp, data.airHumidity, nowMillis);
+    if (actuators.lightAuto) checkLightLogic(re, actuators, nowMillis);
+    if (actuators.pumpAuto)  checkPumpLogic(re, actuators, nowMillis);
+    if (actuators.valveAuto) checkValveLogic(re, actuators, data.floatTriggered, nowMillis);
+    if (actuators.coolerAuto) checkCoolerLogic(re, actuators, data.waterTemp, nowMillis);
+    if (actuators.heaterAuto) checkHeaterLogic(re, actuators, data.waterTemp, nowMillis);
 
     // Water change and sump cleaning logic (handles both manual and auto internally)
-    checkWaterChangeLogic(actuators, commands, data.dissolvedOxygen, nowMillis);
-    checkSumpCleaningLogic(actuators, commands, data.turbidityNTU, nowMillis);
+    checkWaterChangeLogic(re, actuators, commands, data.dissolvedOxygen, nowMillis);
+    checkSumpCleaningLogic(re, actuators, commands, data.turbidityNTU, nowMillis);
 
     // ===== 4. APPLY FINAL STATES =====
-    control_fan(actuators.fan);
-    control_light(actuators.light);
-    control_pump(actuators.pump);
-    control_valve(actuators.valve);
-    control_cooler(actuators.cooler);
-    control_heater(actuators.heater);
-
-    extern RealTimeData current;
-    current.relayStates.fan       = actuators.fan;
-    current.relayStates.light     = actuators.light;
-    current.relayStates.waterPump = actuators.pump;
-    current.relayStates.valve     = actuators.valve;
-    current.relayStates.cooler    = actuators.cooler;
-    current.relayStates.heater    = actuators.heater;
-
-    Serial.printf("[RULE_ENGINE] Final states - Fan:%s(%s) Light:%s(%s) Pump:%s(%s) Valve:%s(%s) Cooler:%s(%s) Heater:%s(%s)\n",
-                  actuators.fan ? "ON" : "OFF", actuators.fanAuto ? "AUTO" : "MANUAL",
-                  actuators.light ? "ON" : "OFF", actuators.lightAuto ? "AUTO" : "MANUAL",
-                  actuators.pump ? "ON" : "OFF", actuators.pumpAuto ? "AUTO" : "MANUAL",
-                  actuators.valve ? "ON" : "OFF", actuators.valveAuto ? "AUTO" : "MANUAL",
-                  actuators.cooler ? "ON" : "OFF", actuators.coolerAuto ? "AUTO" : "MANUAL",
-                  actuators.heater ? "ON" : "OFF", actuators.heaterAuto ? "AUTO" : "MANUAL");
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        setRelay(re, (RelayId)i, actuators.stateBits & (1u << i));
+    }
+
+    reflect_actuator_relays(data, actuators);
+
+    if (LOG_ENABLED(RULES, LOG_LEVEL_DEBUG)) {
+        char line[LOG_LINE_MAX];
+        size_t n = snprintf(line, sizeof(line), "Final states -");
+        for (int i = 0; i < ACTUATOR_COUNT && n < sizeof(line); i++) {
+            uint16_t bit = 1u << i;
+            n += snprintf(line + n, sizeof(line) - n, " %s:%s(%s)", ACTUATORS[i].name,
+                          (actuators.stateBits & bit) ? "ON" : "OFF",
+                          (actuators.autoBits & bit) ? "AUTO" : "MANUAL");
+        }
+        LOGD(RULES, "%s", line);
+    }
 
     // Update previous state trackers
-    prevFanAuto   = commands.fan.isAuto;
-    prevLightAuto = commands.light.isAuto;
-    prevPumpAuto  = commands.pump.isAuto;
-    prevValveAuto = commands.valve.isAuto;
-    prevCoolerAuto = commands.cooler.isAuto;
-    prevHeaterAuto = commands.heater.isAuto;
+    prevAutoMask = autoMask;
     prevPhDosingEnabled = commands.phDosing.phDosingEnabled;
 }
 
 // ===== FALLBACK CONTROL FUNCTIONS =====
-void checkValveLogic(ActuatorState& actuators, bool waterLevelLow, unsigned long nowMillis) {
-    static unsigned long floatLowSince  = 0;
-    static unsigned long floatHighSince = 0;
-    static bool intentPrinted = false;
-    static bool prevValveState = false;
+void checkValveLogic(RuleEngine &re, ActuatorState& actuators, bool waterLevelLow, unsigned long nowMillis) {
+    unsigned long &floatLowSince  = re.state.valve.floatLowSince;
+    unsigned long &floatHighSince = re.state.valve.floatHighSince;
+    bool &intentPrinted = re.state.valve.intentPrinted;
+    bool &prevValveState = re.state.valve.prevValveState;
 
     // Reset timers when auto mode re-enabled
     if (actuators.valveAutoJustEnabled) {
@@ -250,26 +218,26 @@ void checkValveLogic(ActuatorState& actuators, bool waterLevelLow, unsigned long
         if (floatLowSince == 0) floatLowSince = nowMillis;
         floatHighSince = 0;
         if (!intentPrinted && !actuators.valve) {
-            Serial.println("[RULE_ENGINE] [INTENT] Float LOW detected — valve about to OPEN");
+            LOGI(RULES, "[INTENT] Float LOW detected — valve about to OPEN");
             intentPrinted = true;
         }
     } else {
         if (floatHighSince == 0) floatHighSince = nowMillis;
         floatLowSince = 0;
         if (!intentPrinted && actuators.valve) {
-            Serial.println("[RULE_ENGINE] [INTENT] Float HIGH detected — valve about to CLOSE");
+            LOGI(RULES, "[INTENT] Float HIGH detected — valve about to CLOSE");
             intentPrinted = true;
         }
     }
 
-    bool lowStable  = waterLevelLow  && (nowMillis - floatLowSince  >= FLOAT_LOW_DEBOUNCE_MS); //3000;
-    bool highStable = !waterLevelLow && (nowMillis - floatHighSince >= FLOAT_HIGH_DEBOUNCE_MS); //3000;
+    bool lowStable  = waterLevelLow  && (nowMillis - floatLowSince  >= re.params.floatLowDebounceMs);
+    bool highStable = !waterLevelLow && (nowMillis - floatHighSince >= re.params.floatHighDebounceMs);
 
     // Stable LOW → valve ON
     if (lowStable && !actuators.valve) {
         actuators.valve = true;
         intentPrinted = false; // reset after applying action
-        Serial.println("[RULE_ENGINE] 🚰 Valve AUTO OPEN — low water confirmed");
+        LOGI(RULES, "🚰 Valve AUTO OPEN — low water confirmed");
     }
 
     // Stable HIGH → valve OFF
@@ -277,23 +245,23 @@ void checkValveLogic(ActuatorState& actuators, bool waterLevelLow, unsigned long
         actuators.valve = false;
         intentPrinted = false; // reset after applying action
         floatLowSince = 0;
-        Serial.println("[RULE_ENGINE] ✅ Valve AUTO CLOSED — water level normal");
+        LOGI(RULES, "✅ Valve AUTO CLOSED — water level normal");
     }
 
     // Apply relay control if changed
     if (actuators.valve != prevValveState) {
-        control_valve(actuators.valve);
+        setRelay(re, RELAY_VALVE, actuators.valve);
         prevValveState = actuators.valve;
     }
 }
 
-void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis) {
-    static unsigned long lastToggle = 0;
-    static bool pumpWasOn = false;
-    static bool firstRun = true;
+void checkPumpLogic(RuleEngine &re, ActuatorState& actuators, unsigned long nowMillis) {
+    unsigned long &lastToggle = re.state.pumpCycle.lastToggle;
+    bool &pumpWasOn = re.state.pumpCycle.wasOn;
+    bool &firstRun = re.state.pumpCycle.firstRun;
 
-    const unsigned long ON_DURATION  = PUMP_ON_DURATION  * 60 * 1000UL;
-    const unsigned long OFF_DURATION = PUMP_OFF_DURATION * 60 * 1000UL;
+    const unsigned long ON_DURATION  = re.params.pumpOnMs;
+    const unsigned long OFF_DURATION = re.params.pumpOffMs;
 
     if (firstRun) {
         lastToggle = nowMillis - OFF_DURATION;
@@ -310,12 +278,12 @@ void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis) {
 
         if (inOnPhase) {
             actuators.pump = true;
-            Serial.printf("[RULE_ENGINE] 💧 Pump AUTO re-enabled — resuming ON phase (%.1f min left)\n",
-                          (ON_DURATION - elapsed) / 60000.0);
+            LOGI(RULES, "💧 Pump AUTO re-enabled — resuming ON phase (%.1f min left)",
+                 (ON_DURATION - elapsed) / 60000.0);
         } else if (inOffPhase) {
             actuators.pump = false;
-            Serial.printf("[RULE_ENGINE] 💧 Pump AUTO re-enabled — resuming OFF phase (%.1f min left)\n",
-                          (OFF_DURATION - elapsed) / 60000.0);
+            LOGI(RULES, "💧 Pump AUTO re-enabled — resuming OFF phase (%.1f min left)",
+                 (OFF_DURATION - elapsed) / 60000.0);
         } else {
             // cycle complete → toggle
             actuators.pump = !pumpWasOn;
@@ -323,7 +291,7 @@ void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis) {
         }
 
         pumpWasOn = actuators.pump;
-        control_pump(actuators.pump);
+        setRelay(re, RELAY_PUMP, actuators.pump);
         return;
     }
 
@@ -331,8 +299,8 @@ void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis) {
     if (actuators.valve) {
         if (actuators.pump) {
             actuators.pump = false;
-            Serial.println("[RULE_ENGINE] 💧 Pump OFF — valve open, refilling water");
-            control_pump(false);
+            LOGI(RULES, "💧 Pump OFF — valve open, refilling water");
+            setRelay(re, RELAY_PUMP, false);
         }
         return; // skip normal schedule while refilling
     }
@@ -343,41 +311,42 @@ void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis) {
         actuators.pump = false;
         lastToggle = nowMillis;
         pumpWasOn = false;
-        Serial.println("[RULE_ENGINE] 💧 Pump OFF — schedule");
-        control_pump(false);
+        LOGI(RULES, "💧 Pump OFF — schedule");
+        setRelay(re, RELAY_PUMP, false);
     } else if (!pumpWasOn && elapsed >= OFF_DURATION) {
         actuators.pump = true;
         lastToggle = nowMillis;
         pumpWasOn = true;
-        Serial.println("[RULE_ENGINE] 💧 Pump ON — schedule");
-        control_pump(true);
+        LOGI(RULES, "💧 Pump ON — schedule");
+        setRelay(re, RELAY_PUMP, true);
     }
 }
 
-void checkFanAndGrowLightLogic(ActuatorState& actuators, float t, float h, unsigned long now) {
+void checkFanAndGrowLightLogic(RuleEngine &re, ActuatorState& actuators, float t, float h, unsigned long now) {
     if (isnan(t) || isnan(h)) return;
 
-    static unsigned long last = 0;
+    const RuleParams &p = re.params;
+    unsigned long &last = re.state.fanLast;
     const unsigned long DEBOUNCE = 5000;
 
     // Auto re-enable sync for fan
     if (actuators.fanAutoJustEnabled) {
         actuators.fanAutoJustEnabled = false;
-        actuators.fan = (t >= TEMP_ON_THRESHOLD);
-        control_fan(actuators.fan);
+        actuators.fan = (t >= p.fanOnTemp);
+        setRelay(re, RELAY_FAN, actuators.fan);
         last = now;
-        Serial.printf("[RULE_ENGINE] Fan AUTO sync → %s (T=%.1f, H=%.1f)\n",
-                      actuators.fan ? "ON" : "OFF", t, h);
+        LOGI(RULES, "Fan AUTO sync → %s (T=%.1f, H=%.1f)",
+             actuators.fan ? "ON" : "OFF", t, h);
         return;
     }
 
     if (!actuators.fanAuto) return;
 
     // --- Fan Logic ---
-    bool tooHot = t >= TEMP_ON_THRESHOLD;          // 29C
-    bool coolEnough = t <= TEMP_OFF_THRESHOLD;     // 26C
-    bool tooHumid = h >= HUMIDITY_MAX_THRESHOLD;   // 70%
-    bool dryEnough = h <= HUMIDITY_MIN_THRESHOLD;  // 60%
+    bool tooHot = t >= p.fanOnTemp;
+    bool coolEnough = t <= p.fanOffTemp;
+    bool tooHumid = h >= p.fanOnHumidity;
+    bool dryEnough = h <= p.fanOffHumidity;
 
     bool turnOnFan = tooHot || tooHumid;
     bool turnOffFan = coolEnough && dryEnough;
@@ -385,81 +354,80 @@ void checkFanAndGrowLightLogic(ActuatorState& actuators, float t, float h, unsig
     // Fan control logic
     if (turnOnFan && !actuators.fan && now - last > DEBOUNCE) {
         actuators.fan = true;
-        control_fan(true);
+        setRelay(re, RELAY_FAN, true);
         last = now;
-        Serial.printf("[RULE_ENGINE] Fan ON (T=%.1f, H=%.1f)\n", t, h);
+        LOGI(RULES, "Fan ON (T=%.1f, H=%.1f)", t, h);
     }
     else if (turnOffFan && actuators.fan && now - last > DEBOUNCE) {
         actuators.fan = false;
-        control_fan(false);
+        setRelay(re, RELAY_FAN, false);
         last = now;
-        Serial.printf("[RULE_ENGINE] Fan OFF (T=%.1f, H=%.1f)\n", t, h);    
+        LOGI(RULES, "Fan OFF (T=%.1f, H=%.1f)", t, h);
     }
 
     // --- Skip Light Control if it's Managed by the Schedule (checkLightLogic) ---
     if (actuators.lightAuto && actuators.light) {
         // Light is on due to schedule, skip grow light logic
-        Serial.println("[RULE_ENGINE] Skipping Grow Light Control - Light ON due to schedule");
+        LOGD(RULES, "Skipping Grow Light Control - Light ON due to schedule");
         return;
     }
 
     // --- Grow Light Control Logic based on Temperature Thresholds ---
-    bool turnOnGrowLight = t <= TEMP_LOW_THRESHOLD;     // Temperature below 18°C
-    bool turnOffGrowLight = t >= TEMP_HIGH_THRESHOLD;   // Temperature above 24°C
+    bool turnOnGrowLight = t <= p.growLightOnTemp;
+    bool turnOffGrowLight = t >= p.growLightOffTemp;
 
     // Trigger grow light (only if it's not controlled by schedule)
     if (turnOnGrowLight && !actuators.light && now - last > DEBOUNCE) {
         actuators.light = true;
-        control_light(true);
+        setRelay(re, RELAY_LIGHT, true);
         last = now;
-        Serial.printf("[RULE_ENGINE] Grow Light ON (T=%.1f)\n", t);
+        LOGI(RULES, "Grow Light ON (T=%.1f)", t);
     }
     else if (turnOffGrowLight && actuators.light && now - last > DEBOUNCE) {
         actuators.light = false;
-        control_light(false);
+        setRelay(re, RELAY_LIGHT, false);
         last = now;
-        Serial.printf("[RULE_ENGINE] Grow Light OFF (T=%.1f)\n", t);    
+        LOGI(RULES, "Grow Light OFF (T=%.1f)", t);
     }
 }
 
-void checkLightLogic(ActuatorState& actuators, unsigned long nowMillis) {
-    static bool prevLight = false;
+void checkLightLogic(RuleEngine &re, ActuatorState& actuators, unsigned long) {
+    bool &prevLight = re.state.prevLight;
 
     if (actuators.lightAutoJustEnabled) actuators.lightAutoJustEnabled = false;
 
-    if (isTimeAvailable()) {    
-        struct tm timeinfo;
-        if (getLocalTm(timeinfo)) {
-            int currentMinutes = timeinfo.tm_hour * 60 + timeinfo.tm_min;
-            bool shouldBeOn =
-                (currentMinutes >= LIGHT_MORNING_ON  && currentMinutes < LIGHT_MORNING_OFF) ||
-                (currentMinutes >= LIGHT_EVENING_ON && currentMinutes < LIGHT_EVENING_OFF);
-
-            if (shouldBeOn && !actuators.light) {
-                actuators.light = true;
-                Serial.printf("[RULE_ENGINE] 💡 Light AUTO ON — %02d:%02d\n", timeinfo.tm_hour, timeinfo.tm_min);
-            } else if (!shouldBeOn && actuators.light) {
-                actuators.light = false;
-                Serial.printf("[RULE_ENGINE] 💡 Light AUTO OFF — %02d:%02d\n", timeinfo.tm_hour, timeinfo.tm_min);
-            }
+    struct tm timeinfo;
+    if (re.io.localTime(re.io.ctx, timeinfo)) {
+        int currentMinutes = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+        bool shouldBeOn =
+            (currentMinutes >= LIGHT_MORNING_ON  && currentMinutes < LIGHT_MORNING_OFF) ||
+            (currentMinutes >= LIGHT_EVENING_ON && currentMinutes < LIGHT_EVENING_OFF);
+
+        if (shouldBeOn && !actuators.light) {
+            actuators.light = true;
+            LOGI(RULES, "💡 Light AUTO ON — %02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
+        } else if (!shouldBeOn && actuators.light) {
+            actuators.light = false;
+            LOGI(RULES, "💡 Light AUTO OFF — %02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
         }
     } else if (actuators.light) {
         actuators.light = false;
-        Serial.println("[RULE_ENGINE] 💡 Light AUTO OFF — No time available");
+        LOGI(RULES, "💡 Light AUTO OFF — No time available");
     }
 
     if (actuators.light != prevLight) {
-        control_light(actuators.light);
+        setRelay(re, RELAY_LIGHT, actuators.light);
         prevLight = actuators.light;
     }
 }
 
-void checkCoolerLogic(ActuatorState &actuators, float waterTemp, unsigned long nowMillis)
+void checkCoolerLogic(RuleEngine &re, ActuatorState &actuators, float waterTemp, unsigned long nowMillis)
 {
     if (isnan(waterTemp)) return;
     if (!actuators.coolerAuto) return;
 
-    static unsigned long last = 0;
+    const RuleParams &p = re.params;
+    unsigned long &last = re.state.coolerLast;
     const unsigned long DEBOUNCE_MS = 5000;
 
 
@@ -467,192 +435,186 @@ void checkCoolerLogic(ActuatorState &actuators, float waterTemp, unsigned long n
     if (actuators.coolerAutoJustEnabled) {
         actuators.coolerAutoJustEnabled = false;
 
-        if (waterTemp >= COOLER_ON_TEMP) {
+        if (waterTemp >= p.coolerOnTemp) {
             actuators.cooler = true;
-        } else if (waterTemp <= COOLER_OFF_TEMP) {
+        } else if (waterTemp <= p.coolerOffTemp) {
             actuators.cooler = false;
         }
 
-        control_cooler(actuators.cooler);
+        setRelay(re, RELAY_COOLER, actuators.cooler);
         last = nowMillis;
 
-        Serial.printf("[RULE_ENGINE] 💨 Fan AUTO re-enabled → %s (waterTemp=%.2f°C)\n",
-                      actuators.cooler ? "ON" : "OFF", waterTemp);
+        LOGI(RULES, "💨 Fan AUTO re-enabled → %s (waterTemp=%.2f°C)",
+             actuators.cooler ? "ON" : "OFF", waterTemp);
         return;
     }
 
-    bool tooHot     = (waterTemp >= COOLER_ON_TEMP);
-    bool coolEnough = (waterTemp <= COOLER_OFF_TEMP);
+    bool tooHot     = (waterTemp >= p.coolerOnTemp);
+    bool coolEnough = (waterTemp <= p.coolerOffTemp);
 
     if (tooHot && !actuators.cooler && (nowMillis - last) > DEBOUNCE_MS) {
         actuators.cooler = true;
-        control_cooler(true);
+        setRelay(re, RELAY_COOLER, true);
         last = nowMillis;
-        Serial.printf("[RULE_ENGINE] 💨 Fan ON — water warm (%.2f°C)\n", waterTemp);
+        LOGI(RULES, "💨 Fan ON — water warm (%.2f°C)", waterTemp);
     }
     else if (coolEnough && actuators.cooler && (nowMillis - last) > DEBOUNCE_MS) {
         actuators.cooler = false;
-        control_cooler(false);
+        setRelay(re, RELAY_COOLER, false);
         last = nowMillis;
-        Serial.printf("[RULE_ENGINE] 💨 Fan OFF — water cooled (%.2f°C)\n", waterTemp);
+        LOGI(RULES, "💨 Fan OFF — water cooled (%.2f°C)", waterTemp);
     }
 }
 
-void checkHeaterLogic(ActuatorState &actuators, float waterTemp, unsigned long nowMillis)
+void checkHeaterLogic(RuleEngine &re, ActuatorState &actuators, float waterTemp, unsigned long nowMillis)
 {
     if (isnan(waterTemp)) return;
     if (!actuators.heaterAuto) return;
 
-    static unsigned long last = 0;
+    const RuleParams &p = re.params;
+    unsigned long &last = re.state.heaterLast;
     const unsigned long DEBOUNCE_MS = 5000;
 
     // Handle AUTO re-enable
     if (actuators.heaterAutoJustEnabled) {
         actuators.heaterAutoJustEnabled = false;
 
-        if (waterTemp <= HEATER_ON_TEMP) { 
+        if (waterTemp <= p.heaterOnTemp) {
             actuators.heater = true;
-        } else if (waterTemp >= HEATER_OFF_TEMP) {
+        } else if (waterTemp >= p.heaterOffTemp) {
             actuators.heater = false;
         }
 
-        control_heater(actuators.heater);
+        setRelay(re, RELAY_HEATER, actuators.heater);
         last = nowMillis;
 
-        Serial.printf("[RULE_ENGINE] 🔥 Heater AUTO re-enabled → %s (waterTemp=%.2f°C)\n",
-                      actuators.heater ? "ON" : "OFF", waterTemp);
+        LOGI(RULES, "🔥 Heater AUTO re-enabled → %s (waterTemp=%.2f°C)",
+             actuators.heater ? "ON" : "OFF", waterTemp);
         return;
     }
 
-    bool tooCold  = (waterTemp <= HEATER_ON_TEMP);
-    bool warmEnough = (waterTemp >= HEATER_OFF_TEMP);
+    bool tooCold  = (waterTemp <= p.heaterOnTemp);
+    bool warmEnough = (waterTemp >= p.heaterOffTemp);
 
     if (tooCold && !actuators.heater && (nowMillis - last) > DEBOUNCE_MS) {
         actuators.heater = true;
-        control_heater(true);
+        setRelay(re, RELAY_HEATER, true);
         last = nowMillis;
-        Serial.printf("[RULE_ENGINE] 🔥 Heater ON — water cold (%.2f°C)\n", waterTemp);
+        LOGI(RULES, "🔥 Heater ON — water cold (%.2f°C)", waterTemp);
     }
     else if (warmEnough && actuators.heater && (nowMillis - last) > DEBOUNCE_MS) {
         actuators.heater = false;
-        control_heater(false);
+        setRelay(re, RELAY_HEATER, false);
         last = nowMillis;
-        Serial.printf("[RULE_ENGINE] 🔥 Heater OFF — water warmed (%.2f°C)\n", waterTemp);
+        LOGI(RULES, "🔥 Heater OFF — water warmed (%.2f°C)", waterTemp);
     }
 }
 
-void checkpHPumpLogic(ActuatorState &actuators, float phValue, unsigned long nowMillis) {
+void checkpHPumpLogic(RuleEngine &re, ActuatorState &actuators, float phValue, unsigned long nowMillis) {
     if (isnan(phValue)) return;
 
-    static unsigned long lastDoseEnd = 0;
-    static unsigned long lastPhCheck = 0;
-    static bool dosingInProgress = false;
-    static int dosingAttempts = 0;
+    const RuleParams &p = re.params;
+    unsigned long &lastDoseEnd = re.state.phDose.lastDoseEnd;
+    int &dosingAttempts = re.state.phDose.attempts;
+    unsigned long &lastPhCheck = re.state.phDose.lastCheck;
+    bool &dosingInProgress = re.state.phDose.inProgress;
+    bool &dosingUp = re.state.phDose.up;
 
     if (!actuators.phDosingEnabled) {
         if (dosingInProgress || actuators.phRaising || actuators.phLowering) {
-            control_ph_pump(false, false);
+            doseCancel(re);
             actuators.phRaising = false;
             actuators.phLowering = false;
             dosingInProgress = false;
-            Serial.println("[AUTO PH] Disabled — chemical pumps OFF");
+            LOGI(AUTO_PH, "Disabled — chemical pumps OFF");
         }
         return;
     }
 
     if (actuators.phDosingJustEnabled) {
         actuators.phDosingJustEnabled = false;
+        if (dosingInProgress) doseCancel(re);
         dosingInProgress = false;
         dosingAttempts = 0;
         lastDoseEnd = 0;
         lastPhCheck = 0;
-        Serial.println("[AUTO PH] Dosing automation re-enabled — timers reset");
+        LOGI(AUTO_PH, "Dosing automation re-enabled — timers reset");
+    }
+
+    // --- Collect a finished dose (pulses run on the dosing timer) ---
+    if (dosingInProgress) {
+        if (!re.io.doseTakeCompleted(re.io.ctx) && re.io.doseBusy(re.io.ctx)) return;
+
+        LOGI(AUTO_PH, "%s dosing complete (%d pulses)",
+             dosingUp ? "UP" : "DOWN", p.phPulseCount);
+        dosingInProgress = false;
+        dosingAttempts++;
+        lastDoseEnd = nowMillis;
     }
 
     // --- Stop if within rest period ---
-    if (lastDoseEnd > 0 && nowMillis - lastDoseEnd < PH_REST_PERIOD_MS) return;
+    if (lastDoseEnd > 0 && nowMillis - lastDoseEnd < p.phRestMs) return;
 
     // --- Limit how often to check ---
-    if (lastPhCheck > 0 && nowMillis - lastPhCheck < PH_MIN_CHECK_INTERVAL_MS) return;
+    if (lastPhCheck > 0 && nowMillis - lastPhCheck < p.phCheckIntervalMs) return;
     lastPhCheck = nowMillis;
 
     // --- Handle pH UP dosing ---
-    if (phValue < PH_LOW_THRESHOLD && !dosingInProgress) {
-        dosingInProgress = true;
-        actuators.phRaising = true;
-        actuators.phLowering = false;
-
-        Serial.printf("[AUTO PH] Low pH (%.2f) → Starting gradual UP dosing\n", phValue);
-
-        for (int i = 0; i < PH_PULSE_COUNT; i++) {
-            control_ph_pump(true, false);
-            delay(PH_PULSE_MS);
-            control_ph_pump(false, false);
-
-            Serial.printf("[AUTO PH] UP pulse %d/%d complete\n", i + 1, PH_PULSE_COUNT);
-            delay(PH_PULSE_GAP_MS);
+    if (phValue < p.phLow) {
+        if (re.io.doseStart(re.io.ctx, true, p.phPulseCount, p.phPulseMs, p.phPulseGapMs)) {
+            dosingInProgress = true;
+            dosingUp = true;
+            actuators.phRaising = true;
+            actuators.phLowering = false;
+            LOGI(AUTO_PH, "Low pH (%.2f) → Starting gradual UP dosing", phValue);
         }
-
-        dosingInProgress = false;
-        dosingAttempts++;
-        lastDoseEnd = nowMillis;
     }
 
     // --- Handle pH DOWN dosing ---
-    else if (phValue > PH_HIGH_THRESHOLD && !dosingInProgress) {
-        dosingInProgress = true;
-        actuators.phRaising = false;
-        actuators.phLowering = true;
-
-        Serial.printf("[AUTO PH] High pH (%.2f) → Starting gradual DOWN dosing\n", phValue);
-
-        for (int i = 0; i < PH_PULSE_COUNT; i++) {
-            control_ph_pump(false, true);
-            delay(PH_PULSE_MS);
-            control_ph_pump(false, false);
-
-            Serial.printf("[AUTO PH] DOWN pulse %d/%d complete\n", i + 1, PH_PULSE_COUNT);
-            delay(PH_PULSE_GAP_MS);
+    else if (phValue > p.phHigh) {
+        if (re.io.doseStart(re.io.ctx, false, p.phPulseCount, p.phPulseMs, p.phPulseGapMs)) {
+            dosingInProgress = true;
+            dosingUp = false;
+            actuators.phRaising = false;
+            actuators.phLowering = true;
+            LOGI(AUTO_PH, "High pH (%.2f) → Starting gradual DOWN dosing", phValue);
         }
-
-        dosingInProgress = false;
-        dosingAttempts++;
-        lastDoseEnd = nowMillis;
     }
 
     // --- Stop when pH returns to safe range ---
-    else if ((actuators.phRaising && phValue >= PH_LOW_OFF) ||
-             (actuators.phLowering && phValue <= PH_HIGH_OFF)) {
-        control_ph_pump(false, false);
+    else if ((actuators.phRaising && phValue >= p.phLowOff) ||
+             (actuators.phLowering && phValue <= p.phHighOff)) {
+        doseCancel(re);
         actuators.phRaising = false;
         actuators.phLowering = false;
         dosingInProgress = false;
         dosingAttempts = 0;
         lastDoseEnd = nowMillis;
 
-        Serial.printf("[AUTO PH] pH back in safe range (%.2f) → Pumps OFF\n", phValue);
+        LOGI(AUTO_PH, "pH back in safe range (%.2f) → Pumps OFF", phValue);
     }
 
     // --- Safety: too many consecutive doses ---
-    if (dosingAttempts >= PH_MAX_DOSING_ATTEMPTS) {
-        Serial.println("[AUTO PH] ⚠️ Too many consecutive doses. Forcing rest period.");
+    if (dosingAttempts >= p.phMaxAttempts) {
+        LOGW(AUTO_PH, "⚠️ Too many consecutive doses. Forcing rest period.");
         dosingAttempts = 0;
         lastDoseEnd = nowMillis; // enforce rest
     }
 }
 
-void checkWaterChangeLogic(ActuatorState& actuators, Commands& commands, float doValue, unsigned long nowMillis) {
+void checkWaterChangeLogic(RuleEngine &re, ActuatorState& actuators, Commands& commands, float doValue, unsigned long nowMillis) {
     if (isnan(doValue)) return;
 
-    static bool manualDrainActive = false;
-    static unsigned long manualDrainStart = 0;
-    static bool refillActive = false;
-    static unsigned long refillStart = 0;
-    static bool prevDrainState = false;
-    static bool prevValveState = false;
-    static unsigned long lowSince = 0;
-    static bool intentPrinted = false;
-    static unsigned long lastDrainTs = 0;
+    const RuleParams &p = re.params;
+    bool &manualDrainActive = re.state.drain.manualDrainActive;
+    unsigned long &manualDrainStart = re.state.drain.manualDrainStart;
+    bool &refillActive = re.state.drain.refillActive;
+    unsigned long &refillStart = re.state.drain.refillStart;
+    unsigned long &lastDrainTs = re.state.drain.lastDrainTs;
+    bool &prevDrainState = re.state.drain.prevDrainState;
+    bool &prevValveState = re.state.drain.prevValveState;
+    unsigned long &lowSince = re.state.drain.lowSince;
+    bool &intentPrinted = re.state.drain.intentPrinted;
 
     // --- Sync on AUTO re-enable ---
     if (actuators.waterChangeAutoJustEnabled) {
@@ -663,7 +625,7 @@ void checkWaterChangeLogic(ActuatorState& actuators, Commands& commands, float d
         intentPrinted = false;
         lastDrainTs = 0;
         commands.waterChange.inProgress = false;
-        Serial.println("[RULE_ENGINE] ♻️ Drain AUTO re-enabled — timers reset");
+        LOGI(RULES, "♻️ Drain AUTO re-enabled — timers reset");
     }
 
     // --- MANUAL DRAIN START ---
@@ -674,32 +636,32 @@ void checkWaterChangeLogic(ActuatorState& actuators, Commands& commands, float d
         actuators.valve = false;  // Ensure valve is closed during drain
         refillActive = false;
         commands.waterChange.inProgress = true;
-        control_drain(true);
-        control_valve(false);
-        Serial.println("[MANUAL] Manual water change requested — starting drain cycle");
+        setRelay(re, RELAY_DRAIN_PUMP, true);
+        setRelay(re, RELAY_VALVE, false);
+        LOGI(MANUAL, "Manual water change requested — starting drain cycle");
     }
 
     // --- MANUAL DRAIN CANCEL ---
     if (manualDrainActive && commands.waterChange.manualChangeCancel) {
         actuators.waterChange = false;
-        control_drain(false);
+        setRelay(re, RELAY_DRAIN_PUMP, false);
         manualDrainActive = false;
         refillActive = false;
         commands.waterChange.inProgress = false;
-        Serial.println("[MANUAL] Manual water change canceled by user");
+        LOGI(MANUAL, "Manual water change canceled by user");
     }
 
     // --- MANUAL DRAIN AUTO STOP / START REFILL ---
-    if (manualDrainActive && (nowMillis - manualDrainStart >= DO_DRAIN_DURATION_MS)) {
+    if (manualDrainActive && (nowMillis - manualDrainStart >= p.drainMs)) {
         actuators.waterChange = false;
-        control_drain(false);
+        setRelay(re, RELAY_DRAIN_PUMP, false);
         manualDrainActive = false;
         refillActive = true;
         refillStart = nowMillis;
         actuators.valve = true;  // open valve for refill
-        control_valve(true);
+        setRelay(re, RELAY_VALVE, true);
         commands.waterChange.inProgress = true;
-        Serial.println("[MANUAL] Manual drain cycle complete — starting refill");
+        LOGI(MANUAL, "Manual drain cycle complete — starting refill");
     }
 
     // --- AUTO REFILL LOGIC ---
@@ -707,28 +669,28 @@ void checkWaterChangeLogic(ActuatorState& actuators, Commands& commands, float d
         // Pause refill if growbed pump is running
         if (actuators.pump) {
             actuators.valve = false;
-            control_valve(false);
-            Serial.println("[MANUAL] Refill paused — growbed pump active");
+            setRelay(re, RELAY_VALVE, false);
+            LOGI(MANUAL, "Refill paused — growbed pump active");
         } else {
             actuators.valve = true;
-            control_valve(true);
+            setRelay(re, RELAY_VALVE, true);
             // Stop refill if water level high or max refill time exceeded
-            if (nowMillis - refillStart >= MAX_REFILL_MS) {
+            if (nowMillis - refillStart >= p.maxRefillMs) {
                 actuators.valve = false;
-                control_valve(false);
+                setRelay(re, RELAY_VALVE, false);
                 refillActive = false;
                 commands.waterChange.inProgress = false;
-                Serial.println("[MANUAL] Refill complete — valve closed");
+                LOGI(MANUAL, "Refill complete — valve closed");
             }
         }
     }
 
     // --- AUTO DO DRAIN (if no manual drain or refill) ---
     if (!manualDrainActive && !refillActive && actuators.waterChangeAuto) {
-        if (doValue <= DO_LOW_THRESHOLD) {
+        if (doValue <= p.doLow) {
             if (lowSince == 0) lowSince = nowMillis;
             if (!intentPrinted && !actuators.waterChange) {
-                Serial.printf("[RULE_ENGINE] [INTENT] DO low (%.2f mg/L) — drain about to run\n", doValue);
+                LOGI(RULES, "[INTENT] DO low (%.2f mg/L) — drain about to run", doValue);
                 intentPrinted = true;
             }
         } else {
@@ -736,50 +698,50 @@ void checkWaterChangeLogic(ActuatorState& actuators, Commands& commands, float d
             intentPrinted = false;
         }
 
-        bool lowStable = (lowSince > 0) && (nowMillis - lowSince >= DO_LOW_DEBOUNCE_MS);
+        bool lowStable = (lowSince > 0) && (nowMillis - lowSince >= p.doLowDebounceMs);
 
         if (lowStable && !actuators.waterChange && !actuators.pump) { // check growbed pump
             actuators.waterChange = true;
             lastDrainTs = nowMillis;
             commands.waterChange.inProgress = true;
-            Serial.printf("[RULE_ENGINE] ♻️ Drain ON — DO critically low (%.2f mg/L)\n", doValue);
-            control_drain(true);
+            LOGI(RULES, "♻️ Drain ON — DO critically low (%.2f mg/L)", doValue);
+            setRelay(re, RELAY_DRAIN_PUMP, true);
         }
 
         // Stop after duration
-        if (actuators.waterChange && (nowMillis - lastDrainTs >= DO_DRAIN_DURATION_MS)) {
+        if (actuators.waterChange && (nowMillis - lastDrainTs >= p.drainMs)) {
             actuators.waterChange = false;
             lastDrainTs = nowMillis;
             lowSince = 0;
             intentPrinted = false;
             commands.waterChange.inProgress = false;
-            Serial.println("[RULE_ENGINE] ♻️ Drain OFF — cycle complete");
-            control_drain(false);
+            LOGI(RULES, "♻️ Drain OFF — cycle complete");
+            setRelay(re, RELAY_DRAIN_PUMP, false);
         }
     }
 
     // --- APPLY RELAYS ---
     if (actuators.waterChange != prevDrainState) {
-        control_drain(actuators.waterChange);
+        setRelay(re, RELAY_DRAIN_PUMP, actuators.waterChange);
         prevDrainState = actuators.waterChange;
     }
 
     if (actuators.valve != prevValveState) {
-        control_valve(actuators.valve);
+        setRelay(re, RELAY_VALVE, actuators.valve);
         prevValveState = actuators.valve;
     }
 }
 
-void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands,float turbidityNTU, unsigned long nowMillis) {
+void checkSumpCleaningLogic(RuleEngine &re, ActuatorState &actuators, Commands& commands, float turbidityNTU, unsigned long nowMillis) {
     if (isnan(turbidityNTU)) return;
 
-    static bool manualCleaningActive = false;
-    static unsigned long manualCleaningStart = 0;
-
-    static unsigned long highSince = 0;
-    static unsigned long cleaningStart = 0;
-    static bool cleaningActive = false;
-    static bool intentPrinted = false;
+    const RuleParams &p = re.params;
+    bool &manualCleaningActive = re.state.sump.manualActive;
+    unsigned long &manualCleaningStart = re.state.sump.manualStart;
+    bool &cleaningActive = re.state.sump.autoActive;
+    unsigned long &cleaningStart = re.state.sump.autoStart;
+    unsigned long &highSince = re.state.sump.highSince;
+    bool &intentPrinted = re.state.sump.intentPrinted;
 
     //         AUTO RE-ENABLE RESET
     if (actuators.sumpCleaningAutoJustEnabled) {
@@ -792,13 +754,13 @@ void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands,float t
         intentPrinted = false;
         commands.sumpCleaning.inProgress = false;
 
-        Serial.println("[SUMP] Auto re-enabled — timers reset");
+        LOGI(SUMP, "Auto re-enabled — timers reset");
     }
 
     //                   MANUAL START
     if (commands.sumpCleaning.manualCleanRequest && !manualCleaningActive) {
 
-        Serial.println("[SUMP][MANUAL] Manual cleaning requested — starting");
+        LOGI(SUMP, "[MANUAL] Manual cleaning requested — starting");
 
         manualCleaningActive = true;
         manualCleaningStart = nowMillis;
@@ -808,31 +770,31 @@ void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands,float t
         highSince = 0;
         intentPrinted = false;
         commands.sumpCleaning.inProgress = true;
-        control_sump_cleaning(true, true);   // open both valves
+        setSumpValves(re, true, true);   // open both valves
     }
 
     //                     MANUAL CANCEL
     if (manualCleaningActive && commands.sumpCleaning.manualCleanCancel) {
 
-        Serial.println("[SUMP][MANUAL] Manual cleaning canceled");
+        LOGI(SUMP, "[MANUAL] Manual cleaning canceled");
 
         manualCleaningActive = false;
         actuators.sumpCleaning = false;
         commands.sumpCleaning.inProgress = false;
-        control_sump_cleaning(false, false);  // close both valves
+        setSumpValves(re, false, false);  // close both valves
         return;
     }
 
     //      MANUAL CLEANING AUTO STOP AFTER DURATION
     if (manualCleaningActive &&
-        nowMillis - manualCleaningStart >= SUMP_CLEAN_DURATION_MS)
+        nowMillis - manualCleaningStart >= p.sumpCleanMs)
     {
-        Serial.println("[SUMP][MANUAL] Manual cycle complete — stopping");
+        LOGI(SUMP, "[MANUAL] Manual cycle complete — stopping");
 
         manualCleaningActive = false;
         actuators.sumpCleaning = false;
         commands.sumpCleaning.inProgress = false;
-        control_sump_cleaning(false, false);
+        setSumpValves(re, false, false);
         return;
     }
 
@@ -843,12 +805,12 @@ void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands,float t
     if (!actuators.sumpCleaningAuto) return;
 
     // --- Turbidity tracking ---
-    if (turbidityNTU >= TURBIDITY_CLEAN_THRESHOLD) {
+    if (turbidityNTU >= p.turbidityClean) {
         if (highSince == 0) highSince = nowMillis;
 
         if (!intentPrinted && !cleaningActive) {
-            Serial.printf("[SUMP] High NTU detected (%.2f). Cleaning pending…\n",
-                          turbidityNTU);
+            LOGI(SUMP, "High NTU detected (%.2f). Cleaning pending…",
+                 turbidityNTU);
             intentPrinted = true;
         }
     } else {
@@ -856,29 +818,114 @@ void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands,float t
         intentPrinted = false;
     }
 
-    // --- Auto start ---
-    if (!cleaningActive) {
+    // --- Auto start: NTU high for the whole dwell (one noisy reading must
+    //     not open the valves, and a finished cycle must not start the next) ---
+    bool highStable = (highSince > 0) && (nowMillis - highSince >= p.sumpHighDwellMs);
 
-        Serial.printf("[SUMP] AUTO START — NTU=%.2f\n", turbidityNTU);
+    if (!cleaningActive && highStable) {
+
+        LOGI(SUMP, "AUTO START — NTU=%.2f", turbidityNTU);
 
         cleaningActive = true;
         cleaningStart = nowMillis;
         actuators.sumpCleaning = true;
         commands.sumpCleaning.inProgress = true;
 
-        control_sump_cleaning(true, true);
+        setSumpValves(re, true, true);
     }
 
     // --- End auto cleaning ---
     if (cleaningActive &&
-        nowMillis - cleaningStart >= SUMP_CLEAN_DURATION_MS)
+        nowMillis - cleaningStart >= p.sumpCleanMs)
     {
-        Serial.println("[SUMP] AUTO DONE — closing valves");
+        LOGI(SUMP, "AUTO DONE — closing valves");
 
         cleaningActive = false;
+        highSince = 0;              // still high: wait out the dwell again
+        intentPrinted = false;
         actuators.sumpCleaning = false;
         commands.sumpCleaning.inProgress = false;
 
-        control_sump_cleaning(false, false);
+        setSumpValves(re, false, false);
+    }
+}
+
+// ===== WARM-REBOOT CHECKPOINT =====
+// Timestamps are stored as ages so they stay valid against the new millis() origin
+void rule_engine_checkpoint(const RuleEngine &re, const ActuatorState &actuators, RuleCheckpoint &out, unsigned long nowMillis) {
+    const RuleState &st = re.state;
+    out = RuleCheckpoint();
+
+    out.pumpValid = !st.pumpCycle.firstRun;
+    out.pumpWasOn = st.pumpCycle.wasOn;
+    out.pumpAgeMs = nowMillis - st.pumpCycle.lastToggle;
+
+    out.phResting = st.phDose.lastDoseEnd > 0;
+    out.phRestAgeMs = nowMillis - st.phDose.lastDoseEnd;
+    out.phAttempts = st.phDose.attempts;
+
+    if (st.drain.manualDrainActive) {
+        out.manualDrain = true;
+        out.drainAgeMs = nowMillis - st.drain.manualDrainStart;
+    } else if (st.drain.refillActive) {
+        out.refill = true;
+        out.drainAgeMs = nowMillis - st.drain.refillStart;
+    } else if (actuators.waterChange) {
+        out.autoDrain = true;
+        out.drainAgeMs = nowMillis - st.drain.lastDrainTs;
+    }
+
+    out.sumpManual = st.sump.manualActive;
+    out.sumpAuto = st.sump.autoActive;
+    out.sumpAgeMs = nowMillis - (st.sump.manualActive ? st.sump.manualStart : st.sump.autoStart);
+}
+
+void rule_engine_restore(RuleEngine &re, ActuatorState &actuators, Commands &commands,
+                         const RuleCheckpoint &in, unsigned long nowMillis) {
+    RuleState &st = re.state;
+
+    if (in.pumpValid) {
+        st.pumpCycle.firstRun = false;
+        st.pumpCycle.wasOn = in.pumpWasOn;
+        st.pumpCycle.lastToggle = nowMillis - in.pumpAgeMs;
+        actuators.pump = in.pumpWasOn;
+        LOGI(RULES, "↩️ Pump cycle resumed: %s for %.1f min",
+             in.pumpWasOn ? "ON" : "OFF", in.pumpAgeMs / 60000.0);
+    }
+
+    if (in.phResting) {
+        st.phDose.lastDoseEnd = (nowMillis - in.phRestAgeMs) | 1;   // keep it non-zero
+        st.phDose.attempts = in.phAttempts;
+        LOGI(RULES, "↩️ pH rest period resumed (%.1f min elapsed)", in.phRestAgeMs / 60000.0);
+    }
+
+    unsigned long drainStart = nowMillis - in.drainAgeMs;
+    if (in.manualDrain) {
+        st.drain.manualDrainActive = true;
+        st.drain.manualDrainStart = drainStart;
+        actuators.waterChange = true;
+    } else if (in.refill) {
+        st.drain.refillActive = true;
+        st.drain.refillStart = drainStart;
+    } else if (in.autoDrain) {
+        st.drain.lastDrainTs = drainStart;
+        actuators.waterChange = true;
+    }
+    if (in.manualDrain || in.refill || in.autoDrain) {
+        commands.waterChange.inProgress = true;
+        LOGI(RULES, "↩️ %s resumed (%.1f min elapsed)",
+             in.refill ? "Refill" : "Drain", in.drainAgeMs / 60000.0);
+    }
+
+    if (in.sumpManual || in.sumpAuto) {
+        unsigned long sumpStart = nowMillis - in.sumpAgeMs;
+        st.sump.manualActive = in.sumpManual;
+        st.sump.manualStart = sumpStart;
+        st.sump.autoActive = in.sumpAuto;
+        st.sump.autoStart = sumpStart;
+        actuators.sumpCleaning = true;
+        commands.sumpCleaning.inProgress = true;
+        setSumpValves(re, true, true);
+        LOGI(RULES, "↩️ Sump cleaning resumed (%.1f min elapsed)", in.sumpAgeMs / 60000.0);
     }
 }
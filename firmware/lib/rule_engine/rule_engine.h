@@ -1,24 +1,191 @@
 #pragma once
 #include <Arduino.h>
 #include <time.h>
+#include "config.h"
 #include "sensor_data.h"
 #include "firebase.h"
+#include "relay_control.h"
 
-// Initialize relays (implementation expected elsewhere)
-void relay_control_init();
+// === Reentrant rule engine ===
+// Every timer and latch lives in RuleEngine::state and every threshold in
+// RuleEngine::params, so several engines can run side by side (host tuner).
+// Outputs go through RuleIo; the device instance `deviceRules` is bound to the
+// relay driver, the pH dosing engine and time_utils.
+
+// Thresholds and durations, defaulting to include/config.h
+struct RuleParams {
+    // Air (fan / grow light)
+    float fanOnTemp = TEMP_ON_THRESHOLD;
+    float fanOffTemp = TEMP_OFF_THRESHOLD;
+    float fanOnHumidity = HUMIDITY_MAX_THRESHOLD;
+    float fanOffHumidity = HUMIDITY_MIN_THRESHOLD;
+    float growLightOnTemp = TEMP_LOW_THRESHOLD;
+    float growLightOffTemp = TEMP_HIGH_THRESHOLD;
+
+    // Water temperature
+    float coolerOnTemp = COOLER_ON_TEMP;
+    float coolerOffTemp = COOLER_OFF_TEMP;
+    float heaterOnTemp = HEATER_ON_TEMP;
+    float heaterOffTemp = HEATER_OFF_TEMP;
+
+    // Grow bed pump cycle
+    unsigned long pumpOnMs = PUMP_ON_DURATION * 60 * 1000UL;
+    unsigned long pumpOffMs = PUMP_OFF_DURATION * 60 * 1000UL;
+
+    // Float switch
+    unsigned long floatLowDebounceMs = FLOAT_LOW_DEBOUNCE_MS;
+    unsigned long floatHighDebounceMs = FLOAT_HIGH_DEBOUNCE_MS;
+
+    // pH dosing
+    float phLow = PH_LOW_THRESHOLD;
+    float phLowOff = PH_LOW_OFF;
+    float phHigh = PH_HIGH_THRESHOLD;
+    float phHighOff = PH_HIGH_OFF;
+    uint8_t phPulseCount = PH_PULSE_COUNT;
+    uint32_t phPulseMs = PH_PULSE_MS;
+    uint32_t phPulseGapMs = PH_PULSE_GAP_MS;
+    unsigned long phCheckIntervalMs = PH_MIN_CHECK_INTERVAL_MS;
+    unsigned long phRestMs = PH_REST_PERIOD_MS;
+    int phMaxAttempts = PH_MAX_DOSING_ATTEMPTS;
+
+    // Water change
+    float doLow = DO_LOW_THRESHOLD;
+    unsigned long doLowDebounceMs = DO_LOW_DEBOUNCE_MS;
+    unsigned long drainMs = DO_DRAIN_DURATION_MS;
+    unsigned long maxRefillMs = MAX_REFILL_MS;
+
+    // Sump cleaning
+    float turbidityClean = TURBIDITY_CLEAN_THRESHOLD;
+    unsigned long sumpCleanMs = SUMP_CLEAN_DURATION_MS;
+    unsigned long sumpHighDwellMs = SUMP_HIGH_DWELL_MS;
+};
+
+// Output bindings; `ctx` is passed back to every call
+struct RuleIo {
+    void *ctx = nullptr;
+    void (*setRelay)(void *ctx, RelayId id, bool on) = nullptr;
+    bool (*doseStart)(void *ctx, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) = nullptr;
+    void (*doseCancel)(void *ctx) = nullptr;
+    bool (*doseBusy)(void *ctx) = nullptr;
+    bool (*doseTakeCompleted)(void *ctx) = nullptr;   // true once after a dose finished on its own
+    bool (*localTime)(void *ctx, struct tm &out) = nullptr;   // false while time is unknown
+};
+
+// Timers and latches (formerly function-local statics)
+struct RuleState {
+    uint16_t prevAutoMask = ACTUATOR_MASK;
+    bool prevPhDosingEnabled = true;
+
+    struct {
+        unsigned long floatLowSince = 0;
+        unsigned long floatHighSince = 0;
+        bool intentPrinted = false;
+        bool prevValveState = false;
+    } valve;
+
+    struct {
+        unsigned long lastToggle = 0;
+        bool wasOn = false;
+        bool firstRun = true;
+    } pumpCycle;
+
+    unsigned long fanLast = 0;
+    bool prevLight = false;
+    unsigned long coolerLast = 0;
+    unsigned long heaterLast = 0;
+
+    struct {
+        unsigned long lastDoseEnd = 0;   // 0 = no rest period running
+        int attempts = 0;
+        unsigned long lastCheck = 0;
+        bool inProgress = false;
+        bool up = false;
+    } phDose;
+
+    struct {
+        bool manualDrainActive = false;
+        unsigned long manualDrainStart = 0;
+        bool refillActive = false;
+        unsigned long refillStart = 0;
+        unsigned long lastDrainTs = 0;
+        bool prevDrainState = false;
+        bool prevValveState = false;
+        unsigned long lowSince = 0;
+        bool intentPrinted = false;
+    } drain;
+
+    struct {
+        bool manualActive = false;
+        unsigned long manualStart = 0;
+        bool autoActive = false;
+        unsigned long autoStart = 0;
+        unsigned long highSince = 0;
+        bool intentPrinted = false;
+    } sump;
+};
+
+// Every RuleState member, for field-by-field serialization (keep in sync with RuleState)
+#define RULE_STATE_FIELDS(X) \
+    X(prevAutoMask) X(prevPhDosingEnabled) \
+    X(valve.floatLowSince) X(valve.floatHighSince) X(valve.intentPrinted) X(valve.prevValveState) \
+    X(pumpCycle.lastToggle) X(pumpCycle.wasOn) X(pumpCycle.firstRun) \
+    X(fanLast) X(prevLight) X(coolerLast) X(heaterLast) \
+    X(phDose.lastDoseEnd) X(phDose.attempts) X(phDose.lastCheck) X(phDose.inProgress) X(phDose.up) \
+    X(drain.manualDrainActive) X(drain.manualDrainStart) X(drain.refillActive) X(drain.refillStart) \
+    X(drain.lastDrainTs) X(drain.prevDrainState) X(drain.prevValveState) X(drain.lowSince) \
+    X(drain.intentPrinted) \
+    X(sump.manualActive) X(sump.manualStart) X(sump.autoActive) X(sump.autoStart) \
+    X(sump.highSince) X(sump.intentPrinted)
+
+struct RuleEngine {
+    RuleParams params;
+    RuleIo io;
+    RuleState state;
+
+    RuleEngine() = default;
+    explicit RuleEngine(const RuleIo &io, const RuleParams &params = RuleParams()) : params(params), io(io) {}
+};
+
+// Bound to the relay driver, the pH dosing engine and time_utils
+extern RuleEngine deviceRules;
 
 // New mode-aware rule engine that handles AUTO/MANUAL mode control
-void applyRulesWithModeControl(RealTimeData& data, ActuatorState& actuators, Commands& commands, unsigned long nowMillis);
+void applyRulesWithModeControl(RuleEngine &re, RealTimeData& data, ActuatorState& actuators, Commands& commands, unsigned long nowMillis);
 
 // Emergency fallback functions
-void checkValveLogic(ActuatorState& actuators, bool waterLevelLow, unsigned long nowMillis);
-void checkPumpLogic(ActuatorState& actuators, unsigned long nowMillis);
-void checkFanAndGrowLightLogic(ActuatorState& actuators, float airTemp, float humidity, unsigned long nowMillis);
-void checkLightLogic(ActuatorState& actuators, unsigned long nowMillis);
-void checkCoolerLogic(ActuatorState& actuators, float waterTemp, unsigned long nowMillis);
-void checkHeaterLogic(ActuatorState& actuators, float waterTemp, unsigned long nowMillis);
-void checkpHPumpLogic(ActuatorState& actuators, float pH, unsigned long nowMillis);
-void checkWaterChangeLogic( ActuatorState& actuators, Commands& commands, float doValue, unsigned long nowMillis);
-void checkSumpCleaningLogic(ActuatorState &actuators, Commands& commands, float turbidityNTU, unsigned long nowMillis);
-// Main rule evaluation entry point
-void evaluateRules(bool forceImmediate = false);
\ No newline at end of file
+void checkValveLogic(RuleEngine &re, ActuatorState& actuators, bool waterLevelLow, unsigned long nowMillis);
+void checkPumpLogic(RuleEngine &re, ActuatorState& actuators, unsigned long nowMillis);
+void checkFanAndGrowLightLogic(RuleEngine &re, ActuatorState& actuators, float airTemp, float humidity, unsigned long nowMillis);
+void checkLightLogic(RuleEngine &re, ActuatorState& actuators, unsigned long nowMillis);
+void checkCoolerLogic(RuleEngine &re, ActuatorState& actuators, float waterTemp, unsigned long nowMillis);
+void checkHeaterLogic(RuleEngine &re, ActuatorState& actuators, float waterTemp, unsigned long nowMillis);
+void checkpHPumpLogic(RuleEngine &re, ActuatorState& actuators, float pH, unsigned long nowMillis);
+void checkWaterChangeLogic(RuleEngine &re, ActuatorState& actuators, Commands& commands, float doValue, unsigned long nowMillis);
+void checkSumpCleaningLogic(RuleEngine &re, ActuatorState &actuators, Commands& commands, float turbidityNTU, unsigned long nowMillis);
+// Main rule evaluation entry point (device engine on the global state)
+void evaluateRules(bool forceImmediate = false, unsigned long nowMillis = millis());
+
+// Rule timers worth resuming after a warm reboot; times are ages in ms
+struct RuleCheckpoint {
+    uint32_t pumpAgeMs = 0;      // since the last pump cycle toggle
+    uint32_t phRestAgeMs = 0;    // since the last dose ended
+    uint32_t drainAgeMs = 0;     // since the running drain/refill phase started
+    uint32_t sumpAgeMs = 0;      // since the running sump cleaning started
+    uint8_t phAttempts = 0;
+    bool pumpValid : 1;
+    bool pumpWasOn : 1;
+    bool phResting : 1;
+    bool manualDrain : 1;
+    bool refill : 1;
+    bool autoDrain : 1;
+    bool sumpManual : 1;
+    bool sumpAuto : 1;
+
+    RuleCheckpoint()
+        : pumpValid(false), pumpWasOn(false), phResting(false), manualDrain(false),
+          refill(false), autoDrain(false), sumpManual(false), sumpAuto(false) {}
+};
+
+void rule_engine_checkpoint(const RuleEngine &re, const ActuatorState &actuators, RuleCheckpoint &out, unsigned long nowMillis);
+void rule_engine_restore(RuleEngine &re, ActuatorState &actuators, Commands &commands,
+                         const RuleCheckpoint &in, unsigned long nowMillis);
@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include "config.h"
+#include "scheduler.h"
+
+static_assert((SCHED_WHEEL_SLOTS & (SCHED_WHEEL_SLOTS - 1)) == 0, "SCHED_WHEEL_SLOTS must be a power of two");
+
+struct Job {
+    const char *name = nullptr;
+    SchedJobFn fn = nullptr;
+    unsigned long deadline = 0;
+    unsigned long period = 0;     // 0 = one-shot
+    int8_t next = -1;             // next job in the same wheel slot
+    uint8_t slot = 0;
+    bool active = false;
+    bool due = false;             // unlinked into sched_run()'s batch, not run yet
+
+    uint32_t runs = 0;
+    uint32_t skipped = 0;         // periods missed because the loop was busy
+    uint32_t maxLateMs = 0;
+    uint32_t maxRunUs = 0;
+};
+
+static Job jobs[SCHED_MAX_JOBS];
+static int8_t wheel[SCHED_WHEEL_SLOTS];
+static unsigned long lastTick = 0;    // every slot up to this tick has been scanned
+static bool started = false;
+static uint32_t sweeps = 0;
+static uint32_t maxSweepUs = 0;
+
+static inline unsigned long tickOf(unsigned long ms) {
+    return ms / SCHED_TICK_MS;
+}
+
+static void start(unsigned long nowMillis) {
+    if (started) return;
+    for (auto &head : wheel) head = -1;
+    lastTick = tickOf(nowMillis) - 1;
+    started = true;
+}
+
+// Deadlines already behind the scan position go into the next slot to be scanned
+static void link(int8_t id) {
+    Job &job = jobs[id];
+    unsigned long tick = tickOf(job.deadline);
+    if ((long)(tick - lastTick) <= 0) tick = lastTick + 1;
+
+    job.slot = tick & (SCHED_WHEEL_SLOTS - 1);
+    job.next = wheel[job.slot];
+    wheel[job.slot] = id;
+}
+
+static void unlink(int8_t id) {
+    int8_t *pp = &wheel[jobs[id].slot];
+    while (*pp != -1) {
+        if (*pp == id) {
+            *pp = jobs[id].next;
+            jobs[id].next = -1;
+            return;
+        }
+        pp = &jobs[*pp].next;
+    }
+}
+
+static SchedJobId add(const char *name, unsigned long delayMs, unsigned long periodMs, SchedJobFn fn) {
+    unsigned long now = millis();
+    start(now);
+
+    for (int8_t id = 0; id < SCHED_MAX_JOBS; id++) {
+        Job &job = jobs[id];
+        if (job.active) continue;
+
+        job = Job();
+        job.name = name;
+        job.fn = fn;
+        job.period = periodMs;
+        job.deadline = now + delayMs;
+        job.active = true;
+        link(id);
+        return id;
+    }
+
+    Serial.printf("[SCHED] ❌ No free job slot for %s\n", name);
+    return -1;
+}
+
+SchedJobId sched_every(const char *name, unsigned long periodMs, SchedJobFn fn, unsigned long firstDelayMs) {
+    if (periodMs == 0) return -1;
+    return add(name, firstDelayMs, periodMs, fn);
+}
+
+SchedJobId sched_once(const char *name, unsigned long delayMs, SchedJobFn fn) {
+    return add(name, delayMs, 0, fn);
+}
+
+// A job still waiting in the current batch is not in the wheel: dropping it
+// from the batch leaves link() below as its only link
+void sched_reschedule(SchedJobId id, unsigned long delayMs) {
+    if (id < 0 || id >= SCHED_MAX_JOBS || !jobs[id].active) return;
+    unlink(id);
+    jobs[id].due = false;
+    jobs[id].deadline = millis() + delayMs;
+    link(id);
+}
+
+void sched_cancel(SchedJobId id) {
+    if (id < 0 || id >= SCHED_MAX_JOBS || !jobs[id].active) return;
+    unlink(id);
+    jobs[id].due = false;
+    jobs[id].active = false;
+}
+
+unsigned long sched_run(unsigned long nowMillis) {
+    start(nowMillis);
+    uint32_t sweepStart = micros();
+
+    // Scan slots from the last scanned tick up to now (at most one revolution)
+    unsigned long nowTick = tickOf(nowMillis);
+    unsigned long ticks = nowTick - lastTick;
+    if (ticks > SCHED_WHEEL_SLOTS) ticks = SCHED_WHEEL_SLOTS;
+
+    int8_t due[SCHED_MAX_JOBS];
+    int dueCount = 0;
+
+    for (unsigned long k = ticks; k > 0; k--) {
+        uint8_t slot = (nowTick - k + 1) & (SCHED_WHEEL_SLOTS - 1);
+        int8_t *pp = &wheel[slot];
+        while (*pp != -1) {
+            int8_t id = *pp;
+            Job &job = jobs[id];
+            if ((long)(nowMillis - job.deadline) >= 0) {
+                *pp = job.next;     // unlink, keep scanning from the same link
+                job.next = -1;
+                job.due = true;
+                due[dueCount++] = id;
+            } else {
+                pp = &job.next;     // later revolution (or later this tick)
+            }
+        }
+    }
+    // Rescan the current tick next time: it may hold deadlines later in this tick
+    lastTick = nowTick - 1;
+
+    // Run outside the scan so jobs can add/cancel/reschedule jobs. One that an
+    // earlier job cancelled or rescheduled (or whose slot a new job took) has
+    // lost its `due` mark and is skipped: it is already where it belongs.
+    for (int i = 0; i < dueCount; i++) {
+        int8_t id = due[i];
+        Job &job = jobs[id];
+        if (!job.active || !job.due) continue;
+        job.due = false;
+
+        uint32_t late = nowMillis - job.deadline;
+        if (late > job.maxLateMs) job.maxLateMs = late;
+
+        if (job.period) {
+            job.deadline += job.period;
+            if ((long)(nowMillis - job.deadline) >= 0) {
+                unsigned long missed = (nowMillis - job.deadline) / job.period + 1;
+                job.deadline += missed * job.period;
+                job.skipped += missed;
+            }
+            link(id);
+        } else {
+            job.active = false;
+        }
+
+        uint32_t runStart = micros();
+        job.fn(nowMillis);
+        uint32_t runUs = micros() - runStart;
+        if (runUs > job.maxRunUs) job.maxRunUs = runUs;
+        job.runs++;
+    }
+
+    // Time until the next deadline
+    unsigned long idle = SCHED_WHEEL_SLOTS * SCHED_TICK_MS;
+    unsigned long now = millis();
+    for (const auto &job : jobs) {
+        if (!job.active) continue;
+        long remaining = (long)(job.deadline - now);
+        if (remaining <= 0) {
+            idle = 0;
+            break;
+        }
+        if ((unsigned long)remaining < idle) idle = remaining;
+    }
+
+    sweeps++;
+    uint32_t sweepUs = micros() - sweepStart;
+    if (sweepUs > maxSweepUs) maxSweepUs = sweepUs;
+    return idle;
+}
+
+void sched_log_stats() {
+    Serial.printf("[SCHED] sweeps=%lu maxSweep=%lu us\n", (unsigned long)sweeps, (unsigned long)maxSweepUs);
+    for (const auto &job : jobs) {
+        if (!job.active) continue;
+        Serial.printf("[SCHED]   %-12s period=%lu ms runs=%lu skipped=%lu maxLate=%lu ms maxRun=%lu us\n",
+                      job.name, job.period, (unsigned long)job.runs, (unsigned long)job.skipped,
+                      (unsigned long)job.maxLateMs, (unsigned long)job.maxRunUs);
+    }
+}
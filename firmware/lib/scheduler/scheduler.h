@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+
+// === Cooperative deadline scheduler ===
+// Hashed timer wheel (SCHED_WHEEL_SLOTS x SCHED_TICK_MS). Subsystems register
+// periodic or one-shot jobs; sched_run() from loop() runs exactly the jobs
+// that are due and reports how long until the next deadline.
+// Jobs run in the loop task and must not block.
+
+typedef void (*SchedJobFn)(unsigned long nowMillis);
+typedef int8_t SchedJobId;     // -1 = invalid
+
+// Periodic job; first run after `firstDelayMs`. Deadlines advance by the
+// period (no drift); if a run is missed entirely it is skipped, not queued.
+SchedJobId sched_every(const char *name, unsigned long periodMs, SchedJobFn fn,
+                       unsigned long firstDelayMs = 0);
+
+// One-shot job, freed after it runs
+SchedJobId sched_once(const char *name, unsigned long delayMs, SchedJobFn fn);
+
+// Move a job's next deadline to now + delayMs
+void sched_reschedule(SchedJobId id, unsigned long delayMs);
+void sched_cancel(SchedJobId id);
+
+// Run due jobs. Returns ms until the next deadline (capped at one wheel revolution).
+unsigned long sched_run(unsigned long nowMillis);
+
+void sched_log_stats();
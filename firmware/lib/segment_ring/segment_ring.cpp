@@ -0,0 +1,52 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "segment_ring.h"
+
+bool seg_ring_open(SegmentRing &ring) {
+    LittleFS.mkdir(ring.dir);
+
+    bool any = false;
+    uint32_t lo = 0, hi = 0;
+    File dir = LittleFS.open(ring.dir);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        unsigned long seg;
+        const char *name = strrchr(f.name(), '/');
+        name = name ? name + 1 : f.name();
+        if (sscanf(name, "s%08lu.bin", &seg) == 1) {
+            if (!any || seg < lo) lo = seg;
+            if (!any || seg > hi) hi = seg;
+            any = true;
+        }
+        f.close();
+    }
+    dir.close();
+
+    ring.firstSeg = any ? lo : 0;
+    ring.headSeg = any ? hi : 0;
+    return any;
+}
+
+String seg_ring_path(const SegmentRing &ring, uint32_t seg) {
+    char path[32];
+    snprintf(path, sizeof(path), "%s/s%08lu.bin", ring.dir, (unsigned long)seg);
+    return String(path);
+}
+
+uint32_t seg_ring_trim(SegmentRing &ring, SegDropFn onDrop) {
+    uint32_t dropped = 0;
+    while (seg_ring_count(ring) > ring.maxSegments) {
+        if (onDrop) onDrop(ring.firstSeg);
+        LittleFS.remove(seg_ring_path(ring, ring.firstSeg));
+        ring.firstSeg++;
+        dropped++;
+    }
+    return dropped;
+}
+
+void seg_ring_remove_before(SegmentRing &ring, uint32_t seg) {
+    while (ring.firstSeg < seg) {
+        LittleFS.remove(seg_ring_path(ring, ring.firstSeg));
+        ring.firstSeg++;
+    }
+}
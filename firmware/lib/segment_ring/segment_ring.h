@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+
+// === LittleFS segment ring ===
+// Numbered segment files <dir>/sNNNNNNNN.bin, oldest first, of which at most
+// maxSegments (the head included) are kept. Shared by the telemetry log and
+// the control trace recorder; the owner decides what goes into a segment and
+// when the head moves on. LittleFS must already be mounted.
+
+struct SegmentRing {
+    const char *dir;
+    uint32_t maxSegments;
+    uint32_t firstSeg = 0;   // oldest segment file on flash
+    uint32_t headSeg = 0;    // segment being appended to
+};
+
+// Called for each segment just before seg_ring_trim() removes it
+typedef void (*SegDropFn)(uint32_t seg);
+
+// Create the directory and recover firstSeg/headSeg from the file names.
+// Returns false (and 0..0) when no segment exists yet.
+bool seg_ring_open(SegmentRing &ring);
+
+String seg_ring_path(const SegmentRing &ring, uint32_t seg);
+
+inline uint32_t seg_ring_count(const SegmentRing &ring) {
+    return ring.headSeg - ring.firstSeg + 1;
+}
+
+// Drop the oldest segments beyond maxSegments. Returns how many were removed.
+uint32_t seg_ring_trim(SegmentRing &ring, SegDropFn onDrop = nullptr);
+
+// Remove every segment older than `seg`
+void seg_ring_remove_before(SegmentRing &ring, uint32_t seg);
@@ -0,0 +1,332 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "firebase.h"
+#include "outbound_queue.h"
+#include "segment_ring.h"
+#include "telemetry_log.h"
+#include "wifi_manager.h"
+
+#define TLOG_DIR          "/tlog"
+#define TLOG_CURSOR_PATH  TLOG_DIR "/cursor"
+#define TLOG_CHECK_MS     5000UL   // how often a closed batch is looked for
+
+// Fixed 32-byte on-flash record
+struct __attribute__((packed)) LogRecord {
+    uint32_t timestamp;
+    float waterTemp;
+    float pH;
+    float dissolvedOxygen;
+    float turbidityNTU;
+    float airTemp;
+    float airHumidity;
+    uint8_t floatTriggered;
+    uint8_t reserved;
+    uint16_t check;
+};
+static_assert(sizeof(LogRecord) == 32, "LogRecord must stay 32 bytes");
+
+// Position in the ring: segment sequence number + record index inside it
+struct LogPos {
+    uint32_t seg;
+    uint32_t index;
+};
+
+static bool mounted = false;
+static SegmentRing ring = {TLOG_DIR, TLOG_MAX_SEGMENTS};
+static uint32_t headCount = 0;      // records in ring.headSeg
+static LogPos tail = {0, 0};        // first unacknowledged record
+
+static bool inFlight = false;
+static LogPos inFlightEnd = {0, 0};
+static uint32_t inFlightRecords = 0;
+
+static float tokens = TLOG_BACKFILL_BURST;
+static unsigned long lastRefill = 0;
+static unsigned long lastCheck = 0;
+
+static TelemetryLogStats stats;
+static RealTimeData batch[TLOG_BATCH_RECORDS];
+
+// ===== Helpers =====
+static uint16_t recordCheck(const LogRecord &rec) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&rec);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(LogRecord, check); i++) h = (h ^ p[i]) * 16777619u;
+    return (uint16_t)(h ^ (h >> 16));
+}
+
+static bool before(const LogPos &a, const LogPos &b) {
+    return a.seg < b.seg || (a.seg == b.seg && a.index < b.index);
+}
+
+static uint32_t segRecords(uint32_t seg) {
+    if (seg == ring.headSeg) return headCount;
+    File f = LittleFS.open(seg_ring_path(ring, seg), "r");
+    if (!f) return 0;
+    uint32_t n = f.size() / sizeof(LogRecord);
+    f.close();
+    return n;
+}
+
+static void saveCursor() {
+    File f = LittleFS.open(TLOG_CURSOR_PATH, "w");
+    if (!f) return;
+    f.write(reinterpret_cast<const uint8_t *>(&tail), sizeof(tail));
+    f.close();
+}
+
+// Delete segments the tail has moved past
+static void removeConsumedSegments() {
+    seg_ring_remove_before(ring, tail.seg);
+}
+
+// Unsent data in a segment the ring drops is lost
+static void onSegmentDropped(uint32_t seg) {
+    if (tail.seg != seg) return;
+    uint32_t lost = segRecords(seg) - min(tail.index, segRecords(seg));
+    stats.droppedRecords += lost;
+    tail = {seg + 1, 0};
+    Serial.printf("[TLog] ⚠️ Ring full, dropped %lu unsent records\n", (unsigned long)lost);
+}
+
+// Keep at most TLOG_MAX_SEGMENTS segment files
+static void enforceCapacity() {
+    seg_ring_trim(ring, onSegmentDropped);
+    if (before(tail, {ring.firstSeg, 0})) tail = {ring.firstSeg, 0};
+}
+
+// ===== Init =====
+bool telemetry_log_init() {
+    if (!LittleFS.begin(true)) {
+        Serial.println("[TLog] ❌ LittleFS mount failed, samples will not be persisted");
+        return false;
+    }
+    mounted = true;
+
+    // Recover the segment range from the file names
+    bool any = seg_ring_open(ring);
+    headCount = 0;
+    if (any) {
+        File f = LittleFS.open(seg_ring_path(ring, ring.headSeg), "r");
+        size_t size = f ? f.size() : 0;
+        if (f) f.close();
+        headCount = size / sizeof(LogRecord);
+        // A torn write from a power cut is ignored; the next append overwrites it
+        if (size % sizeof(LogRecord)) Serial.println("[TLog] Discarding partial record at end of log");
+    }
+
+    tail = {ring.firstSeg, 0};
+    File c = LittleFS.open(TLOG_CURSOR_PATH, "r");
+    if (c && c.size() == sizeof(LogPos)) {
+        LogPos saved;
+        c.read(reinterpret_cast<uint8_t *>(&saved), sizeof(saved));
+        LogPos headEnd = {ring.headSeg, headCount};
+        if (!before(saved, {ring.firstSeg, 0}) && !before(headEnd, saved)) tail = saved;
+    }
+    if (c) c.close();
+
+    stats.segments = any ? seg_ring_count(ring) : 0;
+    Serial.printf("[TLog] ✅ Log ready: segments %lu..%lu, %lu records pending\n",
+                  (unsigned long)ring.firstSeg, (unsigned long)ring.headSeg,
+                  (unsigned long)telemetry_log_pending());
+    return true;
+}
+
+// ===== Append =====
+bool telemetry_log_append(const RealTimeData &data, time_t timestamp) {
+    if (!mounted) {
+        stats.droppedRecords++;
+        return false;
+    }
+
+    if (headCount >= TLOG_SEGMENT_RECORDS) {
+        ring.headSeg++;
+        headCount = 0;
+        enforceCapacity();
+    }
+
+    LogRecord rec = {};
+    rec.timestamp = timestamp > 0 ? (uint32_t)timestamp : 0;
+    rec.waterTemp = data.waterTemp;
+    rec.pH = data.pH;
+    rec.dissolvedOxygen = data.dissolvedOxygen;
+    rec.turbidityNTU = data.turbidityNTU;
+    rec.airTemp = data.airTemp;
+    rec.airHumidity = data.airHumidity;
+    rec.floatTriggered = data.floatTriggered ? 1 : 0;
+    rec.check = recordCheck(rec);
+
+    // Fixed offset instead of append: a torn record left by a power cut is overwritten
+    String path = seg_ring_path(ring, ring.headSeg);
+    File f = LittleFS.open(path, LittleFS.exists(path) ? "r+" : "w");
+    if (!f || !f.seek(headCount * sizeof(LogRecord)) ||
+        f.write(reinterpret_cast<const uint8_t *>(&rec), sizeof(rec)) != sizeof(rec)) {
+        if (f) f.close();
+        stats.droppedRecords++;
+        Serial.println("[TLog] ❌ Write failed");
+        return false;
+    }
+    f.close();
+
+    headCount++;
+    stats.appended++;
+    stats.segments = seg_ring_count(ring);
+    return true;
+}
+
+// ===== Backfill =====
+static void onBackfillDone(OutboundResult result, const String &) {
+    inFlight = false;
+    if (result == OUT_FAILED) {
+        stats.failedBatches++;
+        Serial.println("[TLog] ❌ Batch upload failed, will retry");
+        return;
+    }
+    if (result == OUT_REJECTED) {
+        // The same batch would be rejected again on every retry; skip past it
+        stats.rejectedBatches++;
+        stats.droppedRecords += inFlightRecords;
+        Serial.printf("[TLog] ❌ Batch of %lu rejected by the server, skipped\n", (unsigned long)inFlightRecords);
+    }
+
+    // The ring may have wrapped past the batch while it was in flight
+    if (before(tail, inFlightEnd)) tail = inFlightEnd;
+    removeConsumedSegments();
+    saveCursor();
+
+    if (result != OUT_SENT) return;
+    stats.uploadedBatches++;
+    stats.uploadedRecords += inFlightRecords;
+    Serial.printf("[TLog] ✅ Batch of %lu uploaded, %lu pending\n",
+                  (unsigned long)inFlightRecords, (unsigned long)telemetry_log_pending());
+}
+
+// Read the next batch starting at the tail. Returns the number of records
+// read; `closed` is true when the batch cannot grow any further.
+static int readBatch(time_t nowUnix, LogPos &end, time_t &batchTime, bool &closed) {
+    int n = 0;
+    uint32_t firstTs = 0;
+    LogPos pos = tail;
+    batchTime = 0;
+    closed = false;
+
+    while (n < TLOG_BATCH_RECORDS && before(pos, {ring.headSeg, headCount})) {
+        uint32_t count = segRecords(pos.seg);
+        if (pos.index >= count) {
+            pos = {pos.seg + 1, 0};
+            continue;
+        }
+
+        File f = LittleFS.open(seg_ring_path(ring, pos.seg), "r");
+        if (!f || !f.seek(pos.index * sizeof(LogRecord))) {
+            if (f) f.close();
+            pos = {pos.seg + 1, 0};   // unreadable segment; skip it
+            continue;
+        }
+
+        LogRecord rec;
+        while (n < TLOG_BATCH_RECORDS && pos.index < count &&
+               f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec)) {
+            if (rec.check != recordCheck(rec)) {
+                stats.droppedRecords++;
+                pos.index++;
+                continue;
+            }
+
+            // A batch spans at most TLOG_BATCH_WINDOW_S and never mixes timed/untimed samples
+            if (n > 0 && ((firstTs == 0) != (rec.timestamp == 0) ||
+                          (firstTs && rec.timestamp - firstTs >= TLOG_BATCH_WINDOW_S))) {
+                closed = true;
+                break;
+            }
+            if (n == 0) firstTs = rec.timestamp;
+
+            RealTimeData &d = batch[n++];
+            d.waterTemp = rec.waterTemp;
+            d.pH = rec.pH;
+            d.dissolvedOxygen = rec.dissolvedOxygen;
+            d.turbidityNTU = rec.turbidityNTU;
+            d.airTemp = rec.airTemp;
+            d.airHumidity = rec.airHumidity;
+            d.floatTriggered = rec.floatTriggered;
+            if (rec.timestamp) batchTime = rec.timestamp;
+            pos.index++;
+        }
+        f.close();
+        if (closed) break;
+    }
+
+    if (n >= TLOG_BATCH_RECORDS) closed = true;
+    if (firstTs && nowUnix > 0 && nowUnix - (time_t)firstTs >= TLOG_BATCH_WINDOW_S) closed = true;
+    if (batchTime == 0) batchTime = nowUnix;   // samples taken before NTP sync
+    end = pos;
+    return n;
+}
+
+void telemetry_log_backfill(unsigned long nowMillis, time_t nowUnix) {
+    // Refill the token bucket
+    float refill = (nowMillis - lastRefill) * (TLOG_BACKFILL_PER_MIN / 60000.0f);
+    tokens = min((float)TLOG_BACKFILL_BURST, tokens + refill);
+    lastRefill = nowMillis;
+
+    if (!mounted || inFlight || !wifi_is_up()) return;
+    if (nowUnix <= 0 || tokens < 1.0f) return;
+    if (outbound_depth() > TLOG_BACKFILL_MAX_QUEUE) return;   // live traffic first
+    if (nowMillis - lastCheck < TLOG_CHECK_MS) return;
+    lastCheck = nowMillis;
+
+    if (telemetry_log_pending() == 0) return;
+
+    LogPos end;
+    time_t batchTime;
+    bool closed;
+    int n = readBatch(nowUnix, end, batchTime, closed);
+
+    if (n == 0) {
+        // Only corrupt records left before `end`; skip them
+        if (before(tail, end)) {
+            tail = end;
+            removeConsumedSegments();
+            saveCursor();
+        }
+        return;
+    }
+    if (!closed) return;   // current batch still filling
+
+    inFlight = true;
+    inFlightEnd = end;
+    inFlightRecords = n;
+    if (!pushBatchLogToFirestore(batch, n, batchTime, onBackfillDone)) {
+        inFlight = false;
+        return;
+    }
+    tokens -= 1.0f;
+}
+
+// ===== Stats =====
+uint32_t telemetry_log_pending() {
+    if (!mounted || !before(tail, {ring.headSeg, headCount})) return 0;
+    if (tail.seg == ring.headSeg) return headCount - tail.index;
+    return (ring.headSeg - tail.seg) * TLOG_SEGMENT_RECORDS + headCount - tail.index;
+}
+
+const TelemetryLogStats &telemetry_log_stats() {
+    return stats;
+}
+
+void telemetry_log_log_stats() {
+    size_t used = mounted ? LittleFS.usedBytes() : 0;
+    size_t total = mounted ? LittleFS.totalBytes() : 0;
+    Serial.printf("[TLog] pending=%lu appended=%lu uploaded=%lu (%lu batches) failed=%lu rejected=%lu dropped=%lu segments=%lu flash=%u/%u B\n",
+                  (unsigned long)telemetry_log_pending(),
+                  (unsigned long)stats.appended,
+                  (unsigned long)stats.uploadedRecords,
+                  (unsigned long)stats.uploadedBatches,
+                  (unsigned long)stats.failedBatches,
+                  (unsigned long)stats.rejectedBatches,
+                  (unsigned long)stats.droppedRecords,
+                  (unsigned long)stats.segments,
+                  (unsigned)used, (unsigned)total);
+}
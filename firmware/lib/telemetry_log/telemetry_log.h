@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+#include "sensor_data.h"
+
+// === Store-and-forward telemetry log ===
+// Every sample is appended to a segmented ring of LittleFS files whether or
+// not WiFi is up. Closed batches are averaged and uploaded to Firestore
+// through a token bucket; the read cursor only advances once an upload is
+// acknowledged, so an outage or failed upload never loses data (until the
+// ring wraps and the oldest segment is dropped). A batch the server rejects
+// outright (4xx) is skipped rather than retried forever.
+
+struct TelemetryLogStats {
+    uint32_t appended = 0;
+    uint32_t uploadedRecords = 0;
+    uint32_t uploadedBatches = 0;
+    uint32_t failedBatches = 0;      // transient failures, retried
+    uint32_t rejectedBatches = 0;    // 4xx from Firestore, skipped
+    uint32_t droppedRecords = 0;     // lost to ring wrap, write errors or rejected batches
+    uint32_t segments = 0;
+};
+
+// Mount LittleFS and recover head/tail from the existing segments
+bool telemetry_log_init();
+
+// Append one sample; `timestamp` may be 0 if wall time is not known yet
+bool telemetry_log_append(const RealTimeData &data, time_t timestamp);
+
+// Submit the next closed batch when connected and a token is available.
+// Call every loop(); does nothing while an upload is in flight.
+void telemetry_log_backfill(unsigned long nowMillis, time_t nowUnix);
+
+// Records appended but not yet acknowledged
+uint32_t telemetry_log_pending();
+
+const TelemetryLogStats &telemetry_log_stats();
+void telemetry_log_log_stats();
@@ -1,24 +1,90 @@
 #include "DallasTemperature.h"
 #include "OneWire.h"
 #include "config.h"
+#include "temp_sensor.h"
 #include <Arduino.h>
 
 OneWire oneWire(ONEWIRE_BUS);
 DallasTemperature sensor(&oneWire);
 
-// Initialize the water temperature sensor
-void temp_sensor_init() {
+// Cached probe ROM addresses (no bus search per read)
+static DeviceAddress probeAddr[TEMP_MAX_PROBES];
+static float probeTemp[TEMP_MAX_PROBES];
+static uint8_t probeCount = 0;
+
+// Conversion state
+static bool conversionPending = false;
+static unsigned long conversionStart = 0;
+static unsigned long conversionTimeMs = 750;
+static unsigned long lastScan = 0;
+
+// Search the bus once and remember every probe's address
+static void scanProbes() {
     sensor.begin();
+    probeCount = 0;
+
+    uint8_t found = sensor.getDeviceCount();
+    for (uint8_t i = 0; i < found && probeCount < TEMP_MAX_PROBES; i++) {
+        if (sensor.getAddress(probeAddr[probeCount], i)) {
+            sensor.setResolution(probeAddr[probeCount], TEMP_RESOLUTION_BITS);
+            probeTemp[probeCount] = NAN;
+            probeCount++;
+        }
+    }
+
+    sensor.setWaitForConversion(false); // requestTemperatures() returns immediately
+    conversionTimeMs = sensor.millisToWaitForConversion(TEMP_RESOLUTION_BITS);
+    conversionPending = false;
+    lastScan = millis();
+}
+
+static void startConversion(unsigned long nowMillis) {
+    sensor.requestTemperatures(); // Skip ROM: all probes convert together
+    conversionStart = nowMillis;
+    conversionPending = true;
+}
+
+// Initialize the water temperature sensor(s)
+void temp_sensor_init() {
+    scanProbes();
+    Serial.printf("✅ Water temp: %u probe(s) on bus, %lu ms conversion\n",
+                  probeCount, conversionTimeMs);
+    if (probeCount > 0) startConversion(millis());
+}
+
+void temp_sensor_update(unsigned long nowMillis) {
+    // Re-scan occasionally if no probe was found (e.g. hot-plugged)
+    if (probeCount == 0) {
+        if (nowMillis - lastScan >= 60000UL) scanProbes();
+        return;
+    }
+
+    if (!conversionPending || nowMillis - conversionStart < conversionTimeMs) return;
+
+    // Conversion finished → read each probe's scratchpad by cached address
+    for (uint8_t i = 0; i < probeCount; i++) {
+        float temp = sensor.getTempC(probeAddr[i]);
+        probeTemp[i] = (temp == DEVICE_DISCONNECTED_C) ? NAN : temp;
+    }
+    conversionPending = false;
 }
 
 // Read the water temperature in Celsius (raw, no clamping)
 float read_waterTemp() {
-    sensor.requestTemperatures(); // Force fresh reading
-    float temp = sensor.getTempCByIndex(0);
-
-    if (temp == DEVICE_DISCONNECTED_C) {
+    float temp = read_waterTempProbe(0);
+    if (isnan(temp)) {
         Serial.println("Water temp sensor disconnected!");
-        return NAN;
     }
+    // Kick off the next conversion so a fresh value is ready for the next read
+    if (probeCount > 0 && !conversionPending) startConversion(millis());
     return temp;
-}
\ No newline at end of file
+}
+
+float read_waterTempProbe(uint8_t index) {
+    if (index >= probeCount) return NAN;
+    return probeTemp[index];
+}
+
+uint8_t temp_sensor_probe_count() {
+    return probeCount;
+}
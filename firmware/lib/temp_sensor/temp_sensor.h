@@ -1,3 +1,15 @@
 #pragma once
+#include <stdint.h>
+
+// DS18B20 probes on ONEWIRE_BUS, read asynchronously:
+// conversions run in the background and reads return the last result.
+
 void temp_sensor_init();
-float read_waterTemp();
\ No newline at end of file
+// Drive the conversion state machine (call every loop, never blocks on conversion)
+void temp_sensor_update(unsigned long nowMillis);
+// Latest water temperature of the first probe (°C), NAN if unavailable
+float read_waterTemp();
+// Latest temperature of probe `index` (°C), NAN if unavailable
+float read_waterTempProbe(uint8_t index);
+// Number of probes found at init
+uint8_t temp_sensor_probe_count();
@@ -1,80 +1,59 @@
 #include <Arduino.h>
-#include <WiFi.h>
 #include <time.h>
+#include <sys/time.h>
+#include "esp_sntp.h"
+#include "config.h"
 #include "time_utils.h"
+#include "wifi_manager.h"
 
 // === Constants ===
-#define NTP_SERVER "pool.ntp.org"
-#define GMT_OFFSET_SEC (8 * 3600)  // UTC+8 (Philippine Standard Time)
-#define DAYLIGHT_OFFSET_SEC 0      // No DST in Philippines
+#define TIME_ZONE "PHT-8"          // UTC+8 (Philippine Standard Time, POSIX sign inverted), no DST
+static const char *const NTP_SERVERS[] = { "pool.ntp.org", "time.google.com", "time.windows.com" };
+#define NTP_SERVER_COUNT (sizeof(NTP_SERVERS) / sizeof(NTP_SERVERS[0]))
+#define VALID_EPOCH 1000000000L    // after 2001: anything earlier is the unset RTC
 
 // === State Variables ===
-static bool timeSynced = false;
-static unsigned long lastSyncAttempt = 0;
-static unsigned long lastSuccessfulSync = 0;
-static const unsigned long SYNC_RETRY_INTERVAL = 24 * 60 * 60 * 1000UL; // 24 hours
-
-// === Helper Functions ===
-bool waitForTimeSync(unsigned long timeoutMs) {
-    unsigned long startTime = millis();
-    
-    // Wait a bit longer for initial NTP response
-    delay(1000);
-    
-    while (millis() - startTime < timeoutMs) {
-        time_t now = time(nullptr);
-        if (now > 1000000000UL) { // Check if we have a reasonable timestamp (after year 2001)
-            Serial.printf("[Time] Got timestamp: %ld\n", now);
-            return true;
-        }
-        delay(500); // Check every 500ms instead of 100ms
-    }
-    return false;
+// Written by the SNTP callback (lwIP task), read anywhere
+static volatile bool timeSynced = false;
+static volatile uint32_t syncCount = 0;
+
+static bool sntpStarted = false;
+static uint32_t loggedSyncCount = 0;
+
+// getCurrentMinutes() cache
+static int cachedMinutes = -1;
+static unsigned long cachedAt = 0;
+static unsigned long cachedValidMs = 0;
+static uint32_t cachedSyncCount = 0;
+
+// === SNTP callback (lwIP task context: flags only) ===
+static void onTimeSynced(struct timeval *tv) {
+    if (tv->tv_sec < VALID_EPOCH) return;
+    syncCount++;
+    timeSynced = true;
 }
 
 // === Public API Implementation ===
 
-bool syncTimeOncePerBoot(unsigned long timeoutMs) {
-    if (timeSynced) {
-        return true; // Already synced
-    }
-    
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("[Time] WiFi not connected, cannot sync time");
-        return false;
+void startTimeSync() {
+    if (sntpStarted) return;
+    if (!wifi_is_up()) {
+        Serial.println("[Time] WiFi not connected, SNTP start deferred");
+        return;
     }
-    
-    configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
-    
-    Serial.printf("[Time] Syncing time (timeout: %lu ms)...\n", timeoutMs);
-    bool success = waitForTimeSync(timeoutMs);
-    
-    // If first attempt fails, try alternative NTP servers
-    if (!success) {
-        Serial.println("[Time] Trying alternative servers...");
-        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, "time.google.com");
-        success = waitForTimeSync(5000); // Shorter timeout for retry
-        
-        if (!success) {
-            configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, "time.windows.com");
-            success = waitForTimeSync(5000);
-        }
-    }
-    
-    if (success) {
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo)) {
-            timeSynced = true;
-            lastSuccessfulSync = millis();
-            Serial.printf("[Time] ✅ Time synced successfully: %04d-%02d-%02d %02d:%02d:%02d\n",
-                timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-            return true;
-        }
-    }
-    
-    Serial.println("[Time] ❌ Time sync failed - continuing without accurate time");
-    return false;
+
+    setenv("TZ", TIME_ZONE, 1);
+    tzset();
+
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    for (uint8_t i = 0; i < NTP_SERVER_COUNT; i++) sntp_setservername(i, NTP_SERVERS[i]);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);   // adjtime() slew for small offsets, step for large
+    sntp_set_sync_interval(TIME_SYNC_INTERVAL_MS);
+    sntp_set_time_sync_notification_cb(onTimeSynced);
+    sntp_init();
+
+    sntpStarted = true;
+    Serial.printf("[Time] SNTP started (%s + %u fallback servers)\n", NTP_SERVERS[0], (unsigned)(NTP_SERVER_COUNT - 1));
 }
 
 time_t getUnixTime() {
@@ -83,15 +62,16 @@ time_t getUnixTime() {
     }
     
     time_t now = time(nullptr);
-    return (now > 1000000000UL) ? now : 0; // Return 0 if timestamp seems invalid
+    return (now > VALID_EPOCH) ? now : 0; // Return 0 if timestamp seems invalid
 }
 
 bool getLocalTm(struct tm &out) {
-    if (!timeSynced) {
+    time_t now = getUnixTime();
+    if (now == 0) {
         return false;
     }
     
-    return getLocalTime(&out);
+    return localtime_r(&now, &out) != nullptr;
 }
 
 String formatDateTime(time_t t) {
@@ -110,44 +90,43 @@ String formatDateTime(time_t t) {
 }
 
 bool isTimeAvailable() {
-    return timeSynced && (getUnixTime() > 0);
+    return timeSynced;
 }
 
 int getCurrentMinutes() {
-    struct tm timeinfo;
-    if (getLocalTm(timeinfo)) {
-        return timeinfo.tm_hour * 60 + timeinfo.tm_min;
+    if (!timeSynced) return -1;
+
+    // Recompute only past the next minute boundary or after a (possibly stepped) sync
+    unsigned long now = millis();
+    if (cachedMinutes >= 0 && now - cachedAt < cachedValidMs && cachedSyncCount == syncCount) {
+        return cachedMinutes;
     }
-    return -1; // Time not available
+
+    struct tm timeinfo;
+    if (!getLocalTm(timeinfo)) return -1; // Time not available
+
+    cachedMinutes = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+    cachedAt = now;
+    cachedValidMs = (60 - timeinfo.tm_sec) * 1000UL;
+    cachedSyncCount = syncCount;
+    return cachedMinutes;
 }
 
 void periodicTimeSync() {
-    unsigned long now = millis();
-    
-    // Only attempt re-sync if:
-    // 1. WiFi is connected
-    // 2. Enough time has passed since last attempt (24 hours)
-    // 3. We haven't synced yet OR it's been 24 hours since last successful sync
-    if (WiFi.status() == WL_CONNECTED && 
-        (now - lastSyncAttempt >= SYNC_RETRY_INTERVAL) &&
-        (!timeSynced || (now - lastSuccessfulSync >= SYNC_RETRY_INTERVAL))) {
-        
-        lastSyncAttempt = now;
-        Serial.println("[Time] Periodic re-sync...");
-        
-        // Non-blocking sync attempt (shorter timeout for periodic sync)
-        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
-        
-        // Check if sync succeeded after a short wait
-        delay(2000);
-        time_t now_time = time(nullptr);
-        if (now_time > 1000000000UL) {
-            struct tm timeinfo;
-            if (getLocalTime(&timeinfo)) {
-                timeSynced = true;
-                lastSuccessfulSync = now;
-                Serial.println("[Time] ✅ Re-sync successful");
-            }
-        }
+    if (!sntpStarted) {
+        if (wifi_is_up()) startTimeSync();
+        return;
+    }
+
+    uint32_t count = syncCount;
+    if (count == loggedSyncCount) return;
+
+    struct tm timeinfo;
+    if (getLocalTm(timeinfo)) {
+        Serial.printf("[Time] ✅ %s: %04d-%02d-%02d %02d:%02d:%02d\n",
+            loggedSyncCount == 0 ? "Time synced" : "Re-sync",
+            timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+            timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
     }
+    loggedSyncCount = count;
 }
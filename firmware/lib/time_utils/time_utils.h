@@ -3,12 +3,13 @@
 #include <time.h>
 
 // === NTP Time Management ===
-// Lightweight NTP-based time utility for ESP32
+// ESP-IDF SNTP client running in the background (lwIP task); nothing here blocks.
 // Philippine Standard Time (UTC+8) with fallback behavior
 
-// Initialize NTP time sync (blocking with timeout)
-// Returns true if time was successfully obtained
-bool syncTimeOncePerBoot(unsigned long timeoutMs = 20000);
+// Start SNTP (idempotent, non-blocking). Time becomes available when the
+// first server answers; the client re-polls every TIME_SYNC_INTERVAL_MS and
+// slews the clock smoothly for small corrections.
+void startTimeSync();
 
 // Get current Unix timestamp (epoch)
 // Returns 0 if time is not available
@@ -21,14 +22,13 @@ bool getLocalTm(struct tm &out);
 // Format timestamp as ISO date string (YYYY-MM-DD HH:MM:SS)
 String formatDateTime(time_t t);
 
-// Check if time is currently available
+// Check if time is currently available (cached flag set by the sync callback)
 bool isTimeAvailable();
 
 // Get current time in minutes since midnight (for scheduling)
-// Returns -1 if time is not available
+// Cached until the next minute boundary. Returns -1 if time is not available
 int getCurrentMinutes();
 
-// Periodic re-sync (call from main loop)
-// Attempts to re-sync every 24 hours when WiFi is available
+// Housekeeping from the main loop: logs sync notifications and starts SNTP
+// if the link came up before it was started. Never blocks.
 void periodicTimeSync();
-
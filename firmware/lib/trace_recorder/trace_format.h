@@ -0,0 +1,243 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "commands.h"
+#include "sensor_data.h"
+#include "rule_engine.h"
+
+// === Control trace format ===
+// Shared by the recorder (device) and sim/replay (host). A trace is a run of
+// numbered segment files; each opens with TRACE_MAGIC and a SNAPSHOT record
+// holding the complete control state, so replay can start at any segment.
+//
+// Record: u8 tag, zigzag varint ms since the previous record (a snapshot
+// carries absolute u32 millis instead), then the payload. Integers are LEB128
+// varints. Floats travel as IEEE bits (raw in a snapshot, as a delta from the
+// previous value in a pass) so replay sees identical inputs, NaN included.
+
+#define TRACE_MAGIC          0x31525441u   // "ATR1", little-endian
+#define TRACE_SNAPSHOT_MAX   256           // upper bound of an encoded snapshot record
+#define TRACE_PASS_MAX       64            // upper bound of an encoded pass record
+#define TRACE_SENSOR_FIELDS  6
+
+enum TraceTag : uint8_t {
+    TRACE_SNAPSHOT = 1,   // reason, commands, actuators, rule state, sensors, clock, relays
+    TRACE_PASS,           // one control pass: flags, then the optional fields they announce
+    TRACE_COMMAND,        // source, length, raw event JSON exactly as handed to the parser
+    TRACE_RELAYS,         // committed relay mask after a change
+};
+
+enum TraceSnapshotReason : uint8_t { TRACE_SNAP_BOOT, TRACE_SNAP_SEGMENT };
+enum TraceSource : uint8_t { TRACE_SRC_STREAM, TRACE_SRC_MQTT };
+
+// PASS flags
+#define TP_EVAL           0x0001   // evaluateRules() from a command handler (rules only, no pH check)
+#define TP_RULES          0x0002   // applyRulesWithModeControl() with the current commands
+#define TP_RULES_DEFAULT  0x0004   // ... with the offline all-AUTO commands
+#define TP_HOLD           0x0008   // gate held the table actuators OFF instead of running rules
+#define TP_FLOAT_LOW      0x0010   // float switch active
+#define TP_SENSORS        0x0020   // u8 field mask + a float delta per changed field follow
+#define TP_CLOCK          0x0040   // varint local clock follows
+#define TP_DECISION       0x0080   // varint ActuatorState::stateBits after the pass follows
+#define TP_DOSE_DONE      0x0100   // doseTakeCompleted() returned true
+#define TP_DOSE_IDLE      0x0200   // doseBusy() returned false
+#define TP_DOSE_REFUSED   0x0400   // doseStart() returned false
+
+// Local clock as the rules see it: 0 = no time, else 1 + minute of day
+inline uint16_t trace_clock(bool available, const struct tm &t) {
+    return available ? (uint16_t)(1 + t.tm_hour * 60 + t.tm_min) : 0;
+}
+
+// Sensor fields in RealTimeData order
+inline float *trace_sensor_field(RealTimeData &data, int i) {
+    float *fields[TRACE_SENSOR_FIELDS] = {
+        &data.waterTemp, &data.pH, &data.dissolvedOxygen,
+        &data.turbidityNTU, &data.airTemp, &data.airHumidity,
+    };
+    return fields[i];
+}
+
+// === Encoding ===
+inline uint8_t *trace_put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+inline uint8_t *trace_put_delta(uint8_t *p, int32_t dt) {
+    return trace_put_varint(p, ((uint32_t)dt << 1) ^ (uint32_t)(dt >> 31));
+}
+
+inline uint8_t *trace_put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) *p++ = (uint8_t)(v >> (8 * i));
+    return p;
+}
+
+inline uint8_t *trace_put_float(uint8_t *p, float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return trace_put_u32(p, bits);
+}
+
+// A changed sensor reading: zigzag difference of the IEEE bits, so a small
+// move of a same-sign value takes 2-3 bytes and still round-trips exactly
+inline uint8_t *trace_put_float_delta(uint8_t *p, float prev, float f) {
+    uint32_t a, b;
+    memcpy(&a, &prev, sizeof(a));
+    memcpy(&b, &f, sizeof(b));
+    return trace_put_delta(p, (int32_t)(b - a));
+}
+
+// === Decoding (bounds-checked; `ok` drops to false on a truncated record) ===
+struct TraceReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok = true;
+
+    TraceReader(const uint8_t *data, size_t len) : p(data), end(data + len) {}
+    bool done() const { return p >= end; }
+};
+
+inline uint32_t trace_get_varint(TraceReader &r) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (r.p >= r.end) break;
+        uint8_t b = *r.p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    r.ok = false;
+    return 0;
+}
+
+inline int32_t trace_get_delta(TraceReader &r) {
+    uint32_t z = trace_get_varint(r);
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+inline uint8_t trace_get_u8(TraceReader &r) {
+    if (r.p >= r.end) {
+        r.ok = false;
+        return 0;
+    }
+    return *r.p++;
+}
+
+inline uint32_t trace_get_u32(TraceReader &r) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)trace_get_u8(r) << (8 * i);
+    return v;
+}
+
+inline float trace_get_float(TraceReader &r) {
+    uint32_t bits = trace_get_u32(r);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline float trace_get_float_delta(TraceReader &r, float prev) {
+    uint32_t bits;
+    memcpy(&bits, &prev, sizeof(bits));
+    bits += (uint32_t)trace_get_delta(r);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// === Commands as one bit word (isAuto/value per actuator, then the extras) ===
+inline uint32_t trace_pack_commands(const Commands &c) {
+    uint32_t bits = 0;
+    int n = 0;
+    auto put = [&](bool b) { bits |= (uint32_t)b << n++; };
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        put((c.*ACTUATORS[i].command).isAuto);
+        put((c.*ACTUATORS[i].command).value);
+    }
+    put(c.phDosing.phDosingEnabled);
+    put(c.phDosing.value);
+    put(c.waterChange.manualChangeRequest);
+    put(c.waterChange.manualChangeCancel);
+    put(c.waterChange.inProgress);
+    put(c.sumpCleaning.manualCleanRequest);
+    put(c.sumpCleaning.manualCleanCancel);
+    put(c.sumpCleaning.inProgress);
+    return bits;
+}
+
+inline void trace_unpack_commands(uint32_t bits, Commands &c) {
+    int n = 0;
+    auto get = [&]() { return (bool)((bits >> n++) & 1); };
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        (c.*ACTUATORS[i].command).isAuto = get();
+        (c.*ACTUATORS[i].command).value = get();
+    }
+    c.phDosing.phDosingEnabled = get();
+    c.phDosing.value = get();
+    c.waterChange.manualChangeRequest = get();
+    c.waterChange.manualChangeCancel = get();
+    c.waterChange.inProgress = get();
+    c.sumpCleaning.manualCleanRequest = get();
+    c.sumpCleaning.manualCleanCancel = get();
+    c.sumpCleaning.inProgress = get();
+}
+
+// === Snapshot ===
+struct TraceSnapshot {
+    uint8_t reason = TRACE_SNAP_BOOT;
+    uint32_t millis = 0;
+    Commands commands = {};
+    ActuatorState actuators;
+    RuleState rules;
+    RealTimeData data;          // sensor fields and floatTriggered
+    uint16_t clock = 0;
+    uint16_t relays = 0;        // committed relay mask
+};
+
+// Writes the whole SNAPSHOT record (tag included); returns the end pointer
+inline uint8_t *trace_put_snapshot(uint8_t *p, const TraceSnapshot &s) {
+    *p++ = TRACE_SNAPSHOT;
+    p = trace_put_u32(p, s.millis);
+    *p++ = s.reason;
+    p = trace_put_varint(p, trace_pack_commands(s.commands));
+    p = trace_put_varint(p, s.actuators.stateBits);
+    p = trace_put_varint(p, s.actuators.autoBits);
+    p = trace_put_varint(p, s.actuators.emergencyBits);
+    p = trace_put_varint(p, s.actuators.manualBits);
+    p = trace_put_varint(p, s.actuators.manualValueBits);
+    p = trace_put_varint(p, s.actuators.justEnabledBits);
+#define TRACE_PUT_RULE_FIELD(f) p = trace_put_varint(p, (uint32_t)s.rules.f);
+    RULE_STATE_FIELDS(TRACE_PUT_RULE_FIELD)
+#undef TRACE_PUT_RULE_FIELD
+    RealTimeData data = s.data;
+    for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) p = trace_put_float(p, *trace_sensor_field(data, i));
+    *p++ = s.data.floatTriggered;
+    p = trace_put_varint(p, s.clock);
+    p = trace_put_varint(p, s.relays);
+    return p;
+}
+
+// Reads a SNAPSHOT payload (the tag has already been consumed)
+inline bool trace_get_snapshot(TraceReader &r, TraceSnapshot &s) {
+    s.millis = trace_get_u32(r);
+    s.reason = trace_get_u8(r);
+    trace_unpack_commands(trace_get_varint(r), s.commands);
+    s.actuators.stateBits = trace_get_varint(r);
+    s.actuators.autoBits = trace_get_varint(r);
+    s.actuators.emergencyBits = trace_get_varint(r);
+    s.actuators.manualBits = trace_get_varint(r);
+    s.actuators.manualValueBits = trace_get_varint(r);
+    s.actuators.justEnabledBits = trace_get_varint(r);
+#define TRACE_GET_RULE_FIELD(f) s.rules.f = (decltype(s.rules.f))trace_get_varint(r);
+    RULE_STATE_FIELDS(TRACE_GET_RULE_FIELD)
+#undef TRACE_GET_RULE_FIELD
+    for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) *trace_sensor_field(s.data, i) = trace_get_float(r);
+    s.data.floatTriggered = trace_get_u8(r);
+    s.clock = trace_get_varint(r);
+    s.relays = trace_get_varint(r);
+    return r.ok;
+}
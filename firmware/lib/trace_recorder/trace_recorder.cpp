@@ -0,0 +1,350 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "relay_control.h"
+#include "rule_engine.h"
+#include "segment_ring.h"
+#include "trace_recorder.h"
+
+#define TRACE_DIR          "/trace"
+#define TRACE_DUMP_CHUNK   48        // bytes per "#TRACE" hex line
+
+extern RealTimeData current;
+extern ActuatorState actuators;
+extern Commands currentCommands;
+
+static bool active = false;
+static SegmentRing ring = {TRACE_DIR, TRACE_MAX_SEGMENTS};
+static uint32_t headBytes = 0;         // bytes already flushed to ring.headSeg
+
+static uint8_t buffer[TRACE_BUFFER_BYTES];
+static size_t bufferLen = 0;
+static unsigned long lastFlush = 0;
+static uint32_t lastMs = 0;            // time base of the next record's delta
+
+// What the replay side already knows, so only changes are written
+static float sensorShadow[TRACE_SENSOR_FIELDS];
+static uint16_t lastDecision = 0;
+static uint16_t lastClock = 0;
+static uint16_t lastRelays = 0;
+
+// Dosing engine / clock answers seen since the last pass record
+static RuleIo innerIo;
+static uint16_t pendingFlags = 0;
+
+// Rule state checkpHPumpLogic() can change without any other input
+struct PassMark {
+    unsigned long lastDoseEnd;
+    unsigned long lastCheck;
+    int attempts;
+    bool inProgress;
+    bool up;
+    uint16_t stateBits;
+    uint16_t justEnabledBits;
+};
+static PassMark passMark;
+
+// Serial dump progress (one line per loop so control keeps running)
+static bool dumping = false;
+static uint32_t dumpSeg = 0;
+static uint32_t dumpOffset = 0;
+
+static TraceRecorderStats stats;
+
+// ===== Helpers =====
+static void flush() {
+    if (bufferLen == 0) return;
+    File f = LittleFS.open(seg_ring_path(ring, ring.headSeg), "a");
+    size_t written = f ? f.write(buffer, bufferLen) : 0;
+    if (f) f.close();
+    if (written != bufferLen) {
+        stats.bytesDropped += bufferLen - written;
+        Serial.println("[Trace] ❌ Write failed");
+    }
+    headBytes += written;
+    stats.bytesWritten += written;
+    bufferLen = 0;
+    lastFlush = millis();
+}
+
+static void put(const uint8_t *data, size_t len) {
+    if (bufferLen + len > sizeof(buffer)) flush();
+    if (len > sizeof(buffer)) {
+        // Oversized command events go straight to the segment file
+        File f = LittleFS.open(seg_ring_path(ring, ring.headSeg), "a");
+        size_t written = f ? f.write(data, len) : 0;
+        if (f) f.close();
+        if (written != len) stats.bytesDropped += len - written;
+        headBytes += written;
+        stats.bytesWritten += written;
+        return;
+    }
+    memcpy(buffer + bufferLen, data, len);
+    bufferLen += len;
+}
+
+// Tag and time delta shared by every record but the snapshot
+static uint8_t *recordHead(uint8_t *p, TraceTag tag, unsigned long ms) {
+    *p++ = tag;
+    p = trace_put_delta(p, (int32_t)((uint32_t)ms - lastMs));
+    lastMs = (uint32_t)ms;
+    return p;
+}
+
+static uint16_t committedRelays() {
+    uint16_t mask = 0;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (relay_is_on((RelayId)i)) mask |= RELAY_BIT(i);
+    }
+    return mask;
+}
+
+// Start of a segment: magic plus the complete state the records that follow build on
+static void writeSnapshot(TraceSnapshotReason reason, unsigned long nowMillis) {
+    TraceSnapshot snap;
+    snap.reason = reason;
+    snap.millis = (uint32_t)nowMillis;
+    snap.commands = currentCommands;
+    snap.actuators = actuators;
+    snap.rules = deviceRules.state;
+    snap.data = current;
+    snap.clock = lastClock;
+    snap.relays = lastRelays = committedRelays();
+
+    uint8_t rec[4 + TRACE_SNAPSHOT_MAX];
+    uint8_t *p = trace_put_u32(rec, TRACE_MAGIC);
+    p = trace_put_snapshot(p, snap);
+    put(rec, p - rec);
+
+    lastMs = (uint32_t)nowMillis;
+    for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) sensorShadow[i] = *trace_sensor_field(current, i);
+    lastDecision = actuators.stateBits;
+    stats.snapshots++;
+}
+
+// Keep at most TRACE_MAX_SEGMENTS segment files
+static void enforceCapacity() {
+    stats.segmentsDropped += seg_ring_trim(ring);
+}
+
+static void markPass() {
+    const auto &dose = deviceRules.state.phDose;
+    passMark = {dose.lastDoseEnd, dose.lastCheck, dose.attempts, dose.inProgress, dose.up,
+                actuators.stateBits, actuators.justEnabledBits};
+}
+
+static bool passChangedState() {
+    const auto &dose = deviceRules.state.phDose;
+    return passMark.lastDoseEnd != dose.lastDoseEnd || passMark.lastCheck != dose.lastCheck ||
+           passMark.attempts != dose.attempts || passMark.inProgress != dose.inProgress ||
+           passMark.up != dose.up || passMark.stateBits != actuators.stateBits ||
+           passMark.justEnabledBits != actuators.justEnabledBits;
+}
+
+// ===== Rule engine IO wrappers =====
+static bool recDoseStart(void *ctx, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    bool started = innerIo.doseStart(ctx, up, pulses, pulseMs, gapMs);
+    if (!started) pendingFlags |= TP_DOSE_REFUSED;
+    return started;
+}
+
+static bool recDoseBusy(void *ctx) {
+    bool busy = innerIo.doseBusy(ctx);
+    if (!busy) pendingFlags |= TP_DOSE_IDLE;
+    return busy;
+}
+
+static bool recDoseTakeCompleted(void *ctx) {
+    bool completed = innerIo.doseTakeCompleted(ctx);
+    if (completed) pendingFlags |= TP_DOSE_DONE;
+    return completed;
+}
+
+static bool recLocalTime(void *ctx, struct tm &out) {
+    bool available = innerIo.localTime(ctx, out);
+    uint16_t clock = trace_clock(available, out);
+    if (clock != lastClock) {
+        lastClock = clock;
+        pendingFlags |= TP_CLOCK;
+    }
+    return available;
+}
+
+// ===== Init =====
+bool trace_recorder_init() {
+    if (!LittleFS.begin(true)) {
+        Serial.println("[Trace] ❌ LittleFS mount failed, recorder off");
+        return false;
+    }
+    // Every boot starts a fresh segment
+    if (seg_ring_open(ring)) ring.headSeg++;
+    headBytes = 0;
+    enforceCapacity();
+
+    innerIo = deviceRules.io;
+    deviceRules.io.doseStart = recDoseStart;
+    deviceRules.io.doseBusy = recDoseBusy;
+    deviceRules.io.doseTakeCompleted = recDoseTakeCompleted;
+    deviceRules.io.localTime = recLocalTime;
+
+    active = true;
+    writeSnapshot(TRACE_SNAP_BOOT, millis());
+    flush();
+    Serial.printf("[Trace] ✅ Recording to segment %lu (%lu on flash), send '%c' to dump\n",
+                  (unsigned long)ring.headSeg, (unsigned long)seg_ring_count(ring), TRACE_DUMP_KEY);
+    return true;
+}
+
+// ===== Records =====
+void trace_rec_pass_begin() {
+    if (!active) return;
+    markPass();
+}
+
+// Bit i set when sensor field i differs (bitwise, so NaN compares equal) from the last record
+static uint8_t changedSensors() {
+    uint8_t mask = 0;
+    for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) {
+        if (memcmp(&sensorShadow[i], trace_sensor_field(current, i), sizeof(float)) != 0) mask |= 1u << i;
+    }
+    return mask;
+}
+
+static void writePass(unsigned long nowMillis, uint16_t flags) {
+    uint8_t rec[TRACE_PASS_MAX];
+    uint8_t sensorMask = changedSensors();
+    if (sensorMask) flags |= TP_SENSORS;
+    if (actuators.stateBits != lastDecision) flags |= TP_DECISION;
+    if (current.floatTriggered) flags |= TP_FLOAT_LOW;
+
+    uint8_t *p = recordHead(rec, TRACE_PASS, nowMillis);
+    p = trace_put_varint(p, flags);
+    if (flags & TP_SENSORS) {
+        *p++ = sensorMask;
+        for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) {
+            if (!(sensorMask & (1u << i))) continue;
+            float value = *trace_sensor_field(current, i);
+            p = trace_put_float_delta(p, sensorShadow[i], value);
+            sensorShadow[i] = value;
+        }
+    }
+    if (flags & TP_CLOCK) p = trace_put_varint(p, lastClock);
+    if (flags & TP_DECISION) p = trace_put_varint(p, lastDecision = actuators.stateBits);
+    put(rec, p - rec);
+    stats.passes++;
+}
+
+void trace_rec_pass(unsigned long nowMillis, TraceRules rules) {
+    if (!active) return;
+
+    static const uint16_t RULE_FLAGS[] = {0, TP_RULES, TP_RULES_DEFAULT, TP_HOLD};
+    uint16_t flags = pendingFlags | RULE_FLAGS[rules];
+    pendingFlags = 0;
+
+    // Passes with no new input and no state change replay as no-ops: skip them
+    if (!flags && !changedSensors() && !passChangedState()) return;
+    writePass(nowMillis, flags);
+}
+
+void trace_rec_eval(unsigned long nowMillis) {
+    if (!active) return;
+    uint16_t flags = pendingFlags | TP_EVAL;
+    pendingFlags = 0;
+    writePass(nowMillis, flags);
+}
+
+void trace_rec_command(const char *json, size_t len, TraceSource source) {
+    if (!active) return;
+    uint8_t head[16];
+    uint8_t *p = recordHead(head, TRACE_COMMAND, millis());
+    *p++ = source;
+    p = trace_put_varint(p, (uint32_t)len);
+    put(head, p - head);
+    put((const uint8_t *)json, len);
+    stats.commands++;
+}
+
+void trace_rec_relays(unsigned long nowMillis) {
+    if (!active) return;
+    uint16_t relays = committedRelays();
+    if (relays == lastRelays) return;
+    lastRelays = relays;
+
+    uint8_t rec[8];
+    uint8_t *p = recordHead(rec, TRACE_RELAYS, nowMillis);
+    p = trace_put_varint(p, relays);
+    put(rec, p - rec);
+    stats.relayCommits++;
+}
+
+// ===== Serial dump =====
+static void dumpStep() {
+    // Only as much as the TX buffer takes without blocking
+    if (Serial.availableForWrite() < 2 * TRACE_DUMP_CHUNK + 24) return;
+
+    while (dumpSeg <= ring.headSeg) {
+        File f = LittleFS.open(seg_ring_path(ring, dumpSeg), "r");
+        if (f && f.seek(dumpOffset)) {
+            uint8_t chunk[TRACE_DUMP_CHUNK];
+            size_t n = f.read(chunk, sizeof(chunk));
+            f.close();
+            if (n > 0) {
+                char line[2 * TRACE_DUMP_CHUNK + 1];
+                for (size_t i = 0; i < n; i++) snprintf(line + 2 * i, 3, "%02x", chunk[i]);
+                Serial.printf("#TRACE s%lu %s\n", (unsigned long)dumpSeg, line);
+                dumpOffset += n;
+                return;
+            }
+        } else if (f) {
+            f.close();
+        }
+        dumpSeg++;
+        dumpOffset = 0;
+    }
+
+    Serial.println("#TRACE end");
+    dumping = false;
+}
+
+void trace_recorder_loop(unsigned long nowMillis) {
+    if (!active) return;
+
+    if (bufferLen > 0 && (nowMillis - lastFlush >= TRACE_FLUSH_MS || bufferLen > sizeof(buffer) * 3 / 4)) flush();
+
+    // Roll over between passes so the snapshot is a consistent state
+    if (headBytes + bufferLen >= TRACE_SEGMENT_BYTES) {
+        flush();
+        ring.headSeg++;
+        headBytes = 0;
+        enforceCapacity();
+        writeSnapshot(TRACE_SNAP_SEGMENT, nowMillis);
+    }
+
+    if (!dumping && Serial.available() > 0 && Serial.read() == TRACE_DUMP_KEY) {
+        flush();
+        dumping = true;
+        dumpSeg = ring.firstSeg;
+        dumpOffset = 0;
+        Serial.printf("#TRACE begin %lu..%lu\n", (unsigned long)ring.firstSeg, (unsigned long)ring.headSeg);
+    }
+    if (dumping) dumpStep();
+}
+
+void trace_recorder_flush() {
+    if (active) flush();
+}
+
+// ===== Stats =====
+const TraceRecorderStats &trace_recorder_stats() {
+    return stats;
+}
+
+void trace_recorder_log_stats() {
+    if (!active) return;
+    Serial.printf("[Trace] passes=%lu commands=%lu relayCommits=%lu snapshots=%lu written=%lu B dropped=%lu B segments=%lu..%lu (%lu dropped)\n",
+                  (unsigned long)stats.passes, (unsigned long)stats.commands,
+                  (unsigned long)stats.relayCommits, (unsigned long)stats.snapshots,
+                  (unsigned long)stats.bytesWritten, (unsigned long)stats.bytesDropped,
+                  (unsigned long)ring.firstSeg, (unsigned long)ring.headSeg, (unsigned long)stats.segmentsDropped);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include "trace_format.h"
+
+// === Control trace recorder ===
+// Records what the control core consumes (sensor values, command events,
+// dose completions, the local clock), every pass that could change its state
+// and the decision it reached, plus relay commits, into a LittleFS segment
+// ring (TRACE_* in config.h). sim/replay feeds a trace back through the same
+// rule engine and command parser and checks every decision.
+// Wraps deviceRules.io to see the dosing engine and clock; loop task only.
+
+// How the rules ran in a control pass
+enum TraceRules : uint8_t {
+    TRACE_RULES_NONE,
+    TRACE_RULES_APPLY,     // applyRulesWithModeControl() with currentCommands
+    TRACE_RULES_DEFAULT,   // ... with the offline all-AUTO commands
+    TRACE_RULES_HOLD,      // gate held the table actuators OFF
+};
+
+struct TraceRecorderStats {
+    uint32_t passes = 0;
+    uint32_t commands = 0;
+    uint32_t relayCommits = 0;
+    uint32_t snapshots = 0;
+    uint32_t bytesWritten = 0;
+    uint32_t bytesDropped = 0;   // write errors
+    uint32_t segmentsDropped = 0;
+};
+
+// Mount the ring, open a new segment and write a BOOT snapshot.
+// Call after the rule engine state has been restored.
+bool trace_recorder_init();
+
+// Around one control pass: begin before checkpHPumpLogic(), end after the rules.
+// A pass is only written when it had inputs or changed state.
+void trace_rec_pass_begin();
+void trace_rec_pass(unsigned long nowMillis, TraceRules rules);
+
+// evaluateRules() run outside the loop pass (command handler)
+void trace_rec_eval(unsigned long nowMillis);
+
+// Raw command event, just before it is handed to rtdb_apply_command_event()
+void trace_rec_command(const char *json, size_t len, TraceSource source);
+
+// After relay_commit(); written when the committed mask changed
+void trace_rec_relays(unsigned long nowMillis);
+
+// Flush, segment rollover and the serial dump; once per loop
+void trace_recorder_loop(unsigned long nowMillis);
+
+// Write out buffered records now (e.g. before a planned restart)
+void trace_recorder_flush();
+
+const TraceRecorderStats &trace_recorder_stats();
+void trace_recorder_log_stats();
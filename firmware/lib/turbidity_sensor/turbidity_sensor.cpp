@@ -4,7 +4,8 @@
 
 void turbidity_sensor_init() {
     pinMode(TURBIDITY_PIN, INPUT);
-    delay(500); // Let voltage stabilize
+    // No blocking settle delay: turbidity is re-read every 30 s, so an
+    // unsettled first sample is short-lived
 }
 
 // === Read average ADC voltage (in volts) ===
@@ -19,13 +20,16 @@ float readTurbidityVoltage() {
 }
 
 // === Convert voltage to NTU ===
-float read_turbidity() {
-    float v_adc = readTurbidityVoltage();           // Voltage at ESP32 ADC pin
+float turbidity_from_voltage(float v_adc) {
     float v_sensor = v_adc * SENSOR_VOLTAGE_GAIN;   // Actual sensor output voltage
     float ntu = NTU_OFFSET + NTU_SLOPE * v_sensor;  // Linear mapping model
     return max(ntu, 0.0f);                          // Prevent negatives
 }
 
+float read_turbidity() {
+    return turbidity_from_voltage(readTurbidityVoltage()); // Voltage at ESP32 ADC pin
+}
+
 // === Interpret turbidity level ===
 const char* classifyTurbidity(float ntu) {
     if (ntu <= 50.0f)   return "Clear";
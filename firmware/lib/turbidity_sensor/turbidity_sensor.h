@@ -2,4 +2,5 @@
 
 void turbidity_sensor_init();
 float read_turbidity();
+float turbidity_from_voltage(float v_adc); // Convert ADC pin voltage (V) to NTU
 const char* classifyTurbidity(float ntu);
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include "config.h"
+#include "wifi_manager.h"
+
+#define WIFI_NVS_NAMESPACE "wifi"
+
+enum WifiState : uint8_t {
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_UP,
+    WIFI_STATE_BACKOFF,
+};
+
+// Latched by the WiFi event task, consumed by wifi_manager_loop()
+static volatile bool evGotIp = false;
+static volatile bool evDisconnected = false;
+static volatile bool linkUp = false;
+
+static WifiState state = WIFI_STATE_BACKOFF;
+static WifiStats stats;
+static WifiLinkFn listeners[WIFI_MAX_LISTENERS];
+static uint8_t listenerCount = 0;
+
+static unsigned long beginMillis = 0;
+static unsigned long outageStart = 0;      // 0 = still connecting after boot
+static unsigned long attemptStart = 0;
+static unsigned long nextAttempt = 0;
+static unsigned long retryDelay = WIFI_RETRY_MIN_MS;
+
+// Last AP we associated with, for a directed (no full scan) connect
+static uint8_t cachedBssid[6];
+static uint8_t cachedChannel = 0;
+static bool cacheValid = false;
+static bool attemptUsedCache = false;
+
+// ===== NVS cache =====
+static void loadCache() {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_NVS_NAMESPACE, true)) return;
+    cacheValid = prefs.getBytes("bssid", cachedBssid, sizeof(cachedBssid)) == sizeof(cachedBssid);
+    cachedChannel = prefs.getUChar("ch", 0);
+    cacheValid = cacheValid && cachedChannel > 0;
+    prefs.end();
+}
+
+// Only written when the AP changed, to spare flash wear
+static void saveCache() {
+    const uint8_t *bssid = WiFi.BSSID();
+    uint8_t channel = WiFi.channel();
+    if (!bssid || !channel) return;
+    if (cacheValid && channel == cachedChannel && memcmp(bssid, cachedBssid, 6) == 0) return;
+
+    memcpy(cachedBssid, bssid, 6);
+    cachedChannel = channel;
+    cacheValid = true;
+
+    Preferences prefs;
+    if (!prefs.begin(WIFI_NVS_NAMESPACE, false)) return;
+    prefs.putBytes("bssid", cachedBssid, sizeof(cachedBssid));
+    prefs.putUChar("ch", cachedChannel);
+    prefs.end();
+    Serial.printf("[WiFi] Cached AP %s on channel %u\n", WiFi.BSSIDstr().c_str(), channel);
+}
+
+static void dropCache() {
+    if (!cacheValid) return;
+    cacheValid = false;
+
+    Preferences prefs;
+    if (!prefs.begin(WIFI_NVS_NAMESPACE, false)) return;
+    prefs.clear();
+    prefs.end();
+    Serial.println("[WiFi] Cached AP failed — falling back to a full scan");
+}
+
+// ===== Events (WiFi event task) =====
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            evGotIp = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            stats.lastReason = info.wifi_sta_disconnected.reason;
+            linkUp = false;
+            evDisconnected = true;
+            break;
+        default:
+            break;
+    }
+}
+
+// ===== State machine (loop task) =====
+static void notify(bool up) {
+    for (uint8_t i = 0; i < listenerCount; i++) listeners[i](up);
+}
+
+static void startAttempt(unsigned long now) {
+    attemptUsedCache = cacheValid;
+    if (attemptUsedCache) WiFi.begin(WIFI_SSID, WIFI_PASS, cachedChannel, cachedBssid);
+    else WiFi.begin(WIFI_SSID, WIFI_PASS);
+
+    attemptStart = now;
+    state = WIFI_STATE_CONNECTING;
+}
+
+static void attemptFailed(unsigned long now) {
+    stats.failedAttempts++;
+    if (attemptUsedCache) {
+        dropCache();
+        nextAttempt = now + WIFI_RETRY_MIN_MS;   // retry soon with a scan
+    } else {
+        nextAttempt = now + retryDelay + random(retryDelay / 4 + 1);
+        retryDelay = min(retryDelay * 2, (unsigned long)WIFI_RETRY_MAX_MS);
+    }
+    state = WIFI_STATE_BACKOFF;
+}
+
+void wifi_manager_begin() {
+    WiFi.persistent(false);        // credentials come from config.h, not flash
+    WiFi.setAutoReconnect(false);  // reconnects are driven by the state machine
+    WiFi.mode(WIFI_STA);
+    WiFi.onEvent(onWiFiEvent);
+
+    loadCache();
+    beginMillis = millis();
+    Serial.printf("[WiFi] Connecting to %s%s...\n", WIFI_SSID, cacheValid ? " (cached AP)" : "");
+    startAttempt(beginMillis);
+}
+
+void wifi_manager_loop(unsigned long nowMillis) {
+    if (evDisconnected) {
+        evDisconnected = false;
+        if (state == WIFI_STATE_UP) {
+            stats.drops++;
+            outageStart = nowMillis;
+            retryDelay = WIFI_RETRY_MIN_MS;
+            nextAttempt = nowMillis;   // first reconnect is immediate
+            state = WIFI_STATE_BACKOFF;
+            Serial.printf("[WiFi] ⚠️ Link lost (reason %u)\n", stats.lastReason);
+            notify(false);
+        } else if (state == WIFI_STATE_CONNECTING) {
+            attemptFailed(nowMillis);
+        }
+    }
+
+    if (evGotIp) {
+        evGotIp = false;
+        if (state != WIFI_STATE_UP && WiFi.status() == WL_CONNECTED) {
+            state = WIFI_STATE_UP;
+            linkUp = true;
+            retryDelay = WIFI_RETRY_MIN_MS;
+            stats.connects++;
+            if (attemptUsedCache) stats.cachedConnects++;
+
+            if (outageStart == 0) {
+                stats.bootConnectMs = nowMillis - beginMillis;
+                Serial.printf("[WiFi] ✅ Connected in %lu ms (boot, %s) — %s\n",
+                              (unsigned long)stats.bootConnectMs, attemptUsedCache ? "cached AP" : "scan",
+                              WiFi.localIP().toString().c_str());
+            } else {
+                stats.lastReconnectMs = nowMillis - outageStart;
+                if (stats.lastReconnectMs > stats.maxReconnectMs) stats.maxReconnectMs = stats.lastReconnectMs;
+                Serial.printf("[WiFi] ✅ Reconnected in %lu ms (%s)\n",
+                              (unsigned long)stats.lastReconnectMs, attemptUsedCache ? "cached AP" : "scan");
+            }
+
+            saveCache();
+            notify(true);
+        }
+    }
+
+    if (state == WIFI_STATE_CONNECTING && nowMillis - attemptStart >= WIFI_CONNECT_TIMEOUT_MS) {
+        WiFi.disconnect();
+        attemptFailed(nowMillis);
+    }
+
+    if (state == WIFI_STATE_BACKOFF && (long)(nowMillis - nextAttempt) >= 0) {
+        startAttempt(nowMillis);
+    }
+}
+
+bool wifi_is_up() {
+    return linkUp;
+}
+
+void wifi_on_link_change(WifiLinkFn fn) {
+    if (listenerCount < WIFI_MAX_LISTENERS) listeners[listenerCount++] = fn;
+}
+
+const WifiStats &wifi_stats() {
+    return stats;
+}
+
+void wifi_log_stats() {
+    Serial.printf("[WiFi] %s | connects=%lu (cached %lu) drops=%lu failed=%lu boot=%lu ms reconnect last=%lu max=%lu ms reason=%u\n",
+                  linkUp ? "up" : "down",
+                  (unsigned long)stats.connects, (unsigned long)stats.cachedConnects,
+                  (unsigned long)stats.drops, (unsigned long)stats.failedAttempts,
+                  (unsigned long)stats.bootConnectMs, (unsigned long)stats.lastReconnectMs,
+                  (unsigned long)stats.maxReconnectMs, stats.lastReason);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// === Event-driven WiFi manager ===
+// WiFi.onEvent() callbacks only latch flags; wifi_manager_loop() runs the
+// state machine in the loop task: non-blocking (re)association with
+// exponential backoff, fast association from the BSSID/channel cached in NVS,
+// and link up/down notifications to registered listeners.
+
+// Called from wifi_manager_loop() (loop task) on every link transition
+typedef void (*WifiLinkFn)(bool up);
+
+struct WifiStats {
+    uint32_t connects = 0;
+    uint32_t drops = 0;
+    uint32_t failedAttempts = 0;
+    uint32_t cachedConnects = 0;     // associated straight from the NVS BSSID/channel
+    uint32_t bootConnectMs = 0;      // wifi_manager_begin() → got IP
+    uint32_t lastReconnectMs = 0;    // link drop → got IP
+    uint32_t maxReconnectMs = 0;
+    uint8_t lastReason = 0;          // wifi_err_reason_t of the last disconnect
+};
+
+// Start the first association and return immediately
+void wifi_manager_begin();
+
+// Drive reconnects and dispatch link events; call every loop()
+void wifi_manager_loop(unsigned long nowMillis);
+
+// Link has an IP (updated on the event, no driver call)
+bool wifi_is_up();
+
+// Register a link listener (up to WIFI_MAX_LISTENERS)
+void wifi_on_link_change(WifiLinkFn fn);
+
+const WifiStats &wifi_stats();
+void wifi_log_stats();
@@ -0,0 +1,172 @@
+// === Command stream parser benchmark (PlatformIO `native_parser_bench` environment) ===
+// Replays SSE captures of the /commands stream through the firmware's own
+// sse_find_json() + rtdb_apply_command_event() and reports events per
+// second and heap traffic per event (every malloc the parser and
+// ArduinoJson make is counted).
+//
+//   pio run -e native_parser_bench && .pio/build/native_parser_bench/program [options] [STORM...]
+//     STORM            SSE capture, events separated by blank lines
+//                      (default: sim/bench/patch_storm.sse)
+//     --repeat N       passes over the storm for the timing run (default 200)
+//
+// Host figures: the ESP32 at 240 MHz is roughly an order of magnitude
+// slower per event, the heap figures carry over as they are.
+
+#include <Arduino.h>
+#include <chrono>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "commands.h"
+#include "logger.h"
+#include "rtdb_command_parser.h"
+
+// === Heap accounting (glibc: the executable's malloc wins) ===
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static bool counting = false;
+static uint64_t allocCalls = 0;
+static uint64_t allocBytes = 0;
+static int64_t liveBytes = 0, peakBytes = 0;
+
+static void noteAlloc(void *p) {
+    if (!counting || !p) return;
+    size_t n = malloc_usable_size(p);
+    allocCalls++;
+    allocBytes += n;
+    liveBytes += n;
+    if (liveBytes > peakBytes) peakBytes = liveBytes;
+}
+
+static void noteFree(void *p) {
+    if (counting && p) liveBytes -= malloc_usable_size(p);
+}
+
+extern "C" void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    noteAlloc(p);
+    return p;
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    void *p = __libc_calloc(count, size);
+    noteAlloc(p);
+    return p;
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    noteFree(ptr);
+    void *p = __libc_realloc(ptr, size);
+    noteAlloc(p);
+    return p;
+}
+
+extern "C" void free(void *ptr) {
+    noteFree(ptr);
+    __libc_free(ptr);
+}
+
+// === Storm loading ===
+static bool loadStorm(const char *path, std::vector<std::string> &events) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find("\n\n", pos);
+        if (end == std::string::npos) end = text.size();
+        std::string event = text.substr(pos, end - pos);
+        if (event.find_first_not_of(" \r\n") != std::string::npos) events.push_back(event);
+        pos = end + 2;
+    }
+    return true;
+}
+
+// The stream callback's path: find the JSON in the buffer, apply it
+static bool applyEvent(const std::string &event, Commands &commands, CommandPatchResult &result) {
+    const char *json;
+    size_t len;
+    result = CommandPatchResult();
+    if (!sse_find_json(event.data(), event.size(), json, len)) return false;
+    return rtdb_apply_command_event(json, len, commands, result);
+}
+
+int main(int argc, char **argv) {
+    uint32_t repeat = 200;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = strtoul(argv[++i], nullptr, 10);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [--repeat N] [STORM...]\n", argv[0]);
+            return 2;
+        } else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) paths.push_back("sim/bench/patch_storm.sse");
+    if (repeat == 0) repeat = 1;
+
+    Serial.setEnabled(false);
+    log_set_level_all(LOG_LEVEL_NONE);
+
+    std::vector<std::string> events;
+    for (const char *path : paths) {
+        if (!loadStorm(path, events)) return 1;
+    }
+    if (events.empty()) {
+        fprintf(stderr, "no events\n");
+        return 1;
+    }
+
+    // Heap pass: one replay with every allocation counted per event
+    Commands commands = {};
+    CommandPatchResult result;
+    uint32_t parsed = 0, changed = 0, failed = 0;
+    uint64_t maxEventBytes = 0, maxEventPeak = 0;
+    uint64_t totalCalls = 0, totalBytes = 0;
+    for (const std::string &event : events) {
+        allocCalls = allocBytes = 0;
+        liveBytes = peakBytes = 0;
+        counting = true;
+        bool ok = applyEvent(event, commands, result);
+        counting = false;
+
+        if (ok) parsed++;
+        else failed++;
+        if (result.changed) changed++;
+        totalCalls += allocCalls;
+        totalBytes += allocBytes;
+        if (allocBytes > maxEventBytes) maxEventBytes = allocBytes;
+        if ((uint64_t)peakBytes > maxEventPeak) maxEventPeak = peakBytes;
+    }
+
+    // Timing pass
+    Commands scratch = {};
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeat; r++) {
+        for (const std::string &event : events) applyEvent(event, scratch, result);
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    double total = (double)events.size() * repeat;
+
+    printf("\n=== Command stream parser: %zu events (%u parsed, %u failed, %u changed a command) ===\n",
+           events.size(), parsed, failed, changed);
+    printf("throughput     %.0f events/s (%.2f us per event, %u passes)\n",
+           total / wall.count(), wall.count() * 1e6 / total, repeat);
+    printf("heap / event   %.1f allocations, %.0f bytes allocated (max %llu), peak live %llu bytes\n",
+           (double)totalCalls / events.size(), (double)totalBytes / events.size(),
+           (unsigned long long)maxEventBytes, (unsigned long long)maxEventPeak);
+    return failed ? 1 : 0;
+}
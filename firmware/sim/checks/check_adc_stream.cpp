@@ -0,0 +1,106 @@
+// ADC DMA stream against the continuous-driver shim: frames keep coming at
+// the sensor task's poll rate, an overflowed driver ring costs samples but
+// never frames, a stuck controller is detected and restarted, and the
+// trimmed mean rejects spikes. Also prints the poll cost next to the time
+// the analogRead() path blocked per sensor pass.
+
+#include <Arduino.h>
+#include <chrono>
+#include <math.h>
+#include "checks.h"
+#include "config.h"
+#include "adc_stream.h"
+#include "sim_hal.h"
+
+// Raw level per channel (3 = pH, 6 = DO, 7 = turbidity), every 16th sample a full-scale spike
+static uint16_t source(uint8_t channel, uint64_t us) {
+    static uint32_t n = 0;
+    if (++n % 16 == 0) return 4095;
+    uint16_t noise = (us / 50) % 5;   // 0..4 counts
+    switch (channel) {
+        case 3: return 1800 + noise;
+        case 6: return 600 + noise;
+        case 7: return 2500 + noise;
+        default: return 0;
+    }
+}
+
+static float mvOf(float raw) {
+    return raw * ADC_VOLTAGE_MV / ADC_MAX;
+}
+
+static bool frameMatches(const AdcFrame &f) {
+    return fabsf(f.phMv - mvOf(1802)) < 2.0f && fabsf(f.doMv - mvOf(602)) < 2.0f &&
+           fabsf(f.turbidityMv - mvOf(2502)) < 2.0f;
+}
+
+// Poll like the sensor task for `ms` of virtual time; returns frames completed
+static uint32_t pollFor(unsigned long ms, unsigned long periodMs, bool *allFresh = nullptr) {
+    uint32_t frames = adc_stream_stats().frames;
+    if (allFresh) *allFresh = true;
+    for (unsigned long t = 0; t < ms; t += periodMs) {
+        sim_clock_advance_to(sim_clock_now_us() + periodMs * 1000ULL);
+        adc_stream_poll();
+        AdcFrame f;
+        if (allFresh && !adc_stream_latest(f)) *allFresh = false;
+    }
+    return adc_stream_stats().frames - frames;
+}
+
+bool check_adc_stream() {
+    sim_clock_reset(0);
+    sim_adc_set_source(source);
+    CHECK(adc_stream_init(), "init failed");
+
+    // Steady state at the sensor task period: no overflow, one frame per ~38 ms
+    bool fresh;
+    pollFor(200, SENSOR_TASK_PERIOD_MS);
+    AdcStreamStats before = adc_stream_stats();
+    uint32_t frames = pollFor(60000, SENSOR_TASK_PERIOD_MS, &fresh);
+    uint32_t expected = 60UL * ADC_DMA_SAMPLE_FREQ_HZ / 3 / ADC_DMA_FRAME_SAMPLES;
+    CHECK(adc_stream_stats().overflows == before.overflows, "%lu overflows at %d ms polls",
+          (unsigned long)(adc_stream_stats().overflows - before.overflows), SENSOR_TASK_PERIOD_MS);
+    CHECK(frames + 1 >= expected && frames <= expected + 1, "%lu frames in 60 s, expected ~%lu",
+          (unsigned long)frames, (unsigned long)expected);
+    CHECK(fresh, "latest frame went stale while polling");
+
+    AdcFrame f;
+    CHECK(adc_stream_latest(f), "no frame");
+    CHECK(frameMatches(f), "spikes leaked into the frame: pH %.1f DO %.1f turb %.1f mV",
+          f.phMv, f.doMv, f.turbidityMv);
+
+    // Stalls of 500 ms overflow the driver ring every time, yet every poll still completes a frame
+    before = adc_stream_stats();
+    uint32_t dropped = sim_adc_dropped();
+    frames = pollFor(10000, 500, &fresh);
+    CHECK(sim_adc_dropped() > dropped, "500 ms polls did not overflow the driver ring");
+    CHECK(adc_stream_stats().overflows > before.overflows, "overflow not counted");
+    CHECK(frames >= 20, "%lu frames from 20 overflowed polls", (unsigned long)frames);
+    CHECK(fresh, "frames went stale under overflow");
+    CHECK(adc_stream_latest(f) && frameMatches(f), "bad frame after overflow");
+
+    // Controller stops producing: frame goes stale, the stream restarts, frames resume
+    sim_adc_halt(true);
+    before = adc_stream_stats();
+    pollFor(ADC_DMA_STALE_MS + 200, SENSOR_TASK_PERIOD_MS);
+    CHECK(!adc_stream_latest(f), "stale frame still reported");
+    CHECK(adc_stream_stats().restarts == before.restarts + 1, "%lu restarts",
+          (unsigned long)(adc_stream_stats().restarts - before.restarts));
+    sim_adc_halt(false);
+    pollFor(200, SENSOR_TASK_PERIOD_MS);
+    CHECK(adc_stream_latest(f) && frameMatches(f), "no fresh frame after restart");
+
+    // Poll cost (host CPU; the device logs its own lastPollUs/maxPollUs)
+    const int polls = 2000;
+    uint64_t busyNs = 0;
+    for (int i = 0; i < polls; i++) {
+        sim_clock_advance_to(sim_clock_now_us() + SENSOR_TASK_PERIOD_MS * 1000ULL);
+        auto t0 = std::chrono::steady_clock::now();
+        adc_stream_poll();
+        busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+    unsigned long blockedMs = PH_SENSOR_SAMPLES * PH_SAMPLE_DELAY_MS + DO_SENSOR_SAMPLES * 5 + NUM_SAMPLES * 5;
+    printf("  analog pass: analogRead() path blocked %lu ms (delays only); DMA poll %.1f us per %d ms of samples (host)\n",
+           blockedMs, busyNs / 1000.0 / polls, SENSOR_TASK_PERIOD_MS);
+    return true;
+}
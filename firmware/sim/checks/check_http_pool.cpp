@@ -0,0 +1,102 @@
+// HTTPS connection pool against the stand-in server: the firmware's host
+// mix reuses one socket per host, sign-in takes the LRU slot, a socket the
+// server closed is retried once on a fresh one, idle sockets are released,
+// and the handshake/latency counters match what the server saw.
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include "checks.h"
+#include "config.h"
+#include "http_pool.h"
+#include "sim_hal.h"
+#include "sim_https.h"
+
+#define RTDB_URL         "https://aquabell-rtdb.example.com/live/device1.json?print=silent"
+#define FIRESTORE_URL    "https://firestore.googleapis.com/v1/projects/p/databases/(default)/documents:commit"
+#define TOKEN_URL        "https://securetoken.googleapis.com/v1/token?key=k"
+#define SIGNIN_URL       "https://identitytoolkit.googleapis.com/v1/accounts:signInWithPassword?key=k"
+
+static int request(const char *url) {
+    return http_pool_request("POST", url, "{}", "application/json", "token");
+}
+
+bool check_http_pool() {
+    sim_clock_reset(0);
+    http_pool_close_all();
+    SimHttpsConfig server;
+    sim_https_reset(server);
+    HttpPoolStats base = http_pool_stats();
+
+    // Boot: sign-in, then the three steady-state hosts. Four hosts, HTTP_POOL_SIZE slots
+    CHECK(http_ok(request(SIGNIN_URL)), "sign-in failed");
+    CHECK(http_ok(request(RTDB_URL)), "RTDB failed");
+    CHECK(http_ok(request(FIRESTORE_URL)), "Firestore failed");
+    CHECK(http_ok(request(TOKEN_URL)), "token refresh failed");
+    CHECK(sim_https_stats().handshakes == 4, "%lu handshakes for 4 hosts", (unsigned long)sim_https_stats().handshakes);
+
+    // Steady state (RTDB every 5 s, Firestore every 10 min, token hourly) with the
+    // firmware's idle sweep: only Firestore, idle past HTTP_POOL_IDLE_MS, reconnects
+    const int rounds = 720;
+    for (int i = 0; i < rounds; i++) {
+        delay(5000);
+        http_pool_close_idle(millis());
+        CHECK(http_ok(request(RTDB_URL)), "RTDB failed in round %d", i);
+        if (i % 120 == 0) CHECK(http_ok(request(FIRESTORE_URL)), "Firestore failed in round %d", i);
+        if (i % 720 == 0) CHECK(http_ok(request(TOKEN_URL)), "token failed in round %d", i);
+    }
+    uint32_t expected = 4 + (rounds - 1) / 120;
+    CHECK(sim_https_stats().handshakes == expected && sim_https_stats().staleSends == 0,
+          "%lu handshakes, %lu stale sends after steady state, expected %lu and 0",
+          (unsigned long)sim_https_stats().handshakes, (unsigned long)sim_https_stats().staleSends,
+          (unsigned long)expected);
+    uint32_t requests = http_pool_stats().requests - base.requests;
+    CHECK(http_pool_stats().handshakes - base.handshakes == expected &&
+          http_pool_stats().handshakesAvoided - base.handshakesAvoided == requests - expected,
+          "pool counted %lu handshakes, %lu avoided of %lu requests",
+          (unsigned long)(http_pool_stats().handshakes - base.handshakes),
+          (unsigned long)(http_pool_stats().handshakesAvoided - base.handshakesAvoided), (unsigned long)requests);
+    CHECK(http_pool_stats().lastLatencyMs == server.requestMs, "reused socket took %lu ms",
+          (unsigned long)http_pool_stats().lastLatencyMs);
+    printf("  %lu requests over 1 h: %lu handshakes (%lu without the pool), avg %lu ms per request\n",
+           (unsigned long)requests, (unsigned long)sim_https_stats().handshakes, (unsigned long)requests,
+           (unsigned long)((http_pool_stats().totalLatencyMs - base.totalLatencyMs) / requests));
+
+    // All slots busy: sign-in evicts the least recently used host (token), RTDB and Firestore keep theirs
+    CHECK(http_ok(request(TOKEN_URL)) && http_ok(request(FIRESTORE_URL)) && http_ok(request(RTDB_URL)),
+          "requests before sign-in failed");
+    uint32_t handshakes = sim_https_stats().handshakes;
+    CHECK(http_ok(request(SIGNIN_URL)), "second sign-in failed");
+    CHECK(http_ok(request(RTDB_URL)) && http_ok(request(FIRESTORE_URL)), "requests after sign-in failed");
+    CHECK(sim_https_stats().handshakes == handshakes + 1, "%lu handshakes for sign-in + RTDB + Firestore",
+          (unsigned long)(sim_https_stats().handshakes - handshakes));
+    CHECK(http_ok(request(TOKEN_URL)), "token after sign-in failed");
+    CHECK(sim_https_stats().handshakes == handshakes + 2, "evicted token socket was not reopened");
+    handshakes = sim_https_stats().handshakes;
+
+    // Server drops idle keep-alive sockets: the stale send is retried once on a new socket
+    delay(server.serverIdleMs + 1000);
+    uint32_t failures = http_pool_stats().failures;
+    CHECK(http_ok(request(RTDB_URL)), "request on a server-closed socket failed");
+    CHECK(sim_https_stats().staleSends == 1, "%lu stale sends", (unsigned long)sim_https_stats().staleSends);
+    CHECK(sim_https_stats().handshakes == handshakes + 1, "no reconnect after a stale socket");
+    CHECK(http_pool_stats().failures == failures, "retried request counted as a failure");
+    CHECK(http_pool_stats().lastLatencyMs == server.handshakeMs + server.requestMs,
+          "reconnect took %lu ms", (unsigned long)http_pool_stats().lastLatencyMs);
+
+    // Idle sockets are closed by the pool before the server does it
+    http_pool_close_idle(millis() + HTTP_POOL_IDLE_MS);
+    handshakes = sim_https_stats().handshakes;
+    uint32_t stale = sim_https_stats().staleSends;
+    CHECK(http_ok(request(RTDB_URL)), "request after idle close failed");
+    CHECK(sim_https_stats().handshakes == handshakes + 1 && sim_https_stats().staleSends == stale,
+          "idle close did not release the socket");
+
+    // Refused connection: negative code, counted as a failure, nothing retried
+    http_pool_close_all();
+    sim_https_refuse(1);
+    failures = http_pool_stats().failures;
+    CHECK(request(RTDB_URL) == HTTPC_ERROR_CONNECTION_REFUSED, "refused connection not reported");
+    CHECK(http_pool_stats().failures == failures + 1, "refused connection not counted");
+    CHECK(http_ok(request(RTDB_URL)), "request after a refused one failed");
+    return true;
+}
@@ -0,0 +1,182 @@
+// LCD framebuffer rendering and diff. Numbers come out as Arduino's
+// String(float, decimals) would print them (rounded, "nan"/"inf"/"ovf"),
+// every field is blank-padded to its width and clipped at it, so a shorter
+// value clears the longer one before it and a long one never spills into
+// the next field. lcd_frame_diff() over random frame pairs returns runs that
+// stay on the display, come in display order, merge across gaps of at most
+// LCD_RUN_MERGE_GAP cells and, applied to the shown frame, reproduce the
+// next one; the worst case fits LCD_MAX_RUNS.
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "checks.h"
+#include "config.h"
+#include "lcd_frame.h"
+
+#define DIFF_PAIRS  100000
+
+static std::string rowText(const LcdFrame &frame, uint8_t row) {
+    return std::string(frame.cells[row], LCD_COLS);
+}
+
+static std::string padded(const std::string &s) {
+    return s + std::string(LCD_COLS - s.size(), ' ');
+}
+
+static LcdFrame renderTurbidity(float ntu) {
+    RealTimeData data;
+    data.turbidityNTU = ntu;
+    LcdFrame frame;
+    lcd_frame_render_labels(frame);
+    lcd_frame_render(frame, data);
+    return frame;
+}
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom() {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+bool check_lcd_frame() {
+    // Rounding against printf on values that are not a rounding tie
+    int compared = 0;
+    for (int i = 0; i < 20000; i++) {
+        float v = (float)((int)(nextRandom() % 2000000) - 1000000) / 997.0f;
+        double scaled = fabs((double)v) * 100;
+        if (fabs(scaled - floor(scaled) - 0.5) < 1e-3) continue;
+        char text[24];
+        snprintf(text, sizeof(text), "Turb: %.2fNTU", (double)v);
+        if (strcmp(text, "Turb: -0.00NTU") == 0) continue;   // printf keeps the sign of a tiny negative too
+        std::string row = rowText(renderTurbidity(v), 3);
+        CHECK(row == padded(text), "%.6f rendered \"%s\", expected \"%s\"", (double)v, row.c_str(), text);
+        compared++;
+    }
+
+    // Arduino's corner cases
+    struct Case {
+        float v;
+        const char *row;
+    };
+    static const Case cases[] = {
+        {1.999f, "Turb: 2.00NTU"},
+        {0.004f, "Turb: 0.00NTU"},
+        {0.005001f, "Turb: 0.01NTU"},
+        {-0.5f, "Turb: -0.50NTU"},
+        {NAN, "Turb: nanNTU"},
+        {INFINITY, "Turb: infNTU"},
+        {-INFINITY, "Turb: -infNTU"},
+        {40000000.0f, "Turb: 40000000.00NTU"},   // fills the field exactly
+        {42949672.0f, "Turb: ovfNTU"},           // x100 is past what a uint32 takes after rounding
+        {-5e7f, "Turb: ovfNTU"},
+    };
+    for (const Case &c : cases) {
+        std::string row = rowText(renderTurbidity(c.v), 3);
+        CHECK(row == padded(c.row), "%g rendered \"%s\", expected \"%s\"", (double)c.v, row.c_str(), c.row);
+    }
+
+    // Every cell written, fields padded and clipped at their width
+    RealTimeData data;
+    data.airTemp = 1000.0f;          // "Air:1000.0C" is 11 cells in a 10-cell field
+    data.airHumidity = 55.4f;
+    data.waterTemp = 125.25f;        // "Water: 125.3C" is 13 in 12
+    data.pH = 123.4f;                // "pH: 123.4" is 9 in 8
+    data.dissolvedOxygen = 7.04f;
+    data.turbidityNTU = 12345.678f;
+    LcdFrame frame;
+    lcd_frame_fill(frame, '#');
+    lcd_frame_render(frame, data);
+    CHECK(memchr(frame.cells, '#', sizeof(frame.cells)) == nullptr, "render left cells unwritten");
+    CHECK(rowText(frame, 0) == "Air:1000.0Hum:55%   ", "row 0 \"%s\"", rowText(frame, 0).c_str());
+    CHECK(rowText(frame, 1) == "Water: 125.3pH: 123.", "row 1 \"%s\"", rowText(frame, 1).c_str());
+    CHECK(rowText(frame, 2) == padded("DO: 7.0mg/L"), "row 2 \"%s\"", rowText(frame, 2).c_str());
+    CHECK(rowText(frame, 3) == padded("Turb: 12345.68NTU"), "row 3 \"%s\"", rowText(frame, 3).c_str());
+
+    data.airTemp = -5.0f;
+    data.waterTemp = 5.0f;
+    data.pH = 7.0f;
+    data.turbidityNTU = 1.5f;
+    lcd_frame_render(frame, data);
+    CHECK(rowText(frame, 0) == "Air:-5.0C Hum:55%   ", "row 0 after a shorter value \"%s\"", rowText(frame, 0).c_str());
+    CHECK(rowText(frame, 1) == "Water: 5.0C pH: 7.0 ", "row 1 after a shorter value \"%s\"", rowText(frame, 1).c_str());
+    CHECK(rowText(frame, 3) == padded("Turb: 1.50NTU"), "row 3 after a shorter value \"%s\"", rowText(frame, 3).c_str());
+
+    // Diff edge cases
+    LcdFrame a, b;
+    LcdRun runs[LCD_MAX_RUNS + 1];
+    lcd_frame_fill(a, ' ');
+    b = a;
+    CHECK(lcd_frame_diff(a, b, runs) == 0, "runs between identical frames");
+    b.cells[0][LCD_COLS - 1] = 'x';
+    b.cells[1][0] = 'x';
+    uint8_t n = lcd_frame_diff(a, b, runs);
+    CHECK(n == 2 && runs[0].row == 0 && runs[0].col == LCD_COLS - 1 && runs[0].len == 1 && runs[1].row == 1 &&
+              runs[1].col == 0 && runs[1].len == 1,
+          "row end + next row start: %u runs, first %u:%u+%u", n, runs[0].row, runs[0].col, runs[0].len);
+    b = a;
+    b.cells[2][3] = 'x';
+    b.cells[2][3 + LCD_RUN_MERGE_GAP + 1] = 'x';
+    b.cells[2][3 + 2 * (LCD_RUN_MERGE_GAP + 1) + 1] = 'x';
+    n = lcd_frame_diff(a, b, runs);
+    CHECK(n == 2 && runs[0].col == 3 && runs[0].len == LCD_RUN_MERGE_GAP + 2 && runs[1].len == 1,
+          "gap of %d merges, gap of %d does not: %u runs, first %u+%u", LCD_RUN_MERGE_GAP, LCD_RUN_MERGE_GAP + 1, n,
+          runs[0].col, runs[0].len);
+    lcd_frame_fill(b, 'x');
+    n = lcd_frame_diff(a, b, runs);
+    CHECK(n == LCD_ROWS && runs[LCD_ROWS - 1].len == LCD_COLS, "whole frame: %u runs", n);
+
+    // Worst case: changes just too far apart to merge
+    b = a;
+    int worst = 0;
+    for (int row = 0; row < LCD_ROWS; row++) {
+        for (int col = 0; col < LCD_COLS; col += LCD_RUN_MERGE_GAP + 2) {
+            b.cells[row][col] = 'x';
+            worst++;
+        }
+    }
+    n = lcd_frame_diff(a, b, runs);
+    CHECK(n == worst && n <= LCD_MAX_RUNS, "worst case: %u runs, expected %d (LCD_MAX_RUNS %d)", n, worst,
+          LCD_MAX_RUNS);
+
+    // Random pairs: in bounds, in order, minimal, and applying them reproduces `next`
+    unsigned maxRuns = 0;
+    for (int i = 0; i < DIFF_PAIRS; i++) {
+        uint32_t density = nextRandom() % 101;      // % of cells changed
+        for (int row = 0; row < LCD_ROWS; row++) {
+            for (int col = 0; col < LCD_COLS; col++) {
+                a.cells[row][col] = 'a' + nextRandom() % 26;
+                bool changed = nextRandom() % 100 < density;
+                b.cells[row][col] = changed ? (a.cells[row][col] == 'z' ? 'a' : a.cells[row][col] + 1) : a.cells[row][col];
+            }
+        }
+        runs[LCD_MAX_RUNS] = {0xEE, 0xEE, 0xEE};
+        n = lcd_frame_diff(a, b, runs);
+        CHECK(n <= LCD_MAX_RUNS && runs[LCD_MAX_RUNS].row == 0xEE, "pair %d: %u runs", i, n);
+        if (n > maxRuns) maxRuns = n;
+
+        LcdFrame applied = a;
+        for (uint8_t r = 0; r < n; r++) {
+            const LcdRun &run = runs[r];
+            CHECK(run.row < LCD_ROWS && run.len > 0 && run.col + run.len <= LCD_COLS, "pair %d: run %u:%u+%u off the display",
+                  i, run.row, run.col, run.len);
+            CHECK(a.cells[run.row][run.col] != b.cells[run.row][run.col] &&
+                      a.cells[run.row][run.col + run.len - 1] != b.cells[run.row][run.col + run.len - 1],
+                  "pair %d: run %u:%u+%u starts or ends on an unchanged cell", i, run.row, run.col, run.len);
+            if (r > 0) {
+                const LcdRun &prev = runs[r - 1];
+                CHECK(prev.row < run.row || (prev.row == run.row && run.col - (prev.col + prev.len) > LCD_RUN_MERGE_GAP),
+                      "pair %d: run %u:%u+%u after %u:%u+%u", i, run.row, run.col, run.len, prev.row, prev.col, prev.len);
+            }
+            memcpy(&applied.cells[run.row][run.col], &b.cells[run.row][run.col], run.len);
+        }
+        CHECK(memcmp(applied.cells, b.cells, sizeof(b.cells)) == 0, "pair %d: runs do not reproduce the next frame", i);
+    }
+
+    printf("  %d values as String(float) prints them, %zu corner cases, fields padded and clipped\n", compared,
+           sizeof(cases) / sizeof(cases[0]));
+    printf("  %d random frame pairs: runs in bounds, ordered, merged across <= %d cells; max %u, worst case %d of %d\n",
+           DIFF_PAIRS, LCD_RUN_MERGE_GAP, maxRuns, worst, LCD_MAX_RUNS);
+    return true;
+}
@@ -0,0 +1,103 @@
+// MpscRing under four producer threads and one consumer at the log ring's
+// size: every item arrives exactly once and intact, and each producer's
+// items arrive in the order it pushed them. Producers retry on a full ring
+// and the consumer yields when the ring is empty, so both edges are hit
+// constantly.
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include "checks.h"
+#include "config.h"
+#include "mpsc_ring.h"
+
+#define MPSC_PRODUCERS  4
+#define MPSC_ITEMS      200000UL   // per producer
+
+struct Item {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t payload[14];
+};
+
+static void fill(Item &item, uint32_t producer, uint32_t seq) {
+    item.producer = producer;
+    item.seq = seq;
+    for (int i = 0; i < 14; i++) item.payload[i] = ((producer << 24) ^ seq) * 2654435761u + i;
+}
+
+static bool intact(const Item &item) {
+    for (int i = 0; i < 14; i++) {
+        if (item.payload[i] != ((item.producer << 24) ^ item.seq) * 2654435761u + i) return false;
+    }
+    return true;
+}
+
+bool check_mpsc_ring() {
+    // Single-thread edge cases: all N slots are usable, full/empty are told apart
+    MpscRing<Item, 4> small;
+    Item item;
+    fill(item, 0, 1);
+    CHECK(!small.pop(item), "pop from an empty ring");
+    for (uint32_t i = 0; i < small.capacity(); i++) CHECK(small.push(item), "push %lu refused", (unsigned long)i);
+    CHECK(!small.push(item), "push into a full ring");
+    CHECK(small.size() == small.capacity(), "size %lu when full", (unsigned long)small.size());
+
+    MpscRing<Item, LOG_RING_SIZE> ring;
+    std::atomic<int> running{MPSC_PRODUCERS};
+    std::atomic<uint32_t> fullRetries{0};
+
+    std::thread producers[MPSC_PRODUCERS];
+    for (uint32_t p = 0; p < MPSC_PRODUCERS; p++) {
+        producers[p] = std::thread([&, p] {
+            Item item;
+            uint32_t retries = 0;
+            for (uint32_t seq = 0; seq < MPSC_ITEMS;) {
+                fill(item, p, seq);
+                if (ring.push(item)) {
+                    seq++;
+                } else {
+                    retries++;
+                    std::this_thread::yield();
+                }
+            }
+            fullRetries += retries;
+            running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    uint32_t next[MPSC_PRODUCERS] = {};
+    uint32_t received = 0, torn = 0, outOfOrder = 0, emptyPolls = 0;
+    for (;;) {
+        bool finished = running.load(std::memory_order_acquire) == 0;
+        bool got = false;
+        while (ring.pop(item)) {
+            got = true;
+            received++;
+            if (!intact(item) || item.producer >= MPSC_PRODUCERS) {
+                torn++;
+                continue;
+            }
+            if (item.seq != next[item.producer]) outOfOrder++;
+            next[item.producer] = item.seq + 1;
+        }
+        if (finished && !got) break;
+        if (!got) {
+            emptyPolls++;
+            std::this_thread::yield();
+        }
+    }
+    for (auto &t : producers) t.join();
+
+    CHECK(torn == 0, "%lu torn items", (unsigned long)torn);
+    CHECK(outOfOrder == 0, "%lu items out of producer order", (unsigned long)outOfOrder);
+    for (int p = 0; p < MPSC_PRODUCERS; p++) {
+        CHECK(next[p] == MPSC_ITEMS, "producer %d: %lu of %lu items", p, (unsigned long)next[p], MPSC_ITEMS);
+    }
+    CHECK(received == MPSC_PRODUCERS * MPSC_ITEMS, "%lu received, %lu pushed", (unsigned long)received,
+          MPSC_PRODUCERS * MPSC_ITEMS);
+    CHECK(ring.size() == 0, "ring not empty at the end");
+    printf("  %d producers x %lu items through a %d-slot ring: all in producer order, %lu full retries, %lu empty polls\n",
+           MPSC_PRODUCERS, MPSC_ITEMS, LOG_RING_SIZE, (unsigned long)fullRetries.load(), (unsigned long)emptyPolls);
+    return true;
+}
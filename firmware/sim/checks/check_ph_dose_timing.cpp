@@ -0,0 +1,104 @@
+// pH dose pulses on the virtual clock: every pump edge lands on the exact
+// microsecond the sequence asks for, the caller never blocks, and a timer
+// that can't be armed leaves both pumps OFF.
+
+#include <Arduino.h>
+#include "checks.h"
+#include "config.h"
+#include "ph_dosing.h"
+#include "relay_control.h"
+#include "sim_hal.h"
+
+#define MAX_EDGES  16
+
+struct Edge {
+    uint64_t us;
+    bool raising;
+    bool lowering;
+};
+
+static Edge edges[MAX_EDGES];
+static int edgeCount = 0;
+static bool lastRaising = false, lastLowering = false;
+
+static void recordEdges(uint64_t fromUs, uint64_t) {
+    bool raising = relay_is_on(RELAY_PH_RAISING);
+    bool lowering = relay_is_on(RELAY_PH_LOWERING);
+    if (raising == lastRaising && lowering == lastLowering) return;
+    if (edgeCount < MAX_EDGES) edges[edgeCount++] = {fromUs, raising, lowering};
+    lastRaising = raising;
+    lastLowering = lowering;
+}
+
+static void resetEdges() {
+    edgeCount = 0;
+    lastRaising = relay_is_on(RELAY_PH_RAISING);
+    lastLowering = relay_is_on(RELAY_PH_LOWERING);
+}
+
+// One full dose: ON/OFF edges at start + 1 µs, then pulse / gap widths
+static bool checkDose(bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    uint64_t startUs = sim_clock_now_us();
+    resetEdges();
+
+    CHECK(ph_dosing_start(up, pulses, pulseMs, gapMs), "start refused");
+    CHECK(sim_clock_now_us() == startUs, "start consumed %llu us", (unsigned long long)(sim_clock_now_us() - startUs));
+    CHECK(ph_dosing_busy(), "not busy after start");
+    CHECK(!ph_dosing_start(!up, pulses, pulseMs, gapMs), "second dose accepted while busy");
+
+    uint64_t expectedEndUs = startUs + 1 + pulses * pulseMs * 1000ULL + (pulses - 1) * gapMs * 1000ULL;
+    sim_clock_advance_to(expectedEndUs + 1000000ULL, recordEdges);
+
+    CHECK(edgeCount == pulses * 2, "%d edges for %u pulses", edgeCount, pulses);
+    uint64_t t = startUs + 1;
+    for (int i = 0; i < edgeCount; i++) {
+        bool on = i % 2 == 0;
+        CHECK(edges[i].us == t, "edge %d at %llu us, expected %llu", i,
+              (unsigned long long)edges[i].us, (unsigned long long)t);
+        CHECK(edges[i].raising == (up && on) && edges[i].lowering == (!up && on),
+              "edge %d drives raising=%d lowering=%d", i, edges[i].raising, edges[i].lowering);
+        t += (on ? pulseMs : gapMs) * 1000ULL;
+    }
+    CHECK(!ph_dosing_busy(), "still busy after the last pulse");
+    CHECK(ph_dosing_take_completed(), "completion not reported");
+    CHECK(!ph_dosing_take_completed(), "completion reported twice");
+    return true;
+}
+
+bool check_ph_dose_timing() {
+    sim_clock_reset(10000000ULL);
+    relay_control_init();
+    ph_dosing_init();
+
+    if (!checkDose(true, PH_PULSE_COUNT, PH_PULSE_MS, PH_PULSE_GAP_MS)) return false;
+    if (!checkDose(false, PH_PULSE_COUNT, PH_PULSE_MS, PH_PULSE_GAP_MS)) return false;
+    if (!checkDose(true, 5, 1, 7)) return false;
+
+    // Cancel mid-pulse: pumps OFF at once, no further edges
+    resetEdges();
+    CHECK(ph_dosing_start(true, 3, 200, 1000), "start refused");
+    sim_clock_advance_to(sim_clock_now_us() + 100000ULL, recordEdges);
+    CHECK(relay_is_on(RELAY_PH_RAISING), "pump not ON mid-pulse");
+    ph_dosing_cancel();
+    CHECK(!relay_is_on(RELAY_PH_RAISING), "pump still ON after cancel");
+    sim_clock_advance_to(sim_clock_now_us() + 10000000ULL, recordEdges);
+    CHECK(edgeCount == 2, "%d edges after cancel", edgeCount);
+    CHECK(!ph_dosing_busy() && !ph_dosing_take_completed(), "cancelled dose reported as running/completed");
+
+    // First edge can't be armed: refused, nothing left running
+    sim_timer_fail_starts(1);
+    CHECK(!ph_dosing_start(true, 2, 50, 3000), "start accepted with a failed timer");
+    CHECK(!ph_dosing_busy(), "busy after a failed start");
+    CHECK(ph_dosing_start(true, 1, 10, 0), "start refused after a failed one");
+    sim_clock_advance_to(sim_clock_now_us() + 1000000ULL);
+    CHECK(ph_dosing_take_completed(), "dose after a failed start did not complete");
+
+    // Re-arm fails with the pump ON: dose aborted, pump OFF
+    CHECK(ph_dosing_start(false, 2, 50, 3000), "start refused");
+    sim_timer_fail_starts(1);
+    sim_clock_advance_to(sim_clock_now_us() + 10ULL);
+    CHECK(!relay_is_on(RELAY_PH_LOWERING), "pump left ON after a failed re-arm");
+    CHECK(!ph_dosing_busy() && !ph_dosing_take_completed(), "aborted dose reported as running/completed");
+    sim_timer_fail_starts(0);
+    return true;
+}
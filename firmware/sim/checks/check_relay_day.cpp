@@ -0,0 +1,131 @@
+// One simulated day through the shadow-register relay driver: every loop
+// re-requests all eleven relays the way applyRulesWithModeControl() does,
+// pH doses run on the esp_timer, and the cooler thermostat hunts for three
+// hours. Physical transitions must match the requested changes, repeated
+// requests never reach the GPIO registers, and the cooler never breaks its
+// minimum on/off time.
+
+#include <Arduino.h>
+#include "checks.h"
+#include "config.h"
+#include "ph_dosing.h"
+#include "relay_control.h"
+#include "sim_hal.h"
+
+#define LOOP_MS   100UL
+#define HOUR_MS   3600000UL
+#define DAY_MS    (24UL * HOUR_MS)
+
+// RelayId order (relay_control.cpp RELAY_TABLE)
+static const uint8_t RELAY_PINS[RELAY_COUNT] = {
+    FAN_RELAY_PIN, LIGHT_RELAY_PIN, PUMP_RELAY_PIN, VALVE_RELAY_PIN, WATER_COOLER_RELAY_PIN,
+    WATER_HEATER_RELAY_PIN, PH_LOWERING_RELAY_PIN, PH_RAISING_RELAY_PIN, DRAIN_PUMP_RELAY_PIN,
+    FLUSH_VALVE_RELAY_PIN, DRAIN_VALVE_RELAY_PIN,
+};
+static const char *const RELAY_NAMES[RELAY_COUNT] = {
+    "fan", "light", "pump", "valve", "cooler", "heater",
+    "ph_lowering", "ph_raising", "drain_pump", "flush_valve", "drain_valve"
+};
+
+static uint32_t pinEdges[RELAY_COUNT];
+static uint8_t pinLast[RELAY_COUNT];
+static uint64_t coolerLastEdgeUs = 0;
+static uint64_t coolerShortestOnUs = UINT64_MAX, coolerShortestOffUs = UINT64_MAX;
+
+// Pin levels are constant over a segment; count every level change (relays are active LOW)
+static void watchPins(uint64_t fromUs, uint64_t) {
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        uint8_t level = sim_pin_output(RELAY_PINS[i]);
+        if (level == pinLast[i]) continue;
+        pinLast[i] = level;
+        pinEdges[i]++;
+        if (i != RELAY_COOLER) continue;
+        if (coolerLastEdgeUs) {
+            uint64_t held = fromUs - coolerLastEdgeUs;
+            bool wasOn = level == HIGH;   // now OFF → it was ON
+            uint64_t &shortest = wasOn ? coolerShortestOnUs : coolerShortestOffUs;
+            if (held < shortest) shortest = held;
+        }
+        coolerLastEdgeUs = fromUs;
+    }
+}
+
+// What the rules would ask for at `ms` into the day
+static void requestAll(unsigned long ms) {
+    unsigned long hour = ms / HOUR_MS;
+    unsigned long minute = ms / 60000UL;
+    control_fan(hour >= 10 && hour < 16);
+    control_light(hour >= 6 && hour < 18);
+    control_pump(minute % 30 < 15);
+    control_valve(false);
+    control_heater(false);
+    // Thermostat hunting around the setpoint 12:00-15:00: flips every 20 s
+    control_cooler(hour >= 12 && hour < 15 && (ms / 20000UL) % 2 == 0);
+    // Sump clean at 03:00 for SUMP_CLEAN_DURATION_MS
+    bool cleaning = ms >= 3 * HOUR_MS && ms < 3 * HOUR_MS + SUMP_CLEAN_DURATION_MS;
+    control_sump_cleaning(cleaning, cleaning);
+    control_drain(cleaning);
+}
+
+bool check_relay_day() {
+    sim_clock_reset(0);
+    relay_control_init();
+    ph_dosing_init();
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        pinEdges[i] = 0;
+        pinLast[i] = sim_pin_output(RELAY_PINS[i]);
+    }
+    uint32_t base[RELAY_COUNT];
+    for (int i = 0; i < RELAY_COUNT; i++) base[i] = relay_transitions((RelayId)i);
+    uint32_t writesBefore = sim_gpio_writes();
+
+    uint32_t loops = 0, doses = 0;
+    for (unsigned long ms = 0; ms < DAY_MS; ms += LOOP_MS) {
+        sim_clock_advance_to(ms * 1000ULL, watchPins);
+        requestAll(ms);
+        if (ms % (30 * 60000UL) == 0 && ph_dosing_start(true, PH_PULSE_COUNT, PH_PULSE_MS, PH_PULSE_GAP_MS)) doses++;
+        relay_commit(millis());
+        loops++;
+    }
+    sim_clock_advance_to(DAY_MS * 1000ULL, watchPins);
+
+    uint32_t transitions[RELAY_COUNT], total = 0;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        transitions[i] = relay_transitions((RelayId)i) - base[i];
+        total += transitions[i];
+        CHECK(transitions[i] == pinEdges[i], "%s: driver counted %lu transitions, pin changed %lu times",
+              RELAY_NAMES[i], (unsigned long)transitions[i], (unsigned long)pinEdges[i]);
+    }
+
+    // Exactly the requested changes
+    CHECK(transitions[RELAY_FAN] == 2 && transitions[RELAY_LIGHT] == 2, "fan %lu, light %lu",
+          (unsigned long)transitions[RELAY_FAN], (unsigned long)transitions[RELAY_LIGHT]);
+    CHECK(transitions[RELAY_PUMP] == 96, "pump %lu, expected 96", (unsigned long)transitions[RELAY_PUMP]);
+    CHECK(transitions[RELAY_VALVE] == 0 && transitions[RELAY_HEATER] == 0 && transitions[RELAY_PH_LOWERING] == 0,
+          "idle relays switched");
+    CHECK(transitions[RELAY_PH_RAISING] == doses * PH_PULSE_COUNT * 2, "pH raising %lu for %lu doses",
+          (unsigned long)transitions[RELAY_PH_RAISING], (unsigned long)doses);
+    CHECK(transitions[RELAY_DRAIN_PUMP] == 2 && transitions[RELAY_FLUSH_VALVE] == 2 &&
+          transitions[RELAY_DRAIN_VALVE] == 2, "sump clean relays switched more than once");
+
+    // The cooler follows the hunting thermostat only as fast as its protection allows
+    const uint32_t maxCooler = 2 * (3 * HOUR_MS / (COOLER_MIN_ON_MS + COOLER_MIN_OFF_MS)) + 2;
+    CHECK(transitions[RELAY_COOLER] > 0 && transitions[RELAY_COOLER] <= maxCooler,
+          "cooler %lu transitions, at most %lu", (unsigned long)transitions[RELAY_COOLER], (unsigned long)maxCooler);
+    CHECK(coolerShortestOnUs >= COOLER_MIN_ON_MS * 1000ULL && coolerShortestOffUs >= COOLER_MIN_OFF_MS * 1000ULL,
+          "cooler held on %llu ms / off %llu ms, minimum %lu / %lu",
+          (unsigned long long)(coolerShortestOnUs / 1000), (unsigned long long)(coolerShortestOffUs / 1000),
+          COOLER_MIN_ON_MS, COOLER_MIN_OFF_MS);
+
+    // Register writes: only commits that changed something write, each relay edge once
+    uint32_t writes = sim_gpio_writes() - writesBefore;
+    CHECK(writes <= total, "%lu register writes for %lu transitions", (unsigned long)writes, (unsigned long)total);
+
+    printf("  24 h, %lu loops:", (unsigned long)loops);
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (transitions[i]) printf(" %s=%lu", RELAY_NAMES[i], (unsigned long)transitions[i]);
+    }
+    printf("\n  %lu transitions in %lu GPIO register writes (one write per relay request: %lu)\n",
+           (unsigned long)total, (unsigned long)writes, (unsigned long)loops * RELAY_COUNT);
+    return true;
+}
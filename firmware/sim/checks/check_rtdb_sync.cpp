@@ -0,0 +1,185 @@
+// Handing an actuator back to AUTO through the firmware's own command
+// handler, rules, relay sync, outbound queue and HTTPS pool, against an RTDB
+// stand-in that applies a multi-location PATCH as one write: the event costs
+// one request at the database root, live_data/<id> and commands/<id> change
+// together in it, a failed attempt changes neither and its retry both, and
+// the command trace is acked once that write lands.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "checks.h"
+#include "command_trace.h"
+#include "commands.h"
+#include "config.h"
+#include "firebase.h"
+#include "outbound_queue.h"
+#include "ph_dosing.h"
+#include "relay_control.h"
+#include "rtdb_command_parser.h"
+#include "rule_engine.h"
+#include "sim_hal.h"
+#include "sim_https.h"
+
+#define LIVE_PREFIX      "live_data/aquabell_esp32/"
+#define COMMANDS_PREFIX  "commands/aquabell_esp32/"
+#define FAN_VALUE        COMMANDS_PREFIX "fan/value"
+
+extern RealTimeData current;
+extern Commands currentCommands;
+
+// ===== RTDB stand-in =====
+struct RtdbWrite {
+    std::string method;
+    std::string node;        // "" for the root, else "a/b/"
+    int status;
+    bool live;               // body has a live_data/<id> key
+    bool commands;           // body has a commands/<id> key
+};
+static std::map<std::string, std::string> tree;   // leaf path → JSON scalar
+static std::vector<RtdbWrite> writes;
+static bool failNextPatch = false;
+
+// "https://host/a/b.json?x" → "a/b/"
+static std::string nodeOf(const String &url) {
+    std::string u = url.c_str();
+    size_t start = u.find('/', u.find("://") + 3);
+    size_t end = u.find(".json", start);
+    std::string node = u.substr(start + 1, end - start - 1);
+    return node.empty() ? node : node + "/";
+}
+
+// A flat object of scalars, which is all the firmware PATCHes
+static bool parseFlat(const String &body, std::vector<std::pair<std::string, std::string>> &fields) {
+    std::string s = body.c_str();
+    if (s.size() < 2 || s.front() != '{' || s.back() != '}') return false;
+    size_t i = 1;
+    while (i < s.size() - 1) {
+        if (s[i] != '"') return false;
+        size_t keyEnd = s.find('"', i + 1);
+        if (keyEnd == std::string::npos || s[keyEnd + 1] != ':') return false;
+        size_t valueEnd = s.find_first_of(",}", keyEnd + 2);
+        fields.emplace_back(s.substr(i + 1, keyEnd - i - 1), s.substr(keyEnd + 2, valueEnd - keyEnd - 2));
+        i = valueEnd + 1;
+    }
+    return true;
+}
+
+static int rtdbHandler(const char *method, const String &url, const String &payload, String &response) {
+    response = "";
+    RtdbWrite w = {method, nodeOf(url), 200, false, false};
+    if (strcmp(method, "PATCH") == 0) {
+        std::vector<std::pair<std::string, std::string>> fields;
+        if (!parseFlat(payload, fields)) {
+            w.status = 400;
+        } else {
+            for (const auto &f : fields) {
+                std::string path = w.node + f.first;
+                if (path.compare(0, strlen(LIVE_PREFIX), LIVE_PREFIX) == 0) w.live = true;
+                if (path.compare(0, strlen(COMMANDS_PREFIX), COMMANDS_PREFIX) == 0) w.commands = true;
+            }
+            if (failNextPatch) {
+                failNextPatch = false;
+                w.status = 503;            // rejected as a whole: nothing applied
+            } else {
+                for (const auto &f : fields) tree[w.node + f.first] = f.second;
+            }
+        }
+    }
+    writes.push_back(w);                   // POSTs are the trace's diagnostics acks
+    return w.status;
+}
+
+// firesbase.cpp's, which needs the FirebaseClient stack
+bool appendDiagnostics(const char *node, const JsonDocument &doc) {
+    String payload;
+    serializeJson(doc, payload);
+    return outbound_submit(OUT_PRIO_LOG, "POST",
+                           String("https://rtdb.example/diagnostics/aquabell_esp32/") + node + ".json?print=silent",
+                           payload, OUT_AUTH_QUERY, OUTBOUND_LOG_TTL_MS);
+}
+
+// ===== Loop =====
+static void runFor(unsigned long ms) {
+    unsigned long end = millis() + ms;
+    while ((long)(millis() - end) < 0) {
+        relay_commit(millis());
+        cmd_trace_poll(relay_pending_mask(), millis());
+        outbound_process(millis(), "token");
+        delay(50);
+    }
+}
+
+bool check_rtdb_sync() {
+    RealTimeData savedData = current;
+    Commands savedCommands = currentCommands;
+
+    SimHttpsConfig server;
+    server.handler = rtdbHandler;
+    sim_clock_reset(0);
+    sim_wifi_set_up(true);
+    sim_https_reset(server);
+    sim_cloud_set_ready(true);
+    relay_control_init();
+    ph_dosing_init();
+    tree.clear();
+    writes.clear();
+
+    // Everything AUTO except the fan, which the user holds OFF; warm enough
+    // that the fan rule wants it ON
+    for (int i = 0; i < ACTUATOR_COUNT; i++) (currentCommands.*ACTUATORS[i].command).isAuto = true;
+    currentCommands.fan = {false, false};
+    tree[COMMANDS_PREFIX "fan/isAuto"] = "false";
+    tree[FAN_VALUE] = "false";
+    current.airTemp = TEMP_ON_THRESHOLD + 3;
+    current.airHumidity = 60;
+    evaluateRules(true, millis());
+    runFor(5000);
+    CHECK(tree[FAN_VALUE] == "false", "a MANUAL fan value was synced over");
+
+    // The user hands the fan back to AUTO; the stream delivers it
+    currentCommands.fan.isAuto = true;
+    tree[COMMANDS_PREFIX "fan/isAuto"] = "true";
+    CommandPatchResult patch;
+    patch.changed = true;
+    patch.autoTriggered = true;
+    patch.actuatorMask = 1u << ACTUATOR_fan;
+    patch.receivedUs = micros();
+    size_t first = writes.size();
+    failNextPatch = true;
+    handleCommandPatch(patch, "stream");
+    runFor(10000);
+
+    int patches = 0, applied = 0, acks = 0;
+    for (size_t i = first; i < writes.size(); i++) {
+        const RtdbWrite &w = writes[i];
+        if (w.method == "POST") {
+            acks++;
+            continue;
+        }
+        CHECK(w.method == "PATCH", "unexpected %s /%s", w.method.c_str(), w.node.c_str());
+        CHECK(w.node.empty(), "PATCH to /%s instead of the root", w.node.c_str());
+        CHECK(w.live && w.commands, "PATCH %d touched live_data=%d commands=%d", patches, w.live, w.commands);
+        patches++;
+        if (w.status == 200) applied++;
+    }
+    CHECK(patches == 2 && applied == 1, "%d PATCHes (%d applied) for one event, expected a failed one and its retry",
+          patches, applied);
+    CHECK(tree[FAN_VALUE] == "true", "fan value %s after the retry", tree[FAN_VALUE].c_str());
+    CHECK(acks == 1, "%d command acks", acks);
+    const CommandTraceStats &traces = cmd_trace_stats();
+    CHECK(traces.completed == 1 && traces.timedOut == 0, "trace completed=%lu timedOut=%lu",
+          (unsigned long)traces.completed, (unsigned long)traces.timedOut);
+    CHECK(outbound_depth() == 0, "%u writes left queued", outbound_depth());
+
+    printf("  fan back to AUTO: 1 root PATCH carrying live_data + commands (503 changed neither, retry both), 1 ack\n");
+
+    sim_cloud_set_ready(false);
+    sim_wifi_set_up(false);
+    current = savedData;
+    currentCommands = savedCommands;
+    return true;
+}
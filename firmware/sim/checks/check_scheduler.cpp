@@ -0,0 +1,194 @@
+// Timer-wheel scheduler on the virtual clock, driven like loop(): run the
+// due jobs, then sleep min(idle, LOOP_IDLE_MAX_MS). Periodic jobs land on
+// their exact deadline for an hour without drift (periods shorter and longer
+// than one wheel revolution), a blocking job makes the others late but
+// missed periods are skipped rather than queued, one-shots and reschedules
+// fire once at the new deadline, including a job rescheduled, or cancelled
+// and its slot reused, by another job due in the same sweep. Reports the
+// host cost of a sweep.
+
+#include <Arduino.h>
+#include <chrono>
+#include "checks.h"
+#include "config.h"
+#include "scheduler.h"
+#include "sim_hal.h"
+
+#define RUN_MS   3600000UL
+
+struct Probe {
+    unsigned long period;
+    unsigned long firstDelay;
+    uint32_t runs;
+    uint32_t skipped;
+    unsigned long lastRun;
+    unsigned long maxLateMs;
+};
+
+// Periods: one tick, off-tick, under and over one revolution (640 ms), long
+static Probe probes[] = {
+    {SCHED_TICK_MS, 0, 0, 0, 0, 0},
+    {37, 3, 0, 0, 0, 0},
+    {500, 0, 0, 0, 0, 0},
+    {1000, 250, 0, 0, 0, 0},
+    {5000, 0, 0, 0, 0, 0},
+    {60000, 1234, 0, 0, 0, 0},
+};
+#define PROBE_COUNT  (int)(sizeof(probes) / sizeof(probes[0]))
+
+static unsigned long startMs = 0;
+
+// The deadline this run is for: the first one of the grid after the previous run
+template <int N>
+static void onProbe(unsigned long nowMillis) {
+    Probe &p = probes[N];
+    unsigned long base = startMs + p.firstDelay;
+    unsigned long deadline = base;
+    if (p.runs) {
+        unsigned long prevDeadline = base + (p.lastRun - base) / p.period * p.period;
+        deadline = prevDeadline + p.period;
+        p.skipped += (nowMillis - base) / p.period - (deadline - base) / p.period;
+    }
+    unsigned long late = nowMillis - deadline;
+    if (late > p.maxLateMs) p.maxLateMs = late;
+    p.lastRun = nowMillis;
+    p.runs++;
+}
+static const SchedJobFn PROBE_FNS[] = {onProbe<0>, onProbe<1>, onProbe<2>, onProbe<3>, onProbe<4>, onProbe<5>};
+
+static int onceRuns = 0;
+static unsigned long onceAt = 0;
+static void onOnce(unsigned long nowMillis) {
+    onceRuns++;
+    onceAt = nowMillis;
+}
+
+static void onBlock(unsigned long) {
+    delay(250);     // a job that hogs the loop
+}
+
+// Same-sweep edits: `victim` and `editor` share a deadline and the editor
+// runs first, then moves the victim or replaces it
+struct Victim {
+    int runs;
+    unsigned long firstAt;
+    unsigned long lastAt;
+};
+static Victim victim = {};
+static SchedJobId victimId = -1;
+static SchedJobId replacementId = -1;
+static void onVictim(unsigned long nowMillis) {
+    if (!victim.runs++) victim.firstAt = nowMillis;
+    victim.lastAt = nowMillis;
+}
+static void onRescheduleVictim(unsigned long) {
+    sched_reschedule(victimId, 300);
+}
+static void onReplaceVictim(unsigned long) {
+    sched_cancel(victimId);
+    replacementId = sched_every("replacement", 1000, onVictim, 300);
+}
+
+static void loopFor(unsigned long ms) {
+    unsigned long end = millis() + ms;
+    while (millis() < end) {
+        unsigned long idle = sched_run(millis());
+        unsigned long sleep = min(idle, (unsigned long)LOOP_IDLE_MAX_MS);
+        delay(sleep ? sleep : 1);
+    }
+}
+
+bool check_scheduler() {
+    sim_clock_reset(0);
+    delay(1000);
+    startMs = millis();
+
+    SchedJobId ids[PROBE_COUNT];
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        probes[i].runs = 0;
+        probes[i].skipped = 0;
+        probes[i].maxLateMs = 0;
+        ids[i] = sched_every("probe", probes[i].period, PROBE_FNS[i], probes[i].firstDelay);
+        CHECK(ids[i] >= 0, "no slot for probe %d", i);
+    }
+
+    // One-shot, rescheduled before it fires
+    SchedJobId once = sched_once("once", 2000, onOnce);
+    loopFor(1000);
+    sched_reschedule(once, 3000);
+    unsigned long onceExpected = millis() + 3000;
+
+    // An hour with the loop sleeping exactly until the next deadline
+    loopFor(RUN_MS - 1000);
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        const Probe &p = probes[i];
+        uint32_t expected = (RUN_MS - p.firstDelay + p.period - 1) / p.period;
+        CHECK(p.maxLateMs == 0, "period %lu ms: up to %lu ms late", p.period, p.maxLateMs);
+        CHECK(p.runs == expected || p.runs == expected + 1, "period %lu ms: %lu runs in 1 h, expected %lu",
+              p.period, (unsigned long)p.runs, (unsigned long)expected);
+    }
+    CHECK(onceRuns == 1 && onceAt == onceExpected, "one-shot ran %d times, at %lu (expected %lu)",
+          onceRuns, onceAt, onceExpected);
+
+    // A job that blocks for 250 ms every second: others run late by at most that,
+    // and the 10 ms job skips the periods it missed instead of bursting
+    for (auto &p : probes) p.maxLateMs = 0;
+    uint32_t fastRuns = probes[0].runs;
+    SchedJobId blocker = sched_every("block", 1000, onBlock);
+    CHECK(blocker >= 0, "no slot for the blocking job");
+    loopFor(60000);
+    sched_cancel(blocker);
+    unsigned long maxLate = 0;
+    for (const Probe &p : probes) {
+        maxLate = max(maxLate, p.maxLateMs);
+        CHECK(p.maxLateMs <= 250 + LOOP_IDLE_MAX_MS, "period %lu ms: %lu ms late behind a 250 ms job",
+              p.period, p.maxLateMs);
+    }
+    uint32_t fast = probes[0].runs - fastRuns;
+    CHECK(probes[0].skipped > 0 && fast + probes[0].skipped <= 60000 / SCHED_TICK_MS + 1 && fast < 60000 / SCHED_TICK_MS,
+          "10 ms job: %lu runs + %lu skipped in 60 s", (unsigned long)fast, (unsigned long)probes[0].skipped);
+
+    // Overhead: host time per sweep with the probes registered (most sweeps find nothing due)
+    const int sweeps = 200000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < sweeps; i++) {
+        sched_run(millis());
+        delay(1);
+    }
+    double nsPerSweep = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / sweeps;
+    CHECK(nsPerSweep < 20000, "%.0f ns per sweep", nsPerSweep);
+
+    for (SchedJobId id : ids) sched_cancel(id);
+
+    // A periodic job rescheduled by a job due in the same sweep runs at the new
+    // deadline and then once per period, never twice from one sweep
+    victim = {};
+    victimId = sched_every("victim", 1000, onVictim, 500);
+    SchedJobId editor = sched_once("editor", 500, onRescheduleVictim);
+    CHECK(victimId >= 0 && editor >= 0, "no slot for the same-sweep jobs");
+    unsigned long t0ms = millis();
+    loopFor(10000);
+    CHECK(victim.runs == 10 && victim.firstAt == t0ms + 800 && victim.lastAt == t0ms + 9800,
+          "rescheduled in its own sweep: %d runs, first at +%lu ms, last at +%lu ms (expected 10, +800, +9800)",
+          victim.runs, victim.firstAt - t0ms, victim.lastAt - t0ms);
+    sched_cancel(victimId);
+
+    // Cancelled in the same sweep and its slot handed to a new job: the new job
+    // keeps its own deadline
+    victim = {};
+    victimId = sched_every("victim", 1000, onVictim, 500);
+    editor = sched_once("editor", 500, onReplaceVictim);
+    t0ms = millis();
+    loopFor(10000);
+    CHECK(replacementId == victimId, "replacement took slot %d, not the cancelled %d", replacementId, victimId);
+    CHECK(victim.runs == 10 && victim.firstAt == t0ms + 800 && victim.lastAt == t0ms + 9800,
+          "replaced in its own sweep: %d runs, first at +%lu ms, last at +%lu ms (expected 10, +800, +9800)",
+          victim.runs, victim.firstAt - t0ms, victim.lastAt - t0ms);
+    sched_cancel(replacementId);
+
+    printf("  1 h at exact deadlines, %d periodic jobs: 0 ms late, no drift; behind a 250 ms job: max %lu ms late\n",
+           PROBE_COUNT, maxLate);
+    printf("  jobs rescheduled or replaced by another job in the same sweep: run once, at the new deadline\n");
+    printf("  sweep overhead %.0f ns per 1 ms loop pass (host, %d jobs, incl. the sim clock)\n", nsPerSweep, PROBE_COUNT);
+    return true;
+}
@@ -0,0 +1,93 @@
+// SpscRing under two real threads at the sensor ring's size: every item
+// that push() accepted arrives once, in order and intact (no torn copies),
+// including when the producer drops on full like the sensor task does.
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include "checks.h"
+#include "config.h"
+#include "spsc_ring.h"
+
+#define SPSC_ITEMS  1000000UL
+
+// Big enough that a torn copy would show (about the size of a SensorSample)
+struct Item {
+    uint32_t seq;
+    uint32_t payload[15];
+};
+
+static void fill(Item &item, uint32_t seq) {
+    item.seq = seq;
+    for (int i = 0; i < 15; i++) item.payload[i] = seq * 2654435761u + i;
+}
+
+static bool intact(const Item &item) {
+    for (int i = 0; i < 15; i++) {
+        if (item.payload[i] != item.seq * 2654435761u + i) return false;
+    }
+    return true;
+}
+
+// dropOnFull: the producer moves on when push() fails (sensor task); otherwise it retries
+static bool run(bool dropOnFull) {
+    SpscRing<Item, SENSOR_RING_SIZE> ring;
+    std::atomic<bool> done{false};
+    uint32_t accepted = 0;
+
+    std::thread producer([&] {
+        Item item;
+        for (uint32_t seq = 0; seq < SPSC_ITEMS;) {
+            fill(item, seq);
+            if (ring.push(item)) {
+                accepted++;
+                seq++;
+            } else if (dropOnFull) {
+                seq++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t received = 0, torn = 0, outOfOrder = 0;
+    int64_t lastSeq = -1;
+    Item item;
+    for (;;) {
+        bool finished = done.load(std::memory_order_acquire);
+        bool got = false;
+        while (ring.pop(item)) {
+            got = true;
+            received++;
+            if (!intact(item)) torn++;
+            if ((int64_t)item.seq <= lastSeq || (!dropOnFull && item.seq != lastSeq + 1)) outOfOrder++;
+            lastSeq = item.seq;
+        }
+        if (finished && !got) break;
+        if (!got) std::this_thread::yield();
+    }
+    producer.join();
+
+    CHECK(torn == 0, "%lu torn items", (unsigned long)torn);
+    CHECK(outOfOrder == 0, "%lu items out of order", (unsigned long)outOfOrder);
+    CHECK(received == accepted, "%lu received, %lu accepted", (unsigned long)received, (unsigned long)accepted);
+    CHECK(dropOnFull || received == SPSC_ITEMS, "%lu of %lu items", (unsigned long)received, SPSC_ITEMS);
+    CHECK(ring.size() == 0, "ring not empty at the end");
+    printf("  %s: %lu of %lu items through a %d-slot ring\n", dropOnFull ? "drop on full" : "retry on full",
+           (unsigned long)received, SPSC_ITEMS, SENSOR_RING_SIZE);
+    return true;
+}
+
+bool check_spsc_ring() {
+    // Single-thread edge cases: capacity is N - 1, full/empty are told apart
+    SpscRing<Item, 4> small;
+    Item item;
+    fill(item, 1);
+    CHECK(!small.pop(item), "pop from an empty ring");
+    for (uint32_t i = 0; i < small.capacity(); i++) CHECK(small.push(item), "push %lu refused", (unsigned long)i);
+    CHECK(!small.push(item), "push into a full ring");
+    CHECK(small.size() == small.capacity(), "size %lu when full", (unsigned long)small.size());
+
+    return run(false) && run(true);
+}
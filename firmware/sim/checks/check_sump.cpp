@@ -0,0 +1,135 @@
+// Sump cleaning start/stop through checkSumpCleaningLogic() with the valves
+// bound to a recorder: a single high-NTU sample, or highs shorter than the
+// dwell, never open the valves; NTU that stays high opens them one dwell
+// after it rose and closes them after the clean time; a finished cycle
+// waits out a fresh dwell instead of starting the next straight away; a
+// manual request opens at once and its cancel closes.
+
+#include <Arduino.h>
+#include <math.h>
+#include "checks.h"
+#include "commands.h"
+#include "config.h"
+#include "rule_engine.h"
+#include "sensor_data.h"
+
+#define STEP_MS     1000UL
+#define SAMPLE_MS   UNIFIED_SENSOR_INTERVAL
+#define NTU_LOW     100.0f
+#define NTU_HIGH    (TURBIDITY_CLEAN_THRESHOLD + 200.0f)
+
+struct Valves {
+    bool flush = false;
+    bool drain = false;
+    uint32_t opens = 0;
+    unsigned long openedAt = 0;
+    unsigned long closedAt = 0;
+    unsigned long now = 0;
+};
+
+static void setRelay(void *ctx, RelayId id, bool on) {
+    Valves &v = *static_cast<Valves *>(ctx);
+    bool wasOpen = v.flush && v.drain;
+    if (id == RELAY_FLUSH_VALVE) v.flush = on;
+    else if (id == RELAY_DRAIN_VALVE) v.drain = on;
+    bool open = v.flush && v.drain;
+    if (open && !wasOpen) {
+        v.opens++;
+        v.openedAt = v.now;
+    } else if (!open && wasOpen) {
+        v.closedAt = v.now;
+    }
+}
+
+struct SumpRun {
+    Valves valves;
+    RuleEngine re;
+    ActuatorState actuators;
+    Commands commands = {};
+    unsigned long now = STEP_MS;   // highSince == 0 means "not high"
+
+    SumpRun() {
+        RuleIo io;
+        io.ctx = &valves;
+        io.setRelay = setRelay;
+        re = RuleEngine(io);
+        actuators.sumpCleaningAuto = true;
+    }
+
+    // Run the rule once per STEP_MS for `ms`; the reading changes only every SAMPLE_MS
+    void run(unsigned long ms, float (*ntuAt)(unsigned long sampleIndex)) {
+        for (unsigned long end = now + ms; now < end; now += STEP_MS) {
+            valves.now = now;
+            checkSumpCleaningLogic(re, actuators, commands, ntuAt(now / SAMPLE_MS), now);
+        }
+    }
+};
+
+static float alwaysLow(unsigned long) { return NTU_LOW; }
+static float alwaysHigh(unsigned long) { return NTU_HIGH; }
+static float oneSpike(unsigned long i) { return i == 3 ? NTU_HIGH : NTU_LOW; }
+// High for one sample less than the dwell, then one low sample, repeated
+static float shortHighs(unsigned long i) {
+    unsigned long period = SUMP_HIGH_DWELL_MS / SAMPLE_MS;
+    return i % period == period - 1 ? NTU_LOW : NTU_HIGH;
+}
+
+bool check_sump() {
+    // Noise: one high sample, then highs that never last the dwell
+    {
+        SumpRun r;
+        r.run(10 * 60000UL, oneSpike);
+        CHECK(r.valves.opens == 0, "one high sample opened the valves");
+        r.run(60 * 60000UL, shortHighs);
+        CHECK(r.valves.opens == 0, "highs shorter than the dwell opened the valves %lu times",
+              (unsigned long)r.valves.opens);
+        CHECK(!r.commands.sumpCleaning.inProgress, "inProgress set without a cycle");
+    }
+
+    // Sustained high: one dwell, one clean, a fresh dwell before the next
+    unsigned long firstOpenAfter = 0, gapMs = 0;
+    {
+        SumpRun r;
+        r.run(60000UL, alwaysLow);
+        unsigned long rose = r.now;
+        r.run(SUMP_HIGH_DWELL_MS + SUMP_CLEAN_DURATION_MS + STEP_MS, alwaysHigh);
+        firstOpenAfter = r.valves.openedAt - rose;
+        CHECK(r.valves.opens == 1, "%lu cycles in the first dwell + clean", (unsigned long)r.valves.opens);
+        CHECK(firstOpenAfter >= SUMP_HIGH_DWELL_MS && firstOpenAfter < SUMP_HIGH_DWELL_MS + SAMPLE_MS,
+              "opened %lu ms after NTU rose (dwell %lu ms)", firstOpenAfter, SUMP_HIGH_DWELL_MS);
+        CHECK(r.valves.closedAt - r.valves.openedAt == SUMP_CLEAN_DURATION_MS, "clean lasted %lu ms",
+              r.valves.closedAt - r.valves.openedAt);
+        CHECK(!r.valves.flush && !r.valves.drain && !r.commands.sumpCleaning.inProgress,
+              "valves or inProgress left set after the clean");
+
+        unsigned long firstClosed = r.valves.closedAt;
+        r.run(SUMP_HIGH_DWELL_MS + SAMPLE_MS, alwaysHigh);
+        CHECK(r.valves.opens == 2, "still high: %lu cycles after a second dwell", (unsigned long)r.valves.opens);
+        gapMs = r.valves.openedAt - firstClosed;
+        CHECK(gapMs >= SUMP_HIGH_DWELL_MS, "next cycle %lu ms after the last one closed", gapMs);
+
+        // NTU drops: the running clean finishes, nothing starts again
+        r.run(SUMP_CLEAN_DURATION_MS + 10 * 60000UL, alwaysLow);
+        CHECK(r.valves.opens == 2 && !r.valves.flush && !r.valves.drain,
+              "%lu cycles, valves %d/%d after NTU dropped", (unsigned long)r.valves.opens, r.valves.flush,
+              r.valves.drain);
+    }
+
+    // Manual: opens at once whatever the NTU, cancel closes
+    {
+        SumpRun r;
+        r.commands.sumpCleaning.manualCleanRequest = true;
+        r.run(STEP_MS, alwaysLow);
+        CHECK(r.valves.flush && r.valves.drain && r.commands.sumpCleaning.inProgress,
+              "manual request did not open the valves");
+        r.run(5000UL, alwaysLow);
+        r.commands.sumpCleaning.manualCleanCancel = true;
+        r.run(STEP_MS, alwaysLow);
+        CHECK(!r.valves.flush && !r.valves.drain && !r.commands.sumpCleaning.inProgress,
+              "manual cancel left the valves open");
+    }
+
+    printf("  noise: 0 cycles; sustained high: open %lu ms after the rise, %lu s clean, next after %lu ms\n",
+           firstOpenAfter, SUMP_CLEAN_DURATION_MS / 1000, gapMs);
+    return true;
+}
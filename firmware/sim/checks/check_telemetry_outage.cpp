@@ -0,0 +1,161 @@
+// Store-and-forward telemetry log through a 3-day outage with a reboot in
+// the middle: flash use stays inside the ring, only wrapped-over records are
+// lost, and once the link is back the backlog drains at the token-bucket
+// rate. Firestore is played here: a transient failure is retried, a 4xx
+// (OUT_REJECTED) batch is skipped instead of re-sent every check interval.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <stdlib.h>
+#include <vector>
+#include "checks.h"
+#include "config.h"
+#include "outbound_queue.h"
+#include "sim_hal.h"
+#include "telemetry_log.h"
+
+#define EPOCH_AT_BOOT   1760000000L
+#define SAMPLE_MS       UNIFIED_SENSOR_INTERVAL
+#define OUTAGE_HOURS    72
+#define REJECT_NTH      3       // submission answered with a 4xx
+#define FAIL_EVERY      10      // every Nth submission fails transiently
+
+// ===== Firestore stand-in =====
+struct Submission {
+    time_t timestamp;
+    int records;
+    OutboundResult result;
+};
+static std::vector<Submission> submissions;
+static OutboundDoneFn pendingDone = nullptr;
+static unsigned long pendingSince = 0;
+
+bool pushBatchLogToFirestore(RealTimeData *, int size, time_t timestamp, OutboundDoneFn onDone) {
+    OutboundResult result = OUT_SENT;
+    int nth = submissions.size() + 1;
+    if (nth == REJECT_NTH) result = OUT_REJECTED;
+    else if (nth % FAIL_EVERY == 0) result = OUT_FAILED;
+    submissions.push_back({timestamp, size, result});
+    pendingDone = onDone;
+    pendingSince = millis();
+    return true;
+}
+
+// Answer the in-flight batch one round trip after it was queued
+static void serveFirestore() {
+    if (!pendingDone || millis() - pendingSince < 300) return;
+    OutboundDoneFn done = pendingDone;
+    pendingDone = nullptr;
+    done(submissions.back().result, String());
+}
+
+static time_t unixNow() {
+    return EPOCH_AT_BOOT + millis() / 1000;
+}
+
+// One second of the main loop: a sample every SAMPLE_MS, backfill every pass
+static void runFor(unsigned long ms, size_t &maxFlash) {
+    unsigned long end = millis() + ms;
+    while (millis() < end) {
+        delay(1000);
+        if (millis() % SAMPLE_MS == 0) {
+            RealTimeData d;
+            d.waterTemp = 25.0f;
+            d.pH = 7.0f;
+            telemetry_log_append(d, unixNow());
+        }
+        telemetry_log_backfill(millis(), unixNow());
+        serveFirestore();
+        if (millis() % 600000UL == 0) maxFlash = max(maxFlash, LittleFS.usedBytes());
+    }
+}
+
+bool check_telemetry_outage() {
+    char dir[] = "/tmp/aquabell_tlog_XXXXXX";
+    CHECK(mkdtemp(dir), "no temp dir");
+    sim_fs_set_root(dir);
+    sim_clock_reset(0);
+    sim_wifi_set_up(false);
+    submissions.clear();
+    CHECK(telemetry_log_init(), "init failed");
+
+    const size_t segBytes = TLOG_SEGMENT_RECORDS * 32;
+    const size_t flashBound = TLOG_MAX_SEGMENTS * ((segBytes + 4095) / 4096 * 4096) + 2 * 4096;   // + cursor, dir
+    const uint32_t capacity = TLOG_MAX_SEGMENTS * TLOG_SEGMENT_RECORDS;
+    size_t maxFlash = 0;
+
+    // Outage, power cut halfway through
+    runFor(OUTAGE_HOURS / 2 * 3600000UL, maxFlash);
+    uint32_t beforeReboot = telemetry_log_pending();
+    CHECK(telemetry_log_init(), "re-init failed");
+    CHECK(telemetry_log_pending() == beforeReboot, "%lu pending after reboot, %lu before",
+          (unsigned long)telemetry_log_pending(), (unsigned long)beforeReboot);
+    runFor(OUTAGE_HOURS / 2 * 3600000UL, maxFlash);
+
+    const TelemetryLogStats &s = telemetry_log_stats();
+    CHECK(submissions.empty(), "%zu uploads while offline", submissions.size());
+    CHECK(maxFlash <= flashBound, "%zu B of flash in use, bound %zu B", maxFlash, flashBound);
+    CHECK(s.segments <= TLOG_MAX_SEGMENTS, "%lu segments", (unsigned long)s.segments);
+    uint32_t pending = telemetry_log_pending();
+    CHECK(pending <= capacity && pending > capacity - TLOG_SEGMENT_RECORDS,
+          "%lu pending after the outage, ring holds %lu", (unsigned long)pending, (unsigned long)capacity);
+    CHECK(s.droppedRecords + pending == s.appended, "appended %lu, dropped %lu, pending %lu",
+          (unsigned long)s.appended, (unsigned long)s.droppedRecords, (unsigned long)pending);
+    printf("  %lu h offline: %lu samples, %lu kept (%zu KB flash max), %lu lost to the ring wrap\n",
+           (unsigned long)OUTAGE_HOURS, (unsigned long)s.appended, (unsigned long)pending,
+           maxFlash / 1024, (unsigned long)s.droppedRecords);
+
+    // Link back: drain until only the batch still filling is left
+    sim_wifi_set_up(true);
+    uint32_t wrapLoss = s.droppedRecords;
+    unsigned long upAt = millis();
+    while (telemetry_log_pending() >= TLOG_BATCH_RECORDS && millis() - upAt < 3 * 3600000UL) {
+        runFor(60000, maxFlash);
+    }
+    unsigned long recoveryMs = millis() - upAt;
+    CHECK(telemetry_log_pending() < TLOG_BATCH_RECORDS, "%lu still pending after 3 h online",
+          (unsigned long)telemetry_log_pending());
+
+    // Token bucket: TLOG_BACKFILL_PER_MIN batches a minute, plus retried failures
+    unsigned long batches = pending / TLOG_BATCH_RECORDS;
+    unsigned long expectedMs = (batches + batches / FAIL_EVERY + 2) * 60000UL / TLOG_BACKFILL_PER_MIN;
+    CHECK(recoveryMs <= expectedMs + 60000UL, "backlog took %lu s, token bucket allows %lu s",
+          recoveryMs / 1000, expectedMs / 1000);
+
+    // Every record is uploaded, pending, or accounted as lost (wrap + the one rejected batch)
+    uint32_t rejectedRecords = submissions[REJECT_NTH - 1].records;
+    CHECK(s.rejectedBatches == 1 && s.droppedRecords == wrapLoss + rejectedRecords,
+          "%lu rejected batches, %lu dropped (wrap %lu + rejected %lu)", (unsigned long)s.rejectedBatches,
+          (unsigned long)s.droppedRecords, (unsigned long)wrapLoss, (unsigned long)rejectedRecords);
+    CHECK(s.uploadedRecords + s.droppedRecords + telemetry_log_pending() == s.appended,
+          "uploaded %lu + dropped %lu + pending %lu != appended %lu", (unsigned long)s.uploadedRecords,
+          (unsigned long)s.droppedRecords, (unsigned long)telemetry_log_pending(), (unsigned long)s.appended);
+
+    // The rejected batch went out once; failed ones were re-sent as the next submission
+    time_t rejectedTs = submissions[REJECT_NTH - 1].timestamp;
+    time_t lastDone = 0;
+    int rejectedSends = 0;
+    for (size_t i = 0; i < submissions.size(); i++) {
+        const Submission &sub = submissions[i];
+        if (sub.timestamp == rejectedTs) rejectedSends++;
+        if (sub.result == OUT_FAILED) {
+            CHECK(i + 1 == submissions.size() || submissions[i + 1].timestamp == sub.timestamp,
+                  "failed batch %ld not retried next", (long)sub.timestamp);
+            continue;
+        }
+        CHECK(sub.timestamp > lastDone, "batch %ld uploaded out of order", (long)sub.timestamp);
+        lastDone = sub.timestamp;
+    }
+    CHECK(rejectedSends == 1, "rejected batch sent %d times", rejectedSends);
+    CHECK(LittleFS.usedBytes() <= 4 * 4096 + segBytes, "%zu B of flash still in use after the backlog",
+          LittleFS.usedBytes());
+
+    printf("  back online: %lu batches in %lu min (%lu failed and retried, 1 rejected and skipped)\n",
+           (unsigned long)s.uploadedBatches, recoveryMs / 60000, (unsigned long)s.failedBatches);
+
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    system(cmd);
+    sim_fs_set_root(".");
+    return true;
+}
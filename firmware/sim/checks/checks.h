@@ -0,0 +1,35 @@
+#pragma once
+#include <stdio.h>
+
+// === Host checks (PlatformIO `native_checks` environment) ===
+// Each check is a plain function against the firmware's own code on the
+// simulator's virtual clock; CHECK() reports the first failing line of a
+// check and returns from it.
+
+#define CHECK(cond, ...)                                              \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            printf("  FAIL %s:%d: %s — ", __FILE__, __LINE__, #cond); \
+            printf(__VA_ARGS__);                                      \
+            printf("\n");                                             \
+            return false;                                             \
+        }                                                             \
+    } while (0)
+
+// X(name): bool check_<name>() lives in sim/checks/check_<name>.cpp
+#define CHECK_LIST(X)   \
+    X(ph_dose_timing)   \
+    X(adc_stream)       \
+    X(spsc_ring)        \
+    X(mpsc_ring)        \
+    X(http_pool)        \
+    X(rtdb_sync)        \
+    X(telemetry_outage) \
+    X(relay_day)        \
+    X(sump)             \
+    X(scheduler)        \
+    X(lcd_frame)
+
+#define CHECK_DECLARE(name) bool check_##name();
+CHECK_LIST(CHECK_DECLARE)
+#undef CHECK_DECLARE
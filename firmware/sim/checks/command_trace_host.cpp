@@ -0,0 +1,2 @@
+// The firmware's command latency tracer; appendDiagnostics() is check_rtdb_sync's
+#include "../../lib/firebase/command_trace.cpp"
@@ -0,0 +1,3 @@
+// The firmware's HTTPS connection pool compiled for the host against the
+// HTTPClient stand-in
+#include "../../lib/firebase/http_pool.cpp"
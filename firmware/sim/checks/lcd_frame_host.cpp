@@ -0,0 +1,2 @@
+// The firmware's LCD framebuffer and diff; it has no I/O, so it builds as is
+#include "../../lib/lcd_display/lcd_frame.cpp"
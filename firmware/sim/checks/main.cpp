@@ -0,0 +1,45 @@
+// === Host check runner ===
+//
+//   pio run -e native_checks && .pio/build/native_checks/program [NAME...]
+//     NAME             run only the named checks (default: all)
+//
+// Exits non-zero if any check fails.
+
+#include <Arduino.h>
+#include <string.h>
+#include "checks.h"
+#include "logger.h"
+
+struct CheckEntry {
+    const char *name;
+    bool (*fn)();
+};
+
+#define CHECK_ENTRY(name) { #name, check_##name },
+static const CheckEntry CHECKS[] = { CHECK_LIST(CHECK_ENTRY) };
+#undef CHECK_ENTRY
+
+static bool selected(const char *name, int argc, char **argv) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], name)) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    Serial.setEnabled(false);
+    log_set_level_all(LOG_LEVEL_NONE);
+
+    int run = 0, failed = 0;
+    for (const CheckEntry &c : CHECKS) {
+        if (!selected(c.name, argc, argv)) continue;
+        printf("%-24s ...\n", c.name);
+        bool ok = c.fn();
+        printf("%-24s %s\n", c.name, ok ? "ok" : "FAILED");
+        run++;
+        if (!ok) failed++;
+    }
+    printf("\n%d checks, %d failed\n", run, failed);
+    return failed ? 1 : 0;
+}
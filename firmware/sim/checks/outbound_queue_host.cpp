@@ -0,0 +1,3 @@
+// The firmware's outbound write queue (own translation unit: its statics
+// share names with the pool's and the tracer's)
+#include "../../lib/firebase/outbound_queue.cpp"
@@ -0,0 +1,3 @@
+// The firmware's live data / relay sync writes and command handler; its
+// firebase.h is the real one, the transport below it the HTTPS stand-in
+#include "../../lib/firebase/relay_sync.cpp"
@@ -0,0 +1,331 @@
+// === Command latency against an RTDB stand-in (PlatformIO `native_cmd_latency` environment) ===
+// The firmware's command tracer, relay driver, outbound queue and HTTPS pool
+// on the virtual clock, with the HTTPS stand-in playing RTDB. Commands arrive
+// the way handleCommandPatch() sees them — MANUAL overrides, and AUTO
+// actuators the rules then switch — while the rules also toggle the pump on
+// their own, so relay syncs that carry only other actuators' keys go out
+// between commands. The loop syncs like main.cpp + pushLiveAndRelayState():
+// the requested (reflected) AUTO values that changed, after the stream
+// debounce and sync cooldown, through the outbound queue. Checks:
+//   - every command is acked exactly once and none time out
+//   - a MANUAL command completes at commit (synced=false, no ackMs)
+//   - an AUTO command is acked by a delivered sync that carries its key and
+//     was queued after the command (possibly before a min on/off hold let
+//     the relay commit), never by a pump-only sync in between
+//   - every ack reaches the database as a POST of its own (acks are never
+//     coalesced with or overwritten by a later one)
+// and reports received → committed and received → acked (p50/p99).
+//
+//   pio run -e native_cmd_latency && .pio/build/native_cmd_latency/program [options]
+//     --count N         commands (default 500)
+//     --rtt-ms MS       RTDB request round trip (default 120)
+//     --fail-every N    every Nth PATCH answers 503 and is retried (default 7, 0 = never)
+//
+// Exits non-zero if a check fails.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "command_trace.h"
+#include "commands.h"
+#include "config.h"
+#include "logger.h"
+#include "outbound_queue.h"
+#include "relay_control.h"
+#include "sim_hal.h"
+#include "sim_https.h"
+
+extern Commands currentCommands;
+
+#define LOOP_MS            50UL
+#define STREAM_DEBOUNCE_MS 5000UL     // main.cpp: sync waits this long after a stream update
+#define PUMP_TOGGLE_MS     20000UL    // rules switch the pump on their own
+#define SYNC_URL           "https://rtdb.example.com/.json?print=silent"
+#define SYNC_PREFIX        "commands/aquabell_esp32/"
+#define ACK_URL            "https://rtdb.example.com/diagnostics/aquabell_esp32/commandAck.json?print=silent"
+
+static int failures = 0;
+#define EXPECT(cond, ...) do { if (!(cond)) { failures++; printf("  FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+// Commanded actuators (the pump is the rules' own background traffic)
+static const ActuatorIndex TARGETS[] = {ACTUATOR_fan, ACTUATOR_light, ACTUATOR_valve, ACTUATOR_cooler, ACTUATOR_heater};
+#define TARGET_COUNT  (int)(sizeof(TARGETS) / sizeof(TARGETS[0]))
+// Cooler commands are spaced so its min on/off hold stays inside the trace timeout
+#define COOLER_GAP_MS  (COOLER_MIN_OFF_MS - CMD_TRACE_TIMEOUT_MS / 2)
+
+static uint16_t openTraces = 0;             // actuators with a command still being traced
+static unsigned long lastCooler = 0;
+
+// ===== RTDB stand-in =====
+static int failEvery = 7;
+static uint32_t patches = 0;
+static uint32_t rejectedPatches = 0;
+
+static void ackDelivered(const String &payload);
+
+static int rtdbHandler(const char *method, const String &, const String &payload, String &response) {
+    response = "";
+    if (!strcmp(method, "POST")) ackDelivered(payload);
+    if (strcmp(method, "PATCH") != 0) return 200;
+    patches++;
+    if (failEvery && patches % failEvery == 0) {
+        rejectedPatches++;
+        return 503;
+    }
+    return 200;
+}
+
+// ===== Relay sync (pushLiveAndRelayState's relay half) =====
+static uint16_t syncedValues = 0, syncedAuto = 0;
+static bool syncedValid = false;
+static unsigned long lastSync = 0, lastStreamUpdate = 0;
+static uint16_t deliveredKeys = 0;      // keys of the sync being settled right now
+static uint16_t keysQueued = 0;         // open commands' keys in a sync queued since the command
+static uint16_t keysDelivered = 0;      // ... and delivered (an ack may follow at the commit)
+
+// Requested states, as reflect_actuator_relays() leaves them for the sync
+static uint16_t relayValues() {
+    uint16_t v = 0;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (relay_is_on((RelayId)i)) v |= 1u << i;
+    }
+    return (v ^ relay_pending_mask()) & ACTUATOR_MASK;
+}
+
+static uint16_t keysOf(const JsonDocument &doc) {
+    uint16_t mask = 0;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (doc[String(SYNC_PREFIX) + ACTUATORS[i].name + "/value"].is<bool>()) mask |= 1u << i;
+    }
+    return mask;
+}
+
+static void onSyncDone(OutboundResult result, const String &payload) {
+    JsonDocument doc;
+    deliveredKeys = deserializeJson(doc, payload) ? 0 : keysOf(doc);
+    if (result != OUT_SENT) {
+        syncedValid = false;
+        keysQueued &= ~deliveredKeys;
+    } else {
+        keysDelivered |= deliveredKeys & keysQueued;
+    }
+    cmd_trace_sync_done(result == OUT_SENT, deliveredKeys);
+    deliveredKeys = 0;
+}
+
+static void syncRelays() {
+    uint16_t values = relayValues();
+    uint16_t autoMask = commands_auto_mask(currentCommands);
+    uint16_t changed = syncedValid ? (values ^ syncedValues) : ACTUATOR_MASK;
+    changed |= autoMask & ~syncedAuto;
+
+    JsonDocument doc;
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        uint16_t bit = 1u << i;
+        if ((autoMask & bit) && (changed & bit)) doc[String(SYNC_PREFIX) + ACTUATORS[i].name + "/value"] = (bool)(values & bit);
+    }
+    doc["live_data/aquabell_esp32/timestamp"] = (long)(millis() / 1000);
+
+    String payload;
+    serializeJson(doc, payload);
+    if (outbound_submit(OUT_PRIO_COMMAND, "PATCH", SYNC_URL, payload, OUT_AUTH_QUERY,
+                        OUTBOUND_COMMAND_TTL_MS, onSyncDone)) {
+        syncedValues = values;
+        syncedAuto = autoMask;
+        syncedValid = true;
+        keysQueued |= keysOf(doc) & openTraces;
+        cmd_trace_sync_submitted(keysOf(doc));
+    }
+}
+
+// ===== Acks (appendDiagnostics stand-in: POSTed through the outbound queue) =====
+struct Ack {
+    uint32_t seq;
+    bool synced;
+    bool timedOut;
+    bool hasAckMs;
+    float commitMs;
+    float totalMs;
+    int actuator;
+    uint16_t deliveredKeys;
+};
+static std::map<uint32_t, Ack> queuedAcks;     // by seq, until their POST is delivered
+static std::vector<Ack> acks;                  // delivered
+static uint32_t ackPosts = 0, unknownAcks = 0;
+
+bool appendDiagnostics(const char *node, const JsonDocument &doc) {
+    if (strcmp(node, "commandAck") != 0) return true;
+    Ack a;
+    a.seq = doc["seq"].as<uint32_t>();
+    a.synced = doc["synced"].as<bool>();
+    a.timedOut = doc["timedOut"].as<bool>();
+    a.hasAckMs = doc["ackMs"].is<float>();
+    a.commitMs = doc["commitMs"] | -1.0f;
+    a.totalMs = doc["totalMs"] | -1.0f;
+    a.actuator = -1;
+    const char *name = doc["actuators"][0] | "";
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (!strcmp(name, ACTUATORS[i].name)) a.actuator = i;
+    }
+    a.deliveredKeys = deliveredKeys;
+    if (a.actuator >= 0) {
+        a.deliveredKeys |= keysDelivered & (1u << a.actuator);
+        openTraces &= ~(1u << a.actuator);
+    }
+    queuedAcks[a.seq] = a;
+
+    String payload;
+    serializeJson(doc, payload);
+    return outbound_submit(OUT_PRIO_LOG, "POST", ACK_URL, payload, OUT_AUTH_QUERY, OUTBOUND_LOG_TTL_MS);
+}
+
+// One POST body is one ack; a merged or re-sent body would name a seq already delivered
+static void ackDelivered(const String &payload) {
+    ackPosts++;
+    const char *seq = strstr(payload.c_str(), "\"seq\":");
+    auto it = seq ? queuedAcks.find(strtoul(seq + 6, nullptr, 10)) : queuedAcks.end();
+    if (it == queuedAcks.end()) {
+        unknownAcks++;
+        return;
+    }
+    acks.push_back(it->second);
+    queuedAcks.erase(it);
+}
+
+// ===== Loop =====
+static void loopPass(bool &syncWanted, uint16_t valuesBefore) {
+    relay_commit(millis());
+    cmd_trace_poll(relay_pending_mask(), millis());
+    if (relayValues() != valuesBefore) syncWanted = true;
+
+    if (syncWanted && millis() - lastStreamUpdate > STREAM_DEBOUNCE_MS &&
+        millis() - lastSync > RELAY_SYNC_COOLDOWN) {
+        syncRelays();
+        lastSync = millis();
+        syncWanted = false;
+    }
+    outbound_process(millis(), "token");
+}
+
+// The stream delivers one actuator's command; MANUAL applies it directly,
+// AUTO hands the actuator back to the rules, which flip it. An actuator is not
+// commanded again while its previous command is still traced (a MANUAL write
+// over an unsynced AUTO value would rightly never be acked).
+static bool deliverCommand(int n) {
+    ActuatorIndex target = TARGETS[rand() % TARGET_COUNT];
+    if ((openTraces & (1u << target)) || __builtin_popcount(openTraces) >= CMD_TRACE_SLOTS) return false;
+    if (target == ACTUATOR_cooler) {
+        if (lastCooler && millis() - lastCooler < COOLER_GAP_MS) return false;
+        lastCooler = millis();
+    }
+    openTraces |= 1u << target;
+    keysQueued &= ~(1u << target);
+    keysDelivered &= ~(1u << target);
+
+    CommandState &cmd = currentCommands.*ACTUATORS[target].command;
+    bool manual = rand() % 5 < 2;
+    if (manual) {
+        cmd.isAuto = false;
+        cmd.value = !relay_is_on((RelayId)target);
+    } else {
+        cmd.isAuto = true;
+    }
+    relay_set((RelayId)target, manual ? cmd.value : !relay_is_on((RelayId)target));
+    cmd_trace_received(1u << target, commands_auto_mask(currentCommands), micros(), n % 2 ? "stream" : "mqtt");
+    syncedValid = false;            // handleCommandPatch(): remote /commands moved, resync all AUTO values
+    lastStreamUpdate = millis();
+    return true;
+}
+
+static float percentile(std::vector<float> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(p * (v.size() - 1) + 0.5)];
+}
+
+int main(int argc, char **argv) {
+    int count = 500;
+    SimHttpsConfig server;
+    server.handler = rtdbHandler;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--count") && i + 1 < argc) count = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rtt-ms") && i + 1 < argc) server.requestMs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--fail-every") && i + 1 < argc) failEvery = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--count N] [--rtt-ms MS] [--fail-every N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    log_set_level_all(LOG_LEVEL_WARN);
+    srand(1);
+    sim_clock_reset(0);
+    sim_wifi_set_up(true);
+    sim_https_reset(server);
+    relay_control_init();
+    for (int i = 0; i < ACTUATOR_COUNT; i++) (currentCommands.*ACTUATORS[i].command).isAuto = true;
+
+    bool syncWanted = true;
+    unsigned long nextCommand = COOLER_MIN_OFF_MS;     // the cooler's boot hold has passed
+    unsigned long nextPump = PUMP_TOGGLE_MS;
+    int sent = 0;
+    while (sent < count || millis() < nextCommand + CMD_TRACE_TIMEOUT_MS) {
+        uint16_t before = relayValues();
+        if (sent < count && millis() >= nextCommand && deliverCommand(sent)) {
+            sent++;
+            nextCommand = millis() + 3000 + rand() % 12000;
+        }
+        if (millis() >= nextPump) {
+            relay_set(RELAY_PUMP, !relay_is_on(RELAY_PUMP));
+            nextPump += PUMP_TOGGLE_MS;
+        }
+        loopPass(syncWanted, before);
+        delay(LOOP_MS);
+    }
+    while (outbound_depth() > 0) {
+        loopPass(syncWanted, relayValues());
+        delay(LOOP_MS);
+    }
+
+    const CommandTraceStats &s = cmd_trace_stats();
+    EXPECT(s.dropped == 0, "%lu commands found no trace slot", (unsigned long)s.dropped);
+    EXPECT((int)acks.size() == count - (int)s.dropped, "%zu acks for %d commands", acks.size(), count);
+    EXPECT(s.timedOut == 0, "%lu commands timed out", (unsigned long)s.timedOut);
+    EXPECT(queuedAcks.empty() && unknownAcks == 0 && ackPosts == acks.size(),
+           "%lu ack POSTs for %zu acks (%zu never delivered, %lu unknown)", (unsigned long)ackPosts,
+           acks.size(), queuedAcks.size(), (unsigned long)unknownAcks);
+
+    std::vector<float> manualCommit, autoCommit, autoTotal;
+    for (const Ack &a : acks) {
+        if (a.timedOut) continue;
+        if (!a.synced) {
+            EXPECT(!a.hasAckMs && a.totalMs == a.commitMs && !a.deliveredKeys,
+                   "manual %s acked by a sync (ackMs %d, total %.1f, commit %.1f ms)",
+                   a.actuator >= 0 ? ACTUATORS[a.actuator].name : "?", a.hasAckMs, a.totalMs, a.commitMs);
+            manualCommit.push_back(a.commitMs);
+            continue;
+        }
+        EXPECT(a.hasAckMs && a.actuator >= 0 && (a.deliveredKeys & (1u << a.actuator)),
+               "auto %s acked by a sync without its key (keys 0x%03x)",
+               a.actuator >= 0 ? ACTUATORS[a.actuator].name : "?", a.deliveredKeys);
+        autoCommit.push_back(a.commitMs);
+        autoTotal.push_back(a.totalMs);
+    }
+
+    printf("%d commands, %lu PATCHes (%lu answered 503), %lu ack POSTs, RTT %lu ms, %.1f h simulated\n", count,
+           (unsigned long)patches, (unsigned long)rejectedPatches, (unsigned long)ackPosts,
+           (unsigned long)server.requestMs, millis() / 3600000.0);
+    printf("  MANUAL %4zu  received→committed p50 %7.1f ms p99 %7.1f ms (complete at commit)\n",
+           manualCommit.size(), percentile(manualCommit, 0.50), percentile(manualCommit, 0.99));
+    printf("  AUTO   %4zu  received→committed p50 %7.1f ms p99 %7.1f ms\n",
+           autoCommit.size(), percentile(autoCommit, 0.50), percentile(autoCommit, 0.99));
+    printf("               received→acked     p50 %7.1f ms p99 %7.1f ms\n",
+           percentile(autoTotal, 0.50), percentile(autoTotal, 0.99));
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "ok", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
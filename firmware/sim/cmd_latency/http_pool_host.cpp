@@ -0,0 +1,2 @@
+// The firmware's HTTPS connection pool against the HTTPClient stand-in
+#include "../../lib/firebase/http_pool.cpp"
@@ -0,0 +1,434 @@
+// === AquaBell plant simulator (PlatformIO `native` environment) ===
+// Runs the real rule engine, relay driver, pH dosing engine and float switch
+// debounce on the host against a tank plant model, as fast as the CPU allows.
+//
+//   pio run -e native && .pio/build/native/program [options]
+//     --hours N        simulated hours (default 72)
+//     --step-ms N      control loop period in virtual ms (default 100)
+//     --start-hour H   local time of day at t = 0 (default 6)
+//     --seed N         sensor noise seed (default 1)
+//     --trace FILE     write every committed relay transition as CSV
+//     --golden FILE    compare the relay transitions against a stored trace; exit 1 on the first difference
+//     --record DIR     run the control trace recorder into DIR/trace (input for sim/replay)
+//     --commands FILE  command events "<seconds> <stream|mqtt> <json>" applied through
+//                      the firmware's command parser (and recorded with --record)
+//     --bench N        run N times without output and report simulated hours per wall-second
+//     --verbose        pass the firmware's Serial log through to stdout
+//
+// A run is deterministic for a given set of options, so two relay traces can
+// be diffed directly to see how a rule change moves the control decisions.
+// sim/golden/relays_24h.csv is `--hours 24` with the other defaults:
+//
+//   .pio/build/native/program --hours 24 --golden sim/golden/relays_24h.csv
+//
+// When a control change is meant to move the decisions, regenerate it with
+// --trace and commit it with the change.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "sensor_data.h"
+#include "commands.h"
+#include "rule_engine.h"
+#include "relay_control.h"
+#include "ph_dosing.h"
+#include "float_switch.h"
+#include "plant.h"
+#include "rtdb_command_parser.h"
+#include "sim_hal.h"
+#include "trace_recorder.h"
+#include "logger.h"
+
+#define SIM_EPOCH          1748707200L   // 2025-06-01 00:00 PHT
+#define SIM_SENSOR_MS      2000UL        // new sample set (sensor task publish rate)
+
+// Device globals (defined in sim_stubs.cpp, like src/main.cpp does on the board)
+extern RealTimeData current;
+extern ActuatorState actuators;
+extern Commands currentCommands;
+
+static const char *const RELAY_NAMES[RELAY_COUNT] = {
+    "fan", "light", "pump", "valve", "cooler", "heater",
+    "ph_lowering", "ph_raising", "drain_pump", "flush_valve", "drain_valve"
+};
+
+struct SimOptions {
+    double hours = 72.0;
+    unsigned long stepMs = 100;
+    double startHour = 6.0;
+    uint32_t seed = 1;
+    const char *tracePath = nullptr;
+    const char *goldenPath = nullptr;
+    const char *recordDir = nullptr;
+    const char *commandsPath = nullptr;
+    int benchRuns = 0;
+    bool verbose = false;
+};
+
+struct SimStats {
+    uint64_t onUs[RELAY_COUNT] = {0};
+    uint32_t ruleRuns = 0;
+    uint32_t commands = 0;
+    uint32_t commandsRejected = 0;
+    float phMin = 99, phMax = -99;
+    float doMin = 99;
+    float waterMin = 99, waterMax = -99;
+    float levelMin = 99, levelMax = -99;
+    uint64_t phOutUs = 0;        // outside [PH_LOW_THRESHOLD, PH_HIGH_THRESHOLD]
+    uint64_t doLowUs = 0;        // below DO_LOW_THRESHOLD
+};
+
+static SimOptions opts;
+static PlantState plant;
+static PlantParams params;
+static SimStats stats;
+static FILE *trace = nullptr;
+static FILE *golden = nullptr;
+static uint16_t tracedMask = 0;
+
+// Scripted command events, as the RTDB stream or MQTT would deliver them
+struct SimCommand {
+    unsigned long atMs;
+    TraceSource source;
+    std::string json;
+};
+static std::vector<SimCommand> commandScript;
+static size_t nextCommand = 0;
+
+// Golden comparison: first differing line (0 = none so far)
+struct GoldenDiff {
+    unsigned long lines = 0;
+    unsigned long firstDiff = 0;
+    char expected[64] = "";
+    char got[64] = "";
+};
+static GoldenDiff goldenDiff;
+
+static void traceLine(const char *line) {
+    if (trace) fputs(line, trace);
+    if (!golden) return;
+
+    goldenDiff.lines++;
+    if (goldenDiff.firstDiff) return;
+    char expected[64];
+    if (!fgets(expected, sizeof(expected), golden)) expected[0] = '\0';
+    if (strcmp(expected, line) == 0) return;
+    goldenDiff.firstDiff = goldenDiff.lines;
+    snprintf(goldenDiff.expected, sizeof(goldenDiff.expected), "%s", expected);
+    snprintf(goldenDiff.got, sizeof(goldenDiff.got), "%s", line);
+}
+
+static uint16_t committedMask() {
+    uint16_t mask = 0;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (relay_is_on((RelayId)i)) mask |= RELAY_BIT(i);
+    }
+    return mask;
+}
+
+// Plant integration between control steps and dose pulse edges
+static void onSegment(uint64_t fromUs, uint64_t toUs) {
+    uint16_t relays = committedMask();
+    uint64_t dtUs = toUs - fromUs;
+
+    if ((trace || golden) && relays != tracedMask) {
+        uint16_t diff = relays ^ tracedMask;
+        for (int i = 0; i < RELAY_COUNT; i++) {
+            if (!(diff & RELAY_BIT(i))) continue;
+            char line[64];
+            snprintf(line, sizeof(line), "%.3f,%s,%d\n", fromUs / 1e6, RELAY_NAMES[i], (relays & RELAY_BIT(i)) ? 1 : 0);
+            traceLine(line);
+        }
+        tracedMask = relays;
+    }
+
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (relays & RELAY_BIT(i)) stats.onUs[i] += dtUs;
+    }
+    if (relays & RELAY_BIT(RELAY_PH_RAISING)) plant_dose(plant, params, true, dtUs);
+    if (relays & RELAY_BIT(RELAY_PH_LOWERING)) plant_dose(plant, params, false, dtUs);
+
+    double hourOfDay = fmod(opts.startHour + fromUs / 3.6e9, 24.0);
+    plant_step(plant, params, dtUs / 1e6f, relays, (float)hourOfDay);
+
+    float level = plant_sump_level(plant, params);
+    if (plant.pH < stats.phMin) stats.phMin = plant.pH;
+    if (plant.pH > stats.phMax) stats.phMax = plant.pH;
+    if (plant.dissolvedOxygen < stats.doMin) stats.doMin = plant.dissolvedOxygen;
+    if (plant.waterTemp < stats.waterMin) stats.waterMin = plant.waterTemp;
+    if (plant.waterTemp > stats.waterMax) stats.waterMax = plant.waterTemp;
+    if (level < stats.levelMin) stats.levelMin = level;
+    if (level > stats.levelMax) stats.levelMax = level;
+    if (plant.pH < PH_LOW_THRESHOLD || plant.pH > PH_HIGH_THRESHOLD) stats.phOutUs += dtUs;
+    if (plant.dissolvedOxygen < DO_LOW_THRESHOLD) stats.doLowUs += dtUs;
+}
+
+static unsigned long lastSensor = 0;
+static unsigned long lastRulesTick = 0;
+static bool first = true;
+
+// Due command events go through the parser the way onRTDBStream() and the MQTT
+// callback feed it; like commandsChangedViaStream, a parsed event runs the rules
+static bool applyDueCommands(unsigned long nowMillis) {
+    bool applied = false;
+    for (; nextCommand < commandScript.size() && commandScript[nextCommand].atMs <= nowMillis; nextCommand++) {
+        const SimCommand &cmd = commandScript[nextCommand];
+        if (opts.recordDir) trace_rec_command(cmd.json.c_str(), cmd.json.size(), cmd.source);
+        CommandPatchResult patch;
+        stats.commands++;
+        if (rtdb_apply_command_event(cmd.json.c_str(), cmd.json.size(), currentCommands, patch)) {
+            applied = true;
+        } else {
+            stats.commandsRejected++;
+        }
+    }
+    return applied;
+}
+
+// One pass of the firmware's control cycle (offline path, see controlCycle in src/main.cpp)
+static void controlStep(unsigned long nowMillis) {
+    bool commandEvent = applyDueCommands(nowMillis);
+    bool sensorsUpdated = first || nowMillis - lastSensor >= SIM_SENSOR_MS;
+    if (sensorsUpdated) {
+        plant_read_sensors(plant, params, current);
+        lastSensor = nowMillis;
+    }
+
+    sim_pin_input(FLOAT_SWITCH_PIN, plant_sump_level(plant, params) < params.floatLowLevel ? LOW : HIGH);
+    bool floatEvent = is_float_switch_triggered();
+    current.floatTriggered = float_switch_active();
+
+    if (opts.recordDir) trace_rec_pass_begin();
+    checkpHPumpLogic(deviceRules, actuators, current.pH, nowMillis);
+    current.relayStates.phRaising = relay_is_on(RELAY_PH_RAISING);
+    current.relayStates.phLowering = relay_is_on(RELAY_PH_LOWERING);
+
+    bool rulesTick = first || nowMillis - lastRulesTick >= RULES_TICK_MS;
+    if (rulesTick) lastRulesTick = nowMillis;
+
+    TraceRules traceRules = TRACE_RULES_NONE;
+    if (sensorsUpdated || floatEvent || commandEvent || rulesTick) {
+        applyRulesWithModeControl(deviceRules, current, actuators, currentCommands, nowMillis);
+        reflect_actuator_relays(current, actuators);
+        traceRules = TRACE_RULES_APPLY;
+        stats.ruleRuns++;
+    }
+    if (opts.recordDir) trace_rec_pass(nowMillis, traceRules);
+
+    relay_commit(nowMillis);
+    if (opts.recordDir) {
+        trace_rec_relays(nowMillis);
+        trace_recorder_loop(nowMillis);
+    }
+    first = false;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--hours N] [--step-ms N] [--start-hour H] [--seed N] [--trace FILE] [--golden FILE]\n"
+                    "          [--record DIR] [--commands FILE] [--bench N] [--verbose]\n", prog);
+}
+
+static bool parseArgs(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--hours") && hasValue) opts.hours = atof(argv[++i]);
+        else if (!strcmp(arg, "--step-ms") && hasValue) opts.stepMs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--start-hour") && hasValue) opts.startHour = atof(argv[++i]);
+        else if (!strcmp(arg, "--seed") && hasValue) opts.seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--trace") && hasValue) opts.tracePath = argv[++i];
+        else if (!strcmp(arg, "--golden") && hasValue) opts.goldenPath = argv[++i];
+        else if (!strcmp(arg, "--record") && hasValue) opts.recordDir = argv[++i];
+        else if (!strcmp(arg, "--commands") && hasValue) opts.commandsPath = argv[++i];
+        else if (!strcmp(arg, "--bench") && hasValue) opts.benchRuns = atoi(argv[++i]);
+        else if (!strcmp(arg, "--verbose")) opts.verbose = true;
+        else return false;
+    }
+    if (opts.benchRuns && (opts.tracePath || opts.goldenPath || opts.recordDir || opts.verbose)) return false;
+    return opts.hours > 0 && opts.stepMs > 0 && opts.benchRuns >= 0;
+}
+
+static void printReport(double wallS) {
+    double simH = opts.hours;
+    double simS = simH * 3600.0;
+
+    printf("\n=== Simulated %.1f h (step %lu ms, seed %lu) ===\n",
+           simH, opts.stepMs, (unsigned long)opts.seed);
+    printf("%-12s %11s %9s\n", "relay", "transitions", "on [h]");
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        printf("%-12s %11lu %9.2f\n", RELAY_NAMES[i],
+               (unsigned long)relay_transitions((RelayId)i), stats.onUs[i] / 3.6e9);
+    }
+    printf("rule runs      %lu\n", (unsigned long)stats.ruleRuns);
+    if (opts.commandsPath) {
+        printf("commands       %lu (%lu rejected by the parser)\n",
+               (unsigned long)stats.commands, (unsigned long)stats.commandsRejected);
+    }
+    printf("water temp     %.2f .. %.2f °C\n", stats.waterMin, stats.waterMax);
+    printf("pH             %.2f .. %.2f (%.1f%% of time outside %.2f..%.2f)\n",
+           stats.phMin, stats.phMax, 100.0 * stats.phOutUs / 1e6 / simS,
+           PH_LOW_THRESHOLD, PH_HIGH_THRESHOLD);
+    printf("DO min         %.2f mg/L (%.1f%% of time below %.1f)\n",
+           stats.doMin, 100.0 * stats.doLowUs / 1e6 / simS, DO_LOW_THRESHOLD);
+    printf("sump level     %.3f .. %.3f (float low below %.2f)\n",
+           stats.levelMin, stats.levelMax, params.floatLowLevel);
+    printf("wall time      %.3f s → %.1f simulated h per wall-second\n",
+           wallS, wallS > 0 ? simH / wallS : 0.0);
+}
+
+// Back to the boot state: clock, plant, drivers, rule timers and globals
+static void resetRun(const Commands &bootCommands) {
+    ph_dosing_cancel();
+    sim_clock_reset(0);
+    sim_set_epoch(SIM_EPOCH + (time_t)(opts.startHour * 3600.0));
+    plant_init(plant, opts.seed);
+    stats = SimStats();
+    tracedMask = 0;
+    nextCommand = 0;
+    lastSensor = 0;
+    lastRulesTick = 0;
+    first = true;
+    deviceRules.state = RuleState();
+    current = RealTimeData();
+    actuators = ActuatorState();
+    currentCommands = bootCommands;
+
+    relay_control_init();
+    ph_dosing_init();
+    float_switch_init();
+}
+
+// "<seconds> <stream|mqtt> <json>" per line; blank lines and # comments skipped
+static bool loadCommands(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[512];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        double atS;
+        char source[8];
+        int jsonAt = 0;
+        if (sscanf(line, "%lf %7s %n", &atS, source, &jsonAt) != 2 || !jsonAt || atS < 0 ||
+            (strcmp(source, "stream") && strcmp(source, "mqtt"))) {
+            fprintf(stderr, "%s:%d: expected \"<seconds> <stream|mqtt> <json>\"\n", path, lineNo);
+            fclose(f);
+            return false;
+        }
+        SimCommand cmd = {(unsigned long)(atS * 1000.0), strcmp(source, "mqtt") ? TRACE_SRC_STREAM : TRACE_SRC_MQTT,
+                          line + jsonAt};
+        if (!commandScript.empty() && cmd.atMs < commandScript.back().atMs) {
+            fprintf(stderr, "%s:%d: events must be in time order\n", path, lineNo);
+            fclose(f);
+            return false;
+        }
+        commandScript.push_back(cmd);
+    }
+    fclose(f);
+    return true;
+}
+
+// Returns the wall time the run took, in seconds
+static double runSimulation() {
+    uint64_t stepUs = opts.stepMs * 1000ULL;
+    uint64_t endUs = (uint64_t)(opts.hours * 3.6e9);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    for (uint64_t t = 0; t < endUs; t += stepUs) {
+        sim_clock_advance_to(t, onSegment);
+        controlStep(millis());
+    }
+    sim_clock_advance_to(endUs, onSegment);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    return wall.count();
+}
+
+// Repeated silent runs; the spread shows how much a single figure can be trusted
+static void runBench(const Commands &bootCommands) {
+    std::vector<double> rates;
+    for (int i = 0; i < opts.benchRuns; i++) {
+        resetRun(bootCommands);
+        double wallS = runSimulation();
+        rates.push_back(wallS > 0 ? opts.hours / wallS : 0.0);
+        printf("run %-3d %8.3f s  %7.1f simulated h per wall-second\n", i + 1, wallS, rates.back());
+    }
+    std::sort(rates.begin(), rates.end());
+    printf("\n=== Bench: %.1f simulated h x %d runs (step %lu ms) ===\n", opts.hours, opts.benchRuns, opts.stepMs);
+    printf("simulated h per wall-second  min %.1f  median %.1f  max %.1f\n",
+           rates.front(), rates[rates.size() / 2], rates.back());
+}
+
+int main(int argc, char **argv) {
+    if (!parseArgs(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Serial.setEnabled(opts.verbose);
+    log_set_level_all(opts.verbose ? LOG_LEVEL_DEBUG : LOG_LEVEL_NONE);   // skip formatting when silent
+    const Commands bootCommands = currentCommands;
+    if (opts.commandsPath && !loadCommands(opts.commandsPath)) return 1;
+
+    if (opts.benchRuns) {
+        runBench(bootCommands);
+        return 0;
+    }
+
+    if (opts.tracePath) {
+        trace = fopen(opts.tracePath, "w");
+        if (!trace) {
+            perror(opts.tracePath);
+            return 1;
+        }
+    }
+    if (opts.goldenPath) {
+        golden = fopen(opts.goldenPath, "r");
+        if (!golden) {
+            perror(opts.goldenPath);
+            return 1;
+        }
+    }
+    traceLine("time_s,relay,state\n");
+
+    resetRun(bootCommands);
+    if (opts.recordDir) {
+        sim_fs_set_root(opts.recordDir);
+        if (!trace_recorder_init()) return 1;
+    }
+
+    double wallS = runSimulation();
+
+    if (trace) fclose(trace);
+    if (opts.recordDir) trace_recorder_flush();
+    printReport(wallS);
+
+    if (!golden) return 0;
+    char extra[64];
+    if (!goldenDiff.firstDiff && fgets(extra, sizeof(extra), golden)) {
+        goldenDiff.firstDiff = goldenDiff.lines + 1;
+        snprintf(goldenDiff.expected, sizeof(goldenDiff.expected), "%s", extra);
+    }
+    fclose(golden);
+    if (!goldenDiff.firstDiff) {
+        printf("golden         %lu lines match %s\n", goldenDiff.lines, opts.goldenPath);
+        return 0;
+    }
+    printf("golden         MISMATCH with %s at line %lu\n  expected %s  got      %s",
+           opts.goldenPath, goldenDiff.firstDiff,
+           goldenDiff.expected[0] ? goldenDiff.expected : "(end of file)\n",
+           goldenDiff.got[0] ? goldenDiff.got : "(end of trace)\n");
+    return 1;
+}
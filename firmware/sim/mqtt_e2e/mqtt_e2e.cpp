@@ -0,0 +1,257 @@
+// === MQTT transport end-to-end check + benchmark (PlatformIO `native_mqtt_e2e` environment) ===
+// Runs the firmware's mqtt_transport against a real broker on the host and
+// watches it from a second client:
+//   - every live delta published arrives on <prefix>/live, in order
+//   - relay deltas arrive on <prefix>/relays, unchanged states are not resent
+//   - commands published on <prefix>/commands[/<group>/<field>] reach
+//     currentCommands and handleCommandPatch()
+// and reports live messages per second, publish → observer and command →
+// applied latency (p50/p99), and wire bytes per message next to the REST
+// PATCH the same update costs.
+//
+//   mosquitto -p 1883 &
+//   pio run -e native_mqtt_e2e && .pio/build/native_mqtt_e2e/program [options]
+//     --host H          broker (default 127.0.0.1); every connect goes here
+//     --port P          (default 1883)
+//     --count N         live updates and commands each (default 2000 / 200)
+//     --rest-rtt-ms MS  RTDB round trip for the REST figures (default 120, the
+//                       HTTPS stand-in's request time; see [HTTP] stats on the device)
+//     --token-bytes N   ID token length for the REST figures (default 950)
+//
+// Exits non-zero if a check fails or no broker answers. The clock runs in
+// real time here (sim_clock_realtime), so the latencies are wall-clock ones.
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "commands.h"
+#include "config.h"
+#include "logger.h"
+#include "mqtt_transport.h"
+#include "rtdb_command_parser.h"
+#include "sensor_data.h"
+#include "sim_hal.h"
+
+extern Commands currentCommands;
+
+#define TOPIC_LIVE      MQTT_TOPIC_PREFIX "/live"
+#define TOPIC_RELAYS    MQTT_TOPIC_PREFIX "/relays"
+#define TOPIC_COMMANDS  MQTT_TOPIC_PREFIX "/commands"
+
+// Same request the outbound queue sends for a live update (firesbase.cpp pushToRTDBLive)
+#define REST_HOST       "aquabell-cap2025-default-rtdb.asia-southeast1.firebasedatabase.app"
+#define REST_PATH       "/live_data/aquabell_esp32.json?print=silent&auth="
+#define REST_RESPONSE_BYTES  260    // approx. "HTTP/1.1 204 No Content" + RTDB's response headers
+#define TLS_RECORD_BYTES     29     // header + explicit nonce + GCM tag per record
+
+static int failures = 0;
+#define EXPECT(cond, ...) do { if (!(cond)) { failures++; printf("  FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+// ===== handleCommandPatch (relay_sync.cpp's needs the whole sync path; see check_rtdb_sync) =====
+static uint32_t patchesHandled = 0;
+static uint16_t lastPatchMask = 0;
+
+void handleCommandPatch(const CommandPatchResult &patch, const char *source) {
+    if (strcmp(source, "mqtt") != 0) return;
+    patchesHandled++;
+    lastPatchMask = patch.actuatorMask;
+}
+
+// ===== Observer =====
+struct Observer {
+    std::vector<double> liveSeen;     // waterTemp of each live message, arrival order
+    std::vector<uint32_t> liveAtUs;
+    uint32_t relayMessages = 0;
+    std::string lastRelays;
+};
+static Observer obs;
+
+static void onObserved(char *topic, uint8_t *payload, unsigned int length) {
+    std::string body((const char *)payload, length);
+    if (strcmp(topic, TOPIC_LIVE) == 0) {
+        const char *key = strstr(body.c_str(), "\"waterTemp\":");
+        if (!key) return;
+        obs.liveSeen.push_back(strtod(key + 12, nullptr));
+        obs.liveAtUs.push_back(micros());
+    } else if (strcmp(topic, TOPIC_RELAYS) == 0) {
+        obs.relayMessages++;
+        obs.lastRelays = body;
+    }
+}
+
+static WiFiClient observerNet;
+static PubSubClient observer(observerNet);
+
+static void pump() {
+    mqtt_transport_loop(millis());
+    observer.loop();
+}
+
+// Pump both clients until `done` or `timeoutMs` passes
+template <typename F>
+static bool pumpUntil(F done, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (!done()) {
+        if (millis() - start > timeoutMs) return false;
+        pump();
+    }
+    return true;
+}
+
+static double percentile(std::vector<uint32_t> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+// ===== Scenarios =====
+static bool connectBoth(const char *host, int port) {
+    mqtt_transport_init();
+    if (!pumpUntil([] { return mqtt_transport_connected(); }, 3000)) {
+        printf("no broker at %s:%d (start one with `mosquitto -p %d`)\n", host, port, port);
+        return false;
+    }
+    observer.setServer(host, port);
+    observer.setCallback(onObserved);
+    observer.setBufferSize(MQTT_BUFFER_SIZE);
+    if (!observer.connect("aquabell_e2e_observer")) {
+        printf("observer could not connect, state=%d\n", observer.state());
+        return false;
+    }
+    observer.subscribe(TOPIC_LIVE, 0);
+    observer.subscribe(TOPIC_RELAYS, 0);
+    pumpUntil([] { return false; }, 200);   // SUBACKs
+    return true;
+}
+
+static void runLive(int count, double restRttMs, int tokenBytes) {
+    printf("live deltas: %d\n", count);
+    RealTimeData data;
+    bool updated[5] = {true, false, false, false, false};
+    std::vector<uint32_t> sentAtUs;
+    uint32_t bytesBefore = mqtt_stats().bytesPublished;
+    size_t bodyBytes = 0;
+
+    uint32_t start = micros();
+    for (int i = 0; i < count; i++) {
+        data.waterTemp = 20.0f + i * 0.01f;
+        data.floatTriggered = false;
+        sentAtUs.push_back(micros());
+        EXPECT(mqtt_publish_live(data, updated), "publish %d failed", i);
+        pump();
+    }
+    pumpUntil([&] { return (int)obs.liveSeen.size() >= count; }, 3000);
+    uint32_t elapsedUs = micros() - start;
+    bodyBytes = mqtt_stats().bytesPublished - bytesBefore;
+
+    EXPECT((int)obs.liveSeen.size() == count, "observer got %zu of %d live messages", obs.liveSeen.size(), count);
+    bool ordered = true;
+    std::vector<uint32_t> latency;
+    for (size_t i = 0; i < obs.liveSeen.size(); i++) {
+        int seq = (int)((obs.liveSeen[i] - 20.0) / 0.01 + 0.5);
+        if (seq != (int)i) ordered = false;
+        if (seq >= 0 && seq < count) latency.push_back(obs.liveAtUs[i] - sentAtUs[seq]);
+    }
+    EXPECT(ordered, "live messages arrived out of order");
+
+    // Wire bytes per message: MQTT PUBLISH = fixed header (2) + topic length (2) + topic + JSON
+    double body = count ? (double)bodyBytes / count : 0;
+    double mqttWire = 2 + 2 + strlen(TOPIC_LIVE) + body;
+    int head = snprintf(nullptr, 0,
+                        "PATCH " REST_PATH "%*s HTTP/1.1\r\nHost: " REST_HOST "\r\n"
+                        "User-Agent: ESP32HTTPClient\r\nConnection: keep-alive\r\n"
+                        "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n"
+                        "Content-Type: application/json\r\nContent-Length: %d\r\n\r\n",
+                        tokenBytes, "", (int)body);
+    double restWire = head + body + REST_RESPONSE_BYTES + 2 * TLS_RECORD_BYTES;
+
+    double rate = elapsedUs ? count * 1e6 / elapsedUs : 0;
+    printf("  MQTT  %8.0f msg/s   publish→observer p50 %.0f us p99 %.0f us   %5.0f B/msg (JSON %.0f B)\n",
+           rate, percentile(latency, 0.50), percentile(latency, 0.99), mqttWire, body);
+    printf("  REST  %8.1f msg/s   one PATCH in flight, %.0f ms RTT             %5.0f B/msg (%d B token)\n",
+           1000.0 / restRttMs, restRttMs, restWire, tokenBytes);
+}
+
+static void runRelays() {
+    printf("relay deltas\n");
+    RealTimeData data;
+    uint32_t before = obs.relayMessages;
+    EXPECT(mqtt_publish_relays(data), "first relay publish (full state) failed");
+    data.relayStates.bits |= 1u << ACTUATOR_fan;
+    EXPECT(mqtt_publish_relays(data), "fan delta not published");
+    EXPECT(!mqtt_publish_relays(data), "unchanged relays published again");
+    pumpUntil([&] { return obs.relayMessages >= before + 2; }, 2000);
+    EXPECT(obs.relayMessages == before + 2, "observer got %u relay messages, expected 2", obs.relayMessages - before);
+    EXPECT(obs.lastRelays == "{\"fan\":true}", "fan delta was %s", obs.lastRelays.c_str());
+}
+
+static void runCommands(int count) {
+    printf("commands: %d\n", count);
+    std::vector<uint32_t> latency;
+    int lost = 0;
+    for (int i = 0; i < count; i++) {
+        bool v = (i % 2) == 0;
+        uint32_t before = patchesHandled;
+        uint32_t t0 = micros();
+        if (i % 4 < 2) {
+            observer.publish(TOPIC_COMMANDS "/fan/value", v ? "true" : "false");
+        } else {
+            char body[64];
+            snprintf(body, sizeof(body), "{\"fan\":{\"value\":%s}}", v ? "true" : "false");
+            observer.publish(TOPIC_COMMANDS, body);
+        }
+        bool ok = pumpUntil([&] { return patchesHandled > before; }, 2000);
+        if (!ok) {
+            lost++;
+            continue;
+        }
+        latency.push_back(micros() - t0);
+        EXPECT(currentCommands.fan.value == v, "command %d: fan.value=%d, expected %d", i, currentCommands.fan.value, v);
+        EXPECT(lastPatchMask & (1u << ACTUATOR_fan), "command %d: fan missing from the patch mask", i);
+    }
+    EXPECT(lost == 0, "%d of %d commands never applied", lost, count);
+    printf("  MQTT  command→applied p50 %.0f us p99 %.0f us, on-device handling max %lu us\n",
+           percentile(latency, 0.50), percentile(latency, 0.99), (unsigned long)mqtt_stats().maxCommandUs);
+}
+
+int main(int argc, char **argv) {
+    const char *host = "127.0.0.1";
+    int port = MQTT_BROKER_PORT;
+    int liveCount = 2000, commandCount = 200;
+    double restRttMs = 120;
+    int tokenBytes = 950;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc) port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            liveCount = atoi(argv[++i]);
+            commandCount = liveCount / 10 > 0 ? liveCount / 10 : 1;
+        }
+        else if (!strcmp(argv[i], "--rest-rtt-ms") && i + 1 < argc) restRttMs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--token-bytes") && i + 1 < argc) tokenBytes = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--host H] [--port P] [--count N] [--rest-rtt-ms MS] [--token-bytes N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    log_set_level_all(LOG_LEVEL_WARN);
+    sim_clock_realtime(true);
+    sim_wifi_set_up(true);
+    sim_net_redirect(host, port);
+
+    if (!connectBoth(host, port)) return 1;
+    runLive(liveCount, restRttMs, tokenBytes);
+    runRelays();
+    runCommands(commandCount);
+
+    observer.disconnect();
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "ok", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+#include <math.h>
+#include "plant.h"
+#include "relay_control.h"
+
+// Fresh (tap) water mixed in by refills
+#define FRESH_WATER_C     26.0f
+#define FRESH_WATER_PH    7.5f
+#define FRESH_WATER_NTU   5.0f
+#define MIN_VOLUME        0.3f       // drain pump intake sits above the sump floor
+
+static float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Oxygen saturation in fresh water (mg/L) at temperature `t` (°C)
+static float doSaturation(float t) {
+    return 14.62f - 0.3898f * t + 0.006969f * t * t - 0.00005897f * t * t * t;
+}
+
+static float noise(PlantState &s, float amplitude) {
+    s.rng ^= s.rng << 13;
+    s.rng ^= s.rng >> 17;
+    s.rng ^= s.rng << 5;
+    return amplitude * ((s.rng & 0xFFFF) / 32767.5f - 1.0f);
+}
+
+void plant_init(PlantState &s, uint32_t seed) {
+    s = PlantState();
+    s.rng = seed ? seed : 1;
+}
+
+void plant_step(PlantState &s, const PlantParams &p, float dtS, uint16_t relays, float hourOfDay) {
+    float dtH = dtS / 3600.0f;
+    bool pump = relays & RELAY_BIT(RELAY_PUMP);
+
+    // --- Air (the exhaust fan pulls in drier, slightly cooler air) ---
+    float phase = (hourOfDay - 9.0f) * (float)(2.0 * M_PI / 24.0);
+    s.airTemp = p.airMeanC + p.airSwingC * sinf(phase);
+    s.airHumidity = p.humidityMean - p.humiditySwing * sinf(phase);
+    if (relays & RELAY_BIT(RELAY_FAN)) {
+        s.airTemp -= 1.0f;
+        s.airHumidity -= 8.0f;
+    }
+
+    // --- Water temperature ---
+    s.waterTemp += (s.airTemp - s.waterTemp) * dtH / p.waterTauH;
+    if (relays & RELAY_BIT(RELAY_HEATER)) s.waterTemp += p.heaterCPerH * dtH;
+    if (relays & RELAY_BIT(RELAY_COOLER)) s.waterTemp -= p.coolerCPerH * dtH;
+
+    // --- pH drift ---
+    s.pH = clampf(s.pH + p.phDriftPerH * dtH, 4.0f, 9.5f);
+
+    // --- Dissolved oxygen ---
+    float sat = doSaturation(s.waterTemp);
+    float aeration = pump ? p.aerationPumpPerH : p.aerationStillPerH;
+    float uptake = p.doUptakePerH * powf(1.05f, s.waterTemp - 25.0f);
+    s.dissolvedOxygen += (aeration * (sat - s.dissolvedOxygen) - uptake) * dtH;
+    s.dissolvedOxygen = clampf(s.dissolvedOxygen, 0.0f, sat);
+
+    // --- Turbidity (sump flush needs both valves open) ---
+    s.turbidityNTU += p.ntuPerH * dtH;
+    bool flushing = (relays & RELAY_BIT(RELAY_FLUSH_VALVE)) && (relays & RELAY_BIT(RELAY_DRAIN_VALVE));
+    if (flushing) s.turbidityNTU -= (s.turbidityNTU - FRESH_WATER_NTU) * clampf(p.flushPerS * dtS, 0.0f, 1.0f);
+
+    // --- Grow bed flood / drain ---
+    if (pump) s.growBedFill += (1.0f - s.growBedFill) * clampf(dtS / p.growBedFillTauS, 0.0f, 1.0f);
+    else s.growBedFill -= s.growBedFill * clampf(dtS / p.growBedDrainTauS, 0.0f, 1.0f);
+
+    // --- Volume: evaporation, drain pump, refill valve ---
+    s.waterVolume -= p.evaporationPerH * dtH;
+    if (relays & RELAY_BIT(RELAY_DRAIN_PUMP)) s.waterVolume -= p.drainPerS * dtS;
+    if (relays & RELAY_BIT(RELAY_VALVE)) {
+        float added = p.refillPerS * dtS;
+        float mix = added / (s.waterVolume + added);
+        s.waterTemp += (FRESH_WATER_C - s.waterTemp) * mix;
+        s.pH += (FRESH_WATER_PH - s.pH) * mix;
+        s.dissolvedOxygen += (doSaturation(FRESH_WATER_C) - s.dissolvedOxygen) * mix;
+        s.turbidityNTU += (FRESH_WATER_NTU - s.turbidityNTU) * mix;
+        s.waterVolume += added;
+    }
+
+    // Sump overflows above capacity
+    float maxVolume = 1.0f + p.growBedHold * s.growBedFill;
+    s.waterVolume = clampf(s.waterVolume, MIN_VOLUME, maxVolume);
+}
+
+void plant_dose(PlantState &s, const PlantParams &p, bool up, uint32_t onUs) {
+    float shift = p.phPerDoseMs * (onUs / 1000.0f);
+    s.pH = clampf(s.pH + (up ? shift : -shift), 4.0f, 9.5f);
+}
+
+float plant_sump_level(const PlantState &s, const PlantParams &p) {
+    return s.waterVolume - p.growBedHold * s.growBedFill;
+}
+
+void plant_read_sensors(PlantState &s, const PlantParams &p, RealTimeData &data) {
+    data.waterTemp = s.waterTemp + noise(s, p.noiseTempC);
+    data.pH = s.pH + noise(s, p.noisePh);
+    data.dissolvedOxygen = s.dissolvedOxygen + noise(s, p.noiseDo);
+    data.turbidityNTU = s.turbidityNTU + noise(s, p.noiseNtu);
+    data.airTemp = s.airTemp + noise(s, p.noiseTempC);
+    data.airHumidity = s.airHumidity + noise(s, 0.5f);
+}
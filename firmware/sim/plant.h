@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include "sensor_data.h"
+
+// === Tank plant model ===
+// Lumped first-order model of the sump + grow bed, driven by the committed
+// relay states. Coarse on purpose: it only has to move each sensor the right
+// way and at a plausible rate so the rules see realistic trajectories.
+
+struct PlantParams {
+    // Air (daily sine, warmest at 15:00)
+    float airMeanC = 28.0f;
+    float airSwingC = 4.0f;
+    float humidityMean = 68.0f;
+    float humiditySwing = 10.0f;
+
+    // Water temperature
+    float waterTauH = 4.0f;            // relaxation toward air temperature
+    float heaterCPerH = 2.0f;
+    float coolerCPerH = 2.5f;
+
+    // pH
+    float phDriftPerH = -0.03f;        // nitrification slowly acidifies
+    float phPerDoseMs = 0.0006f;       // pH shift per ms of dosing pump on-time
+
+    // Dissolved oxygen
+    float doUptakePerH = 0.35f;        // fish + bacteria respiration at 25 °C
+    float aerationStillPerH = 0.15f;   // surface exchange, pump off
+    float aerationPumpPerH = 1.5f;     // grow bed return splash, pump on
+
+    // Turbidity
+    float ntuPerH = 12.0f;
+    float flushPerS = 0.02f;           // fraction of turbidity removed per second of sump flush
+
+    // Level (fraction of sump capacity)
+    float evaporationPerH = 0.004f;
+    float growBedHold = 0.08f;         // water held in the bed when it is full
+    float growBedFillTauS = 120.0f;
+    float growBedDrainTauS = 300.0f;
+    float refillPerS = 0.003f;
+    float drainPerS = 0.0025f;
+    float floatLowLevel = 0.85f;
+
+    // Sensor noise (uniform ±)
+    float noiseTempC = 0.05f;
+    float noisePh = 0.02f;
+    float noiseDo = 0.05f;
+    float noiseNtu = 2.0f;
+};
+
+struct PlantState {
+    float airTemp = 28.0f;
+    float airHumidity = 68.0f;
+    float waterTemp = 27.0f;
+    float pH = 7.0f;
+    float dissolvedOxygen = 6.5f;
+    float turbidityNTU = 80.0f;
+    float waterVolume = 0.95f;         // sump + grow bed, fraction of sump capacity
+    float growBedFill = 0.0f;          // 0..1
+    uint32_t rng = 0x12345678;         // sensor noise state (xorshift32)
+};
+
+void plant_init(PlantState &s, uint32_t seed);
+
+// Advance the model by `dtS` seconds with outputs `relayMask` (RELAY_BIT layout)
+// held constant. `hourOfDay` drives the ambient air curve.
+void plant_step(PlantState &s, const PlantParams &p, float dtS, uint16_t relayMask, float hourOfDay);
+
+// Dosing pumps run in 50 ms pulses, far below the simulation step; their
+// exact on-time is fed in separately
+void plant_dose(PlantState &s, const PlantParams &p, bool up, uint32_t onUs);
+
+// Sump level as the float switch sees it (grow bed water is not in the sump)
+float plant_sump_level(const PlantState &s, const PlantParams &p);
+
+// Noisy sensor readings into `data` (same fields the sensor task fills)
+void plant_read_sensors(PlantState &s, const PlantParams &p, RealTimeData &data);
@@ -0,0 +1,4 @@
+// The firmware's command stream parser compiled for the host; the rest of
+// lib/firebase needs the network stack, so only this translation unit is pulled in
+#include <ctype.h>
+#include "../../lib/firebase/rtdb_command_parser.cpp"
@@ -0,0 +1,453 @@
+// === Control trace replay (PlatformIO `native_replay` environment) ===
+// Feeds a trace from lib/trace_recorder back through the firmware's own
+// applyRulesWithModeControl(), checkpHPumpLogic() and command stream parser
+// and checks every recorded decision. Each segment opens with a full state
+// snapshot, so any range of segments replays on its own (bisect a long trace
+// by segment), and segment boundaries double as state checkpoints.
+//
+//   pio run -e native_replay && .pio/build/native_replay/program [options] TRACE...
+//     TRACE            serial capture containing "#TRACE" lines, or segment files (sNNNNNNNN.bin)
+//     --from-seg N     first segment to replay (default: oldest)
+//     --to-seg N       last segment to replay (default: newest)
+//     --max-report N   mismatches printed in full (default 20)
+//     --timeline       print decisions, commands and relay commits as they replay
+//     --log            pass the firmware's Serial log through to stdout
+//
+// A simulator trace that exercises the parser too (stream and MQTT events):
+//   .pio/build/native/program --hours 8 --commands sim/replay/commands_8h.txt --record DIR
+
+#include <Arduino.h>
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "rule_engine.h"
+#include "logger.h"
+#include "rtdb_command_parser.h"
+#include "trace_format.h"
+
+// ActuatorState::stateBits order
+static const char *const STATE_NAMES[] = {
+    "fan", "light", "pump", "valve", "cooler", "heater", "phLowering", "phRaising",
+    "waterChange", "sumpWaterValve", "sumpDrainValve", "phDosingEnabled", "sumpCleaning",
+};
+static const int STATE_BITS = sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]);
+
+static const char *const RELAY_NAMES[RELAY_COUNT] = {
+    "fan", "light", "pump", "valve", "cooler", "heater",
+    "ph_lowering", "ph_raising", "drain_pump", "flush_valve", "drain_valve"
+};
+
+struct ReplayOptions {
+    uint32_t fromSeg = 0;
+    uint32_t toSeg = UINT32_MAX;
+    uint32_t maxReport = 20;
+    bool timeline = false;
+    bool log = false;
+};
+
+struct ReplayStats {
+    uint32_t segments = 0;
+    uint32_t boots = 0;
+    uint32_t passes = 0;
+    uint32_t commands = 0;
+    uint32_t commandsRejected = 0;   // parser returned false (same as on the device)
+    uint32_t relayRecords = 0;
+    uint32_t decisionsChecked = 0;
+    uint32_t mismatches = 0;
+    uint32_t snapshotDrift = 0;      // replayed state != next segment's snapshot
+    uint32_t badSegments = 0;
+    uint32_t truncated = 0;          // segment ended mid-record (power cut)
+    uint64_t spanMs = 0;             // device time covered
+    uint64_t bytes = 0;
+};
+
+// Engine inputs the trace supplies, in place of the dosing timer and SNTP
+struct Replay {
+    RuleEngine engine;
+    ActuatorState actuators;
+    Commands commands = {};
+    RealTimeData data;
+    uint16_t clock = 0;
+    uint16_t notes = 0;        // TP_DOSE_* of the pass being replayed
+    uint16_t requested = 0;    // relay requests from the rules (not checked, holds differ)
+    uint16_t decision = 0;     // last recorded decision
+    uint32_t seg = 0;
+    uint32_t nowMs = 0;
+};
+
+static ReplayOptions opts;
+static ReplayStats stats;
+
+// === Rule engine IO ===
+static void setRelay(void *ctx, RelayId id, bool on) {
+    Replay &rp = *(Replay *)ctx;
+    if (on) rp.requested |= RELAY_BIT(id);
+    else rp.requested &= ~RELAY_BIT(id);
+}
+
+static bool doseStart(void *ctx, bool, uint8_t, uint32_t, uint32_t) {
+    return !(((Replay *)ctx)->notes & TP_DOSE_REFUSED);
+}
+
+static void doseCancel(void *) {}
+
+static bool doseBusy(void *ctx) {
+    return !(((Replay *)ctx)->notes & TP_DOSE_IDLE);
+}
+
+static bool doseTakeCompleted(void *ctx) {
+    return ((Replay *)ctx)->notes & TP_DOSE_DONE;
+}
+
+static bool localTime(void *ctx, struct tm &out) {
+    const Replay &rp = *(const Replay *)ctx;
+    if (rp.clock == 0) return false;
+    memset(&out, 0, sizeof(out));
+    out.tm_hour = (rp.clock - 1) / 60;
+    out.tm_min = (rp.clock - 1) % 60;
+    return true;
+}
+
+// === Reporting ===
+static void printBits(const char *const *names, int count, uint16_t bits) {
+    bool any = false;
+    for (int i = 0; i < count; i++) {
+        if (!(bits & (1u << i))) continue;
+        printf("%s%s", any ? "," : "", names[i]);
+        any = true;
+    }
+    if (!any) printf("-");
+}
+
+static void printChanges(const char *const *names, int count, uint16_t before, uint16_t after) {
+    uint16_t diff = before ^ after;
+    for (int i = 0; i < count; i++) {
+        if (diff & (1u << i)) printf(" %c%s", (after & (1u << i)) ? '+' : '-', names[i]);
+    }
+}
+
+static void stamp(const Replay &rp) {
+    printf("[s%lu %10.3f s]", (unsigned long)rp.seg, rp.nowMs / 1000.0);
+}
+
+static void reportMismatch(const Replay &rp, uint16_t expected) {
+    stats.mismatches++;
+    if (stats.mismatches > opts.maxReport) return;
+    stamp(rp);
+    printf(" ❌ decision differs:");
+    printChanges(STATE_NAMES, STATE_BITS, expected, rp.actuators.stateBits);
+    printf("  (recorded ");
+    printBits(STATE_NAMES, STATE_BITS, expected);
+    printf(")\n");
+}
+
+// First field where the replayed state and a snapshot disagree, or nullptr
+static const char *snapshotDiff(const Replay &rp, const TraceSnapshot &snap) {
+    if (trace_pack_commands(rp.commands) != trace_pack_commands(snap.commands)) return "commands";
+    if (rp.actuators.stateBits != snap.actuators.stateBits) return "actuators.stateBits";
+    if (rp.actuators.autoBits != snap.actuators.autoBits) return "actuators.autoBits";
+    if (rp.actuators.emergencyBits != snap.actuators.emergencyBits) return "actuators.emergencyBits";
+    if (rp.actuators.manualBits != snap.actuators.manualBits) return "actuators.manualBits";
+    if (rp.actuators.manualValueBits != snap.actuators.manualValueBits) return "actuators.manualValueBits";
+    if (rp.actuators.justEnabledBits != snap.actuators.justEnabledBits) return "actuators.justEnabledBits";
+#define REPLAY_DIFF_RULE_FIELD(f) if (rp.engine.state.f != snap.rules.f) return "rules." #f;
+    RULE_STATE_FIELDS(REPLAY_DIFF_RULE_FIELD)
+#undef REPLAY_DIFF_RULE_FIELD
+    RealTimeData replayed = rp.data, recorded = snap.data;
+    for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) {
+        if (memcmp(trace_sensor_field(replayed, i), trace_sensor_field(recorded, i), sizeof(float))) return "sensors";
+    }
+    if (rp.clock != snap.clock) return "clock";
+    return nullptr;
+}
+
+static void loadSnapshot(Replay &rp, const TraceSnapshot &snap) {
+    rp.commands = snap.commands;
+    rp.actuators = snap.actuators;
+    rp.engine.state = snap.rules;
+    rp.data = snap.data;
+    rp.clock = snap.clock;
+    rp.requested = snap.relays;
+    rp.decision = snap.actuators.stateBits;
+    rp.nowMs = snap.millis;
+}
+
+// === Records ===
+static bool replayPass(Replay &rp, TraceReader &r) {
+    uint16_t flags = trace_get_varint(r);
+    if (flags & TP_SENSORS) {
+        uint8_t mask = trace_get_u8(r);
+        for (int i = 0; i < TRACE_SENSOR_FIELDS; i++) {
+            if (!(mask & (1u << i))) continue;
+            float *field = trace_sensor_field(rp.data, i);
+            *field = trace_get_float_delta(r, *field);
+        }
+    }
+    if (flags & TP_CLOCK) rp.clock = trace_get_varint(r);
+    if (flags & TP_DECISION) rp.decision = trace_get_varint(r);
+    if (!r.ok) return false;
+
+    // Same order as controlCycle() in src/main.cpp
+    rp.data.floatTriggered = flags & TP_FLOAT_LOW;
+    rp.notes = flags;
+    if (!(flags & TP_EVAL)) checkpHPumpLogic(rp.engine, rp.actuators, rp.data.pH, rp.nowMs);
+
+    uint16_t before = rp.actuators.stateBits;
+    if (flags & (TP_EVAL | TP_RULES)) {
+        applyRulesWithModeControl(rp.engine, rp.data, rp.actuators, rp.commands, rp.nowMs);
+    } else if (flags & TP_RULES_DEFAULT) {
+        Commands defaultAuto = {
+            {true,false}, {true,false}, {true,false},
+            {true,false}, {true,false}, {true,false},
+            {true,false}, {false,false, false}, {false,false, false}
+        };
+        applyRulesWithModeControl(rp.engine, rp.data, rp.actuators, defaultAuto, rp.nowMs);
+    } else if (flags & TP_HOLD) {
+        rp.actuators.fan = false;
+        rp.actuators.light = false;
+        rp.actuators.pump = false;
+        rp.actuators.valve = false;
+        rp.actuators.cooler = false;
+        rp.actuators.heater = false;
+    }
+    reflect_actuator_relays(rp.data, rp.actuators);
+    rp.notes = 0;
+    stats.passes++;
+
+    if (opts.timeline && rp.actuators.stateBits != before) {
+        stamp(rp);
+        printf(" decision");
+        printChanges(STATE_NAMES, STATE_BITS, before, rp.actuators.stateBits);
+        printf("\n");
+    }
+
+    stats.decisionsChecked++;
+    if (rp.actuators.stateBits != rp.decision) {
+        reportMismatch(rp, rp.decision);
+        rp.actuators.stateBits = rp.decision;   // resync so one divergence is reported once
+    }
+    return true;
+}
+
+static bool replayCommand(Replay &rp, TraceReader &r) {
+    uint8_t source = trace_get_u8(r);
+    uint32_t len = trace_get_varint(r);
+    if (!r.ok || (size_t)(r.end - r.p) < len) return false;
+    const char *json = (const char *)r.p;
+    r.p += len;
+
+    CommandPatchResult patch;
+    bool parsed = rtdb_apply_command_event(json, len, rp.commands, patch);
+    stats.commands++;
+    if (!parsed) stats.commandsRejected++;
+
+    if (opts.timeline) {
+        stamp(rp);
+        printf(" command %s%s %.*s\n", source == TRACE_SRC_MQTT ? "mqtt" : "stream",
+               parsed ? (patch.changed ? "" : " (no change)") : " (rejected)",
+               (int)(len > 160 ? 160 : len), json);
+    }
+    return true;
+}
+
+static bool replayRelays(Replay &rp, TraceReader &r, uint16_t &committed) {
+    uint16_t relays = trace_get_varint(r);
+    if (!r.ok) return false;
+    stats.relayRecords++;
+    if (opts.timeline) {
+        stamp(rp);
+        printf(" relays  ");
+        printChanges(RELAY_NAMES, RELAY_COUNT, committed, relays);
+        printf("\n");
+    }
+    committed = relays;
+    return true;
+}
+
+// One segment; `contiguous` when the previous segment was replayed right before it
+static void replaySegment(Replay &rp, uint32_t seg, const std::vector<uint8_t> &bytes, bool contiguous) {
+    TraceReader r(bytes.data(), bytes.size());
+    TraceSnapshot snap;
+    if (trace_get_u32(r) != TRACE_MAGIC || trace_get_u8(r) != TRACE_SNAPSHOT || !trace_get_snapshot(r, snap)) {
+        printf("[s%lu] ⚠️ No valid header, skipped\n", (unsigned long)seg);
+        stats.badSegments++;
+        return;
+    }
+
+    rp.seg = seg;
+    stats.segments++;
+    stats.bytes += bytes.size();
+    if (snap.reason == TRACE_SNAP_BOOT) {
+        stats.boots++;
+        if (opts.timeline) printf("[s%lu %10.3f s] boot\n", (unsigned long)seg, snap.millis / 1000.0);
+    } else if (contiguous) {
+        const char *diff = snapshotDiff(rp, snap);
+        if (diff) {
+            stats.snapshotDrift++;
+            printf("[s%lu] ⚠️ Replayed state differs from the segment snapshot (%s); resyncing\n",
+                   (unsigned long)seg, diff);
+        }
+    }
+    loadSnapshot(rp, snap);
+
+    uint32_t start = snap.millis;
+    uint16_t committed = snap.relays;
+    while (!r.done()) {
+        uint8_t tag = trace_get_u8(r);
+        int32_t dt = trace_get_delta(r);
+        if (!r.ok) break;
+        rp.nowMs += dt;
+
+        bool ok;
+        switch (tag) {
+        case TRACE_PASS:    ok = replayPass(rp, r); break;
+        case TRACE_COMMAND: ok = replayCommand(rp, r); break;
+        case TRACE_RELAYS:  ok = replayRelays(rp, r, committed); break;
+        default:            ok = false; break;
+        }
+        if (!ok) {
+            r.ok = false;
+            break;
+        }
+    }
+    if (!r.ok) {
+        stats.truncated++;
+        printf("[s%lu %10.3f s] ⚠️ Segment ends mid-record, rest ignored\n", (unsigned long)seg, rp.nowMs / 1000.0);
+    }
+    stats.spanMs += rp.nowMs - start;
+}
+
+// === Input ===
+static bool readFile(const char *path, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out.insert(out.end(), chunk, chunk + n);
+    fclose(f);
+    return true;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "#TRACE s<seg> <hex>" lines from a serial capture; anything else is ignored
+static void parseDump(const std::vector<uint8_t> &text, std::map<uint32_t, std::vector<uint8_t>> &segs) {
+    std::string all(text.begin(), text.end());
+    size_t pos = 0;
+    while ((pos = all.find("#TRACE s", pos)) != std::string::npos) {
+        size_t eol = all.find('\n', pos);
+        if (eol == std::string::npos) eol = all.size();
+
+        char *hex;
+        unsigned long seg = strtoul(all.c_str() + pos + 8, &hex, 10);
+        while (*hex == ' ') hex++;
+        std::vector<uint8_t> &out = segs[seg];
+        for (const char *p = hex; p + 1 < all.c_str() + eol; p += 2) {
+            int hi = hexValue(p[0]), lo = hexValue(p[1]);
+            if (hi < 0 || lo < 0) break;
+            out.push_back((uint8_t)(hi << 4 | lo));
+        }
+        pos = eol;
+    }
+}
+
+static bool loadTrace(const char *path, std::map<uint32_t, std::vector<uint8_t>> &segs) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) return false;
+
+    TraceReader r(bytes.data(), bytes.size());
+    if (trace_get_u32(r) == TRACE_MAGIC) {
+        // Raw segment file: number from the name, else after everything loaded so far
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        unsigned long seg;
+        if (sscanf(name, "s%08lu.bin", &seg) != 1) seg = segs.empty() ? 0 : segs.rbegin()->first + 1;
+        segs[seg] = std::move(bytes);
+    } else {
+        parseDump(bytes, segs);
+    }
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--from-seg N] [--to-seg N] [--max-report N] [--timeline] [--log] TRACE...\n", prog);
+}
+
+int main(int argc, char **argv) {
+    std::map<uint32_t, std::vector<uint8_t>> segs;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--from-seg") && hasValue) opts.fromSeg = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--to-seg") && hasValue) opts.toSeg = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--max-report") && hasValue) opts.maxReport = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--timeline")) opts.timeline = true;
+        else if (!strcmp(arg, "--log")) opts.log = true;
+        else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (!loadTrace(arg, segs)) {
+            return 1;
+        }
+    }
+    if (segs.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    Serial.setEnabled(opts.log);
+    log_set_level_all(opts.log ? LOG_LEVEL_DEBUG : LOG_LEVEL_NONE);
+
+    RuleIo io;
+    io.setRelay = setRelay;
+    io.doseStart = doseStart;
+    io.doseCancel = doseCancel;
+    io.doseBusy = doseBusy;
+    io.doseTakeCompleted = doseTakeCompleted;
+    io.localTime = localTime;
+    static Replay rp;
+    io.ctx = &rp;
+    rp.engine = RuleEngine(io);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    bool havePrev = false;
+    uint32_t prevSeg = 0;
+    for (const auto &entry : segs) {
+        if (entry.first < opts.fromSeg || entry.first > opts.toSeg) continue;
+        replaySegment(rp, entry.first, entry.second, havePrev && entry.first == prevSeg + 1);
+        havePrev = true;
+        prevSeg = entry.first;
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+    printf("\n=== Replayed %lu segments (%lu boots, %.1f KB), %.2f h of device time ===\n",
+           (unsigned long)stats.segments, (unsigned long)stats.boots, stats.bytes / 1024.0,
+           stats.spanMs / 3.6e6);
+    printf("passes         %lu\n", (unsigned long)stats.passes);
+    printf("commands       %lu (%lu rejected by the parser)\n",
+           (unsigned long)stats.commands, (unsigned long)stats.commandsRejected);
+    printf("relay commits  %lu\n", (unsigned long)stats.relayRecords);
+    printf("decisions      %lu checked, %lu mismatched\n",
+           (unsigned long)stats.decisionsChecked, (unsigned long)stats.mismatches);
+    if (stats.snapshotDrift) printf("snapshot drift %lu segments\n", (unsigned long)stats.snapshotDrift);
+    if (stats.badSegments || stats.truncated) {
+        printf("damaged        %lu unreadable, %lu truncated\n",
+               (unsigned long)stats.badSegments, (unsigned long)stats.truncated);
+    }
+    double speed = wall.count() > 0 ? stats.spanMs / 1000.0 / wall.count() : 0;
+    printf("wall time      %.3f s → %.0f× real time\n", wall.count(), speed);
+
+    return stats.mismatches || stats.snapshotDrift ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+// === Host shim of the Arduino-ESP32 core (native simulator build) ===
+// Just enough of the core for the control libraries: time comes from the
+// virtual clock in sim_hal, pins are an in-memory array and Serial prints to
+// stdout only when enabled (rules log every tick, which would dominate runtime).
+
+// Arduino String on std::string, with the members the firmware uses
+class String : public std::string {
+public:
+    String() = default;
+    String(const std::string &s) : std::string(s) {}
+    String(const char *s) : std::string(s ? s : "") {}
+
+    bool isEmpty() const { return empty(); }
+    int indexOf(const char *s, size_t from = 0) const { return toIndex(find(s, from)); }
+    int indexOf(char c, size_t from = 0) const { return toIndex(find(c, from)); }
+    String substring(size_t from, size_t to) const { return substr(from, to - from); }
+    String substring(size_t from) const { return substr(from); }
+
+private:
+    static int toIndex(size_t pos) { return pos == npos ? -1 : (int)pos; }
+};
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH          0x1
+#define LOW           0x0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long max);
+long random(long min, long max);
+
+// FreeRTOS critical sections: the simulator is single-threaded
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)      ((void)(mux))
+#define portEXIT_CRITICAL(mux)       ((void)(mux))
+
+// FreeRTOS tasks: creation always fails, so callers take their inline fallback
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+#define pdPASS               1
+#define pdFAIL               0
+#define pdMS_TO_TICKS(ms)    (ms)
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *,
+                                          unsigned, TaskHandle_t *, int) {
+    return pdFAIL;
+}
+inline void vTaskDelay(uint32_t) {}
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    void setEnabled(bool on) { enabled = on; }
+
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *s);
+    size_t println(const char *s = "");
+
+    // No host input; output is never back-pressured
+    int available() { return 0; }
+    int read() { return -1; }
+    int availableForWrite() { return 4096; }
+
+private:
+    bool enabled = false;
+};
+
+extern HardwareSerial Serial;
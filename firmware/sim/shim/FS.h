@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <string>
+
+// === Host shim of the Arduino FS API ===
+// Files and directories live under a host directory (sim_fs_set_root), so
+// flash-backed modules such as the trace recorder run unchanged.
+
+struct SimFileImpl;
+
+class File {
+public:
+    File() = default;
+    explicit File(std::shared_ptr<SimFileImpl> impl) : impl(impl) {}
+
+    explicit operator bool() const;
+    size_t write(const uint8_t *buf, size_t size);
+    size_t read(uint8_t *buf, size_t size);
+    bool seek(uint32_t pos);
+    size_t size() const;
+    const char *name() const;
+    File openNextFile();
+    void close();
+
+private:
+    std::shared_ptr<SimFileImpl> impl;
+};
+
+namespace fs {
+
+class FS {
+public:
+    File open(const std::string &path, const char *mode = "r");
+    bool exists(const std::string &path);
+    bool remove(const std::string &path);
+    bool mkdir(const std::string &path);
+};
+
+}  // namespace fs
@@ -0,0 +1,7 @@
+#pragma once
+
+// === FirebaseClient stand-in ===
+// Only the names lib/firebase/firebase.h mentions, so the lib/firebase
+// sources other than firesbase.cpp build on the host. Nothing here is used.
+
+class AsyncResult;
@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+#include "WiFiClientSecure.h"
+
+// === Host shim of HTTPClient ===
+// Requests go to the HTTPS stand-in (sim_https.h); time spent in the TLS
+// handshake and the request passes on the virtual clock.
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+
+class HTTPClient {
+public:
+    void setReuse(bool reuse) { reuse_ = reuse; }
+    void setTimeout(uint32_t) {}
+    bool begin(WiFiClientSecure &client, const String &url);
+    void addHeader(const String &, const String &) {}
+    int sendRequest(const char *method, const String &payload);
+    String getString() { return response_; }
+    void end();
+
+private:
+    WiFiClientSecure *client_ = nullptr;
+    String url_;
+    String response_;
+    bool reuse_ = false;
+};
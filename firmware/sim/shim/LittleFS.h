@@ -0,0 +1,14 @@
+#pragma once
+#include "FS.h"
+
+// === Host shim of the LittleFS mount (see FS.h) ===
+
+class LittleFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false);
+    // Bytes in 4 KB blocks under the root, against the default 1408 KB data partition
+    size_t usedBytes();
+    size_t totalBytes() { return 0x160000; }
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+#include "Client.h"
+
+// === Host shim of WiFi.h ===
+// HTTPS goes to the stand-in in sim/sim_https.cpp; WiFiClient is a plain
+// TCP socket (sim/sim_net.cpp) for harnesses that talk to a real local
+// server, e.g. the MQTT broker in sim/mqtt_e2e.
+
+class WiFiClient : public Client {
+public:
+    ~WiFiClient() override { stop(); }
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    // As in the ESP32 core: give up on the TCP handshake after timeoutMs
+    int connect(const char *host, uint16_t port, int32_t timeoutMs);
+    using Client::write;
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return fd_ >= 0; }
+
+    uint32_t bytesSent() const { return sent_; }
+
+private:
+    bool fill();
+    int fd_ = -1;
+    uint8_t buf_[1024];
+    size_t head_ = 0, tail_ = 0;   // received, not yet read
+    uint32_t sent_ = 0;
+};
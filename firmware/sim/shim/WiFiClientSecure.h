@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// === Host shim of WiFiClientSecure ===
+// A socket on the HTTPS stand-in (sim_https.h). connected() is the client's
+// view: a keep-alive socket the server already closed still reads as
+// connected until the next request fails on it, as on the device.
+
+class WiFiClientSecure {
+public:
+    void setInsecure() {}
+    void setTimeout(uint32_t) {}
+    bool connected() const { return socket_ != 0; }
+    void stop();
+
+    // Stand-in side
+    uint32_t socket_ = 0;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+// === Host shim of esp_err ===
+typedef int esp_err_t;
+#define ESP_OK                   0
+#define ESP_FAIL                 -1
+#define ESP_ERR_INVALID_STATE    0x103
+#define ESP_ERR_TIMEOUT          0x107
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+// === Host shim of esp_timer ===
+// One-shot timers on the simulator's virtual clock. Callbacks fire from
+// sim_clock_advance_to() at their exact due time, in deadline order.
+
+typedef void (*esp_timer_cb_t)(void *arg);
+typedef struct sim_timer *esp_timer_handle_t;
+
+typedef enum {
+    ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+int64_t esp_timer_get_time();
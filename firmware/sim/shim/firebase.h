@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+#include "sensor_data.h"
+#include "commands.h"
+
+// === Cloud layer stand-in for the native simulator ===
+// The simulated controller runs offline: Firebase is not ready (unless a check
+// calls sim_cloud_set_ready()), so the rule engine takes its local-automation path.
+
+void pushLiveAndRelayState(const RealTimeData &data, const Commands &commands, const bool updatedSensors[6]);
+bool isFirebaseReady();
+bool isInitialCommandsSynced();
+
+// Store-and-forward uploads from telemetry_log (outbound_queue.h types);
+// defined by the check that plays Firestore (sim/checks/check_telemetry_outage.cpp).
+// No default argument: lib/firebase/relay_sync.cpp sees the real header too.
+enum OutboundResult : uint8_t;
+typedef void (*OutboundDoneFn)(OutboundResult result, const String &payload);
+bool pushBatchLogToFirestore(RealTimeData *buffer, int size, time_t timestamp, OutboundDoneFn onDone);
+
+// Defined by whichever harness feeds command events (see sim/mqtt_e2e)
+struct CommandPatchResult;
+void handleCommandPatch(const CommandPatchResult &patch, const char *source);
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+// === Host shim of the GPIO register block ===
+// Writes to out_w1ts / out_w1tc set / clear the simulated output levels.
+
+struct SimGpioReg {
+    bool set;
+    SimGpioReg &operator=(uint32_t mask);
+};
+
+struct gpio_dev_t {
+    SimGpioReg out_w1ts{true};
+    SimGpioReg out_w1tc{false};
+};
+
+extern gpio_dev_t GPIO;
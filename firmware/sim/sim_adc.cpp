@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <string.h>
+#include "sim_hal.h"
+
+#define SIM_ADC_RING_MAX   16384
+#define SIM_ADC_PATTERN    8
+
+// === Continuous ADC on the virtual clock ===
+static SimAdcSourceFn source = nullptr;
+static bool halted = false;
+
+static uint8_t ring[SIM_ADC_RING_MAX];
+static uint32_t ringSize = 0;
+static uint32_t head = 0, count = 0;   // head = oldest byte
+static bool overflow = false;
+static uint32_t dropped = 0;
+
+static uint8_t pattern[SIM_ADC_PATTERN];
+static uint32_t patternNum = 0;
+static uint32_t sampleFreqHz = 0;
+static bool running = false;
+static uint64_t startUs = 0;
+static uint64_t produced = 0;          // conversions since start (kept or dropped)
+
+void sim_adc_set_source(SimAdcSourceFn fn) {
+    source = fn;
+}
+
+void sim_adc_halt(bool h) {
+    halted = h;
+}
+
+uint32_t sim_adc_dropped() {
+    return dropped;
+}
+
+static void pushConversion(uint8_t channel, uint64_t us) {
+    if (count + SOC_ADC_DIGI_RESULT_BYTES > ringSize) {
+        overflow = true;
+        dropped++;
+        return;
+    }
+    adc_digi_output_data_t d;
+    d.val = 0;
+    d.type1.channel = channel;
+    d.type1.data = source ? source(channel, us) & 0xFFF : 0;
+    for (int i = 0; i < SOC_ADC_DIGI_RESULT_BYTES; i++) {
+        ring[(head + count) % ringSize] = ((const uint8_t *)&d.val)[i];
+        count++;
+    }
+}
+
+// Everything the controller converted up to now
+static void produce() {
+    if (!running || !sampleFreqHz || !patternNum) return;
+    uint64_t nowUs = sim_clock_now_us();
+    uint64_t due = (nowUs - startUs) * sampleFreqHz / 1000000ULL;
+    for (; produced < due; produced++) {
+        if (halted) continue;
+        uint64_t us = startUs + produced * 1000000ULL / sampleFreqHz;
+        pushConversion(pattern[produced % patternNum], us);
+    }
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *config) {
+    if (!config || config->max_store_buf_size > SIM_ADC_RING_MAX) return ESP_FAIL;
+    ringSize = config->max_store_buf_size;
+    head = count = 0;
+    overflow = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config) {
+    if (!config || config->pattern_num == 0 || config->pattern_num > SIM_ADC_PATTERN) return ESP_FAIL;
+    patternNum = config->pattern_num;
+    for (uint32_t i = 0; i < patternNum; i++) pattern[i] = config->adc_pattern[i].channel;
+    sampleFreqHz = config->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+    if (!ringSize) return ESP_ERR_INVALID_STATE;
+    head = count = 0;
+    overflow = false;
+    running = true;
+    startUs = sim_clock_now_us();
+    produced = 0;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+    produce();
+    running = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize() {
+    running = false;
+    ringSize = 0;
+    return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max, uint32_t *out_length, uint32_t) {
+    produce();
+    uint32_t n = length_max < count ? length_max : count;
+    n -= n % SOC_ADC_DIGI_RESULT_BYTES;
+    for (uint32_t i = 0; i < n; i++) buf[i] = ring[(head + i) % ringSize];
+    head = (head + n) % (ringSize ? ringSize : 1);
+    count -= n;
+    *out_length = n;
+
+    if (overflow) return ESP_ERR_INVALID_STATE;
+    return n ? ESP_OK : ESP_ERR_TIMEOUT;
+}
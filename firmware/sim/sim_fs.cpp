@@ -0,0 +1,129 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include "sim_hal.h"
+
+// === Flash file system on a host directory ===
+static std::string root = ".";
+
+struct SimFileImpl {
+    FILE *fp = nullptr;
+    DIR *dir = nullptr;
+    std::string hostPath;
+    std::string name;    // path as the firmware sees it
+
+    ~SimFileImpl() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+LittleFSFS LittleFS;
+
+void sim_fs_set_root(const char *dir) {
+    root = dir;
+}
+
+static std::string hostPath(const std::string &path) {
+    return root + (path.empty() || path[0] != '/' ? "/" : "") + path;
+}
+
+// === File ===
+File::operator bool() const {
+    return impl && (impl->fp || impl->dir);
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+    return impl && impl->fp ? fwrite(buf, 1, size, impl->fp) : 0;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+    return impl && impl->fp ? fread(buf, 1, size, impl->fp) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+    return impl && impl->fp && fseek(impl->fp, pos, SEEK_SET) == 0;
+}
+
+size_t File::size() const {
+    struct stat st;
+    if (!impl) return 0;
+    if (impl->fp) fflush(impl->fp);
+    return stat(impl->hostPath.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+const char *File::name() const {
+    return impl ? impl->name.c_str() : "";
+}
+
+File File::openNextFile() {
+    if (!impl || !impl->dir) return File();
+    for (struct dirent *e = readdir(impl->dir); e; e = readdir(impl->dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        return LittleFS.open(impl->name + "/" + e->d_name, "r");
+    }
+    return File();
+}
+
+void File::close() {
+    impl.reset();
+}
+
+// === FS ===
+bool LittleFSFS::begin(bool) {
+    ::mkdir(root.c_str(), 0755);
+    struct stat st;
+    return stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static size_t blocksUnder(const std::string &dir) {
+    size_t bytes = 0;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return 0;
+    for (struct dirent *e = readdir(d); e; e = readdir(d)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        std::string path = dir + "/" + e->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) bytes += 4096 + blocksUnder(path);
+        else bytes += (st.st_size + 4095) / 4096 * 4096;
+    }
+    closedir(d);
+    return bytes;
+}
+
+size_t LittleFSFS::usedBytes() {
+    return blocksUnder(root);
+}
+
+File fs::FS::open(const std::string &path, const char *mode) {
+    auto impl = std::make_shared<SimFileImpl>();
+    impl->hostPath = hostPath(path);
+    impl->name = path;
+
+    struct stat st;
+    if (!strcmp(mode, "r") && stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+    } else {
+        const char *hostMode = !strcmp(mode, "r") ? "rb" : !strcmp(mode, "r+") ? "r+b" : !strcmp(mode, "a") ? "ab" : "wb";
+        impl->fp = fopen(impl->hostPath.c_str(), hostMode);
+    }
+    return (impl->fp || impl->dir) ? File(impl) : File();
+}
+
+bool fs::FS::exists(const std::string &path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool fs::FS::remove(const std::string &path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool fs::FS::mkdir(const std::string &path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <chrono>
+#include <esp_timer.h>
+#include <soc/gpio_struct.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim_hal.h"
+
+#define SIM_PIN_COUNT    40
+#define SIM_MAX_TIMERS   8
+
+// === Virtual clock ===
+static uint64_t nowUs = 0;
+static time_t epochAtZero = 0;
+static bool realtime = false;
+static uint64_t realtimeBaseUs = 0;
+static std::chrono::steady_clock::time_point realtimeStart;
+
+struct sim_timer {
+    esp_timer_cb_t callback = nullptr;
+    void *arg = nullptr;
+    uint64_t dueUs = 0;
+    bool used = false;
+    bool armed = false;
+};
+
+static sim_timer timers[SIM_MAX_TIMERS];
+static int failStarts = 0;
+
+void sim_clock_reset(uint64_t startUs) {
+    nowUs = startUs;
+    for (auto &t : timers) t.armed = false;
+}
+
+uint64_t sim_clock_now_us() {
+    return nowUs;
+}
+
+static sim_timer *nextDue(uint64_t limitUs) {
+    sim_timer *next = nullptr;
+    for (auto &t : timers) {
+        if (!t.armed || t.dueUs > limitUs) continue;
+        if (!next || t.dueUs < next->dueUs) next = &t;
+    }
+    return next;
+}
+
+void sim_clock_advance_to(uint64_t targetUs, SimSegmentFn segment) {
+    // Callbacks may re-arm (dose pulse edges), so look again after each one
+    while (sim_timer *t = nextDue(targetUs)) {
+        if (t->dueUs > nowUs) {
+            if (segment) segment(nowUs, t->dueUs);
+            nowUs = t->dueUs;
+        }
+        t->armed = false;
+        t->callback(t->arg);
+    }
+
+    if (targetUs > nowUs) {
+        if (segment) segment(nowUs, targetUs);
+        nowUs = targetUs;
+    }
+}
+
+void sim_set_epoch(time_t epoch) {
+    epochAtZero = epoch;
+}
+
+time_t sim_epoch_now() {
+    return epochAtZero + (time_t)(nowUs / 1000000ULL);
+}
+
+void sim_clock_realtime(bool on) {
+    realtime = on;
+    realtimeBaseUs = nowUs;
+    realtimeStart = std::chrono::steady_clock::now();
+}
+
+static void followWall() {
+    if (!realtime) return;
+    auto elapsed = std::chrono::steady_clock::now() - realtimeStart;
+    nowUs = realtimeBaseUs + std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+unsigned long millis() { followWall(); return nowUs / 1000ULL; }
+unsigned long micros() { followWall(); return nowUs; }
+void delay(unsigned long ms) { sim_clock_advance_to(nowUs + ms * 1000ULL); }
+void yield() {}
+long random(long max) { return random(0, max); }
+long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+
+// === esp_timer ===
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    for (auto &t : timers) {
+        if (t.used) continue;
+        t = sim_timer();
+        t.used = true;
+        t.callback = args->callback;
+        t.arg = args->arg;
+        *out = &t;
+        return ESP_OK;
+    }
+    return ESP_FAIL;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs) {
+    if (!timer || timer->armed) return ESP_FAIL;
+    if (failStarts > 0) {
+        failStarts--;
+        return ESP_FAIL;
+    }
+    timer->dueUs = nowUs + timeoutUs;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+void sim_timer_fail_starts(int count) {
+    failStarts = count;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer || !timer->armed) return ESP_FAIL;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)nowUs;
+}
+
+// === Pins ===
+static uint8_t pinLevel[SIM_PIN_COUNT];
+gpio_dev_t GPIO;
+static uint32_t gpioWrites = 0;
+
+SimGpioReg &SimGpioReg::operator=(uint32_t mask) {
+    gpioWrites++;
+    for (int pin = 0; pin < 32; pin++) {
+        if (mask & (1u << pin)) pinLevel[pin] = set ? HIGH : LOW;
+    }
+    return *this;
+}
+
+uint32_t sim_gpio_writes() {
+    return gpioWrites;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < SIM_PIN_COUNT && mode == INPUT_PULLUP) pinLevel[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < SIM_PIN_COUNT) pinLevel[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < SIM_PIN_COUNT ? pinLevel[pin] : LOW;
+}
+
+void sim_pin_input(uint8_t pin, int level) {
+    if (pin < SIM_PIN_COUNT) pinLevel[pin] = level ? HIGH : LOW;
+}
+
+int sim_pin_output(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+// === Serial ===
+HardwareSerial Serial;
+
+size_t HardwareSerial::printf(const char *fmt, ...) {
+    if (!enabled) return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n > 0 ? n : 0;
+}
+
+size_t HardwareSerial::print(const char *s) {
+    if (!enabled) return 0;
+    fputs(s, stdout);
+    return strlen(s);
+}
+
+size_t HardwareSerial::println(const char *s) {
+    if (!enabled) return 0;
+    puts(s);
+    return strlen(s) + 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+// === Simulated hardware ===
+// Virtual clock behind millis()/micros()/esp_timer, an in-memory pin array
+// behind digitalRead()/digitalWrite()/GPIO, a host directory behind LittleFS,
+// and the wall-clock epoch used by the time_utils stand-in. Nothing advances
+// unless the simulator says so.
+
+// Called for every interval of virtual time during which no timer fired,
+// i.e. outputs were constant from `fromUs` up to `toUs`
+typedef void (*SimSegmentFn)(uint64_t fromUs, uint64_t toUs);
+
+void sim_clock_reset(uint64_t startUs);
+uint64_t sim_clock_now_us();
+
+// Real-time mode (network harnesses): millis()/micros() follow the host's
+// steady clock from here on instead of waiting for sim_clock_advance_to()
+void sim_clock_realtime(bool on);
+
+// Move the clock forward to `targetUs`, firing due esp_timer callbacks at
+// their exact deadlines (earliest first)
+void sim_clock_advance_to(uint64_t targetUs, SimSegmentFn segment = nullptr);
+
+// Make the next `count` esp_timer_start_once() calls fail (error-path checks)
+void sim_timer_fail_starts(int count);
+
+// Level seen by digitalRead() on an input pin
+void sim_pin_input(uint8_t pin, int level);
+// Level last driven on an output pin
+int sim_pin_output(uint8_t pin);
+// GPIO.out_w1ts / out_w1tc register writes so far
+uint32_t sim_gpio_writes();
+
+// Raw 12-bit value the continuous ADC driver converts on `channel` at `us`
+typedef uint16_t (*SimAdcSourceFn)(uint8_t channel, uint64_t us);
+void sim_adc_set_source(SimAdcSourceFn source);
+// Halted: the controller produces nothing (a stuck DMA)
+void sim_adc_halt(bool halted);
+// Conversions dropped because the driver ring was full
+uint32_t sim_adc_dropped();
+
+// Link state seen by wifi_is_up() (default down: the controller runs offline)
+void sim_wifi_set_up(bool up);
+// Firebase signed in with /commands synced (default no: the rules take their local path)
+void sim_cloud_set_ready(bool ready);
+// Every WiFiClient connect() goes to this address instead (a local broker or server)
+void sim_net_redirect(const char *host, uint16_t port);
+
+// Host directory behind LittleFS (default: the working directory)
+void sim_fs_set_root(const char *dir);
+
+// Unix time at virtual t = 0 (local time is fixed at UTC+8, like the device)
+void sim_set_epoch(time_t epochAtZero);
+time_t sim_epoch_now();
@@ -0,0 +1,89 @@
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <map>
+#include "sim_hal.h"
+#include "sim_https.h"
+
+// === Server side ===
+struct SimSocket {
+    unsigned long lastActivity = 0;
+};
+
+static SimHttpsConfig config;
+static SimHttpsStats stats;
+static std::map<uint32_t, SimSocket> sockets;   // open on the server
+static uint32_t nextSocket = 1;
+static int refuseCount = 0;
+
+void sim_https_reset(const SimHttpsConfig &c) {
+    config = c;
+    stats = SimHttpsStats();
+    sockets.clear();
+    refuseCount = 0;
+}
+
+void sim_https_refuse(int count) {
+    refuseCount = count;
+}
+
+const SimHttpsStats &sim_https_stats() {
+    return stats;
+}
+
+// Server-side idle timeout, applied lazily
+static bool serverOpen(uint32_t socket) {
+    auto it = sockets.find(socket);
+    if (it == sockets.end()) return false;
+    if (millis() - it->second.lastActivity >= config.serverIdleMs) {
+        sockets.erase(it);
+        return false;
+    }
+    return true;
+}
+
+// === WiFiClientSecure ===
+void WiFiClientSecure::stop() {
+    sockets.erase(socket_);
+    socket_ = 0;
+}
+
+// === HTTPClient ===
+bool HTTPClient::begin(WiFiClientSecure &client, const String &url) {
+    client_ = &client;
+    url_ = url;
+    return true;
+}
+
+int HTTPClient::sendRequest(const char *method, const String &payload) {
+    if (!client_->connected()) {
+        if (refuseCount > 0) {
+            refuseCount--;
+            stats.refused++;
+            delay(config.handshakeMs);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        delay(config.handshakeMs);
+        client_->socket_ = nextSocket++;
+        sockets[client_->socket_].lastActivity = millis();
+        stats.handshakes++;
+    } else if (!serverOpen(client_->socket_)) {
+        // The server closed this keep-alive socket; the write fails
+        stats.staleSends++;
+        client_->socket_ = 0;
+        return HTTPC_ERROR_CONNECTION_LOST;
+    }
+
+    delay(config.requestMs);
+    sockets[client_->socket_].lastActivity = millis();
+    stats.requests++;
+
+    response_ = "";
+    if (config.handler) return config.handler(method, url_, payload, response_);
+    return 200;
+}
+
+void HTTPClient::end() {
+    if (!reuse_ && client_) client_->stop();
+    client_ = nullptr;
+}
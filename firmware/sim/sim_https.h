@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+// === HTTPS stand-in server ===
+// What the WiFiClientSecure / HTTPClient shims talk to. Each new socket
+// costs a TLS handshake and each request a round trip on the virtual clock;
+// the server closes keep-alive sockets idle longer than its own timeout.
+
+// Answers one request; returns the HTTP status
+typedef int (*SimHttpsHandler)(const char *method, const String &url, const String &payload, String &response);
+
+struct SimHttpsConfig {
+    uint32_t handshakeMs = 1200;        // TCP + TLS setup on a new socket
+    uint32_t requestMs = 120;           // one request/response on an open socket
+    uint32_t serverIdleMs = 120000;     // server drops keep-alive sockets idle this long
+    SimHttpsHandler handler = nullptr;  // default: 200 with an empty body
+};
+
+struct SimHttpsStats {
+    uint32_t handshakes = 0;
+    uint32_t requests = 0;
+    uint32_t staleSends = 0;            // requests sent on a socket the server had closed
+    uint32_t refused = 0;
+};
+
+void sim_https_reset(const SimHttpsConfig &config);
+// Refuse the next `count` connection attempts
+void sim_https_refuse(int count);
+const SimHttpsStats &sim_https_stats();
@@ -0,0 +1,151 @@
+// TCP sockets behind the WiFiClient shim
+#include <WiFi.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include "sim_hal.h"
+
+static std::string redirectHost;
+static uint16_t redirectPort = 0;
+
+void sim_net_redirect(const char *host, uint16_t port) {
+    redirectHost = host ? host : "";
+    redirectPort = port;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    char host[16];
+    snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    return connect(host, port);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+    return connect(host, port, -1);
+}
+
+// Non-blocking connect, then wait up to timeoutMs (< 0: no limit) for it to finish
+static bool connectWithin(int fd, const sockaddr *addr, socklen_t len, int32_t timeoutMs) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    bool ok = ::connect(fd, addr, len) == 0;
+    if (!ok && errno == EINPROGRESS) {
+        pollfd p = {fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t errLen = sizeof(err);
+        ok = poll(&p, 1, timeoutMs < 0 ? -1 : timeoutMs) == 1 &&
+             getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 && err == 0;
+    }
+    fcntl(fd, F_SETFL, flags);
+    return ok;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    if (!redirectHost.empty()) {
+        host = redirectHost.c_str();
+        port = redirectPort;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &res) != 0) return 0;
+
+    for (addrinfo *a = res; a; a = a->ai_next) {
+        int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connectWithin(fd, a->ai_addr, a->ai_addrlen, timeoutMs)) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // lwIP default on the device
+            fd_ = fd;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+    head_ = tail_ = 0;
+    return fd_ >= 0;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+    if (fd_ < 0) return 0;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = send(fd_, buf + done, size - done, MSG_NOSIGNAL);
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        done += n;
+    }
+    sent_ += done;
+    return done;
+}
+
+// Pull whatever the socket has without blocking; false once the peer closed
+bool WiFiClient::fill() {
+    if (fd_ < 0) return false;
+    if (head_ == tail_) head_ = tail_ = 0;
+    if (tail_ == sizeof(buf_)) return true;
+    ssize_t n = recv(fd_, buf_ + tail_, sizeof(buf_) - tail_, MSG_DONTWAIT);
+    if (n > 0) tail_ += n;
+    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) return false;
+    return true;
+}
+
+int WiFiClient::available() {
+    if (head_ == tail_ && fd_ >= 0) {
+        // PubSubClient spins on available(); wait a little instead of burning a core
+        pollfd p = {fd_, POLLIN, 0};
+        poll(&p, 1, 1);
+        fill();
+    }
+    return (int)(tail_ - head_);
+}
+
+int WiFiClient::read() {
+    if (!available()) return -1;
+    return buf_[head_++];
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+    size_t n = 0;
+    while (n < size && available()) {
+        size_t chunk = tail_ - head_;
+        if (chunk > size - n) chunk = size - n;
+        memcpy(buf + n, buf_ + head_, chunk);
+        head_ += chunk;
+        n += chunk;
+    }
+    return n ? (int)n : -1;
+}
+
+int WiFiClient::peek() {
+    if (!available()) return -1;
+    return buf_[head_];
+}
+
+void WiFiClient::stop() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    head_ = tail_ = 0;
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd_ < 0) return 0;
+    if (head_ != tail_) return 1;
+    if (!fill()) {
+        close(fd_);
+        fd_ = -1;
+    }
+    return fd_ >= 0 || head_ != tail_;
+}
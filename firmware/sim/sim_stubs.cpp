@@ -0,0 +1,43 @@
+#include <Arduino.h>
+#include "firebase.h"
+#include "wifi_manager.h"
+#include "time_utils.h"
+#include "sim_hal.h"
+
+// === Globals the control libraries expect from src/main.cpp ===
+RealTimeData current;
+ActuatorState actuators;
+// Offline defaults (same as the firmware before Firebase is reachable): all AUTO, pH dosing on
+Commands currentCommands = {
+    {true,false}, {true,false}, {true,false},
+    {true,false}, {true,false}, {true,false},
+    {true,false}, {false,false, false}, {false,false, false}
+};
+unsigned long lastStreamUpdate = 0;
+unsigned long lastRelaySync = 0;
+volatile bool commandsChangedViaStream = false;
+
+// === Offline link / cloud ===
+static bool linkUp = false;
+static bool cloudReady = false;
+void sim_wifi_set_up(bool up) { linkUp = up; }
+void sim_cloud_set_ready(bool ready) { cloudReady = ready; }
+bool wifi_is_up() { return linkUp; }
+bool isFirebaseReady() { return cloudReady; }
+bool isInitialCommandsSynced() { return cloudReady; }
+// Weak: a check that links lib/firebase/relay_sync.cpp gets the real one
+__attribute__((weak)) void pushLiveAndRelayState(const RealTimeData &, const Commands &, const bool[6]) {}
+
+// === Time (SNTP "synced" from the first tick; local time is UTC+8) ===
+bool isTimeAvailable() {
+    return true;
+}
+
+time_t getUnixTime() {
+    return sim_epoch_now();
+}
+
+bool getLocalTm(struct tm &out) {
+    time_t local = sim_epoch_now() + 8 * 3600;
+    return gmtime_r(&local, &out) != nullptr;
+}
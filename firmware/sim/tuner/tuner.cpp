@@ -0,0 +1,206 @@
+// === Rule threshold tuner (PlatformIO `native_tuner` environment) ===
+// Sweeps a grid of rule thresholds, runs every combination closed-loop
+// against the plant model on all cores and prints the Pareto-optimal settings
+// for (relay cycles, hours out of band, energy). Lower is better on all three.
+//
+//   pio run -e native_tuner && .pio/build/native_tuner/program [options]
+//     --hours N      simulated hours per run (default 24)
+//     --step-ms N    control loop period in virtual ms (default 250)
+//     --seed N       sensor noise seed, shared by every run (default 1)
+//     --threads N    worker threads (default: all cores)
+//     --csv FILE     write every run's parameters and score
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "rule_engine.h"
+#include "logger.h"
+#include "tuner_run.h"
+#include "work_pool.h"
+
+// === Sweep grid ===
+// Off thresholds follow the on thresholds at a fixed hysteresis
+static const float FAN_ON_C[]         = { 28.5f, 29.1f, 30.0f };
+static const float COOLER_ON_C[]      = { 28.0f, 28.5f, 29.0f, 29.5f };
+static const float COOLER_BAND_C[]    = { 1.0f, 1.5f, 2.0f };
+static const float PH_LOW[]           = { 6.0f, 6.2f, 6.4f };
+static const uint8_t PH_PULSES[]      = { 1, 2, 3, 4 };
+static const unsigned PUMP_ON_MIN[]   = { 10, 15, 20 };
+static const unsigned PUMP_OFF_MIN[]  = { 30, 45, 60 };
+static const float DO_LOW[]           = { 3.5f, 4.0f, 4.5f, 5.0f };
+
+struct Candidate {
+    RuleParams params;
+    RunScore score;
+    bool baseline = false;
+};
+
+struct Sweep {
+    std::vector<Candidate> runs;
+    RunConfig config;
+};
+
+static void buildGrid(std::vector<Candidate> &out) {
+    // Job 0 is config.h as shipped, for reference
+    Candidate baseline;
+    baseline.baseline = true;
+    out.push_back(baseline);
+
+    for (float fanOn : FAN_ON_C)
+    for (float coolerOn : COOLER_ON_C)
+    for (float coolerBand : COOLER_BAND_C)
+    for (float phLow : PH_LOW)
+    for (uint8_t pulses : PH_PULSES)
+    for (unsigned pumpOn : PUMP_ON_MIN)
+    for (unsigned pumpOff : PUMP_OFF_MIN)
+    for (float doLow : DO_LOW) {
+        Candidate c;
+        RuleParams &p = c.params;
+        p.fanOnTemp = fanOn;
+        p.fanOffTemp = fanOn - (TEMP_ON_THRESHOLD - TEMP_OFF_THRESHOLD);
+        p.coolerOnTemp = coolerOn;
+        p.coolerOffTemp = coolerOn - coolerBand;
+        p.phLow = phLow;
+        p.phLowOff = phLow + (PH_LOW_OFF - PH_LOW_THRESHOLD);
+        p.phPulseCount = pulses;
+        p.pumpOnMs = pumpOn * 60 * 1000UL;
+        p.pumpOffMs = pumpOff * 60 * 1000UL;
+        p.doLow = doLow;
+        out.push_back(c);
+    }
+}
+
+static void runJob(size_t job, void *ctx) {
+    Sweep &sweep = *(Sweep *)ctx;
+    Candidate &c = sweep.runs[job];
+    c.score = tuner_run(c.params, sweep.config);
+}
+
+// One Pareto point; settings with an identical score are folded into `ties`
+struct FrontEntry {
+    size_t run;
+    uint32_t ties;
+};
+
+static bool sameScore(const RunScore &a, const RunScore &b) {
+    return a.cycles == b.cycles && a.outOfBandH == b.outOfBandH && a.energyWh == b.energyWh;
+}
+
+static bool dominates(const RunScore &a, const RunScore &b) {
+    bool noWorse = a.cycles <= b.cycles && a.outOfBandH <= b.outOfBandH && a.energyWh <= b.energyWh;
+    bool better = a.cycles < b.cycles || a.outOfBandH < b.outOfBandH || a.energyWh < b.energyWh;
+    return noWorse && better;
+}
+
+// Lexicographic pre-sort: a point can only be dominated by one sorted before it
+static std::vector<FrontEntry> paretoFront(const std::vector<Candidate> &runs) {
+    std::vector<size_t> order(runs.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const RunScore &x = runs[a].score, &y = runs[b].score;
+        if (x.energyWh != y.energyWh) return x.energyWh < y.energyWh;
+        if (x.outOfBandH != y.outOfBandH) return x.outOfBandH < y.outOfBandH;
+        return x.cycles < y.cycles;
+    });
+
+    std::vector<FrontEntry> front;
+    for (size_t i : order) {
+        bool dominated = false;
+        for (FrontEntry &f : front) {
+            if (sameScore(runs[f.run].score, runs[i].score)) {
+                f.ties++;
+                dominated = true;
+                break;
+            }
+            if (dominates(runs[f.run].score, runs[i].score)) {
+                dominated = true;
+                break;
+            }
+        }
+        if (!dominated) front.push_back({i, 0});
+    }
+    return front;
+}
+
+static void printHeader() {
+    printf("%7s %8s %9s | %6s %6s %7s %5s %6s %4s %4s %4s %5s\n",
+           "cycles", "oob [h]", "energy", "fanOn", "coolOn", "coolOff", "phLow", "pulses",
+           "pOn", "pOff", "doLo", "ties");
+}
+
+static void printRow(const Candidate &c, uint32_t ties) {
+    const RuleParams &p = c.params;
+    printf("%7lu %8.2f %7.0fWh | %6.1f %6.1f %7.1f %5.2f %6u %4lu %4lu %4.1f %5lu%s\n",
+           (unsigned long)c.score.cycles, c.score.outOfBandH, c.score.energyWh,
+           p.fanOnTemp, p.coolerOnTemp, p.coolerOffTemp, p.phLow, (unsigned)p.phPulseCount,
+           p.pumpOnMs / 60000UL, p.pumpOffMs / 60000UL, p.doLow, (unsigned long)ties,
+           c.baseline ? "  (config.h)" : "");
+}
+
+static bool writeCsv(const char *path, const std::vector<Candidate> &runs) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fprintf(f, "fanOn,coolerOn,coolerOff,phLow,phPulses,pumpOnMin,pumpOffMin,doLow,cycles,outOfBandH,energyWh\n");
+    for (const auto &c : runs) {
+        const RuleParams &p = c.params;
+        fprintf(f, "%.2f,%.2f,%.2f,%.2f,%u,%lu,%lu,%.2f,%lu,%.3f,%.1f\n",
+                p.fanOnTemp, p.coolerOnTemp, p.coolerOffTemp, p.phLow, (unsigned)p.phPulseCount,
+                p.pumpOnMs / 60000UL, p.pumpOffMs / 60000UL, p.doLow,
+                (unsigned long)c.score.cycles, c.score.outOfBandH, c.score.energyWh);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Sweep sweep;
+    unsigned threads = 0;
+    const char *csvPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--hours") && hasValue) sweep.config.hours = atof(argv[++i]);
+        else if (!strcmp(arg, "--step-ms") && hasValue) sweep.config.stepMs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--seed") && hasValue) sweep.config.seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--threads") && hasValue) threads = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--csv") && hasValue) csvPath = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--hours N] [--step-ms N] [--seed N] [--threads N] [--csv FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (sweep.config.hours <= 0 || sweep.config.stepMs == 0) return 2;
+
+    log_set_level_all(LOG_LEVEL_NONE);   // engines run in parallel; nothing reads their log
+    buildGrid(sweep.runs);
+    printf("Sweeping %zu threshold sets × %.0f h ...\n", sweep.runs.size(), sweep.config.hours);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    WorkPoolStats pool = work_pool_run(sweep.runs.size(), threads, runJob, &sweep);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+    printf("%lu runs on %lu threads in %.1f s (%lu stolen, %.0f simulated h per wall-second)\n\n",
+           (unsigned long)pool.executed, (unsigned long)pool.threads, wall.count(),
+           (unsigned long)pool.stolen, sweep.runs.size() * sweep.config.hours / wall.count());
+
+    std::vector<FrontEntry> front = paretoFront(sweep.runs);
+    printf("=== Pareto front: %zu scores (sorted by energy; ties = other settings scoring the same) ===\n",
+           front.size());
+    printHeader();
+    for (const FrontEntry &f : front) printRow(sweep.runs[f.run], f.ties);
+
+    printf("\n=== Shipped config.h ===\n");
+    printHeader();
+    printRow(sweep.runs[0], 0);
+
+    if (csvPath && !writeCsv(csvPath, sweep.runs)) return 1;
+    return 0;
+}
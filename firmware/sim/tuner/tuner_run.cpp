@@ -0,0 +1,199 @@
+#include <Arduino.h>
+#include "config.h"
+#include "ph_dosing.h"
+#include "plant.h"
+#include "relay_control.h"
+#include "tuner_run.h"
+
+#define RUN_EPOCH          1748707200L   // 2025-06-01 00:00 PHT
+#define RUN_SENSOR_MS      2000UL
+
+// Target bands the score is measured against (deliberately not the tuned thresholds)
+#define BAND_WATER_MIN_C   22.0f
+#define BAND_WATER_MAX_C   29.0f
+#define BAND_PH_MIN        6.4f
+#define BAND_PH_MAX        7.6f
+#define BAND_DO_MIN        5.0f
+
+// Nominal load per relay (W), RelayId order
+static const float LOAD_W[RELAY_COUNT] = {
+    25,    // fan
+    45,    // light
+    40,    // pump
+    5,     // valve
+    150,   // cooler
+    300,   // heater
+    4, 4,  // pH pumps
+    40,    // drain pump
+    5, 5,  // sump flush / drain valves
+};
+
+// === Per-run hardware ===
+struct Run {
+    uint64_t nowUs = 0;
+    RelayBank relays;               // the driver's hold rules, without the pins
+
+    PhDoseState dose;
+    bool doseActive = false;
+    bool doseCompleted = false;
+    uint64_t nextEdgeUs = 0;
+
+    PlantState plant;
+    PlantParams plantParams;
+    double startHour = 0;
+    RunScore score;
+};
+
+static void setRelay(void *ctx, RelayId id, bool on) {
+    relay_bank_set(((Run *)ctx)->relays, id, on);
+}
+
+static void commit(Run &run, uint16_t mask) {
+    uint16_t written = relay_bank_commit(run.relays, run.nowUs / 1000ULL, mask);
+    run.score.cycles += __builtin_popcount(written & run.relays.committed);
+}
+
+// Dose pulse edges are committed immediately, like the esp_timer callback does
+static void applyDoseOutputs(Run &run) {
+    bool up = run.dose.up && run.dose.pumpOn;
+    bool down = !run.dose.up && run.dose.pumpOn;
+    relay_bank_set(run.relays, RELAY_PH_RAISING, up);
+    relay_bank_set(run.relays, RELAY_PH_LOWERING, down);
+    commit(run, RELAY_MASK_PH);
+}
+
+static bool doseStart(void *ctx, bool up, uint8_t pulses, uint32_t pulseMs, uint32_t gapMs) {
+    Run &run = *(Run *)ctx;
+    if (run.doseActive || pulses == 0) return false;
+    ph_dose_begin(run.dose, up, pulses, pulseMs, gapMs);
+    run.doseActive = true;
+    run.doseCompleted = false;
+    run.nextEdgeUs = run.nowUs + 1;
+    return true;
+}
+
+static void doseCancel(void *ctx) {
+    Run &run = *(Run *)ctx;
+    run.doseActive = false;
+    run.doseCompleted = false;
+    run.dose.pumpOn = false;
+    run.dose.pulsesLeft = 0;
+    applyDoseOutputs(run);
+}
+
+static bool doseBusy(void *ctx) {
+    return ((Run *)ctx)->doseActive;
+}
+
+static bool doseTakeCompleted(void *ctx) {
+    Run &run = *(Run *)ctx;
+    bool completed = run.doseCompleted;
+    run.doseCompleted = false;
+    return completed;
+}
+
+static bool localTime(void *ctx, struct tm &out) {
+    const Run &run = *(const Run *)ctx;
+    time_t local = RUN_EPOCH + (time_t)(run.startHour * 3600.0) + (time_t)(run.nowUs / 1000000ULL) + 8 * 3600;
+    return gmtime_r(&local, &out) != nullptr;
+}
+
+// === Plant integration and scoring ===
+static void integrate(Run &run, uint64_t toUs) {
+    if (toUs <= run.nowUs) return;
+    uint64_t dtUs = toUs - run.nowUs;
+    float dtH = dtUs / 3.6e9f;
+    uint16_t relays = run.relays.committed;
+
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (relays & RELAY_BIT(i)) run.score.energyWh += LOAD_W[i] * dtH;
+    }
+    if (relays & RELAY_BIT(RELAY_PH_RAISING)) plant_dose(run.plant, run.plantParams, true, dtUs);
+    if (relays & RELAY_BIT(RELAY_PH_LOWERING)) plant_dose(run.plant, run.plantParams, false, dtUs);
+
+    double hourOfDay = fmod(run.startHour + run.nowUs / 3.6e9, 24.0);
+    plant_step(run.plant, run.plantParams, dtUs / 1e6f, relays, (float)hourOfDay);
+
+    const PlantState &p = run.plant;
+    if (p.waterTemp < BAND_WATER_MIN_C || p.waterTemp > BAND_WATER_MAX_C) run.score.outOfBandH += dtH;
+    if (p.pH < BAND_PH_MIN || p.pH > BAND_PH_MAX) run.score.outOfBandH += dtH;
+    if (p.dissolvedOxygen < BAND_DO_MIN) run.score.outOfBandH += dtH;
+
+    run.nowUs = toUs;
+}
+
+// Advance to `targetUs`, stepping the dose sequencer at its exact edges
+static void advance(Run &run, uint64_t targetUs) {
+    while (run.doseActive && run.nextEdgeUs <= targetUs) {
+        integrate(run, run.nextEdgeUs);
+        uint32_t nextUs = ph_dose_step(run.dose);
+        applyDoseOutputs(run);
+        if (nextUs == 0) {
+            run.doseActive = false;
+            run.doseCompleted = true;
+        } else {
+            run.nextEdgeUs = run.nowUs + nextUs;
+        }
+    }
+    integrate(run, targetUs);
+}
+
+RunScore tuner_run(const RuleParams &params, const RunConfig &config) {
+    Run run;
+    run.startHour = config.startHour;
+    plant_init(run.plant, config.seed);
+
+    RuleIo io;
+    io.ctx = &run;
+    io.setRelay = setRelay;
+    io.doseStart = doseStart;
+    io.doseCancel = doseCancel;
+    io.doseBusy = doseBusy;
+    io.doseTakeCompleted = doseTakeCompleted;
+    io.localTime = localTime;
+    RuleEngine engine(io, params);
+
+    // Offline defaults: all AUTO, pH dosing on
+    Commands commands = {
+        {true,false}, {true,false}, {true,false},
+        {true,false}, {true,false}, {true,false},
+        {true,false}, {false,false, false}, {false,false, false}
+    };
+    ActuatorState actuators;
+    RealTimeData data;
+
+    uint64_t stepUs = config.stepMs * 1000ULL;
+    uint64_t endUs = (uint64_t)(config.hours * 3.6e9);
+    unsigned long lastSensor = 0, lastTick = 0;
+    bool first = true, prevFloatLow = false;
+
+    for (uint64_t t = 0; t < endUs; t += stepUs) {
+        advance(run, t);
+        unsigned long now = t / 1000ULL;
+
+        bool sensorsUpdated = first || now - lastSensor >= RUN_SENSOR_MS;
+        if (sensorsUpdated) {
+            plant_read_sensors(run.plant, run.plantParams, data);
+            lastSensor = now;
+        }
+
+        bool floatLow = plant_sump_level(run.plant, run.plantParams) < run.plantParams.floatLowLevel;
+        bool floatEvent = floatLow && !prevFloatLow;
+        prevFloatLow = floatLow;
+        data.floatTriggered = floatLow;
+
+        checkpHPumpLogic(engine, actuators, data.pH, now);
+
+        bool tick = first || now - lastTick >= RULES_TICK_MS;
+        if (tick) lastTick = now;
+        if (sensorsUpdated || floatEvent || tick) {
+            applyRulesWithModeControl(engine, data, actuators, commands, now);
+        }
+
+        commit(run, RELAY_MASK_ALL);
+        first = false;
+    }
+    advance(run, endUs);
+
+    return run.score;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include "rule_engine.h"
+
+// === One closed-loop run for the tuner ===
+// Self-contained (own rule engine, plant, relays and dose sequencer, no
+// globals), so any number of runs can execute in parallel.
+
+struct RunConfig {
+    double hours = 24.0;
+    unsigned long stepMs = 250;
+    double startHour = 6.0;
+    uint32_t seed = 1;
+};
+
+struct RunScore {
+    uint32_t cycles = 0;          // relay OFF→ON transitions, dose pulses included
+    float outOfBandH = 0;         // summed hours of water temp / pH / DO outside the target bands
+    float energyWh = 0;           // relay on-time × nominal load
+};
+
+RunScore tuner_run(const RuleParams &params, const RunConfig &config);
@@ -0,0 +1,74 @@
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "work_pool.h"
+
+struct Worker {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+};
+
+static bool popOwn(Worker &w, size_t &job) {
+    std::lock_guard<std::mutex> guard(w.lock);
+    if (w.jobs.empty()) return false;
+    job = w.jobs.back();
+    w.jobs.pop_back();
+    return true;
+}
+
+static bool steal(Worker &victim, size_t &job) {
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (victim.jobs.empty()) return false;
+    job = victim.jobs.front();
+    victim.jobs.pop_front();
+    return true;
+}
+
+WorkPoolStats work_pool_run(size_t count, unsigned threads, WorkFn fn, void *ctx) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > count && count > 0) threads = count;
+
+    std::vector<Worker> workers(threads);
+    for (unsigned t = 0; t < threads; t++) {
+        size_t begin = count * t / threads;
+        size_t end = count * (t + 1) / threads;
+        for (size_t j = begin; j < end; j++) workers[t].jobs.push_back(j);
+    }
+
+    // No job spawns new jobs, so one empty sweep over every deque means done
+    std::atomic<uint64_t> executed{0}, stolen{0};
+    auto run = [&](unsigned self) {
+        size_t job;
+        for (;;) {
+            if (popOwn(workers[self], job)) {
+                fn(job, ctx);
+                executed++;
+                continue;
+            }
+
+            bool found = false;
+            for (unsigned k = 1; k < threads && !found; k++) {
+                found = steal(workers[(self + k) % threads], job);
+            }
+            if (!found) return;
+
+            fn(job, ctx);
+            executed++;
+            stolen++;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(run, t);
+    run(0);
+    for (auto &th : pool) th.join();
+
+    WorkPoolStats stats;
+    stats.threads = threads;
+    stats.executed = executed;
+    stats.stolen = stolen;
+    return stats;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// === Work-stealing job pool ===
+// Jobs 0..count-1 are dealt out to per-worker deques in contiguous chunks.
+// Each worker pops from the back of its own deque and, once empty, steals
+// from the front of the others, so uneven job costs still keep every core busy.
+
+typedef void (*WorkFn)(size_t job, void *ctx);
+
+struct WorkPoolStats {
+    uint32_t threads = 0;
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+};
+
+// Runs every job and returns when all have finished. threads = 0 → all cores.
+WorkPoolStats work_pool_run(size_t count, unsigned threads, WorkFn fn, void *ctx);
@@ -8,11 +8,27 @@
 #include "turbidity_sensor.h"
 #include "dht_sensor.h"
 #include "float_switch.h"
+#include "adc_stream.h"
+#include "ph_dosing.h"
+#include "relay_control.h"
 #include "sensor_data.h"
 #include "rule_engine.h"
 #include "lcd_display.h"
 #include "firebase.h"
+#include "http_pool.h"
+#include "outbound_queue.h"
+#include "command_trace.h"
+#include "mqtt_transport.h"
+#include "telemetry_log.h"
 #include "time_utils.h"
+#include "spsc_ring.h"
+#include "scheduler.h"
+#include "loop_profiler.h"
+#include "wifi_manager.h"
+#include "control_state.h"
+#include "boot_profiler.h"
+#include "trace_recorder.h"
+#include "logger.h"
 
 // === CONSTANTS ===
 #define USE_DHT_MOCK false
@@ -38,105 +54,145 @@ Commands currentCommands = {
     {false, false, false}  // sump cleaning (startClean, cancelClean, inProgress)
 };
 
+// === SENSOR ACQUISITION TASK ===
+static SpscRing<SensorSample, SENSOR_RING_SIZE> sensorRing;
+static volatile uint32_t sensorSamplesDropped = 0;
+static TaskHandle_t sensorTaskHandle = nullptr;
+
 // === FLAGS & TIMERS ===
 volatile bool commandsChangedViaStream = false;
+static bool rulesTickDue = false;
+static bool commandsRestored = false;   // last /commands loaded from NVS at boot
 unsigned long lastStreamUpdate = 0;
 unsigned long lastRelaySync = 0;
 
 // === FORWARD DECLARATIONS ===
 void initAllModules();
+void initSensorDrivers();
+void registerJobs();
+unsigned long controlCycle(unsigned long nowMillis);
 bool readSensorsMultiInterval(unsigned long now, RealTimeData &data, bool updatedSensors[5]);
-void connectWiFi();
+void startSensorTask();
+bool drainSensorSamples(RealTimeData &data, bool updatedSensors[5]);
 float read_ph_mock();
 float read_do_mock();
 
 // === UTILS ===
 void displaySensorReading(const char* label, float value, const char* unit) {
-    Serial.printf("[SENSOR] %s = %.2f %s\n", label, value, unit);
+    LOGD(SENSOR, "%s = %.2f %s", label, value, unit);
 }
 
-void connectWiFi() {
-    Serial.print("Connecting to WiFi...");
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        yield();
-        Serial.print(".");
-        attempts++;
-    }
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println(" connected.");
-    } else {
-        Serial.println(" failed. Continuing without WiFi.");
-    }
+// Link-up: start background SNTP (Firebase is notified separately)
+void onWiFiLink(bool up) {
+    if (up) boot_milestone(BOOT_WIFI_UP);
+    if (!up || isTimeAvailable()) return;
+
+    Serial.println("🕐 Starting NTP time sync — schedule-based actions suspended until time available");
+    startTimeSync();
 }
 
 // === SETUP ===
 void setup() {
     Serial.begin(115200);
-    delay(1000);
+    log_init();   // LOG* lines leave the loop through the drain task from here on
 
     Serial.println("🚀 AquaBell System Starting...");
     analogReadResolution(12);
     analogSetAttenuation(ADC_11db);
 
-    initAllModules();
-    connectWiFi();
+    // Outputs first so every relay is in a known state
+    {
+        BOOT_STAGE("relays");
+        relay_control_init();
+        ph_dosing_init();
+        float_switch_init();
+    }
 
-    if (WiFi.status() == WL_CONNECTED) {
-        firebaseSignIn();
+    // Association runs in the background while the rest initializes;
+    // Firebase and NTP start on link-up
+    {
+        BOOT_STAGE("wifi");
+        wifi_on_link_change(firebase_on_wifi);
+        wifi_on_link_change(onWiFiLink);
+        wifi_manager_begin();
+    }
 
-        Serial.println("🔥 Starting Firebase RTDB stream...");
-        startFirebaseStream();
+    // Sensor drivers initialize on the sensor task (core 0) in parallel
+    startSensorTask();
 
-        Serial.println("🕐 Initializing NTP time sync...");
-        bool timeSyncSuccess = syncTimeOncePerBoot(10000);
-        if (timeSyncSuccess) {
-            Serial.println("✅ Time sync successful - schedule-based actions enabled");
-        } else {
-            Serial.println("⚠️ Time sync failed - schedule-based actions suspended until time available");
-        }
+    // Resume control from the last known state; Firebase reconciles once the stream is up
+    {
+        BOOT_STAGE("nvs");
+        commandsRestored = control_state_load_commands(currentCommands);
+        RuleCheckpoint checkpoint;
+        if (control_state_restore(checkpoint)) rule_engine_restore(deviceRules, actuators, currentCommands, checkpoint, millis());
     }
 
+    initAllModules();
+    registerJobs();
+
     Serial.println("✅ System initialization complete.");
 }
 
 // === MAIN LOOP ===
 void loop() {
-    unsigned long nowMillis = millis();
-
-    // === Handle WiFi reconnect ===
-    if (WiFi.status() != WL_CONNECTED) {
-        static unsigned long lastWiFiAttempt = 0;
-        if (nowMillis - lastWiFiAttempt >= 30000) {
-            Serial.println("📡 WiFi reconnecting...");
-            WiFi.reconnect();
-            lastWiFiAttempt = nowMillis;
-        }
+    unsigned long idleMs;
+    {
+        PROF_SCOPE(PROF_LOOP);
+        idleMs = controlCycle(millis());
     }
 
-    // === Refresh Firebase token periodically ===
-    if (WiFi.status() == WL_CONNECTED) {
-        safeTokenRefresh(); // ✅ Non-blocking, auto-handles expiry and re-sign-in
-    }
+    // Sleep until the next job is due (bounded so stream/MQTT/sensor ring stay responsive)
+    if (idleMs > 0 && outbound_depth() == 0) delay(min(idleMs, (unsigned long)LOOP_IDLE_MAX_MS));
+    else yield();
+}
 
-    // === Periodic NTP Time Sync ===
-    periodicTimeSync();
+// One pass of the control loop; returns ms until the next scheduled job
+unsigned long controlCycle(unsigned long nowMillis) {
+    // === WiFi state machine (reconnects + link events) ===
+    wifi_manager_loop(nowMillis);
+
+    // === Scheduled jobs (token, NTP, rules tick, backfill, stats) ===
+    unsigned long idleMs;
+    {
+        PROF_SCOPE(PROF_SCHED);
+        idleMs = sched_run(nowMillis);
+    }
 
     // === Handle Firebase Stream ===
-    if (WiFi.status() == WL_CONNECTED) {
+    if (wifi_is_up()) {
+        PROF_SCOPE(PROF_STREAM);
         handleFirebaseStream();
     }
 
+    // === MQTT Transport (optional) ===
+    if (MQTT_ENABLED) {
+        PROF_SCOPE(PROF_MQTT);
+        mqtt_transport_loop(nowMillis);
+    }
+
     // === Read Sensors ===
     bool updatedSensors[5] = {false, false, false, false, false}; // waterTemp, pH, DO, turbidity, airTemp/humidity
-    bool sensorsUpdated = readSensorsMultiInterval(nowMillis, current, updatedSensors);
+    bool sensorsUpdated;
+    if (sensorTaskHandle) {
+        PROF_SCOPE(PROF_SENSOR_DRAIN);
+        sensorsUpdated = drainSensorSamples(current, updatedSensors);
+    } else {
+        PROF_SCOPE(PROF_SENSOR_READ);
+        sensorsUpdated = readSensorsMultiInterval(nowMillis, current, updatedSensors);
+    }
+    if (sensorsUpdated) boot_milestone(BOOT_FIRST_SENSOR_READING);
 
     // Push to RTDB if any sensor updated
     if (sensorsUpdated) {
-        pushToRTDBLive(current, updatedSensors);
-        lcd_display(current); // only update display if something changed
+        {
+            PROF_SCOPE(PROF_PUSH);
+            bool viaMqtt = MQTT_ENABLED && mqtt_transport_connected();
+            if (viaMqtt) mqtt_publish_live(current, updatedSensors);
+            if (!viaMqtt || !MQTT_TELEMETRY_ONLY) pushToRTDBLive(current, updatedSensors);
+        }
+        PROF_SCOPE(PROF_LCD);
+        lcd_display(current); // only changed cells reach the display
     }
     
     bool floatEvent = is_float_switch_triggered(); // check float switch state
@@ -144,22 +200,31 @@ void loop() {
     current.floatTriggered = currentFloatState; // update data struct
 
     // ===== pH PUMP LOGIC - Always runs independently, no Firebase dependency =====
-    // Must run every loop iteration for non-blocking timing control
-    checkpHPumpLogic(actuators, current.pH, nowMillis);
-    current.relayStates.phRaising = actuators.phRaising;
-    current.relayStates.phLowering = actuators.phLowering;
+    // Must run every loop iteration; dose pulses themselves run on the dosing timer
+    {
+        PROF_SCOPE(PROF_PH);
+        if (TRACE_ENABLED) trace_rec_pass_begin();
+        checkpHPumpLogic(deviceRules, actuators, current.pH, nowMillis);
+    }
+    current.relayStates.phRaising = relay_is_on(RELAY_PH_RAISING);   // physical pulse state
+    current.relayStates.phLowering = relay_is_on(RELAY_PH_LOWERING);
+
+    // Rules run on every event and at least every RULES_TICK_MS
+    bool eventDriven = sensorsUpdated || commandsChangedViaStream || floatEvent;
+    bool rulesTick = rulesTickDue;
+    rulesTickDue = false;
+    TraceRules traceRules = TRACE_RULES_NONE;
 
-    // Update LCD
-    if (sensorsUpdated || commandsChangedViaStream || floatEvent) {
-        lcd_display(current);
+    if (eventDriven || rulesTick) {
+        uint16_t relaysBefore = current.relayStates.bits;
 
-        bool wifiUp = (WiFi.status() == WL_CONNECTED);
+        bool wifiUp = wifi_is_up();
         bool fbReady = isFirebaseReady();
         bool cmdsSynced = isInitialCommandsSynced();
 
-        // === Gate logic: wait until Firebase ready ===
-        if (wifiUp && (!fbReady || !cmdsSynced)) {
-            Serial.println("[MAIN] Firebase not ready — holding actuators OFF");
+        // === Gate logic: without restored commands, wait until Firebase ready ===
+        if (wifiUp && (!fbReady || !cmdsSynced) && !commandsRestored) {
+            LOGD(MAIN, "Firebase not ready — holding actuators OFF");
             actuators.fan = false;
             actuators.light = false;
             actuators.pump = false;
@@ -167,41 +232,48 @@ void loop() {
             actuators.cooler = false;
             actuators.heater = false;
             commandsChangedViaStream = false;
+            traceRules = TRACE_RULES_HOLD;
         } else {
             // === Automation & Manual Control ===
-            if (wifiUp) {
-                applyRulesWithModeControl(current, actuators, currentCommands, nowMillis);
-            } else {
-                Commands defaultAuto = {
-                    {true,false}, {true,false}, {true,false},
-                    {true,false}, {true,false}, {true,false},
-                    {true,false}, {false,false, false}, {false,false, false}
-                };
-                applyRulesWithModeControl(current, actuators, defaultAuto, nowMillis);
+            {
+                PROF_SCOPE(PROF_RULES);
+                if (wifiUp || commandsRestored) {
+                    applyRulesWithModeControl(deviceRules, current, actuators, currentCommands, nowMillis);
+                    traceRules = TRACE_RULES_APPLY;
+                } else {
+                    Commands defaultAuto = {
+                        {true,false}, {true,false}, {true,false},
+                        {true,false}, {true,false}, {true,false},
+                        {true,false}, {false,false, false}, {false,false, false}
+                    };
+                    applyRulesWithModeControl(deviceRules, current, actuators, defaultAuto, nowMillis);
+                    traceRules = TRACE_RULES_DEFAULT;
+                }
+                boot_milestone(BOOT_FIRST_CONTROL_DECISION);
+
+                // === Reflect relay states ===
+                reflect_actuator_relays(current, actuators);
+                // pH pump states already reflected above (runs independently)
             }
 
-            // === Reflect relay states ===
-            current.relayStates.fan       = actuators.fan;
-            current.relayStates.light     = actuators.light;
-            current.relayStates.waterPump = actuators.pump;
-            current.relayStates.valve     = actuators.valve;
-            current.relayStates.cooler = actuators.cooler;
-            current.relayStates.heater = actuators.heater;
-            // pH pump states already reflected above (runs independently)
-
-            // === Sync to Firebase if ready ===
-            if (wifiUp && fbReady && cmdsSynced) {
+            PROF_SCOPE(PROF_PUSH);
+
+            // Relay deltas go out on the persistent MQTT connection immediately
+            if (MQTT_ENABLED) mqtt_publish_relays(current);
+
+            // === Sync to Firebase if ready (periodic ticks only when a relay changed) ===
+            bool relaysChanged = current.relayStates.bits != relaysBefore;
+            if (wifiUp && fbReady && cmdsSynced && (eventDriven || relaysChanged)) {
                 bool debounceExpired = (millis() - lastStreamUpdate > 5000);
                 bool cooldownExpired = (millis() - lastRelaySync > RELAY_SYNC_COOLDOWN);
 
                 if (debounceExpired && cooldownExpired) {
-                    syncRelayState(current, currentCommands);
-                    // Use empty array if no sensors updated (for relay state sync only)
+                    // Relay state + live timestamp in one request
                     bool emptySensors[6] = {false, false, false, false, false, false};
-                    pushToRTDBLive(current, emptySensors);
+                    pushLiveAndRelayState(current, currentCommands, emptySensors);
                     lastRelaySync = millis();
                 } else {
-                    Serial.println("[MAIN] Skipping sync — debounce/cooldown active");
+                    LOGD(MAIN, "Skipping sync — debounce/cooldown active");
                 }
             }
 
@@ -209,54 +281,130 @@ void loop() {
         }
     }
 
-    // === Retry Handling ===
-    if (isRetryInProgress()) processRetry();
+    if (TRACE_ENABLED) trace_rec_pass(nowMillis, traceRules);
 
-    // === Batch Firestore Logging ===
-    static RealTimeData logBuffer[60];
-    static int logIndex = 0;
-    static unsigned long lastBatchLog = 0;
-    const unsigned long batchInterval = 600000;
+    // === Relay Commit (changed relays written in one GPIO update) ===
+    relay_commit(millis());
+    cmd_trace_poll(relay_pending_mask(), millis());
+    if (TRACE_ENABLED) trace_rec_relays(millis());
 
-    if (WiFi.status() == WL_CONNECTED) {
-        if (sensorsUpdated && logIndex < 60)
-            logBuffer[logIndex++] = current;
+    // === Outbound Queue (one request per iteration) ===
+    {
+        PROF_SCOPE(PROF_NETWORK);
+        processOutboundQueue();
+    }
 
-        bool intervalElapsed = (nowMillis - lastBatchLog >= batchInterval);
-        bool bufferFull = (logIndex >= 60);
+    // === Telemetry Log (flash store-and-forward → Firestore) ===
+    if (sensorsUpdated) {
+        PROF_SCOPE(PROF_TLOG);
+        telemetry_log_append(current, getUnixTime());
+    }
 
-        if ((intervalElapsed || bufferFull) && logIndex > 0) {
-            time_t timestamp = getUnixTime();
-            if (timestamp > 0) {
-                bool success = pushBatchLogToFirestore(logBuffer, logIndex, timestamp);
-                if (success) {
-                    logIndex = 0; // ✅ Only clear after success
-                } else {
-                    Serial.println("[Firestore] Retaining batch for next retry");
-                }
-            }
-            lastBatchLog = nowMillis;
-        }
+    // === Control Trace (flush / rollover / serial dump) ===
+    if (TRACE_ENABLED) trace_recorder_loop(nowMillis);
+
+    return idleMs;
+}
+
+// === SCHEDULED JOBS ===
+static void jobTokenRefresh(unsigned long) {
+    if (wifi_is_up()) {
+        safeTokenRefresh(); // ✅ Non-blocking, auto-handles expiry and re-sign-in
     }
+}
+
+static void jobTimeSync(unsigned long) {
+    periodicTimeSync();
+}
+
+static void jobRulesTick(unsigned long) {
+    rulesTickDue = true;
+}
 
-    yield();
+static void jobTelemetryBackfill(unsigned long now) {
+    telemetry_log_backfill(now, getUnixTime());
+}
+
+static void jobCheckpoint(unsigned long now) {
+    RuleCheckpoint checkpoint;
+    rule_engine_checkpoint(deviceRules, actuators, checkpoint, now);
+    control_state_checkpoint(checkpoint);
+    control_state_save_commands(currentCommands);
+}
+
+static void jobBootReport(unsigned long) {
+    boot_log_report();
+    JsonDocument doc;
+    boot_to_json(doc);
+    pushDiagnostics("boot", doc);
+}
+
+static void jobLogStats(unsigned long) {
+    wifi_log_stats();
+    telemetry_log_log_stats();
+    relay_log_stats();
+    if (ADC_DMA_ENABLED) adc_stream_log_stats();
+    lcd_log_stats();
+    http_pool_log_stats();
+    outbound_log_metrics();
+    if (MQTT_ENABLED) mqtt_log_stats();
+    cmd_trace_log_stats();
+    if (TRACE_ENABLED) trace_recorder_log_stats();
+    sched_log_stats();
+    log_log_stats();
+    loop_prof_log();
+}
+
+static void jobUploadProfile(unsigned long) {
+    JsonDocument doc;
+    if (loop_prof_to_json(doc)) pushDiagnostics("loop", doc);
+}
+
+void registerJobs() {
+    sched_every("token", 1000, jobTokenRefresh);
+    sched_every("ntp", 5000, jobTimeSync);
+    sched_every("rules", RULES_TICK_MS, jobRulesTick);   // first pass right away
+    sched_once("bootReport", BOOT_REPORT_DELAY_MS, jobBootReport);
+    sched_every("backfill", 1000, jobTelemetryBackfill);
+    sched_every("checkpoint", CTRL_CHECKPOINT_MS, jobCheckpoint, CTRL_CHECKPOINT_MS);
+    sched_every("stats", 600000, jobLogStats, 600000);
+    if (LOOP_PROF_ENABLED) sched_every("profile", LOOP_PROF_UPLOAD_MS, jobUploadProfile, LOOP_PROF_UPLOAD_MS);
 }
 
 // === INIT HELPERS ===
+// Loop-side modules (relays and WiFi are started earlier in setup())
 void initAllModules() {
+    {
+        BOOT_STAGE("lcd");
+        lcd_init();
+    }
+    {
+        BOOT_STAGE("telemetryLog");
+        telemetry_log_init();
+    }
+    if (TRACE_ENABLED) {
+        BOOT_STAGE("trace");
+        trace_recorder_init();
+    }
+    if (MQTT_ENABLED) mqtt_transport_init();
+    Serial.println("✅ All modules initialized successfully.");
+}
+
+// Sensor drivers; called by the sensor task, or inline when it is not running
+void initSensorDrivers() {
+    BOOT_STAGE("sensors");
     temp_sensor_init();
     ph_sensor_init();
     do_sensor_init();
-    turbidity_sensor_init();    
+    turbidity_sensor_init();
     dht_sensor_init();
-    float_switch_init();
-    relay_control_init(); 
-    lcd_init();
-    Serial.println("✅ All modules initialized successfully.");
+    if (ADC_DMA_ENABLED) adc_stream_init();
 }
 
 bool readSensorsMultiInterval(unsigned long now, RealTimeData &data, bool updatedSensors[5]) {
     static unsigned long lastRead[5] = {0, 0, 0, 0, 0};
+    static bool primed[5] = {false, false, false, false, false};
+    static bool firstCall = true;
     const unsigned long intervals[5] = {
         10000,   // waterTemp: 10s
         60000,   // pH: 1min
@@ -265,9 +413,30 @@ bool readSensorsMultiInterval(unsigned long now, RealTimeData &data, bool update
         60000    // airTemp & airHumidity: 60s
     };
 
+    // Every sensor is due on the first call rather than one interval after boot
+    if (firstCall) {
+        for (int i = 0; i < 5; i++) lastRead[i] = now - intervals[i];
+        firstCall = false;
+    }
+
+    // Until a sensor's first valid value (DS18B20 conversion, first DMA frame),
+    // a failed read is retried on the next pass instead of after a full interval
+    auto markRead = [&](int i) {
+        if (updatedSensors[i]) primed[i] = true;
+        if (primed[i] || now >= BOOT_SENSOR_PRIME_MS) lastRead[i] = now;
+    };
+
     bool updated = false;
     for (int i = 0; i < 5; i++) updatedSensors[i] = false;
 
+    // DS18B20 conversion runs in the background; collect it when done
+    temp_sensor_update(now);
+
+    // Analog channels come from the background DMA frames when available
+    adc_stream_poll();
+    AdcFrame frame;
+    bool haveFrame = adc_stream_latest(frame);
+
     // --- Water Temp ---
     if (now - lastRead[0] >= intervals[0]) {
         float temp = USE_WATERTEMP_MOCK ? 28.5 : read_waterTemp();
@@ -276,40 +445,46 @@ bool readSensorsMultiInterval(unsigned long now, RealTimeData &data, bool update
             updatedSensors[0] = true;
             updated = true;
         }
-        lastRead[0] = now;
+        markRead(0);
     }
 
     // --- pH ---
     if (now - lastRead[1] >= intervals[1]) {
-        float ph = USE_PH_MOCK ? read_ph_mock(): read_ph(data.waterTemp);
+        float ph = USE_PH_MOCK ? read_ph_mock()
+                 : haveFrame ? ph_from_voltage(frame.phMv, data.waterTemp)
+                 : adc_stream_active() ? NAN : read_ph(data.waterTemp);
         if (!isnan(ph) && ph > -2.0f && ph < 16.0f) {
             data.pH = ph;
             updatedSensors[1] = true;
             updated = true;
         }
-        lastRead[1] = now;
+        markRead(1);
     }
 
     // --- Dissolved Oxygen ---
     if (now - lastRead[2] >= intervals[2]) {
-        float doValue = USE_DO_MOCK ? read_do_mock() : read_dissolveOxygen(readDOVoltage(), data.waterTemp);
+        float doValue = USE_DO_MOCK ? read_do_mock()
+                      : haveFrame ? read_dissolveOxygen(frame.doMv, data.waterTemp)
+                      : adc_stream_active() ? NAN : read_dissolveOxygen(readDOVoltage(), data.waterTemp);
         if (!isnan(doValue) && doValue >= -5.0f && doValue < 25.0f) {
             data.dissolvedOxygen = doValue;
             updatedSensors[2] = true;
             updated = true;
         }
-        lastRead[2] = now;
+        markRead(2);
     }
 
     // --- Turbidity ---
     if (now - lastRead[3] >= intervals[3]) {
-        float turbidity = USE_TURBIDITY_MOCK ? 50.0 : read_turbidity();
+        float turbidity = USE_TURBIDITY_MOCK ? 50.0
+                        : haveFrame ? turbidity_from_voltage(frame.turbidityMv / 1000.0f)
+                        : adc_stream_active() ? NAN : read_turbidity();
         if (!isnan(turbidity) && turbidity >= -100.0f && turbidity < 3000.0f) {
             data.turbidityNTU = turbidity;
             updatedSensors[3] = true;
             updated = true;
         }
-        lastRead[3] = now;
+        markRead(3);
     }
 
     // --- Air Temp & Humidity ---
@@ -330,13 +505,85 @@ bool readSensorsMultiInterval(unsigned long now, RealTimeData &data, bool update
             updatedSensors[4] = true;
             updated = true;
         }
-        lastRead[4] = now;
+        markRead(4);
     }
 
     return updated;
 }
 
 
+// Owns the sensor drivers; runs on the other core so network stalls in loop()
+// never delay sampling. Publishes samples through a lock-free SPSC ring.
+void sensorTask(void *) {
+    initSensorDrivers();
+
+    RealTimeData local = {};
+    for (;;) {
+        SensorSample sample;
+        bool updated;
+        {
+            PROF_SCOPE(PROF_SENSOR_READ);
+            updated = readSensorsMultiInterval(millis(), local, sample.updated);
+        }
+        if (updated) {
+            sample.timestamp = millis();
+            sample.data = local;
+            if (!sensorRing.push(sample)) sensorSamplesDropped++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS));
+    }
+}
+
+void startSensorTask() {
+    if (sensorTaskHandle) return;
+    if (!SENSOR_TASK_ENABLED) {
+        initSensorDrivers();
+        return;
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_TASK_STACK, nullptr,
+                                            SENSOR_TASK_PRIORITY, &sensorTaskHandle, SENSOR_TASK_CORE);
+    if (ok != pdPASS) {
+        sensorTaskHandle = nullptr;
+        Serial.println("❌ Sensor task creation failed");
+        initSensorDrivers();   // fall back to reading from loop()
+        return;
+    }
+    Serial.printf("✅ Sensor task running on core %d\n", SENSOR_TASK_CORE);
+}
+
+// Merge every queued sample into `data` (only the fields each sample updated)
+bool drainSensorSamples(RealTimeData &data, bool updatedSensors[5]) {
+    bool updated = false;
+    for (int i = 0; i < 5; i++) updatedSensors[i] = false;
+
+    SensorSample sample;
+    while (sensorRing.pop(sample)) {
+        if (sample.updated[0]) data.waterTemp = sample.data.waterTemp;
+        if (sample.updated[1]) data.pH = sample.data.pH;
+        if (sample.updated[2]) data.dissolvedOxygen = sample.data.dissolvedOxygen;
+        if (sample.updated[3]) data.turbidityNTU = sample.data.turbidityNTU;
+        if (sample.updated[4]) {
+            data.airTemp = sample.data.airTemp;
+            data.airHumidity = sample.data.airHumidity;
+        }
+        for (int i = 0; i < 5; i++) {
+            if (sample.updated[i]) {
+                updatedSensors[i] = true;
+                updated = true;
+            }
+        }
+    }
+
+    static uint32_t reportedDrops = 0;
+    if (sensorSamplesDropped != reportedDrops) {
+        reportedDrops = sensorSamplesDropped;
+        LOGW(SENSOR, "⚠️ %lu sample(s) dropped (ring full)", (unsigned long)reportedDrops);
+    }
+
+    return updated;
+}
+
 float read_ph_mock() {
     static float mockPH = 7.2f;
     static unsigned long lastUpdate = 0;